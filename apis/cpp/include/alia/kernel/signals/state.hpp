@@ -1,5 +1,6 @@
 #pragma once
 
+#include <alia/abi/kernel/components.h>
 #include <alia/abi/ui/context.h>
 #include <alia/abi/ui/system/work.h>
 #include <alia/kernel/signals/basic.hpp>
@@ -89,8 +90,8 @@ struct state_storage
     handle_tracked_change(alia_context* ctx)
     {
         inc_version();
-        if (ctx && ctx->system)
-            alia_ui_mark_dirty(alia_ctx_system(ctx));
+        if (ctx)
+            alia_component_mark_dirty(ctx);
     }
 };
 
@@ -2,6 +2,7 @@
 
 #include <alia/abi/ui/geometry.h>
 #include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/layout/placements.h>
 #include <alia/context.h>
 #include <alia/ui/layout/flags.hpp>
 
@@ -396,6 +397,17 @@ growth_override(context& ctx, float growth, Content&& content)
     alia_layout_growth_override_end(&ctx);
 }
 
+// Tag the layout of `content` with `id` so that its box can be looked up in
+// the layout system's placement table.
+template<class Content>
+void
+layout_tag(context& ctx, alia_element_id id, Content&& content)
+{
+    alia_layout_tag_begin(&ctx, id);
+    std::forward<Content>(content)();
+    alia_layout_tag_end(&ctx);
+}
+
 inline void
 flow_spring(context& ctx, float min_width = 0.f)
 {
@@ -0,0 +1,234 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench_common.hpp"
+
+#include <alia/abi/ui/drawing/commands.h>
+#include <alia/abi/ui/drawing/system.h>
+#include <alia/abi/ui/geometry.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/impl/events.hpp>
+#include <alia/ui/drawing/bucket_key.h>
+#include <alia/ui/system/object.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// This measures the draw pass (recording commands into buckets, ordering the
+// buckets and handing them to their materials) and counts the heap
+// allocations that it makes. For comparison, it also runs the same stream of
+// bucket keys through the per-frame std::unordered_map bucketing that the
+// draw pass used to do.
+
+namespace {
+
+size_t allocation_count = 0;
+
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+    ++allocation_count;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+// the number of custom materials that the commands are spread across
+uint32_t const material_count = 4;
+
+// a UI that records `count` draw commands, spread across z indices,
+// materials and clip regions
+struct draw_scene
+{
+    size_t count;
+    alia_draw_material_id first_material = 0;
+    size_t drawn_buckets = 0;
+    alia_ui_system* ui = nullptr;
+
+    explicit draw_scene(size_t count) : count(count)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {1000, 1000});
+        first_material = alia_material_alloc_ids(ui, material_count);
+        for (uint32_t i = 0; i != material_count; ++i)
+        {
+            alia_material_register(
+                ui,
+                alia_draw_material_id(first_material + i),
+                {.draw_bucket = draw_bucket},
+                this);
+        }
+        alia_ui_system_update(ui);
+    }
+
+    ~draw_scene()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    static void
+    draw_bucket(void* user, alia_draw_bucket const*)
+    {
+        ++static_cast<draw_scene*>(user)->drawn_buckets;
+    }
+
+    alia_z_index
+    z_index_for(size_t i) const
+    {
+        return alia_z_index(i % 8);
+    }
+
+    alia_draw_material_id
+    material_for(size_t i) const
+    {
+        return alia_draw_material_id(
+            first_material + (i / 4) % material_count);
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& scene = *static_cast<draw_scene*>(user_data);
+        if (alia::get_event_type(*ctx) != ALIA_EVENT_DRAW)
+            return;
+        // Every 64 commands go in their own clip region.
+        for (size_t i = 0; i < scene.count; i += 64)
+        {
+            alia_geometry_push_clip_box(ctx, {{0.f, 0.f}, {100.f, 100.f}});
+            size_t const end = std::min(i + 64, scene.count);
+            for (size_t j = i; j != end; ++j)
+            {
+                (void) alia_draw_command_alloc(
+                    ctx,
+                    scene.z_index_for(j),
+                    scene.material_for(j),
+                    ALIA_MIN_ALIGNED_SIZE(sizeof(alia_draw_command)));
+            }
+            alia_geometry_pop_clip_box(ctx);
+        }
+    }
+
+    // Run the keys that the controller produces through the old bucketing
+    // scheme.
+    void
+    reference_bucketing()
+    {
+        std::unordered_map<uint64_t, size_t> buckets;
+        std::vector<uint64_t> keys;
+        for (size_t i = 0; i != count; ++i)
+        {
+            uint64_t const key = make_bucket_key(
+                ALIA_DRAW_TARGET_PRIMARY,
+                z_index_for(i),
+                alia_clip_id(1 + i / 64),
+                material_for(i));
+            auto it = buckets.find(key);
+            if (it == buckets.end())
+            {
+                keys.push_back(key);
+                it = buckets.insert(it, {key, 0});
+            }
+            ++it->second;
+        }
+        std::unordered_map<alia_draw_target_id, std::vector<uint64_t>>
+            keys_by_target;
+        for (auto const key : keys)
+            keys_by_target[target_from_key(key)].push_back(key);
+        for (auto& entry : keys_by_target)
+        {
+            std::sort(entry.second.begin(), entry.second.end());
+            drawn_buckets += entry.second.size();
+        }
+    }
+};
+
+// Returns false if the steady-state draw pass touched the heap.
+bool
+bench_draw_pass(ankerl::nanobench::Bench& suite, size_t count)
+{
+    std::string const prefix = std::to_string(count) + "/";
+
+    draw_scene scene(count);
+
+    // Warm up so that the arenas have grown to fit the frame.
+    alia_ui_execute_draw_pass(scene.ui);
+
+    // (The allocations are counted inside the timed functions so that the
+    // benchmark harness's own allocations don't show up.)
+    size_t passes = 0;
+    size_t draw_pass_allocations = 0;
+    suite.run(prefix + "draw_pass", [&] {
+        size_t const before = allocation_count;
+        alia_ui_execute_draw_pass(scene.ui);
+        draw_pass_allocations += allocation_count - before;
+        ++passes;
+    });
+
+    size_t reference_passes = 0;
+    size_t reference_allocations = 0;
+    suite.run(prefix + "reference_unordered_map", [&] {
+        size_t const before = allocation_count;
+        scene.reference_bucketing();
+        reference_allocations += allocation_count - before;
+        ++reference_passes;
+    });
+
+    std::cerr << prefix << "heap allocations per pass: draw_pass "
+              << double(draw_pass_allocations) / double(passes)
+              << ", reference_unordered_map "
+              << double(reference_allocations) / double(reference_passes)
+              << "\n";
+
+    ankerl::nanobench::doNotOptimizeAway(scene.drawn_buckets);
+    return draw_pass_allocations == 0;
+}
+
+} // namespace
+
+int
+main()
+{
+    ankerl::nanobench::Bench suite = make_bench();
+    if (!benchmark_smoke_mode())
+        suite.minEpochIterations(100);
+
+    bool allocation_free = true;
+    for (size_t count : {size_t(100), size_t(1'000), size_t(10'000)})
+        allocation_free = bench_draw_pass(suite, count) && allocation_free;
+
+    ankerl::nanobench::render(
+        ankerl::nanobench::templates::csv(), suite, std::cout);
+    if (!benchmark_smoke_mode())
+    {
+        std::ofstream json_out("draw_pass_benchmark_results.json");
+        suite.render(ankerl::nanobench::templates::json(), json_out);
+    }
+
+    return allocation_free ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench_common.hpp"
+
+#include <alia/renderers/gl/renderer.h>
+
+#include <alia/abi/base/object.h>
+#include <alia/abi/ui/drawing/primitives.h>
+#include <alia/abi/ui/drawing/system.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/impl/events.hpp>
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// This measures GL draw passes made up entirely of primitive instances, i.e.,
+// the instance upload path of the GL renderer. Each pass is followed by a
+// `glFinish` so that the GPU side (including any stalls on buffer reuse) is
+// included.
+//
+// It needs a GL context, so it runs in a hidden GLFW window. To run it
+// headless on Mesa's software rasterizer, use something like:
+//
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./alia_gl_benchmarks
+//
+// Note that llvmpipe spends most of each pass rasterizing, so it can't tell
+// the instance upload paths apart. (On a single core, every count here takes
+// 20-35 ms per pass on either path.) Use a hardware driver to compare them.
+//
+
+namespace {
+
+int const surface_width = 1024;
+int const surface_height = 1024;
+
+// a UI that draws `count` rounded boxes in a grid
+struct primitive_scene
+{
+    size_t count = 0;
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& scene = *static_cast<primitive_scene*>(user_data);
+        if (alia::get_event_type(*ctx) != ALIA_EVENT_DRAW)
+            return;
+        for (size_t i = 0; i != scene.count; ++i)
+        {
+            float const x = float((i * 7) % surface_width);
+            float const y = float((i / 13) % surface_height);
+            alia_draw_rounded_box(
+                ctx,
+                0,
+                {{x, y}, {6.f, 4.f}},
+                {uint8_t(i), uint8_t(i >> 8), 160, 255},
+                1.5f);
+        }
+    }
+};
+
+void
+bench_primitives(
+    ankerl::nanobench::Bench& suite,
+    alia_ui_system* ui,
+    primitive_scene& scene,
+    size_t count)
+{
+    scene.count = count;
+    suite.run(std::to_string(count) + "/draw_pass", [&] {
+        alia_ui_execute_draw_pass(ui);
+        glFinish();
+    });
+}
+
+} // namespace
+
+int
+main()
+{
+    if (!glfwInit())
+    {
+        std::fprintf(stderr, "[alia gl benchmarks] glfwInit failed\n");
+        return 1;
+    }
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(
+        surface_width, surface_height, "alia GL benchmarks", nullptr, nullptr);
+    if (!window)
+    {
+        std::fprintf(stderr, "[alia gl benchmarks] glfwCreateWindow failed\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    {
+        std::fprintf(stderr, "[alia gl benchmarks] gladLoadGLLoader failed\n");
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 1;
+    }
+    std::fprintf(
+        stderr,
+        "[alia gl benchmarks] %s / %s\n",
+        reinterpret_cast<char const*>(glGetString(GL_RENDERER)),
+        reinterpret_cast<char const*>(glGetString(GL_VERSION)));
+    // The renderer streams instances through a persistently mapped ring when
+    // it can and falls back to orphaning a plain buffer otherwise.
+    std::fprintf(
+        stderr,
+        "[alia gl benchmarks] instance upload: %s\n",
+        glBufferStorage ? "persistent mapped ring" : "buffer orphaning");
+
+    primitive_scene scene;
+    alia_struct_spec const ui_spec = alia_ui_system_object_spec();
+    void* ui_storage = alia_object_alloc(ui_spec);
+    alia_ui_system* ui = alia_ui_system_init(
+        ui_storage,
+        {primitive_scene::controller, &scene},
+        {surface_width, surface_height});
+
+    alia_struct_spec const renderer_spec = alia_gl_renderer_object_spec();
+    void* renderer_storage = alia_object_alloc(renderer_spec);
+    alia_gl_renderer* renderer = alia_gl_renderer_init(renderer_storage);
+    alia_gl_renderer_attach(renderer, ui);
+
+    ankerl::nanobench::Bench suite = make_bench();
+    if (!benchmark_smoke_mode())
+        suite.minEpochIterations(10);
+
+    for (size_t count : {size_t(1'000), size_t(10'000), size_t(100'000)})
+        bench_primitives(suite, ui, scene, count);
+
+    ankerl::nanobench::render(
+        ankerl::nanobench::templates::csv(), suite, std::cout);
+    if (!benchmark_smoke_mode())
+    {
+        std::ofstream json_out("gl_primitives_benchmark_results.json");
+        suite.render(ankerl::nanobench::templates::json(), json_out);
+    }
+
+    alia_gl_renderer_destroy(renderer);
+    alia_object_free(renderer_storage);
+    alia_object_free(ui_storage);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
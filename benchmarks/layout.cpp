@@ -1,11 +1,18 @@
 #define ANKERL_NANOBENCH_IMPLEMENT
 #include "layout_bench_phases.hpp"
+#include "layout_bench_profile.hpp"
+#include "layout_bench_snapshot.hpp"
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
+// Any arguments are paths to layout snapshots (see
+// alia/abi/ui/layout/snapshot.h), which are benchmarked after the built-in
+// scenarios.
 int
-main()
+main(int argc, char** argv)
 {
     layout_fixture* fixture = layout_fixture_create();
     if (!fixture)
@@ -24,11 +31,55 @@ main()
          alia_layout_scenario_growth_rows_100,
          alia_vec2f_make(10'000.f, 10'000.f),
          alia_layout_scenario_growth_rows_100_leaf_count},
+        {"grid_100",
+         alia_layout_scenario_grid_100,
+         alia_vec2f_make(10'000.f, 10'000.f),
+         alia_layout_scenario_grid_100_leaf_count},
+    };
+
+    layout_bench_scenario const large_scenarios[] = {
+        {"nested_grid_100x100x100",
+         alia_layout_scenario_nested_grid_1m,
+         alia_vec2f_make(1'000'000.f, 1'000'000.f),
+         alia_layout_scenario_nested_grid_1m_leaf_count},
+        {"column_of_rows_333333",
+         alia_layout_scenario_column_of_rows_1m,
+         alia_vec2f_make(10'000.f, 10'000'000.f),
+         alia_layout_scenario_column_of_rows_1m_leaf_count},
+    };
+
+    layout_bench_scenario const resize_scenarios[] = {
+        {"paragraphs_20x200",
+         alia_layout_scenario_paragraphs,
+         alia_vec2f_make(800.f, 10'000.f),
+         alia_layout_scenario_paragraphs_leaf_count},
+        // (wide enough that the lines are long and the flows use batches)
+        {"paragraphs_20x200_wide",
+         alia_layout_scenario_paragraphs,
+         alia_vec2f_make(6'000.f, 10'000.f),
+         alia_layout_scenario_paragraphs_leaf_count},
     };
 
     ankerl::nanobench::Bench suite = make_bench();
     for (auto const& scenario : scenarios)
         bench_layout_phases(suite, fixture, scenario);
+    for (auto const& scenario : large_scenarios)
+        bench_large_layout(suite, fixture, scenario);
+    for (auto const& scenario : resize_scenarios)
+        bench_resize_drag(suite, fixture, scenario);
+    // Grids are cached as a whole, so a resize has to re-measure them from
+    // scratch. (This is `grid_100`.)
+    bench_resize_drag(suite, fixture, scenarios[3]);
+    int status = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!bench_layout_snapshot(
+                suite, fixture, argv[i], read_layout_snapshot_file(argv[i])))
+        {
+            std::cerr << argv[i] << ": not a valid layout snapshot\n";
+            status = 1;
+        }
+    }
 
     ankerl::nanobench::render(
         ankerl::nanobench::templates::csv(), suite, std::cout);
@@ -38,6 +89,21 @@ main()
         suite.render(ankerl::nanobench::templates::json(), json_out);
     }
 
+    // (In smoke mode, the profiles are still taken, just not saved.)
+    std::vector<layout_bench_scenario> profiled(
+        std::begin(scenarios), std::end(scenarios));
+    profiled.insert(
+        profiled.end(),
+        std::begin(resize_scenarios),
+        std::end(resize_scenarios));
+    std::ostringstream profiles;
+    write_layout_profiles(profiles, fixture, profiled);
+    if (!benchmark_smoke_mode() && !profiles.str().empty())
+    {
+        std::ofstream profile_out("layout_profile_results.json");
+        profile_out << profiles.str();
+    }
+
     layout_fixture_destroy(fixture);
-    return 0;
+    return status;
 }
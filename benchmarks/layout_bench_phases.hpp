@@ -5,7 +5,11 @@
 #include <alia/test/layout/layout_fixture.hpp>
 #include <alia/test/layout/scenarios.h>
 
+#include <alia/ui/layout/components/flow.h>
+#include <alia/ui/layout/system.h>
+
 #include <cassert>
+#include <climits>
 #include <string>
 
 struct layout_bench_scenario
@@ -23,7 +27,7 @@ assert_scenario_sanity(
     assert(layout_fixture_root_child(fixture) != nullptr);
 
     alia_arena_stats stats = layout_fixture_node_arena_stats(fixture);
-    assert(stats.current_usage > 0);
+    assert(stats.peak_usage > 0);
     (void) scenario.leaf_count;
 }
 
@@ -44,8 +48,64 @@ bench_layout_phases(
             layout_fixture_root_child(fixture));
     });
 
+    // full resolves, with nothing cached from previous ones
     layout_fixture_run_refresh_impl(fixture, scenario.fn, nullptr);
     suite.run(prefix + "resolve", [&] {
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    // the same, but split across four threads
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 4, .min_fork_size = 64});
+    suite.run(prefix + "resolve_parallel", [&] {
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 1, .min_fork_size = 0});
+
+    // full resolves of the compact (structure-of-arrays) form of the tree
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_COMPACT);
+    suite.run(prefix + "resolve_compact", [&] {
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_LINKED);
+
+    // resolves of a tree that hasn't changed since the last one
+    layout_fixture_resolve(fixture, scenario.available);
+    suite.run(prefix + "resolve_unchanged", [&] {
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    // refresh + resolve, where each refresh changes the width of the middle
+    // leaf (so the resolve is incremental)
+    alia_layout_scenario_change change
+        = {.leaf_index = scenario.leaf_count() / 2,
+           .extra_width = 0.f,
+           .leaf_counter = 0};
+    suite.run(prefix + "one_leaf_changed", [&] {
+        change.extra_width = change.extra_width == 0.f ? 1.f : 0.f;
+        layout_fixture_run_refresh_impl(fixture, scenario.fn, &change);
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    // the same, but with full resolves (for comparison)
+    suite.run(prefix + "one_leaf_changed_full", [&] {
+        change.extra_width = change.extra_width == 0.f ? 1.f : 0.f;
+        layout_fixture_run_refresh_impl(fixture, scenario.fn, &change);
+        layout_fixture_clear_layout_cache(fixture);
         layout_fixture_resolve(fixture, scenario.available);
         ankerl::nanobench::doNotOptimizeAway(
             layout_fixture_placement_arena_identity(fixture));
@@ -58,3 +118,98 @@ bench_layout_phases(
         ankerl::nanobench::doNotOptimizeAway(layout_fixture_context(fixture));
     });
 }
+
+// Benchmark full resolves of a scenario that's too large to go through all of
+// the phases above, comparing linked and compact storage.
+inline void
+bench_large_layout(
+    ankerl::nanobench::Bench& suite,
+    layout_fixture* fixture,
+    layout_bench_scenario const& scenario)
+{
+    std::string const prefix = std::string(scenario.name) + "/";
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+
+    uint64_t const min_epoch_iterations = suite.minEpochIterations();
+    suite.minEpochIterations(1);
+
+    layout_fixture_run_refresh_impl(fixture, scenario.fn, nullptr);
+    assert_scenario_sanity(fixture, scenario);
+
+    suite.run(prefix + "resolve", [&] {
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    // compact resolves of a tree that was already flattened
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_COMPACT);
+    layout_fixture_resolve(fixture, scenario.available);
+    suite.run(prefix + "resolve_compact", [&] {
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    // the same, but flattening the tree each time (as happens after a
+    // refresh)
+    suite.run(prefix + "resolve_compact_with_build", [&] {
+        alia::layout_system_end_refresh(*system);
+        layout_fixture_resolve(fixture, scenario.available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_LINKED);
+
+    suite.minEpochIterations(min_epoch_iterations);
+}
+
+// Benchmark a window resize drag: 300 resolves of an unchanged tree, with the
+// width shrinking by a pixel each frame. Each iteration covers the whole drag.
+inline void
+bench_resize_drag(
+    ankerl::nanobench::Bench& suite,
+    layout_fixture* fixture,
+    layout_bench_scenario const& scenario)
+{
+    std::string const prefix = std::string(scenario.name) + "/";
+    int const frame_count = 300;
+
+    uint64_t const min_epoch_iterations = suite.minEpochIterations();
+    suite.minEpochIterations(1);
+
+    layout_fixture_run_refresh_impl(fixture, scenario.fn, nullptr);
+    assert_scenario_sanity(fixture, scenario);
+
+    auto drag = [&](bool clear_cache) {
+        for (int i = 0; i != frame_count; ++i)
+        {
+            if (clear_cache)
+                layout_fixture_clear_layout_cache(fixture);
+            layout_fixture_resolve(
+                fixture,
+                alia_vec2f_make(
+                    scenario.available.x - float(i), scenario.available.y));
+            ankerl::nanobench::doNotOptimizeAway(
+                layout_fixture_placement_arena_identity(fixture));
+        }
+    };
+
+    // with the cache carried over from frame to frame (so that flows can
+    // reuse their line breaks)
+    drag(false);
+    suite.run(prefix + "resize_drag", [&] { drag(false); });
+
+    // the same, but with full resolves (for comparison)
+    suite.run(prefix + "resize_drag_full", [&] { drag(true); });
+
+    // full resolves with the flows' fragments measured one at a time (to
+    // show what fragment batching saves)
+    int const min_fragments = alia::flow_batch_min_fragments;
+    alia::flow_batch_min_fragments = INT_MAX;
+    suite.run(prefix + "resize_drag_full_unbatched", [&] { drag(true); });
+    alia::flow_batch_min_fragments = min_fragments;
+
+    suite.minEpochIterations(min_epoch_iterations);
+}
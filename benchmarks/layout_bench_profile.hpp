@@ -0,0 +1,86 @@
+#pragma once
+
+#include "layout_bench_phases.hpp"
+
+#include <alia/abi/ui/layout/profile.h>
+
+#include <ostream>
+#include <span>
+
+// If layout profiling is compiled in, this profiles a full resolve of each
+// scenario and writes the results to `out` as JSON. (It writes nothing
+// otherwise.)
+inline void
+write_layout_profiles(
+    std::ostream& out,
+    layout_fixture* fixture,
+    std::span<layout_bench_scenario const> scenarios)
+{
+    static char const* const phase_names[ALIA_LAYOUT_PROFILE_PHASE_COUNT]
+        = {"horizontal", "vertical", "assignment"};
+    static char const* const call_names[ALIA_LAYOUT_PROFILE_CALL_COUNT]
+        = {"measure_horizontal",
+           "measure_vertical",
+           "assign_boxes",
+           "count_flow_emissions",
+           "emit_flow_fragments",
+           "read_fragment_placements"};
+
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    if (!alia_layout_system_profile(system))
+        return;
+
+    out << "{\n  \"scenarios\": [";
+    char const* scenario_separator = "\n";
+    for (auto const& scenario : scenarios)
+    {
+        layout_fixture_run_refresh_impl(fixture, scenario.fn, nullptr);
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, scenario.available);
+        alia_layout_profile const& profile
+            = *alia_layout_system_profile(system);
+
+        out << scenario_separator << "    {\n";
+        scenario_separator = ",\n";
+        out << "      \"name\": \"" << scenario.name << "\",\n";
+        out << "      \"total_ns\": " << profile.total_nanoseconds << ",\n";
+        out << "      \"phase_ns\": {";
+        for (int i = 0; i != ALIA_LAYOUT_PROFILE_PHASE_COUNT; ++i)
+        {
+            out << (i != 0 ? ", " : "") << "\"" << phase_names[i]
+                << "\": " << profile.phase_nanoseconds[i];
+        }
+        out << "},\n";
+        out << "      \"nodes_visited\": " << profile.nodes_visited << ",\n";
+        out << "      \"scratch_peak_bytes\": " << profile.scratch_peak_bytes
+            << ",\n";
+        out << "      \"placement_bytes\": " << profile.placement_bytes
+            << ",\n";
+        out << "      \"untracked_calls\": " << profile.untracked_calls
+            << ",\n";
+        out << "      \"node_types\": [";
+        for (uint32_t i = 0; i != profile.node_type_count; ++i)
+        {
+            alia_layout_profile_node_type const& type = profile.node_types[i];
+            char const* name
+                = type.vtable->name ? type.vtable->name : "(unnamed)";
+            out << (i != 0 ? "," : "") << "\n        {\"type\": \"" << name
+                << "\", \"calls\": {";
+            char const* call_separator = "";
+            for (int j = 0; j != ALIA_LAYOUT_PROFILE_CALL_COUNT; ++j)
+            {
+                alia_layout_profile_calls const& calls = type.calls[j];
+                if (calls.count == 0)
+                    continue;
+                out << call_separator << "\"" << call_names[j]
+                    << "\": {\"count\": " << calls.count
+                    << ", \"ns\": " << calls.nanoseconds
+                    << ", \"self_ns\": " << calls.self_nanoseconds << "}";
+                call_separator = ", ";
+            }
+            out << "}}";
+        }
+        out << "\n      ]\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
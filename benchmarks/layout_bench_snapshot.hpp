@@ -0,0 +1,86 @@
+#pragma once
+
+#include "layout_bench_phases.hpp"
+
+#include <alia/abi/ui/layout/snapshot.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Read a whole snapshot file (or return an empty vector if it can't be read).
+inline std::vector<uint8_t>
+read_layout_snapshot_file(char const* path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return {};
+    return std::vector<uint8_t>(
+        std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Benchmark the phases of a layout tree recorded in a snapshot (see
+// alia/abi/ui/layout/snapshot.h): replaying it (which stands in for the
+// refresh that originally emitted it), then resolving it in the same ways
+// that bench_layout_phases does. This returns false if the snapshot isn't
+// well-formed.
+inline bool
+bench_layout_snapshot(
+    ankerl::nanobench::Bench& suite,
+    layout_fixture* fixture,
+    std::string const& name,
+    std::vector<uint8_t> const& snapshot)
+{
+    std::string const prefix = name + "/";
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+
+    alia_vec2f available;
+    if (!layout_fixture_load_snapshot(
+            fixture, snapshot.data(), snapshot.size(), &available))
+    {
+        return false;
+    }
+
+    suite.run(prefix + "replay", [&] {
+        layout_fixture_load_snapshot(
+            fixture, snapshot.data(), snapshot.size(), nullptr);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_root_child(fixture));
+    });
+
+    suite.run(prefix + "resolve", [&] {
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 4, .min_fork_size = 64});
+    suite.run(prefix + "resolve_parallel", [&] {
+        layout_fixture_clear_layout_cache(fixture);
+        layout_fixture_resolve(fixture, available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 1, .min_fork_size = 0});
+
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_COMPACT);
+    suite.run(prefix + "resolve_compact", [&] {
+        layout_fixture_resolve(fixture, available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_LINKED);
+
+    layout_fixture_resolve(fixture, available);
+    suite.run(prefix + "resolve_unchanged", [&] {
+        layout_fixture_resolve(fixture, available);
+        ankerl::nanobench::doNotOptimizeAway(
+            layout_fixture_placement_arena_identity(fixture));
+    });
+
+    return true;
+}
@@ -0,0 +1,229 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench_common.hpp"
+
+#include <alia/kernel/key_map.h>
+#include <alia/kernel/substrate.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// This compares the flat key map used by substrate key tables against the
+// node-based `std::unordered_map` that it replaced.
+
+namespace {
+
+// the previous key map implementation
+struct node_key_map
+{
+    struct view_key
+    {
+        alia_id_view view;
+    };
+
+    struct view_key_hash
+    {
+        size_t
+        operator()(view_key const& key) const
+        {
+            return alia_id_view_hash(key.view);
+        }
+    };
+
+    struct view_key_eq
+    {
+        bool
+        operator()(view_key const& a, view_key const& b) const
+        {
+            return alia_id_view_equal(a.view, b.view);
+        }
+    };
+
+    std::unordered_map<
+        view_key,
+        alia_substrate_key_entry*,
+        view_key_hash,
+        view_key_eq>
+        entries;
+};
+
+void*
+bench_alloc(void*, size_t size, size_t alignment)
+{
+    ALIA_ASSERT(alignment <= alignof(std::max_align_t));
+    return std::malloc(size);
+}
+
+void
+bench_free(void*, void* ptr, size_t, size_t)
+{
+    std::free(ptr);
+}
+
+alia_general_allocator const bench_allocator
+    = {.alloc = bench_alloc, .free = bench_free, .user_data = nullptr};
+
+std::vector<alia_substrate_key_entry>
+make_entries(size_t count)
+{
+    std::vector<alia_substrate_key_entry> entries(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        entries[i] = alia_substrate_key_entry{
+            .anchor = {.block = nullptr},
+            .key = {alia_id_view_make_u64(i * 7919u + 1u)},
+            .key_storage = nullptr,
+            .last_seen = 0,
+            .flags = 0,
+            .next = nullptr};
+    }
+    return entries;
+}
+
+void
+fill(node_key_map& map, std::vector<alia_substrate_key_entry>& entries)
+{
+    for (auto& entry : entries)
+        map.entries.emplace(node_key_map::view_key{entry.key.view}, &entry);
+}
+
+void
+fill(
+    alia_substrate_key_map& map,
+    std::vector<alia_substrate_key_entry>& entries)
+{
+    for (auto& entry : entries)
+        alia::key_map_insert(map, bench_allocator, &entry);
+}
+
+// Sweep every other entry out of the map, the way the substrate would after a
+// filtered list loses half its rows.
+void
+sweep_half(node_key_map& map)
+{
+    std::vector<alia_substrate_key_entry*> to_remove;
+    to_remove.reserve(map.entries.size());
+    for (auto& i : map.entries)
+    {
+        if (i.second->last_seen & 1)
+            to_remove.push_back(i.second);
+    }
+    for (alia_substrate_key_entry* entry : to_remove)
+        map.entries.erase(node_key_map::view_key{entry->key.view});
+}
+
+void
+sweep_half(alia_substrate_key_map& map)
+{
+    uint32_t i = 0;
+    while (i != map.capacity)
+    {
+        alia_substrate_key_entry* entry = map.slots[i].entry;
+        if (entry && (entry->last_seen & 1))
+            alia::key_map_erase_at(map, i);
+        else
+            ++i;
+    }
+}
+
+void
+bench_key_maps(ankerl::nanobench::Bench& suite, size_t count)
+{
+    std::string const prefix = std::to_string(count) + "/";
+
+    std::vector<alia_substrate_key_entry> entries = make_entries(count);
+    for (size_t i = 0; i != count; ++i)
+        entries[i].last_seen = uint32_t(i);
+
+    std::vector<alia_id_view> hits(count);
+    std::vector<alia_id_view> misses(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        hits[i] = entries[(i * 31u) % count].key.view;
+        misses[i] = alia_id_view_make_u64(i * 7919u + 2u);
+    }
+
+    {
+        node_key_map map;
+        fill(map, entries);
+
+        suite.run(prefix + "unordered_map/lookup_hit", [&] {
+            for (alia_id_view const& key : hits)
+            {
+                auto i = map.entries.find(node_key_map::view_key{key});
+                ankerl::nanobench::doNotOptimizeAway(i->second);
+            }
+        });
+        suite.run(prefix + "unordered_map/lookup_miss", [&] {
+            for (alia_id_view const& key : misses)
+            {
+                auto i = map.entries.find(node_key_map::view_key{key});
+                ankerl::nanobench::doNotOptimizeAway(i == map.entries.end());
+            }
+        });
+        suite.run(prefix + "unordered_map/build_and_sweep", [&] {
+            node_key_map fresh;
+            fill(fresh, entries);
+            sweep_half(fresh);
+            ankerl::nanobench::doNotOptimizeAway(fresh.entries.size());
+        });
+    }
+
+    {
+        alia_substrate_key_map map;
+        alia::key_map_init(map);
+        fill(map, entries);
+
+        suite.run(prefix + "flat/lookup_hit", [&] {
+            for (alia_id_view const& key : hits)
+            {
+                ankerl::nanobench::doNotOptimizeAway(
+                    alia::key_map_find(map, key));
+            }
+        });
+        suite.run(prefix + "flat/lookup_miss", [&] {
+            for (alia_id_view const& key : misses)
+            {
+                ankerl::nanobench::doNotOptimizeAway(
+                    alia::key_map_find(map, key));
+            }
+        });
+        suite.run(prefix + "flat/build_and_sweep", [&] {
+            alia_substrate_key_map fresh;
+            alia::key_map_init(fresh);
+            fill(fresh, entries);
+            sweep_half(fresh);
+            ankerl::nanobench::doNotOptimizeAway(fresh.count);
+            alia::key_map_destroy(fresh, bench_allocator);
+        });
+
+        alia::key_map_destroy(map, bench_allocator);
+    }
+}
+
+} // namespace
+
+int
+main()
+{
+    ankerl::nanobench::Bench suite = make_bench();
+    if (!benchmark_smoke_mode())
+        suite.minEpochIterations(10);
+
+    for (size_t count : {size_t(1'000), size_t(10'000), size_t(100'000)})
+        bench_key_maps(suite, count);
+
+    ankerl::nanobench::render(
+        ankerl::nanobench::templates::csv(), suite, std::cout);
+    if (!benchmark_smoke_mode())
+    {
+        std::ofstream json_out("substrate_key_map_benchmark_results.json");
+        suite.render(ankerl::nanobench::templates::json(), json_out);
+    }
+
+    return 0;
+}
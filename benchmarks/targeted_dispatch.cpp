@@ -0,0 +1,161 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench_common.hpp"
+
+#include <alia/abi/kernel/components.h>
+#include <alia/abi/kernel/events.h>
+#include <alia/abi/ui/input/elements.h>
+#include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/impl/events.hpp>
+#include <alia/kernel/flow/dispatch.h>
+#include <alia/ui/system/object.h>
+
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// This measures the cost of delivering a targeted (timer) event to one
+// element in a UI made up of a tree of nested components, both with and
+// without route information on the target's ID. Without a route, dispatch
+// falls back to traversing the whole controller (which is what every targeted
+// event did before route node IDs existed).
+
+namespace {
+
+// the number of child components per component in the tree
+size_t const tree_fanout = 8;
+
+// a UI with `count` leaf components, each containing one element, grouped
+// into a tree of components
+struct component_list
+{
+    std::vector<alia_element_id> ids;
+    size_t deliveries = 0;
+    alia_ui_system* ui = nullptr;
+
+    explicit component_list(size_t count) : ids(count)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {1000, 1000});
+        alia_ui_system_update(ui);
+        // Do a full non-refresh pass so that the components know their
+        // placements.
+        alia_event hit_test = alia_make_mouse_hit_test_event(
+            {.x = -1.f, .y = -1.f, .result = {}});
+        alia::dispatch_event(*ui, hit_test);
+    }
+
+    ~component_list()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    void
+    send_timer(alia_element_id target)
+    {
+        alia_event event
+            = alia_make_timer_event({.target = target, .fire_time = 0});
+        alia::dispatch_targeted_event(*ui, event, target);
+    }
+
+    void
+    do_leaf(alia_context* ctx, alia_element_id& stored_id)
+    {
+        alia_element_id const id = alia_element_get_identity(ctx);
+        stored_id = id;
+        if (alia::is_refresh_event(*ctx))
+        {
+            alia_layout_leaf_emit(
+                ctx,
+                alia_layout_content_metrics_make(alia_vec2f_make(10.f, 1.f)),
+                0);
+        }
+        else
+        {
+            (void) alia_layout_consume_box(ctx);
+            if (alia::get_event_type(*ctx) == ALIA_EVENT_TIMER
+                && alia::get_event_target(*ctx).ptr == id.ptr)
+            {
+                ++deliveries;
+            }
+        }
+    }
+
+    // Do the leaves in [begin, end), splitting them among child components.
+    void
+    do_range(alia_context* ctx, size_t begin, size_t end)
+    {
+        size_t const chunk = (end - begin + tree_fanout - 1) / tree_fanout;
+        for (size_t i = begin; i < end; i += chunk)
+        {
+            size_t const chunk_end = i + chunk < end ? i + chunk : end;
+            if (alia_component_begin(ctx, alia_id_view_unit()))
+            {
+                if (chunk_end - i == 1)
+                    do_leaf(ctx, ids[i]);
+                else
+                    do_range(ctx, i, chunk_end);
+            }
+            alia_component_end(ctx);
+        }
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& list = *static_cast<component_list*>(user_data);
+        alia_layout_column_begin(ctx, 0, 0.f);
+        list.do_range(ctx, 0, list.ids.size());
+        alia_layout_column_end(ctx);
+    }
+};
+
+void
+bench_targeted_dispatch(ankerl::nanobench::Bench& suite, size_t count)
+{
+    std::string const prefix = std::to_string(count) + "/";
+
+    component_list list(count);
+    alia_element_id const routed = list.ids[count / 2];
+    alia_element_id unrouted = routed;
+    unrouted.route = 0;
+
+    suite.run(prefix + "full_traversal", [&] { list.send_timer(unrouted); });
+    suite.run(prefix + "routed", [&] { list.send_timer(routed); });
+
+    // The target should have seen the events either way.
+    ALIA_ASSERT(list.deliveries != 0);
+    ankerl::nanobench::doNotOptimizeAway(list.deliveries);
+}
+
+} // namespace
+
+int
+main()
+{
+    ankerl::nanobench::Bench suite = make_bench();
+    if (!benchmark_smoke_mode())
+        suite.minEpochIterations(10);
+
+    for (size_t count :
+         {size_t(100), size_t(1'000), size_t(10'000), size_t(100'000)})
+        bench_targeted_dispatch(suite, count);
+
+    ankerl::nanobench::render(
+        ankerl::nanobench::templates::csv(), suite, std::cout);
+    if (!benchmark_smoke_mode())
+    {
+        std::ofstream json_out("targeted_dispatch_benchmark_results.json");
+        suite.render(ankerl::nanobench::templates::json(), json_out);
+    }
+
+    return 0;
+}
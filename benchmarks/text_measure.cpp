@@ -0,0 +1,420 @@
+#define ANKERL_NANOBENCH_IMPLEMENT
+#include "bench_common.hpp"
+
+#include <alia/abi/ui/msdf.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/abi/ui/text.h>
+#include <alia/ui/system/object.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// This measures text measurement in the MSDF engine (preparing blocks,
+// measuring widths and breaking lines) over 1 MB of prose, using a synthetic
+// font with a realistic number of kerning pairs. For comparison, it also
+// prepares and measures the same text with the per-character
+// std::unordered_map lookups that the engine used to do.
+
+namespace {
+
+// the synthetic font
+
+float
+glyph_advance(uint32_t c)
+{
+    return 0.25f + float((c * 7) % 11) * 0.03f;
+}
+
+std::vector<alia_msdf_glyph>
+make_glyphs()
+{
+    std::vector<alia_msdf_glyph> glyphs;
+    for (uint32_t c = 32; c != 127; ++c)
+    {
+        float const advance = glyph_advance(c);
+        glyphs.push_back(
+            {.unicode = c,
+             .advance = advance,
+             .visible = c != ' ',
+             .plane_left = 0.02f,
+             .plane_bottom = -0.2f,
+             .plane_right = advance - 0.02f,
+             .plane_top = 0.75f,
+             .atlas_left = float(c % 16) * 32.f,
+             .atlas_bottom = float(c / 16) * 32.f,
+             .atlas_right = float(c % 16) * 32.f + 30.f,
+             .atlas_top = float(c / 16) * 32.f + 30.f});
+    }
+    return glyphs;
+}
+
+std::vector<alia_msdf_kerning_pair>
+make_kerning_pairs()
+{
+    std::string const lefts = "AFKLPTVWYfkrvwy\"'";
+    std::string const rights = "AJacdegmnopqrsuvwxyz.,-";
+    std::vector<alia_msdf_kerning_pair> pairs;
+    for (char l : lefts)
+    {
+        for (char r : rights)
+        {
+            pairs.push_back(
+                {.left = uint32_t(l),
+                 .right = uint32_t(r),
+                 .adjustment = -0.01f * float((l + r) % 7)});
+        }
+    }
+    return pairs;
+}
+
+// at least 1 MB of prose, in paragraphs separated by newlines
+std::string
+make_prose()
+{
+    char const* const words[] = {
+        "the",       "layout",   "of",        "a",         "paragraph",
+        "depends",   "on",       "width",     "and",       "font",
+        "Typically", "every",    "glyph",     "advances",  "the",
+        "pen",       "by",       "its",       "own",       "amount",
+        "while",     "kerning",  "tightens",  "awkward",   "pairs",
+        "like",      "AV",       "To",        "Wa",        "Ye",
+        "fly",       "very",     "quickly",   "over",      "wavy",
+        "lines",     "Yet",      "readers",   "rarely",    "notice",
+        "Fairly",    "Kept",     "Layouts",   "Printed",   "Tables",
+        "with",      "words",    "wrap",      "across",    "rows",
+        "that",      "few",      "people",    "ever",      "examine",
+        "closely",   "\"quoted\"", "text",    "can",       "vary"};
+    size_t const word_count = sizeof(words) / sizeof(words[0]);
+
+    std::string prose;
+    uint32_t seed = 12345;
+    auto next = [&](uint32_t n) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % n;
+    };
+    while (prose.size() < (size_t(1) << 20))
+    {
+        // a paragraph of 3-8 sentences of 5-20 words
+        uint32_t const sentences = 3 + next(6);
+        for (uint32_t s = 0; s != sentences; ++s)
+        {
+            uint32_t const length = 5 + next(16);
+            for (uint32_t w = 0; w != length; ++w)
+            {
+                std::string word = words[next(uint32_t(word_count))];
+                if (w == 0 && word[0] >= 'a' && word[0] <= 'z')
+                    word[0] = char(word[0] - 'a' + 'A');
+                prose += word;
+                if (w + 1 != length)
+                    prose += next(8) == 0 ? ", " : " ";
+            }
+            prose += s + 1 != sentences ? ". " : ".";
+        }
+        prose += '\n';
+    }
+    return prose;
+}
+
+// the previous glyph and kerning tables
+struct map_font
+{
+    struct pair_hash
+    {
+        size_t
+        operator()(std::pair<uint32_t, uint32_t> const& pair) const
+        {
+            return (pair.first << 4) ^ pair.second;
+        }
+    };
+
+    std::unordered_map<int, alia_msdf_glyph> glyphs;
+    std::unordered_map<std::pair<uint32_t, uint32_t>, float, pair_hash>
+        kerning;
+
+    float
+    get_kerning(char left, char right) const
+    {
+        auto it = kerning.find(
+            {uint32_t(static_cast<unsigned char>(left)),
+             uint32_t(static_cast<unsigned char>(right))});
+        return it != kerning.end() ? it->second : 0.0f;
+    }
+};
+
+// Prepare a block for `text` the way `prepare_block` used to, returning its
+// total width.
+float
+reference_prepare_block(
+    map_font const& font, std::string const& text, float font_size)
+{
+    // (This allocates the same storage that a block does.)
+    std::vector<char> copy(text.begin(), text.end());
+    std::vector<alia_text_segment> segments;
+    size_t const length = copy.size();
+    size_t i = 0;
+    while (i < length)
+    {
+        char const c = copy[i];
+        if (c == '\n')
+        {
+            segments.push_back(
+                {.byte_start = i,
+                 .byte_end = i + 1,
+                 .advance_width = 0.0f,
+                 .kind = ALIA_TEXT_SEGMENT_HARD_BREAK,
+                 .direction = ALIA_TEXT_DIRECTION_LTR});
+            ++i;
+            continue;
+        }
+        bool const is_space = (c == ' ');
+        size_t const start = i;
+        float width = 0.0f;
+        while (i < length)
+        {
+            char const d = copy[i];
+            if (d == '\n' || ((d == ' ') != is_space))
+                break;
+            width += font.glyphs.at(static_cast<int>(d)).advance;
+            ++i;
+            if (i < length)
+            {
+                char const e = copy[i];
+                if (e != '\n' && ((e == ' ') == is_space))
+                    width += font.get_kerning(d, e);
+            }
+        }
+        segments.push_back(
+            {.byte_start = start,
+             .byte_end = i,
+             .advance_width = width * font_size,
+             .kind = is_space ? ALIA_TEXT_SEGMENT_SPACE
+                              : ALIA_TEXT_SEGMENT_CONTENT,
+             .direction = ALIA_TEXT_DIRECTION_LTR});
+    }
+    float total = 0;
+    for (auto const& segment : segments)
+        total += segment.advance_width;
+    return total;
+}
+
+// Measure `text` the way `alia_msdf_measure_text_width` used to.
+float
+reference_measure_text_width(
+    map_font const& font, char const* text, size_t length, float font_size)
+{
+    float width = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        char const c = text[i];
+        float const advance = font.glyphs.at(static_cast<int>(c)).advance;
+        if (i + 1 < length)
+            width += (advance + font.get_kerning(c, text[i + 1])) * font_size;
+        else
+            width += advance * font_size;
+    }
+    return width;
+}
+
+float const font_size = 16.f;
+
+struct text_scene
+{
+    std::vector<alia_msdf_glyph> glyphs = make_glyphs();
+    std::vector<alia_msdf_kerning_pair> kerning = make_kerning_pairs();
+    std::string prose = make_prose();
+    // the offsets of the paragraphs within `prose` (plus the end)
+    std::vector<size_t> paragraphs;
+    alia_msdf_text_engine* engine = nullptr;
+    alia_ui_system* ui = nullptr;
+    alia_resolved_typeface typeface;
+    map_font reference;
+
+    text_scene()
+    {
+        alia_msdf_font_description const description
+            = {.metrics
+               = {.em_size = 1.f,
+                  .line_height = 1.2f,
+                  .ascender = 0.9f,
+                  .descender = -0.25f,
+                  .underline_y = -0.1f,
+                  .underline_thickness = 0.05f,
+                  .cap_height = 0.7f},
+               .atlas
+               = {.distance_range = 4.f,
+                  .distance_range_middle = 0.f,
+                  .font_size = 32.f,
+                  .width = 512.f,
+                  .height = 256.f},
+               .glyphs = glyphs.data(),
+               .glyph_count = glyphs.size(),
+               .kerning_pairs = kerning.data(),
+               .kerning_pair_count = kerning.size()};
+        engine = alia_msdf_create_text_engine(&description, 1);
+
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = [](void*, alia_context*) {}}, {1000, 1000});
+        typeface = alia_typeface_resolve(
+            ui, alia_msdf_register_typeface(ui, engine, 0));
+
+        for (auto const& glyph : glyphs)
+            reference.glyphs[int(glyph.unicode)] = glyph;
+        for (auto const& pair : kerning)
+            reference.kerning[{pair.left, pair.right}] = pair.adjustment;
+
+        paragraphs.push_back(0);
+        for (size_t i = 0; i != prose.size(); ++i)
+        {
+            if (prose[i] == '\n')
+                paragraphs.push_back(i + 1);
+        }
+    }
+
+    ~text_scene()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+        alia_msdf_destroy_text_engine(engine);
+    }
+
+    // Prepare the whole text as one block and return its total width.
+    float
+    prepare_block() const
+    {
+        alia_text_engine* e = typeface.engine;
+        alia_text_block* block = e->vtable->prepare_block(
+            e,
+            typeface.engine_handle,
+            font_size,
+            ALIA_TEXT_DIRECTION_LTR,
+            prose.data(),
+            prose.size());
+        float total = 0;
+        int const count = e->vtable->segment_count(e, block);
+        for (int i = 0; i != count; ++i)
+        {
+            alia_text_segment segment;
+            e->vtable->segment_info(e, block, i, &segment);
+            total += segment.advance_width;
+        }
+        e->vtable->release_block(e, block);
+        return total;
+    }
+
+    // Measure each paragraph (without its newline) with `measure`.
+    template<class Measure>
+    float
+    measure_paragraphs(Measure const& measure) const
+    {
+        float total = 0;
+        for (size_t p = 0; p + 1 < paragraphs.size(); ++p)
+        {
+            total += measure(
+                prose.data() + paragraphs[p],
+                paragraphs[p + 1] - paragraphs[p] - 1);
+        }
+        return total;
+    }
+
+    // Break the text into lines at `width` and return the line count.
+    size_t
+    break_lines(float width) const
+    {
+        size_t lines = 0;
+        size_t position = 0;
+        while (position < prose.size())
+        {
+            alia_msdf_break_result const result = alia_msdf_break_text(
+                engine,
+                0,
+                prose.data(),
+                position,
+                prose.size(),
+                prose.size(),
+                font_size,
+                width,
+                true);
+            position = result.next;
+            ++lines;
+        }
+        return lines;
+    }
+};
+
+} // namespace
+
+int
+main()
+{
+    ankerl::nanobench::Bench suite = make_bench();
+    if (!benchmark_smoke_mode())
+        suite.minEpochIterations(10);
+
+    text_scene scene;
+    std::cerr << "prose: " << scene.prose.size() << " bytes, "
+              << scene.paragraphs.size() - 1 << " paragraphs\n";
+    suite.unit("byte").batch(scene.prose.size());
+
+    // (The results are checked below, so they don't need to be passed to
+    // doNotOptimizeAway.)
+    float prepared = 0;
+    suite.run("1MB/prepare_block", [&] {
+        prepared = scene.prepare_block();
+    });
+
+    float reference_prepared = 0;
+    suite.run("1MB/reference_prepare_block", [&] {
+        reference_prepared
+            = reference_prepare_block(scene.reference, scene.prose, font_size);
+    });
+
+    float measured = 0;
+    suite.run("1MB/measure_text_width", [&] {
+        measured = scene.measure_paragraphs(
+            [&](char const* text, size_t length) {
+                return alia_msdf_measure_text_width(
+                    scene.engine, 0, text, length, font_size);
+            });
+    });
+
+    float reference_measured = 0;
+    suite.run("1MB/reference_measure_text_width", [&] {
+        reference_measured = scene.measure_paragraphs(
+            [&](char const* text, size_t length) {
+                return reference_measure_text_width(
+                    scene.reference, text, length, font_size);
+            });
+    });
+
+    suite.run("1MB/break_text", [&] {
+        ankerl::nanobench::doNotOptimizeAway(scene.break_lines(500.f));
+    });
+
+    ankerl::nanobench::render(
+        ankerl::nanobench::templates::csv(), suite, std::cout);
+    if (!benchmark_smoke_mode())
+    {
+        std::ofstream json_out("text_measure_benchmark_results.json");
+        suite.render(ankerl::nanobench::templates::json(), json_out);
+    }
+
+    // The engine's tables must give the same measurements as the maps.
+    if (prepared != reference_prepared || measured != reference_measured)
+    {
+        std::cerr << "measurement mismatch: prepare_block " << prepared
+                  << " vs " << reference_prepared << ", measure_text_width "
+                  << measured << " vs " << reference_measured << "\n";
+        return 1;
+    }
+    return 0;
+}
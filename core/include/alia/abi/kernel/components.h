@@ -0,0 +1,96 @@
+#ifndef ALIA_ABI_KERNEL_COMPONENTS_H
+#define ALIA_ABI_KERNEL_COMPONENTS_H
+
+#include <alia/abi/context.h>
+#include <alia/abi/kernel/ids.h>
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/prelude.h>
+
+// SKIPPABLE COMPONENTS
+//
+// A skippable component is a region of the controller whose output is fully
+// determined by a 'value ID' that the caller supplies (plus any state stored
+// within the component itself). On refresh passes, if the value ID matches
+// the one from the component's last refresh and nothing inside the component
+// has been marked dirty (or animating) since then, the component's content
+// is skipped entirely: its substrate block isn't entered and the layout nodes
+// that it emitted last time are spliced back into the layout tree.
+//
+// Usage:
+//
+//   if (alia_component_begin(ctx, value_id))
+//   {
+//       ... content ...
+//   }
+//   alia_component_end(ctx);
+//
+// `alia_component_end` must be called whether or not the content ran.
+//
+// The content runs normally on non-refresh passes (since those consume
+// layout placements and may deliver events to the content), with one
+// exception: Targeted events whose target element has a route (i.e., was
+// created inside a component) only visit the components on the path to
+// that element. Any other component steps over its content, as long as it
+// knows (from its last full pass) which layout placements the content
+// consumes.
+//
+// Notes:
+// - A null value ID means that the component can never be skipped. Use the
+//   unit ID for a component whose content doesn't depend on external inputs.
+// - Apart from the geometry scale, ambient state (active styles, the active
+//   font, etc.) is assumed to be stable for a given value ID. If that isn't
+//   the case, fold it into the ID.
+// - Layout nodes emitted inside a skippable component persist across
+//   refreshes, so they must only reference persistent data (e.g., data in
+//   the substrate).
+
+ALIA_EXTERN_C_BEGIN
+
+typedef struct alia_component alia_component;
+
+// Begin a skippable component.
+// Returns true iff the content of the component should be executed.
+bool
+alia_component_begin(alia_context* ctx, alia_id_view value_id);
+
+// End the current skippable component.
+void
+alia_component_end(alia_context* ctx);
+
+// Mark the active component (and its ancestors) as dirty so that it's
+// refreshed (rather than skipped) on the next refresh pass. This also marks
+// the UI system as dirty.
+void
+alia_component_mark_dirty(alia_context* ctx);
+
+// Mark the active component (and its ancestors) as animating.
+// Animating components are never skipped.
+void
+alia_component_mark_animating(alia_context* ctx);
+
+// Opt the active component into retained drawing. This must be called on
+// every refresh of the content (e.g., right after `alia_component_begin`).
+//
+// A component that retains its drawing records the draw commands that its
+// content produces. On later draw passes, as long as the component hasn't been
+// refreshed, dirtied or animated since, and the placements, geometry, styles,
+// palette and interaction state (hot/focused element, etc.) that it was drawn
+// with are unchanged, the content isn't run. Its recorded commands are
+// spliced back into the draw buckets instead.
+//
+// Drawing that depends on anything else (e.g., the current time) must mark
+// the component as animating. Content that draws into other draw targets or
+// pushes its own clip regions is always redrawn.
+void
+alia_component_retain_draw(alia_context* ctx);
+
+// Get an element ID that identifies the active component.
+// Targeted events dispatched with this ID are routed directly through the
+// component's ancestors, and they're dropped if the component no longer
+// exists. If there's no active component, this returns a null ID.
+alia_element_id
+alia_component_id(alia_context* ctx);
+
+ALIA_EXTERN_C_END
+
+#endif // ALIA_ABI_KERNEL_COMPONENTS_H
@@ -23,7 +23,10 @@ static inline alia_element_id
 alia_offset_id(alia_element_id main_id, uint8_t index)
 {
     return ALIA_BRACED_INIT(
-        alia_element_id, (uint8_t*) main_id.ptr + index, main_id.generation);
+        alia_element_id,
+        (uint8_t*) main_id.ptr + index,
+        main_id.generation,
+        main_id.route);
 }
 
 static inline bool
@@ -41,11 +44,23 @@ alia_element_id_equal(alia_element_id a, alia_element_id b)
 
 ALIA_DEFINE_EQUALITY_OPERATOR(alia_element_id);
 
+// Get the route node ID of the innermost skippable component that's active
+// in `ctx` (or 0 if there isn't one).
+//
+// Targeted events for elements with a route node ID only visit the
+// components on the path to that node (see alia/abi/kernel/components.h).
+//
+alia_route_node_id
+alia_active_route_node(alia_context* ctx);
+
 static inline alia_element_id
 alia_make_element_id(alia_context* ctx, alia_substrate_usage_result result)
 {
-    // TODO: Get the route node ID from the context.
-    return ALIA_BRACED_INIT(alia_element_id, result.ptr, result.generation, 0);
+    return ALIA_BRACED_INIT(
+        alia_element_id,
+        result.ptr,
+        result.generation,
+        alia_active_route_node(ctx));
 }
 
 ALIA_EXTERN_C_END
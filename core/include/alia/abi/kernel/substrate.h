@@ -199,7 +199,8 @@ alia_substrate_path_for_object(alia_context* ctx, void* object);
 // that uses keyed blocks should call `begin_key_scope` / `end_key_scope`
 // around the keyed blocks.
 //
-// Garbage collection is explicit via `sweep_table_keys` / `sweep_system_keys`.
+// Garbage collection is explicit via `sweep_table_keys` / `sweep_system_keys`
+// (or incrementally via `sweep_system_keys_incrementally`).
 // By default, sweeping collects all blocks that haven't been seen in the
 // most recent pass through the key table.
 // This can be overridden by setting the `requires_explicit_delete` flag on the
@@ -253,9 +254,60 @@ alia_substrate_sweep_table_keys(
     alia_context* ctx, alia_substrate_key_table* table);
 
 // Remove stale entries from all key tables in the substrate system.
+// This also finishes (and resets) any incremental sweep that's in progress.
 void
 alia_substrate_sweep_system_keys(alia_substrate_system* system);
 
+// INCREMENTAL SWEEPING
+//
+// Sweeping a large key table (or freeing the blocks of a large number of
+// stale entries) all at once can take a noticeable amount of time. The
+// incremental sweep spreads that work out across calls: each call does a
+// bounded amount of work and resumes where the previous one left off.
+//
+// A sweep 'cycle' visits every key table in the system once. Stale entries
+// are removed from their table as soon as they're found, but the blocks
+// attached to them are freed lazily (within the budget of the same call or a
+// later one).
+//
+// Entries that go stale after the cycle has already passed their slot are
+// picked up in the next cycle.
+
+typedef struct alia_substrate_sweep_budget
+{
+    // the maximum number of units of work to do in this call (0 for no limit)
+    // Examining a key table slot and freeing a stale entry each count as one
+    // unit.
+    size_t max_work;
+    // an absolute deadline for this call, in nanoseconds on the steady clock
+    // (the same time base as the UI system's tick count), or 0 for none
+    alia_nanosecond_count deadline;
+} alia_substrate_sweep_budget;
+
+typedef struct alia_substrate_sweep_progress
+{
+    // the number of units of work done during this call
+    size_t work_done;
+    // the number of key table slots that the current cycle has yet to examine
+    size_t pending_slots;
+    // the number of stale entries whose blocks are waiting to be freed
+    size_t pending_frees;
+} alia_substrate_sweep_progress;
+
+// Is there any sweeping work left?
+// If this returns false, the last sweep cycle has finished and the next call
+// to `sweep_system_keys_incrementally` will start a new one.
+static inline bool
+alia_substrate_sweep_is_pending(alia_substrate_sweep_progress progress)
+{
+    return progress.pending_slots != 0 || progress.pending_frees != 0;
+}
+
+// Do a budgeted amount of sweeping work across all key tables in the system.
+alia_substrate_sweep_progress
+alia_substrate_sweep_system_keys_incrementally(
+    alia_substrate_system* system, alia_substrate_sweep_budget budget);
+
 // Mark a key for deletion when it becomes stale.
 // TODO: Add a scope-based version of this?
 void
@@ -64,6 +64,23 @@ alia_draw_command_alloc_aligned(
     size_t size,
     size_t alignment);
 
+// Note that the content is drawing within `box` (in the current frame of
+// reference).
+// Damage tracking attributes the commands that a retained component draws
+// to the boxes that its content consumes from the layout. Content that
+// draws outside of those (e.g., shadows) or that reads its placement
+// directly from the placement arena should call this to cover the rest.
+void
+alia_draw_note_bounds(alia_context* ctx, alia_box box);
+
+// Note that the content's drawing within `box` (in the current frame of
+// reference) depends on state that its draw commands don't capture (e.g., a
+// viewport onto an external scene).
+// Damage tracking can't tell when such drawing changes, so it damages the
+// region on every pass (even when a retaining component replays it).
+void
+alia_draw_note_volatile(alia_context* ctx, alia_box box);
+
 ALIA_EXTERN_C_END
 
 #endif /* ALIA_ABI_UI_DRAWING_COMMANDS_H */
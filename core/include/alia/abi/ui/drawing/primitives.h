@@ -17,6 +17,8 @@ enum
     ALIA_PRIMITIVE_EQUILATERAL_TRIANGLE = 1,
     ALIA_PRIMITIVE_SQUIRCLE = 2,
     ALIA_PRIMITIVE_MSDF_GLYPH = 3,
+    // a run of MSDF glyphs (see `alia_draw_msdf_glyph_run_command`)
+    ALIA_PRIMITIVE_MSDF_GLYPH_RUN = 4,
 };
 
 typedef struct alia_draw_box_payload
@@ -64,6 +66,87 @@ typedef struct alia_draw_primitive_command
     alia_primitive_payload payload;
 } alia_draw_primitive_command;
 
+// GLYPH RUNS
+//
+// A glyph run draws a line of MSDF glyphs that share a baseline, color and
+// scale as a single command. Rather than a full primitive per glyph, it
+// stores a glyph index and pen offset per glyph. The glyphs' quads and atlas
+// rects live in a table that's owned by the text engine (and that outlives
+// the command), so renderers can expand each entry into a glyph instance when
+// they upload the bucket.
+//
+// Glyph runs are recorded with the primitive material. `primitive_type` is at
+// the same offset as in `alia_draw_primitive_command`, so the material can
+// check it before deciding how to read a command.
+
+// the data that renderers need to draw a glyph
+typedef struct alia_msdf_glyph_metrics
+{
+    // the glyph's quad, relative to the pen position on the baseline (in em
+    // units, with y up)
+    float plane_left, plane_bottom, plane_right, plane_top;
+    // the glyph's rect within the atlas (as in `alia_draw_msdf_glyph_payload`)
+    float uv_rect[4];
+} alia_msdf_glyph_metrics;
+
+typedef struct alia_msdf_glyph_run_entry
+{
+    // the glyph's index within the run's glyph table
+    uint32_t glyph;
+    // the pen position of the glyph, relative to the run's origin
+    float x;
+} alia_msdf_glyph_run_entry;
+
+// `count` entries follow the command (see `alia_msdf_glyph_run_entries`).
+typedef struct alia_draw_msdf_glyph_run_command
+{
+    alia_draw_command base;
+    // the bounds of all the glyphs' quads
+    alia_box box;
+    // always ALIA_PRIMITIVE_MSDF_GLYPH_RUN
+    alia_primitive_type primitive_type;
+    alia_srgba8 color;
+    // the pen position on the baseline at the start of the run
+    alia_vec2f origin;
+    // the scale from em units to pixels
+    float scale;
+    // as in `alia_draw_msdf_glyph_payload`
+    float sdf_scale;
+    alia_msdf_glyph_metrics const* glyphs;
+    uint32_t count;
+} alia_draw_msdf_glyph_run_command;
+
+// Get the size of a glyph run command with `count` entries.
+static inline size_t
+alia_msdf_glyph_run_size(uint32_t count)
+{
+    return ALIA_MIN_ALIGNED_SIZE(
+        sizeof(alia_draw_msdf_glyph_run_command)
+        + count * sizeof(alia_msdf_glyph_run_entry));
+}
+
+// Get the entries of a glyph run command.
+static inline alia_msdf_glyph_run_entry*
+alia_msdf_glyph_run_entries(alia_draw_msdf_glyph_run_command const* run)
+{
+    return (alia_msdf_glyph_run_entry*) (run + 1);
+}
+
+// Get the box covered by the quad of `entry` (one of `run`'s entries).
+static inline alia_box
+alia_msdf_glyph_run_entry_box(
+    alia_draw_msdf_glyph_run_command const* run,
+    alia_msdf_glyph_run_entry entry)
+{
+    alia_msdf_glyph_metrics const* glyph = &run->glyphs[entry.glyph];
+    alia_box box;
+    box.min.x = run->origin.x + entry.x + glyph->plane_left * run->scale;
+    box.min.y = run->origin.y - glyph->plane_top * run->scale;
+    box.size.x = (glyph->plane_right - glyph->plane_left) * run->scale;
+    box.size.y = (glyph->plane_top - glyph->plane_bottom) * run->scale;
+    return box;
+}
+
 // TODO: Revisit this structure breakdown.
 typedef struct alia_box_paint
 {
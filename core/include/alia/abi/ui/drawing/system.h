@@ -40,6 +40,52 @@ alia_material_register(
     alia_material_vtable vtable,
     void* user);
 
+// counters for the draw commands that draw passes have produced
+typedef struct alia_draw_stats
+{
+    // commands that were replayed from retained recordings (without running
+    // the code that drew them)
+    uint64_t commands_replayed;
+    // commands that were recorded by running the controller
+    uint64_t commands_recorded;
+} alia_draw_stats;
+
+// Get the draw stats accumulated since the system was created (or since the
+// last call to `alia_ui_reset_draw_stats`).
+alia_draw_stats
+alia_ui_get_draw_stats(alia_ui_system* system);
+
+void
+alia_ui_reset_draw_stats(alia_ui_system* system);
+
+// the maximum number of rectangles in a draw pass's damage
+enum
+{
+    ALIA_MAX_DRAW_DAMAGE_RECTS = 8,
+};
+
+// the parts of the primary surface that a draw pass changed
+//
+// Damage is only tracked if the renderer implements
+// `draw_pass_set_damage`. Otherwise, every pass reports full damage.
+//
+typedef struct alia_draw_damage
+{
+    // If this is set, the whole surface must be redrawn and `rects` is empty.
+    bool full;
+    // the damaged regions, in surface pixels - These are rounded out to whole
+    // pixels and clipped to the surface. They don't overlap, but there may be
+    // none at all (if nothing changed).
+    uint32_t count;
+    alia_box rects[ALIA_MAX_DRAW_DAMAGE_RECTS];
+} alia_draw_damage;
+
+// Get the damage from the last draw pass.
+// This is intended for hosts that can present partial updates (e.g., via
+// buffer age or swap-with-damage extensions).
+alia_draw_damage const*
+alia_ui_get_draw_damage(alia_ui_system* system);
+
 // Execute a draw pass.
 // This invokes the UI controller to record draw commands, then invokes the
 // associated material vtables to execute the draw commands in the appropriate
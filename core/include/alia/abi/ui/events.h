@@ -105,7 +105,14 @@ enum
       alia_mouse_notification)                                                \
     X(0x77, INPUT, TARGETED, CURSOR_QUERY, cursor_query, alia_cursor_query)   \
     /* scroll */                                                              \
-    X(0x80, INPUT, TARGETED, SCROLL_INPUT, scroll_input, alia_scroll_input)
+    X(0x80, INPUT, TARGETED, SCROLL_INPUT, scroll_input, alia_scroll_input)   \
+    /* text */                                                                \
+    X(0x90,                                                                   \
+      INPUT,                                                                  \
+      TARGETED,                                                               \
+      TEXT_BLOCK_READY,                                                       \
+      text_block_ready,                                                       \
+      alia_text_block_ready)
 
 // These are the event-specific data structures that correspond to the event
 // types in the table above...
@@ -246,6 +253,15 @@ typedef struct alia_mouse_notification
     int dummy;
 } alia_mouse_notification;
 
+// A text element's block has finished preparing in the background. `serial`
+// identifies which preparation it was (since the element may have started
+// another one in the meantime).
+typedef struct alia_text_block_ready
+{
+    alia_element_id target;
+    uint64_t serial;
+} alia_text_block_ready;
+
 typedef struct alia_timer
 {
     alia_element_id target;
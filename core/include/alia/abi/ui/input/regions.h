@@ -32,6 +32,19 @@ alia_element_box_region(
     alia_cursor_t cursor,
     alia_hit_test_flags_t flags);
 
+// Declare a region where `id` does its own (custom geometry) hit testing.
+// `bounding_box` is in layout coordinates and must contain every point where
+// the element might report a mouse hit. This should be called on every mouse
+// hit test pass, before any call to `alia_element_report_hit` for the same
+// element. (Undeclared mouse hits are still honored, but they force the system
+// to do a full hit test pass for every pointer movement.)
+void
+alia_element_custom_region(
+    alia_context* ctx,
+    alia_element_id id,
+    alia_box const* bounding_box,
+    alia_cursor_t cursor);
+
 // Report a hit after custom geometry testing. `bounding_box` is in layout
 // coordinates. It will be transformed into surface coordinates and stored in
 // as part of the hit test result.
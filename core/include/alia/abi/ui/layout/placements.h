@@ -0,0 +1,104 @@
+#ifndef ALIA_ABI_UI_LAYOUT_PLACEMENTS_H
+#define ALIA_ABI_UI_LAYOUT_PLACEMENTS_H
+
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/context.h>
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/prelude.h>
+#include <alia/abi/ui/layout/system.h>
+
+// PLACEMENT TABLES
+//
+// Placement data is normally read back by running the controller again, so
+// that each component consumes its boxes in the order that it emitted its
+// nodes. A placement table indexes the boxes of tagged elements by ID instead,
+// so that code outside the controller (e.g., hit testing, accessibility export
+// or debug overlays) can look up any of them directly.
+//
+// Elements are tagged by wrapping their layout in alia_layout_tag_begin/end.
+// Each resolve builds a new table of the tagged elements (including those
+// within subtrees that come out of the layout cache), and the system keeps the
+// table from the resolve before it, so that the two can be diffed.
+
+ALIA_EXTERN_C_BEGIN
+
+// Tag the layout within this scope with `id`. (The tag itself doesn't affect
+// the layout.) Like the other layout wrappers, this should wrap a single
+// node. It must be called on all passes.
+void
+alia_layout_tag_begin(alia_context* ctx, alia_element_id id);
+void
+alia_layout_tag_end(alia_context* ctx);
+
+typedef struct alia_layout_placement_table alia_layout_placement_table;
+
+typedef struct alia_layout_placement
+{
+    alia_element_id id;
+    // the box assigned to the tagged node (or, within a flow, the bounds of
+    // its fragments)
+    alia_box box;
+    // where the tagged node's placement data starts (see
+    // alia_layout_system_placement_data)
+    size_t offset;
+} alia_layout_placement;
+
+// Get the table of the last resolve.
+alia_layout_placement_table const*
+alia_layout_system_placements(alia_layout_system const* system);
+
+// Get the table of the resolve before the last one.
+alia_layout_placement_table const*
+alia_layout_system_previous_placements(alia_layout_system const* system);
+
+// Get the placement data that the last resolve wrote, starting at `offset`.
+void const*
+alia_layout_system_placement_data(
+    alia_layout_system const* system, size_t offset);
+
+// Get the number of tagged elements in a table.
+uint32_t
+alia_layout_placement_table_size(alia_layout_placement_table const* table);
+
+// Get the entries of a table, in placement order.
+alia_layout_placement const*
+alia_layout_placement_table_entries(alia_layout_placement_table const* table);
+
+// Look up the entry for `id` (or return null if it isn't in the table). If an
+// ID was tagged more than once, this finds the first entry.
+alia_layout_placement const*
+alia_layout_placement_table_find(
+    alia_layout_placement_table const* table, alia_element_id id);
+
+// DIFFING
+
+typedef uint8_t alia_layout_placement_change_flags;
+#define ALIA_LAYOUT_PLACEMENT_ADDED 0x1
+#define ALIA_LAYOUT_PLACEMENT_REMOVED 0x2
+#define ALIA_LAYOUT_PLACEMENT_MOVED 0x4
+#define ALIA_LAYOUT_PLACEMENT_RESIZED 0x8
+
+typedef struct alia_layout_placement_change
+{
+    alia_element_id id;
+    alia_layout_placement_change_flags flags;
+    // the element's box in each table (or zero if it isn't in that table)
+    alia_box before;
+    alia_box after;
+} alia_layout_placement_change;
+
+// Report each element whose placement differs between two tables: first the
+// ones in `after` that were added, moved and/or resized (in `after` order),
+// then the ones that were removed (in `before` order). `report` may be null.
+// This returns the number of changes.
+uint32_t
+alia_layout_placement_table_diff(
+    alia_layout_placement_table const* before,
+    alia_layout_placement_table const* after,
+    void (*report)(
+        void* user_data, alia_layout_placement_change const* change),
+    void* user_data);
+
+ALIA_EXTERN_C_END
+
+#endif // ALIA_ABI_UI_LAYOUT_PLACEMENTS_H
@@ -0,0 +1,119 @@
+#ifndef ALIA_ABI_UI_LAYOUT_PROFILE_H
+#define ALIA_ABI_UI_LAYOUT_PROFILE_H
+
+#include <alia/abi/prelude.h>
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/system.h>
+
+// LAYOUT PROFILING
+//
+// If alia is built with ALIA_ENABLE_LAYOUT_PROFILING (which defines
+// ALIA_LAYOUT_PROFILING), each resolve records where its time goes: how long
+// each pass takes, how often each type of node is called through the protocol
+// functions (and for how long), and how much scratch and placement memory the
+// resolve uses. Otherwise, none of this is compiled in, and
+// alia_layout_system_profile always returns null.
+//
+// Only calls that go through the dispatch functions in
+// alia/abi/ui/layout/utilities/dispatch.h are recorded. (In compact storage
+// mode, rows, columns and leaves are laid out without them, and the passes
+// aren't timed separately.)
+
+ALIA_EXTERN_C_BEGIN
+
+// the passes of a resolve
+#define ALIA_LAYOUT_PROFILE_HORIZONTAL 0
+#define ALIA_LAYOUT_PROFILE_VERTICAL 1
+#define ALIA_LAYOUT_PROFILE_ASSIGNMENT 2
+#define ALIA_LAYOUT_PROFILE_PHASE_COUNT 3
+
+// the protocol functions
+#define ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL 0
+#define ALIA_LAYOUT_PROFILE_MEASURE_VERTICAL 1
+#define ALIA_LAYOUT_PROFILE_ASSIGN_BOXES 2
+#define ALIA_LAYOUT_PROFILE_COUNT_FLOW_EMISSIONS 3
+#define ALIA_LAYOUT_PROFILE_EMIT_FLOW_FRAGMENTS 4
+#define ALIA_LAYOUT_PROFILE_READ_FRAGMENT_PLACEMENTS 5
+#define ALIA_LAYOUT_PROFILE_CALL_COUNT 6
+
+// Node types beyond this many aren't broken down.
+#define ALIA_LAYOUT_PROFILE_MAX_NODE_TYPES 32
+
+typedef struct alia_layout_profile_calls
+{
+    uint64_t count;
+    // the total time spent in the calls (When nodes of the same type are
+    // nested, this counts the time of the inner ones again.)
+    uint64_t nanoseconds;
+    // the time spent in the calls themselves (i.e., excluding the protocol
+    // calls that they make in turn)
+    uint64_t self_nanoseconds;
+} alia_layout_profile_calls;
+
+typedef struct alia_layout_profile_node_type
+{
+    alia_layout_node_vtable const* vtable;
+    // indexed by ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL, etc.
+    alia_layout_profile_calls calls[ALIA_LAYOUT_PROFILE_CALL_COUNT];
+} alia_layout_profile_node_type;
+
+typedef struct alia_layout_profile
+{
+    // the wall time of the whole resolve
+    uint64_t total_nanoseconds;
+    // the wall time of each pass (indexed by ALIA_LAYOUT_PROFILE_HORIZONTAL,
+    // etc.)
+    uint64_t phase_nanoseconds[ALIA_LAYOUT_PROFILE_PHASE_COUNT];
+    // the number of times that the passes visited a node (i.e., the number
+    // of calls to measure or assign boxes)
+    uint64_t nodes_visited;
+    // the peak scratch usage on the thread that resolved the layout
+    size_t scratch_peak_bytes;
+    // the size of the placement data that the resolve wrote
+    size_t placement_bytes;
+    // the calls to each type of node, in the order that the types were first
+    // seen - In parallel resolves, this includes the calls made on the worker
+    // threads, so the times can add up to more than the wall time.
+    uint32_t node_type_count;
+    alia_layout_profile_node_type
+        node_types[ALIA_LAYOUT_PROFILE_MAX_NODE_TYPES];
+    // the number of calls to node types that didn't fit in `node_types`
+    uint64_t untracked_calls;
+} alia_layout_profile;
+
+// Get the profile of the last resolve, or null if profiling isn't compiled
+// in. (The profile is overwritten by each resolve.)
+alia_layout_profile const*
+alia_layout_system_profile(alia_layout_system const* system);
+
+#ifdef ALIA_LAYOUT_PROFILING
+
+// These record the protocol calls that the dispatch functions make.
+// (`alia_layout_profile_enter` returns the start time of the call.)
+
+uint64_t
+alia_layout_profile_enter(void);
+
+void
+alia_layout_profile_exit(
+    alia_layout_node_vtable const* vtable, int call, uint64_t start);
+
+#define ALIA_LAYOUT_PROFILE_BEGIN_CALL()                                      \
+    uint64_t const alia_layout_profile_start_ = alia_layout_profile_enter()
+
+#define ALIA_LAYOUT_PROFILE_END_CALL(node, call)                              \
+    alia_layout_profile_exit(                                                 \
+        (node)->vtable,                                                       \
+        ALIA_LAYOUT_PROFILE_##call,                                           \
+        alia_layout_profile_start_)
+
+#else
+
+#define ALIA_LAYOUT_PROFILE_BEGIN_CALL()
+#define ALIA_LAYOUT_PROFILE_END_CALL(node, call)
+
+#endif
+
+ALIA_EXTERN_C_END
+
+#endif // ALIA_ABI_UI_LAYOUT_PROFILE_H
@@ -17,6 +17,15 @@
 // pass is required to walk the tree in the same order as the previous pass.
 // (i.e., Individual nodes must (re-)allocate the same data every pass, in the
 // same order, and they must recursively visit each child in the same order.)
+//
+// Results are cached across resolutions for nodes that carry a content hash
+// (and whose type opts into caching). A node that hits the cache doesn't
+// visit its descendants at all, so the passes only walk the paths through the
+// tree that actually changed. See `alia/ui/layout/cache.h` for details.
+// (Only containers opt into caching.)
+//
+// Measurement can also be parallelized across large subtrees. See
+// `alia/ui/layout/parallel.h` for how this preserves the protocol above.
 
 ALIA_EXTERN_C_BEGIN
 
@@ -26,6 +35,14 @@ typedef struct alia_layout_node
 {
     alia_layout_node_vtable* vtable;
     struct alia_layout_node* next_sibling;
+    // a hash of everything that the layout of this node and its descendants
+    // depends on, or 0 if the node can't provide one (in which case neither
+    // can its ancestors)
+    //
+    // A node may only provide a hash if its layout is a pure function of its
+    // content, its scratch data doesn't contain pointers and isn't modified
+    // while assigning boxes, and the same holds for all its descendants.
+    uint64_t content_hash;
 } alia_layout_node;
 
 typedef struct alia_horizontal_requirements
@@ -42,15 +59,42 @@ typedef struct alia_vertical_requirements
     float descent;
 } alia_vertical_requirements;
 
+typedef struct alia_layout_cache alia_layout_cache;
+
+typedef struct alia_layout_fork_context alia_layout_fork_context;
+
+typedef struct alia_layout_placement_table alia_layout_placement_table;
+
 typedef struct alia_placement_context
 {
     alia_bump_allocator scratch;
     alia_bump_allocator arena;
+    // the cache to consult for nodes with content hashes (or null to lay
+    // everything out directly)
+    alia_layout_cache* cache;
+    // the cache to consult for the line breaks of flows (or null to break
+    // lines directly) - Unlike `cache`, this stays set while cached subtrees
+    // are laid out outside the regular passes.
+    alia_layout_cache* line_breaks;
+    // the state of the parallel resolve (or null if the resolve is serial)
+    alia_layout_fork_context* parallel;
+    // the table to record tagged nodes in (or null if they aren't recorded)
+    // - See alia/abi/ui/layout/placements.h.
+    alia_layout_placement_table* placements;
 } alia_placement_context;
 
 typedef struct alia_measurement_context
 {
     alia_bump_allocator scratch;
+    // the cache to consult for nodes with content hashes (or null to measure
+    // everything directly)
+    alia_layout_cache* cache;
+    // the cache to consult for the line breaks of flows (or null to break
+    // lines directly) - Unlike `cache`, this stays set while cached subtrees
+    // are laid out outside the regular passes.
+    alia_layout_cache* line_breaks;
+    // the state of the parallel resolve (or null if the resolve is serial)
+    alia_layout_fork_context* parallel;
 } alia_measurement_context;
 
 typedef struct alia_line_requirements
@@ -243,6 +287,14 @@ typedef struct alia_layout_node_vtable
         alia_layout_node* node,
         alia_flow_fragment_reader* reader);
 
+    // Should the results for nodes of this type be cached? (This only
+    // applies to nodes with content hashes.) It's worthwhile for containers
+    // but not for nodes that are cheaper to lay out than to look up.
+    bool cache_results;
+
+    // the name of this type of node, for diagnostics like profiling (or null)
+    char const* name;
+
 } alia_layout_node_vtable;
 
 ALIA_EXTERN_C_END
@@ -0,0 +1,112 @@
+#ifndef ALIA_ABI_UI_LAYOUT_SNAPSHOT_H
+#define ALIA_ABI_UI_LAYOUT_SNAPSHOT_H
+
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/prelude.h>
+#include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/layout/system.h>
+
+// LAYOUT SNAPSHOTS
+//
+// A snapshot records an emitted layout tree, along with the space that it was
+// resolved within, in a self-contained binary form. Snapshots can be captured
+// from a running app and then replayed offline (e.g., to benchmark the layout
+// of a real app, or to attach to a performance bug report).
+//
+// The core node types (leaves, rows, columns, flows, grids and the wrappers)
+// are recorded with all of their parameters, so they replay exactly. Any other
+// node (e.g., text or a library widget) is recorded as an opaque node: its
+// requirements (measured at its minimum width) and, if it emits its own flow
+// fragments, those fragments. Its descendants aren't recorded. Layout tags
+// (see alia/abi/ui/layout/placements.h) are left out.
+//
+// FORMAT
+//
+// All values are little-endian. Floats are IEEE 754 singles.
+//
+// header:
+//   u32 magic (ALIA_LAYOUT_SNAPSHOT_MAGIC)
+//   u32 version (ALIA_LAYOUT_SNAPSHOT_VERSION)
+//   f32 available width, f32 available height
+//
+// This is followed by the top-level nodes of the tree, in order, and then an
+// END record. Each node is a u8 kind followed by its parameters. Containers
+// are followed by their children and then an END record.
+//
+//   LEAF: u32 flags, f32 spacing, f32 width, height, ascent, descent
+//   COLUMN, ROW: u32 flags, f32 gap
+//   FLOW, BLOCK_FLOW: u32 flags, f32 gap, line_gap, minimum_line_height
+//   GRID: u32 flags
+//   GRID_ROW: u32 flags (only directly within a GRID)
+//   EDGE_OFFSETS: u32 flags, f32 left, right, top, bottom
+//   ALIGNMENT_OVERRIDE: u32 flags
+//   GROWTH_OVERRIDE: f32 growth
+//   MIN_SIZE: f32 width, height
+//   FLOW_SPRING: f32 min_width
+//   OPAQUE:
+//     u8 hashed (whether the node had a content hash)
+//     f32 horizontal min_size, growth_factor
+//     f32 vertical min_size, growth_factor, ascent, descent
+//     u32 fragment count (0 if the node uses the default fragment)
+//     fragments: u16 flags, u8 kind, f32 x4 payload (by kind: CONTENT is
+//       width, height, ascent, descent; GAP is gap; CONTEXT_PUSH/POP are
+//       line_gap, minimum_line_height; RUN_PUSH/POP are left, right, top,
+//       bottom; unused values are 0)
+
+ALIA_EXTERN_C_BEGIN
+
+#define ALIA_LAYOUT_SNAPSHOT_MAGIC 0x4E534C41u // "ALSN"
+#define ALIA_LAYOUT_SNAPSHOT_VERSION 1u
+
+// record kinds
+#define ALIA_LAYOUT_SNAPSHOT_END 0
+#define ALIA_LAYOUT_SNAPSHOT_LEAF 1
+#define ALIA_LAYOUT_SNAPSHOT_COLUMN 2
+#define ALIA_LAYOUT_SNAPSHOT_ROW 3
+#define ALIA_LAYOUT_SNAPSHOT_FLOW 4
+#define ALIA_LAYOUT_SNAPSHOT_BLOCK_FLOW 5
+#define ALIA_LAYOUT_SNAPSHOT_GRID 6
+#define ALIA_LAYOUT_SNAPSHOT_GRID_ROW 7
+#define ALIA_LAYOUT_SNAPSHOT_EDGE_OFFSETS 8
+#define ALIA_LAYOUT_SNAPSHOT_ALIGNMENT_OVERRIDE 9
+#define ALIA_LAYOUT_SNAPSHOT_GROWTH_OVERRIDE 10
+#define ALIA_LAYOUT_SNAPSHOT_MIN_SIZE 11
+#define ALIA_LAYOUT_SNAPSHOT_FLOW_SPRING 12
+#define ALIA_LAYOUT_SNAPSHOT_OPAQUE 13
+
+// receives the bytes of a snapshot (which are written in several pieces)
+typedef struct alia_layout_snapshot_writer
+{
+    void (*write)(void* user_data, void const* data, size_t size);
+    void* user_data;
+} alia_layout_snapshot_writer;
+
+// Write a snapshot of the system's current layout tree, as it would be
+// resolved within `available_space`.
+void
+alia_layout_system_write_snapshot(
+    alia_layout_system* system,
+    alia_vec2f available_space,
+    alia_layout_snapshot_writer writer);
+
+// Capture a snapshot of the tree (and the space) that the system's next
+// resolve lays out. This only applies to that one resolve.
+void
+alia_layout_system_capture_next_resolve(
+    alia_layout_system* system, alia_layout_snapshot_writer writer);
+
+// Check that `data` holds a well-formed snapshot. If it does, this returns
+// true and sets `*available_space` to the space that it was resolved within.
+bool
+alia_layout_snapshot_read(
+    void const* data, size_t size, alia_vec2f* available_space);
+
+// Emit the layout tree recorded in a snapshot. This must be called on refresh
+// passes (and ONLY on refresh passes). It emits nothing (and returns false)
+// if the snapshot isn't well-formed.
+bool
+alia_layout_snapshot_emit(alia_context* ctx, void const* data, size_t size);
+
+ALIA_EXTERN_C_END
+
+#endif // ALIA_ABI_UI_LAYOUT_SNAPSHOT_H
@@ -11,6 +11,41 @@ typedef struct alia_layout_system alia_layout_system;
 void
 alia_layout_system_init(alia_layout_system* system);
 
+// Release all memory owned by the layout system.
+void
+alia_layout_system_destroy(alia_layout_system* system);
+
+typedef struct alia_layout_parallelism
+{
+    // the number of threads to measure the layout with (including the one
+    // that resolves it) - 0 or 1 makes resolves serial.
+    uint32_t thread_count;
+    // the minimum number of nodes in a subtree for it to be split across
+    // threads (or 0 for a reasonable default)
+    uint32_t min_fork_size;
+} alia_layout_parallelism;
+
+// Configure how resolves are parallelized. (By default, they're serial.)
+// Parallel resolves produce exactly the same results as serial ones.
+void
+alia_layout_system_set_parallelism(
+    alia_layout_system* system, alia_layout_parallelism parallelism);
+
+// how the layout system stores the layout tree for resolves
+typedef uint8_t alia_layout_storage;
+// Resolves walk the linked node tree. (This is the default.)
+#define ALIA_LAYOUT_STORAGE_LINKED 0
+// The tree is flattened into parallel arrays after each refresh, and resolves
+// sweep over those. This avoids chasing pointers through the node tree (which
+// pays off for large trees), but it doesn't use the layout cache or
+// parallelism, so it's best suited to trees that change on every refresh.
+// Either way, resolves produce exactly the same results.
+#define ALIA_LAYOUT_STORAGE_COMPACT 1
+
+void
+alia_layout_system_set_storage(
+    alia_layout_system* system, alia_layout_storage storage);
+
 void
 alia_layout_system_resolve(
     alia_layout_system* system, alia_vec2f available_space);
@@ -2,14 +2,51 @@
 #define ALIA_ABI_UI_LAYOUT_UTILITIES_DISPATCH_H
 
 #include <alia/abi/prelude.h>
+#include <alia/abi/ui/layout/profile.h>
 #include <alia/abi/ui/layout/protocol.h>
 
 ALIA_EXTERN_C_BEGIN
 
+// These implement the protocol functions for nodes that go through the layout
+// cache. (They're only called when the context has a cache and the node has a
+// content hash.)
+
+alia_horizontal_requirements
+alia_cached_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node);
+
+alia_vertical_requirements
+alia_cached_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width);
+
+void
+alia_cached_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline);
+
+static inline bool
+alia_layout_node_is_cached(alia_layout_cache* cache, alia_layout_node* node)
+{
+    return cache && node->content_hash != 0 && node->vtable->cache_results;
+}
+
 static inline alia_horizontal_requirements
 alia_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
 {
-    return node->vtable->measure_horizontal(ctx, node);
+    alia_horizontal_requirements result;
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
+    if (alia_layout_node_is_cached(ctx->cache, node))
+        result = alia_cached_measure_horizontal(ctx, node);
+    else
+        result = node->vtable->measure_horizontal(ctx, node);
+    ALIA_LAYOUT_PROFILE_END_CALL(node, MEASURE_HORIZONTAL);
+    return result;
 }
 
 static inline alia_vertical_requirements
@@ -19,8 +56,20 @@ alia_measure_vertical(
     alia_layout_node* node,
     float assigned_width)
 {
-    return node->vtable->measure_vertical(
-        ctx, main_axis, node, assigned_width);
+    alia_vertical_requirements result;
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
+    if (alia_layout_node_is_cached(ctx->cache, node))
+    {
+        result = alia_cached_measure_vertical(
+            ctx, main_axis, node, assigned_width);
+    }
+    else
+    {
+        result = node->vtable->measure_vertical(
+            ctx, main_axis, node, assigned_width);
+    }
+    ALIA_LAYOUT_PROFILE_END_CALL(node, MEASURE_VERTICAL);
+    return result;
 }
 
 static inline void
@@ -31,7 +80,12 @@ alia_assign_boxes(
     alia_box box,
     float baseline)
 {
-    node->vtable->assign_boxes(ctx, main_axis, node, box, baseline);
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
+    if (alia_layout_node_is_cached(ctx->cache, node))
+        alia_cached_assign_boxes(ctx, main_axis, node, box, baseline);
+    else
+        node->vtable->assign_boxes(ctx, main_axis, node, box, baseline);
+    ALIA_LAYOUT_PROFILE_END_CALL(node, ASSIGN_BOXES);
 }
 
 static inline alia_flow_emission_counts
@@ -47,7 +101,11 @@ static inline alia_flow_emission_counts
 alia_count_flow_emissions(
     alia_measurement_context* ctx, alia_layout_node* node)
 {
-    return node->vtable->count_flow_emissions(ctx, node);
+    alia_flow_emission_counts result;
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
+    result = node->vtable->count_flow_emissions(ctx, node);
+    ALIA_LAYOUT_PROFILE_END_CALL(node, COUNT_FLOW_EMISSIONS);
+    return result;
 }
 
 static inline void
@@ -56,7 +114,9 @@ alia_emit_flow_fragments(
     alia_layout_node* node,
     alia_flow_fragment_emitter* emitter)
 {
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
     node->vtable->emit_flow_fragments(ctx, node, emitter);
+    ALIA_LAYOUT_PROFILE_END_CALL(node, EMIT_FLOW_FRAGMENTS);
 }
 
 static inline void
@@ -65,7 +125,9 @@ alia_layout_read_fragment_placements(
     alia_layout_node* node,
     alia_flow_fragment_reader* reader)
 {
-    return node->vtable->read_fragment_placements(ctx, node, reader);
+    ALIA_LAYOUT_PROFILE_BEGIN_CALL();
+    node->vtable->read_fragment_placements(ctx, node, reader);
+    ALIA_LAYOUT_PROFILE_END_CALL(node, READ_FRAGMENT_PLACEMENTS);
 }
 
 ALIA_EXTERN_C_END
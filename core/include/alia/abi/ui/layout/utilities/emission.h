@@ -12,12 +12,41 @@ typedef struct alia_layout_emission
 {
     alia_bump_allocator arena;
     alia_layout_node** next_ptr;
+    // the number of nodes emitted so far
+    uint32_t node_count;
 } alia_layout_emission;
 
+// Append a node to the current list of siblings.
+static inline void
+alia_layout_emit_node(alia_layout_emission* emission, alia_layout_node* node)
+{
+    *emission->next_ptr = node;
+    emission->next_ptr = &node->next_sibling;
+    ++emission->node_count;
+}
+
+typedef struct alia_layout_system alia_layout_system;
+
+// the visible region of a scrolling container's content
+typedef struct alia_layout_viewport
+{
+    // the viewport's box in layout coordinates (as of the last resolve)
+    alia_box box;
+    // how far the content is scrolled within the viewport - Containers that
+    // virtualize their content may adjust this during refresh passes (e.g.,
+    // to reveal an item that isn't currently emitted).
+    alia_vec2f scroll;
+} alia_layout_viewport;
+
 struct alia_layout_context
 {
+    // the layout system that this pass is operating on
+    alia_layout_system* system;
     alia_layout_emission emission;
     alia_bump_allocator placement;
+    // the viewport of the innermost scrolling container that encloses the
+    // current point in the controller (or NULL if there isn't one)
+    alia_layout_viewport* viewport;
 };
 
 static inline alia_bump_allocator*
@@ -34,6 +63,9 @@ struct alia_layout_container
     alia_layout_node* first_child;
     // fixed spacing between adjacent children along the container main axis
     float gap;
+    // the number of nodes in the container's subtree (including itself) -
+    // This is set when the container is deactivated.
+    uint32_t subtree_size;
 };
 
 static inline float
@@ -431,6 +431,52 @@ alia_ui_scroll_view_begin(
 void
 alia_ui_scroll_view_end(alia_context* ctx);
 
+// VIRTUAL COLUMN
+//
+// A virtual column lays out a list of items as a column, but only the items
+// that intersect the viewport of the enclosing scroll view (plus `overscan`
+// pixels on either side) are actually emitted. This makes it practical to
+// scroll through lists with hundreds of thousands of items.
+//
+// The column keeps the height of every item in a prefix-sum index. Items that
+// haven't been laid out yet are assumed to be `estimated_item_height` tall,
+// and once an item is laid out, its actual height replaces the estimate.
+// Locating the items at a given scroll position (or the position of a given
+// item) takes O(log n) time.
+//
+// `alia_ui_virtual_column_begin` returns the range of items to emit. The
+// caller must emit exactly one layout node for each item in the range, in
+// order (e.g., a row per item). Since the range changes as the view scrolls,
+// items that keep state should key it on their index rather than their
+// position in the controller.
+//
+// If `reveal_item` is non-NULL and refers to an item, the column scrolls that
+// item into view and resets `*reveal_item` to `ALIA_VIRTUAL_COLUMN_NO_ITEM`.
+// (Since the items around it may turn out to have different heights than
+// their estimates, the column may take a few refreshes to settle.)
+//
+// Outside of a scroll view, all items are emitted.
+
+#define ALIA_VIRTUAL_COLUMN_NO_ITEM UINT32_MAX
+
+// a range of items, [begin, end)
+typedef struct alia_virtual_column_range
+{
+    uint32_t begin;
+    uint32_t end;
+} alia_virtual_column_range;
+
+alia_virtual_column_range
+alia_ui_virtual_column_begin(
+    alia_context* ctx,
+    alia_layout_flags_t layout_flags,
+    uint32_t item_count,
+    float estimated_item_height,
+    float overscan,
+    uint32_t* reveal_item);
+void
+alia_ui_virtual_column_end(alia_context* ctx);
+
 // TODO: Decide on a more general return value for this.
 bool
 alia_ui_collapsible_begin(
@@ -87,6 +87,92 @@ typedef struct alia_msdf_atlas_image
     int height;
 } alia_msdf_atlas_image;
 
+// a rectangle of updated atlas pixels (RGB, with rows ordered like the atlas
+// image's) - `x` and `y` give the position of its first pixel in the atlas.
+typedef struct alia_msdf_atlas_region
+{
+    uint8_t const* rgb;
+    int x;
+    int y;
+    int width;
+    int height;
+} alia_msdf_atlas_region;
+
+// DYNAMIC GLYPHS
+//
+// The baked atlas only covers the glyphs that the asset builder was given.
+// For everything else (e.g., CJK text), the engine can generate glyphs on
+// demand: the first time a codepoint outside the baked set is measured or
+// drawn, the engine asks a host-supplied generator for it. (In practice, the
+// generator runs the same msdfgen pipeline as the asset builder, against the
+// same font file, so the core itself doesn't depend on FreeType or msdfgen.)
+//
+// Generated glyphs are packed into pages: bands of the atlas texture, as wide
+// as the baked atlas, stacked below it. New glyphs are handed to the renderer
+// (via `alia_renderer_ops::update_msdf_atlas`) during each draw pass, before
+// anything is rendered.
+// When the pages fill up, the least recently used page is evicted at the
+// start of the next draw pass (which makes every retained drawing record
+// itself again), so an application only pays for the glyphs that it actually
+// shows. A glyph's metrics survive the eviction of its page, so evictions
+// never change any text measurements.
+
+// a glyph produced by an `alia_msdf_glyph_generator`
+typedef struct alia_msdf_generated_glyph
+{
+    // the metrics, in em units (as in `alia_msdf_glyph`)
+    float advance;
+    float plane_left, plane_bottom, plane_right, plane_top;
+    // the MSDF image, covering exactly the plane bounds at the atlas's font
+    // size and distance range, with rows ordered from bottom to top (as
+    // msdfgen produces them) - This only has to stay valid until the next
+    // call to the generator. It may be empty if the glyph has no quad.
+    uint8_t const* rgb;
+    int width;
+    int height;
+} alia_msdf_generated_glyph;
+
+// Generate the glyph for `codepoint` in font `font_index`, filling in `out`.
+// Returns false if the font doesn't have the glyph.
+typedef bool (*alia_msdf_glyph_generator)(
+    void* user,
+    size_t font_index,
+    uint32_t codepoint,
+    alia_msdf_generated_glyph* out);
+
+typedef struct alia_msdf_dynamic_glyph_config
+{
+    alia_msdf_glyph_generator generate;
+    void* user;
+    // the height (in pixels) and number of the atlas pages
+    int page_height;
+    int page_count;
+    // the maximum number of generated glyphs that can be in the atlas at once
+    size_t glyph_capacity;
+} alia_msdf_dynamic_glyph_config;
+
+// BACKGROUND PREPARATION
+//
+// Segmenting and measuring a large block of text (e.g., a pasted log file)
+// can take long enough to stall the UI. With background preparation enabled,
+// the engine hands blocks above a size threshold to a pool of worker threads
+// (via the asynchronous entries in `alia_text_engine_vtable`), and text
+// elements lay out with estimated metrics until their blocks are ready.
+// Smaller blocks are still prepared synchronously.
+//
+// Measuring only reads the engine's glyph tables, so workers can do it
+// alongside the UI thread. Generating glyphs writes to them, so background
+// preparation and dynamic glyphs can't be used together.
+
+typedef struct alia_msdf_background_config
+{
+    // the number of worker threads
+    uint32_t thread_count;
+    // the minimum length (in bytes) of text for it to be prepared in the
+    // background (or 0 for a reasonable default)
+    size_t min_length;
+} alia_msdf_background_config;
+
 void
 alia_msdf_atlas_rle_decompress(
     uint8_t const* rle_r,
@@ -118,6 +204,30 @@ alia_msdf_create_text_engine(
 void
 alia_msdf_destroy_text_engine(alia_msdf_text_engine* ctx);
 
+// Enable dynamic glyphs for an engine (see DYNAMIC GLYPHS above). This must
+// be called before the engine measures or draws anything. The engine must be
+// bound to the UI system (via `alia_ui_bind_msdf_text_engine`) for its pages
+// to reach the renderer.
+void
+alia_msdf_enable_dynamic_glyphs(
+    alia_msdf_text_engine* engine,
+    alia_msdf_dynamic_glyph_config const* config);
+
+// Enable background preparation for an engine (see BACKGROUND PREPARATION
+// above). This must be called before the engine prepares anything, and it
+// can't be combined with dynamic glyphs.
+void
+alia_msdf_enable_background_preparation(
+    alia_msdf_text_engine* engine,
+    alia_msdf_background_config const* config);
+
+// Get the size of the atlas texture that the engine expects. This is the
+// size of the baked atlas unless dynamic glyphs are enabled, in which case
+// the texture also includes the pages. (The baked atlas occupies the first
+// rows of the texture, so its image can simply be extended with zeros.)
+alia_vec2i
+alia_msdf_get_atlas_texture_size(alia_msdf_text_engine* engine);
+
 // Register one of the engine's fonts as a core typeface, returning its
 // `alia_typeface_id`. This adapts the MSDF engine to the abstract text engine
 // interface so the font can be resolved, activated, and drawn through the core
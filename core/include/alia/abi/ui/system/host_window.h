@@ -13,6 +13,11 @@ typedef struct alia_ui_system alia_ui_system;
 typedef struct alia_host_window_ops
 {
     void (*toggle_fullscreen)(void* user);
+    // Wake the host's event loop so that it checks `alia_ui_needs_tick`.
+    // Unlike the other ops, this may be called from any thread (e.g., when
+    // text finishes preparing in the background), so the ops shouldn't be
+    // changed while such work is outstanding.
+    void (*wake)(void* user);
     void* user;
 } alia_host_window_ops;
 
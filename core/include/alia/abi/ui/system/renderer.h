@@ -17,6 +17,10 @@ typedef struct alia_ui_system alia_ui_system;
 typedef struct alia_renderer_ops
 {
     void (*upload_msdf_atlas)(void* user, alia_msdf_atlas_image const* image);
+    // Update a region of the MSDF atlas texture. (This is only needed for
+    // glyphs generated at runtime - see DYNAMIC GLYPHS in `msdf.h`.)
+    void (*update_msdf_atlas)(
+        void* user, alia_msdf_atlas_region const* region);
 
     // Register a portable effect. Returns 0 on success.
     int (*register_effect)(
@@ -34,6 +38,14 @@ typedef struct alia_renderer_ops
     void (*draw_pass_begin)(void* user);
     void (*draw_pass_end)(void* user);
 
+    // Restrict the next draw pass to the damaged parts of the primary target.
+    // (This is called before `draw_pass_begin`.) Unless `damage->full` is
+    // set, the renderer must preserve the primary target's contents outside
+    // of `damage->rects`. (It's still given every bucket, so it can simply
+    // scissor to the damage.) If there are no rects, nothing is drawn.
+    // Implementing this is what enables damage tracking.
+    void (*draw_pass_set_damage)(void* user, alia_draw_damage const* damage);
+
     // Bind a draw target to the active draw target.
     void (*draw_target_bind)(void* user, alia_draw_target_id target);
 
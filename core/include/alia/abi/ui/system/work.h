@@ -2,6 +2,7 @@
 #define ALIA_ABI_UI_SYSTEM_WORK_H
 
 #include <alia/abi/kernel/events.h>
+#include <alia/abi/kernel/substrate.h>
 #include <alia/abi/prelude.h>
 
 ALIA_EXTERN_C_BEGIN
@@ -46,6 +47,12 @@ alia_ui_needs_tick(alia_ui_system* ui);
 bool
 alia_ui_next_wake_ns(alia_ui_system* ui, alia_nanosecond_count* out_wake_ns);
 
+// Do a budgeted amount of key table garbage collection on the UI's substrate
+// (see `alia_substrate_sweep_system_keys_incrementally`). Hosts can call this
+// during idle time until the result reports no pending work.
+alia_substrate_sweep_progress
+alia_ui_sweep_keys(alia_ui_system* ui, alia_substrate_sweep_budget budget);
+
 void
 alia_ui_enqueue_event(alia_ui_system* ui, alia_event const* event);
 
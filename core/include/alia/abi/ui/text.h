@@ -32,9 +32,9 @@ ALIA_EXTERN_C_BEGIN
 // UTF-8 into measurable, drawable glyph data. The Alia core provides text
 // components, flow layout integration, font metrics and style management,
 // but it outsources the actual shaping and rendering to the engine. At the
-// moment, the only available text engine is an ASCII/Latin MSDF engine, but
-// the API itself is designed to support future engines with glyph caching and
-// complex script handling.
+// moment, the only available text engine is an MSDF engine (which handles
+// UTF-8 but not complex scripts), but the API itself is designed to support
+// future engines with full shaping and complex script handling.
 
 typedef struct alia_text_engine_vtable alia_text_engine_vtable;
 
@@ -106,6 +106,9 @@ typedef struct alia_text_segment
     alia_text_direction direction;
 } alia_text_segment;
 
+// an engine-owned handle for a block that's being prepared in the background
+typedef struct alia_text_preparation alia_text_preparation;
+
 // the engine contract
 struct alia_text_engine_vtable
 {
@@ -152,6 +155,37 @@ struct alia_text_engine_vtable
         alia_vec2f baseline_origin,
         alia_srgba8 color,
         alia_text_direction direction);
+
+    // ASYNCHRONOUS PREPARATION (optional)
+    //
+    // Engines that can prepare blocks on background threads provide the
+    // following. Others leave them null, and every block is prepared
+    // synchronously.
+
+    // Start preparing a block in the background. The arguments are as for
+    // `prepare_block` (and the engine copies `utf8` before returning). When
+    // the block is ready, `on_ready(user)` is called exactly once, from an
+    // arbitrary thread. Returns null (without calling `on_ready`) if the block
+    // should be prepared synchronously instead (e.g., because it's small).
+    alia_text_preparation* (*begin_prepare_block)(
+        alia_text_engine* engine,
+        void* engine_handle,
+        float font_size,
+        alia_text_direction base_direction,
+        char const* utf8,
+        size_t length,
+        void (*on_ready)(void* user),
+        void* user);
+
+    // Take the block from a preparation whose `on_ready` has been called.
+    // This frees the preparation.
+    alia_text_block* (*finish_prepare_block)(
+        alia_text_engine* engine, alia_text_preparation* preparation);
+
+    // Abandon a preparation, whether or not it has finished. Once this
+    // returns, `on_ready` won't be called.
+    void (*cancel_prepare_block)(
+        alia_text_engine* engine, alia_text_preparation* preparation);
 };
 
 // TYPEFACE REGISTRY
@@ -251,6 +285,46 @@ alia_active_font_metrics(alia_context* ctx)
     return &alia_active_font(ctx)->metrics;
 }
 
+// SHARED BLOCK CACHE
+
+// Text elements share prepared blocks through a system-wide cache, so a
+// string that appears in many places (with the same typeface and size) is
+// only prepared once. Blocks that are no longer in use are kept until the
+// cache exceeds its memory budget, at which point the least recently used
+// ones are released. Blocks that are in use are never released, so the cache
+// can exceed its budget if that many blocks are on screen.
+
+typedef struct alia_text_block_cache_stats
+{
+    // lookups that found a block already in the cache
+    uint64_t hits;
+    // lookups that had to prepare a new block
+    uint64_t misses;
+    // unused blocks that were released to stay within the budget
+    uint64_t evictions;
+    // the blocks currently in the cache (in use or not) and their estimated
+    // memory usage
+    size_t resident_blocks;
+    size_t resident_bytes;
+} alia_text_block_cache_stats;
+
+// Set the cache's memory budget, in bytes. (The default is 8 MiB.)
+void
+alia_ui_set_text_block_cache_budget(alia_ui_system* system, size_t bytes);
+
+// Release every block that isn't in use (e.g., before destroying a text
+// engine).
+void
+alia_ui_clear_text_block_cache(alia_ui_system* system);
+
+// Get the cache stats. The counters accumulate from the time the system was
+// created (or since the last call to `alia_ui_reset_text_block_cache_stats`).
+alia_text_block_cache_stats
+alia_ui_get_text_block_cache_stats(alia_ui_system* system);
+
+void
+alia_ui_reset_text_block_cache_stats(alia_ui_system* system);
+
 // TEXT COMPONENT
 
 // styling for a text element - The font is a pointer to a resolved font (NULL
@@ -6,9 +6,11 @@
 
 namespace alia {
 
+// the path from the root of the component tree to the target of an event
+// (excluding components that have already been entered)
 struct event_routing_path
 {
-    component_container* node;
+    alia_component* node;
     event_routing_path* rest;
 };
 
@@ -18,10 +20,13 @@ extern "C" {
 
 struct alia_event_traversal
 {
-    alia::component_container_ptr* active_container = nullptr;
-    bool targeted;
+    // the innermost skippable component that the traversal is inside of
+    alia_component* active_component = nullptr;
+    bool targeted = false;
 
     alia::event_routing_path* path_to_target = nullptr;
+    // true while a targeted traversal is inside the target component
+    bool inside_target = false;
     alia_event* event = {};
     bool aborted = false;
 };
@@ -30,15 +35,6 @@ struct alia_event_traversal
 
 namespace alia {
 
-template<class Context>
-component_container_ptr const
-get_active_component_container(Context& ctx)
-{
-    return *ctx.events->active_container;
-}
-
-using component_identity = std::weak_ptr<component_container>;
-
 struct traversal_aborted
 {
 };
@@ -136,71 +132,6 @@ ALIA_EVENTS(X)
 //     ALIA_END
 // }
 
-typedef component_identity* component_id;
-
-void
-refresh_component_identity(
-    ephemeral_context& ctx, component_identity& identity);
-
-component_id
-get_component_id(ephemeral_context& ctx);
-
-// external_component_id identifies a component in a form that can be safely
-// stored outside of the alia data graph.
-struct external_component_id
-{
-    // :id captures the original ID pointer used for the component within the
-    // data graph.
-    component_id id = nullptr;
-    // :identity stores a copy of the actual weak_ptr to the component identity
-    // so that it can be tested externally to see if the component still exists
-    // within the data graph.
-    component_identity identity;
-
-    explicit
-    operator bool() const
-    {
-        return id != nullptr;
-    }
-};
-
-external_component_id const null_component_id{};
-
-inline external_component_id
-externalize(component_id id)
-{
-    external_component_id external;
-    external.id = id;
-    external.identity = *id;
-    return external;
-}
-
-struct targeted_event
-{
-    component_id target_id;
-};
-
-template<class Event>
-bool
-detect_targeted_event(ephemeral_context& ctx, component_id id, Event** event)
-{
-    return detect_event(ctx, event) && (*event)->target_id == id;
-}
-
-// TODO: Implement this.
-// template<class Event, class Context, class Handler>
-// void
-// targeted_event_handler(Context ctx, component_id id, Handler&& handler)
-// {
-//     Event* e;
-//     ALIA_UNTRACKED_IF(detect_targeted_event(ctx, id, &e))
-//     {
-//         handler(ctx, *e);
-//         abort_traversal(ctx);
-//     }
-//     ALIA_END
-// }
-
 // TODO: Implement this.
 // template<class Context, class Handler>
 // void
@@ -0,0 +1,134 @@
+#include <alia/kernel/flow/component_table.h>
+
+#include <cstring>
+
+namespace {
+
+// the number of low bits in a route node ID that hold the slot index
+unsigned const route_index_bits = 22;
+uint32_t const route_index_mask = (1u << route_index_bits) - 1;
+uint32_t const route_generation_mask = (1u << (32 - route_index_bits)) - 1;
+
+// the number of slots allocated on first use
+uint32_t const min_component_table_capacity = 64;
+
+alia_route_node_id
+make_route_node_id(uint32_t index, uint32_t generation)
+{
+    return ((generation & route_generation_mask) << route_index_bits)
+         | (index + 1);
+}
+
+void
+grow_component_table(
+    alia_component_table& table, alia_general_allocator const& allocator)
+{
+    uint32_t const new_capacity = table.capacity == 0
+                                    ? min_component_table_capacity
+                                    : table.capacity * 2;
+    ALIA_ASSERT(new_capacity - 1 <= route_index_mask);
+    auto* new_slots = static_cast<alia_component_table_slot*>(allocator.alloc(
+        allocator.user_data,
+        new_capacity * sizeof(alia_component_table_slot),
+        alignof(alia_component_table_slot)));
+    if (table.slots)
+    {
+        std::memcpy(
+            new_slots,
+            table.slots,
+            table.capacity * sizeof(alia_component_table_slot));
+        allocator.free(
+            allocator.user_data,
+            table.slots,
+            table.capacity * sizeof(alia_component_table_slot),
+            alignof(alia_component_table_slot));
+    }
+    // The free list is always empty when the table grows.
+    table.free_head = new_capacity;
+    table.slots = new_slots;
+    table.capacity = new_capacity;
+}
+
+} // namespace
+
+namespace alia {
+
+void
+component_table_init(alia_component_table& table)
+{
+    table.slots = nullptr;
+    table.capacity = 0;
+    table.used = 0;
+    table.free_head = 0;
+}
+
+void
+component_table_destroy(
+    alia_component_table& table, alia_general_allocator const& allocator)
+{
+    if (table.slots)
+    {
+        allocator.free(
+            allocator.user_data,
+            table.slots,
+            table.capacity * sizeof(alia_component_table_slot),
+            alignof(alia_component_table_slot));
+    }
+    component_table_init(table);
+}
+
+alia_route_node_id
+component_table_acquire(
+    alia_component_table& table,
+    alia_general_allocator const& allocator,
+    alia_component* component)
+{
+    ALIA_ASSERT(component);
+    uint32_t index;
+    if (table.free_head < table.capacity)
+    {
+        index = table.free_head;
+        table.free_head = table.slots[index].next_free;
+    }
+    else
+    {
+        if (table.used == table.capacity)
+            grow_component_table(table, allocator);
+        index = table.used++;
+        table.slots[index].generation = 0;
+    }
+    alia_component_table_slot& slot = table.slots[index];
+    slot.component = component;
+    slot.next_free = table.capacity;
+    return make_route_node_id(index, slot.generation);
+}
+
+void
+component_table_release(alia_component_table& table, alia_route_node_id id)
+{
+    ALIA_ASSERT(component_table_lookup(table, id));
+    uint32_t const index = (id & route_index_mask) - 1;
+    alia_component_table_slot& slot = table.slots[index];
+    slot.component = nullptr;
+    ++slot.generation;
+    slot.next_free = table.free_head;
+    table.free_head = index;
+}
+
+alia_component*
+component_table_lookup(
+    alia_component_table const& table, alia_route_node_id id)
+{
+    uint32_t const index_plus_one = id & route_index_mask;
+    if (index_plus_one == 0 || index_plus_one > table.used)
+        return nullptr;
+    alia_component_table_slot const& slot = table.slots[index_plus_one - 1];
+    if ((slot.generation & route_generation_mask)
+        != (id >> route_index_bits))
+    {
+        return nullptr;
+    }
+    return slot.component;
+}
+
+} // namespace alia
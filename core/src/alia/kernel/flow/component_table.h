@@ -0,0 +1,75 @@
+#pragma once
+
+#include <alia/abi/base/allocator.h>
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/prelude.h>
+
+#include <stdint.h>
+
+struct alia_component;
+
+// A single slot in an `alia_component_table`.
+struct alia_component_table_slot
+{
+    // the component occupying the slot (or null if the slot is free)
+    alia_component* component;
+    // incremented every time the slot is released
+    uint32_t generation;
+    // the next free slot (if this one is free)
+    uint32_t next_free;
+};
+
+// `alia_component_table` maps route node IDs to the (live) components that
+// own them.
+//
+// Components live in substrate blocks, so once a component is destroyed,
+// anything that still refers to it by pointer is dangling. Route node IDs are
+// generation-checked handles instead: The low bits hold a slot index (plus
+// one, so that zero is never a valid ID) and the high bits hold the slot's
+// generation at the time the ID was issued. A lookup with a stale ID simply
+// fails.
+//
+// (Since the generation field is only a few bits wide, a sufficiently old ID
+// could eventually alias a newer component in the same slot. That can only
+// misroute an event, not misdeliver it, since handlers still compare full
+// element IDs.)
+//
+// Slot storage is allocated through the substrate's general allocator.
+//
+struct alia_component_table
+{
+    alia_component_table_slot* slots;
+    uint32_t capacity;
+    // the number of slots that have ever been used
+    uint32_t used;
+    // the head of the free slot list (or `capacity` if there are none)
+    uint32_t free_head;
+};
+
+namespace alia {
+
+void
+component_table_init(alia_component_table& table);
+
+// Release the slot storage.
+void
+component_table_destroy(
+    alia_component_table& table, alia_general_allocator const& allocator);
+
+// Acquire a slot for `component` and return its route node ID.
+alia_route_node_id
+component_table_acquire(
+    alia_component_table& table,
+    alia_general_allocator const& allocator,
+    alia_component* component);
+
+// Release the slot identified by `id` (which must be valid).
+void
+component_table_release(alia_component_table& table, alia_route_node_id id);
+
+// Get the component identified by `id`, or null if `id` is stale or null.
+alia_component*
+component_table_lookup(
+    alia_component_table const& table, alia_route_node_id id);
+
+} // namespace alia
@@ -0,0 +1,447 @@
+#include <alia/kernel/flow/components.h>
+
+#include <alia/abi/ui/geometry.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+#include <alia/abi/ui/system/work.h>
+#include <alia/impl/base/stack.hpp>
+#include <alia/impl/events.hpp>
+#include <alia/kernel/flow/component_table.h>
+#include <alia/kernel/flow/traversal.h>
+#include <alia/kernel/substrate.h>
+#include <alia/ui/drawing/retention.h>
+#include <alia/ui/layout/system.h>
+
+namespace {
+
+// the per-pass state for a component (kept on the context's stack)
+struct component_scope
+{
+    alia_component* component;
+    // the component that was active before this one
+    alia_component* parent;
+    // true iff the content is being executed
+    bool running;
+    // true iff the component is being refreshed (and its nodes cached)
+    // This is false for components that are only being discovered.
+    bool refreshing;
+    // true iff this is the target component of a targeted traversal
+    bool is_target;
+    // the placement arena offset when the content started (on non-refresh
+    // passes)
+    size_t placement_start;
+    // the recorder for the content's drawing (if it's being recorded)
+    alia::draw_recorder* draw_recorder;
+
+    // The following are only used when `refreshing` is true...
+
+    // where the content's first top-level node will be linked
+    alia_layout_node** first_next_ptr;
+    // the emission's node count when the content started
+    uint32_t node_start;
+    // true iff this component switched the emission over to the retained
+    // node arena (i.e., it's the outermost skippable component)
+    bool owns_retained_emission;
+    // the emission arena that was active before the switch
+    alia_bump_allocator outer_arena;
+    // the retained node offset when the content started
+    size_t retained_start;
+    // the refresh event's `incomplete` flag as of the start of the content
+    bool outer_incomplete;
+};
+
+void
+release_value_id(alia_substrate_system* system, alia_component* component)
+{
+    if (component->value_id)
+    {
+        alia_captured_id_release(component->value_id);
+        system->allocator.free(
+            system->allocator.user_data,
+            component->value_id,
+            component->value_id_spec.size,
+            component->value_id_spec.align);
+        component->value_id = nullptr;
+    }
+}
+
+void
+capture_value_id(
+    alia_substrate_system* system,
+    alia_component* component,
+    alia_id_view value_id)
+{
+    release_value_id(system, component);
+    if (alia_id_view_is_null(value_id))
+        return;
+    alia_struct_spec const spec = alia_captured_id_spec(value_id);
+    void* storage = system->allocator.alloc(
+        system->allocator.user_data, spec.size, spec.align);
+    alia_captured_id_capture_into(value_id, storage, spec.size);
+    component->value_id = static_cast<alia_captured_id*>(storage);
+    component->value_id_spec = spec;
+}
+
+// The component's retained nodes are no longer referenced by it, so count
+// them as garbage (if they're from the current epoch).
+void
+discard_cached_nodes(alia_layout_system& layout, alia_component* component)
+{
+    if (component->layout_epoch == layout.retained_node_epoch)
+        layout.retained_node_garbage += component->retained_bytes;
+    component->retained_bytes = 0;
+    component->first_node = nullptr;
+    component->last_next_ptr = nullptr;
+    component->node_count = 0;
+    component->flags &= ~ALIA_COMPONENT_CACHE_VALID;
+}
+
+void
+component_cleanup(
+    alia_substrate_system* system, void* ptr, alia_substrate_cleanup_mode mode)
+{
+    auto* component = static_cast<alia_component*>(ptr);
+    // Note that the layout system may already be gone at this point, so the
+    // retained nodes are simply abandoned. (They'll be reclaimed along with
+    // the rest of the arena.)
+    component->flags &= ~ALIA_COMPONENT_CACHE_VALID;
+    release_value_id(system, component);
+    if (mode == ALIA_SUBSTRATE_CLEAR_CACHE)
+    {
+        alia_substrate_deactivate_anchor(system, &component->anchor);
+    }
+    else
+    {
+        alia::substrate_reset_anchor(system, &component->anchor);
+        if (component->route != 0)
+        {
+            alia::component_table_release(
+                system->component_table, component->route);
+            component->route = 0;
+        }
+    }
+}
+
+bool
+component_can_be_skipped(
+    alia_context* ctx, alia_component const* component, alia_id_view value_id)
+{
+    return (component->flags
+            & (ALIA_COMPONENT_CACHE_VALID | ALIA_COMPONENT_DIRTY
+               | ALIA_COMPONENT_ANIMATING))
+            == ALIA_COMPONENT_CACHE_VALID
+        && component->value_id
+        && component->layout_epoch
+               == ctx->layout->system->retained_node_epoch
+        && component->geometry_scale == ctx->geometry->scale
+        && alia_captured_id_matches_view(component->value_id, value_id);
+}
+
+// Splice the component's cached nodes into the layout tree as if the content
+// had just emitted them.
+void
+replay_cached_nodes(alia_context* ctx, alia_component const* component)
+{
+    if (!component->first_node)
+        return;
+    auto& emission = ctx->layout->emission;
+    *emission.next_ptr = component->first_node;
+    emission.next_ptr = component->last_next_ptr;
+    emission.node_count += component->node_count;
+}
+
+void
+begin_refresh(
+    alia_context* ctx, component_scope& scope, alia_id_view value_id)
+{
+    alia_component* component = scope.component;
+    alia_layout_system& layout = *ctx->layout->system;
+    auto& emission = ctx->layout->emission;
+
+    discard_cached_nodes(layout, component);
+    // The content has to opt back into retained drawing (and redraw).
+    component->flags &= ~(
+        ALIA_COMPONENT_DIRTY | ALIA_COMPONENT_ANIMATING
+        | ALIA_COMPONENT_RETAIN_DRAW | ALIA_COMPONENT_DRAW_CACHE_VALID);
+    // The content may emit a different set of nodes this time.
+    component->placement_epoch = 0;
+    if (!component->value_id
+        || !alia_captured_id_matches_view(component->value_id, value_id))
+    {
+        capture_value_id(ctx->substrate->system, component, value_id);
+    }
+
+    scope.first_next_ptr = emission.next_ptr;
+    scope.node_start = emission.node_count;
+
+    // Nested components just keep emitting into the retained arena.
+    scope.owns_retained_emission
+        = emission.arena.arena != &layout.retained_node_arena;
+    if (scope.owns_retained_emission)
+    {
+        scope.outer_arena = emission.arena;
+        alia_bump_allocator_init(&emission.arena, &layout.retained_node_arena);
+        emission.arena.offset = layout.retained_node_offset;
+    }
+    scope.retained_start = emission.arena.offset;
+
+    // Track whether the content itself leaves the refresh incomplete.
+    auto& refresh = alia::as_refresh_event(*ctx);
+    scope.outer_incomplete = refresh.incomplete;
+    refresh.incomplete = false;
+}
+
+void
+end_refresh(alia_context* ctx, component_scope const& scope)
+{
+    alia_component* component = scope.component;
+    alia_layout_system& layout = *ctx->layout->system;
+    auto& emission = ctx->layout->emission;
+
+    if (emission.next_ptr != scope.first_next_ptr)
+    {
+        component->first_node = *scope.first_next_ptr;
+        component->last_next_ptr = emission.next_ptr;
+        component->node_count = emission.node_count - scope.node_start;
+    }
+    component->retained_bytes = emission.arena.offset - scope.retained_start;
+    component->layout_epoch = layout.retained_node_epoch;
+    component->geometry_scale = ctx->geometry->scale;
+
+    if (scope.owns_retained_emission)
+    {
+        layout.retained_node_offset = emission.arena.offset;
+        alia_bump_allocator_commit_peak(&emission.arena);
+        emission.arena = scope.outer_arena;
+    }
+
+    // If any part of the content was only discovered on this pass, the nodes
+    // may reference discovery data, so they can't be reused.
+    auto& refresh = alia::as_refresh_event(*ctx);
+    if (!refresh.incomplete && !ctx->events->aborted)
+        component->flags |= ALIA_COMPONENT_CACHE_VALID;
+    refresh.incomplete = refresh.incomplete || scope.outer_incomplete;
+}
+
+// Determine whether or not `component` is on the route of the current
+// traversal. (Untargeted traversals visit everything.) If it is, advance the
+// path to the target past it.
+bool
+enter_route(
+    alia_event_traversal& events,
+    alia_component* component,
+    component_scope& scope)
+{
+    scope.is_target = false;
+    if (!events.targeted || events.inside_target)
+        return true;
+    if (!events.path_to_target || events.path_to_target->node != component)
+        return false;
+    events.path_to_target = events.path_to_target->rest;
+    if (!events.path_to_target)
+    {
+        scope.is_target = true;
+        events.inside_target = true;
+    }
+    return true;
+}
+
+// Step over the component's content by advancing the placement arena past
+// the range that the content consumed last time.
+// This fails if the recorded range isn't from the current layout or doesn't
+// start where the content would.
+bool
+step_over_placements(alia_context* ctx, alia_component const* component)
+{
+    if (!ctx->layout)
+        return false;
+    alia_bump_allocator& placement = ctx->layout->placement;
+    if (component->placement_epoch != ctx->layout->system->placement_epoch
+        || component->placement_start != placement.offset)
+    {
+        return false;
+    }
+    placement.offset = component->placement_end;
+    return true;
+}
+
+void
+record_placements(alia_context* ctx, component_scope const& scope)
+{
+    alia_component* component = scope.component;
+    component->placement_start = scope.placement_start;
+    component->placement_end = ctx->layout->placement.offset;
+    component->placement_epoch = ctx->layout->system->placement_epoch;
+}
+
+} // namespace
+
+extern "C" {
+
+bool
+alia_component_begin(alia_context* ctx, alia_id_view value_id)
+{
+    alia_substrate_usage_result const usage = alia_substrate_use_object(
+        ctx,
+        sizeof(alia_component),
+        alignof(alia_component),
+        component_cleanup);
+    auto* component = static_cast<alia_component*>(usage.ptr);
+    if (usage.mode != ALIA_SUBSTRATE_BLOCK_TRAVERSAL_NORMAL)
+    {
+        alia_substrate_system* system = ctx->substrate->system;
+        *component = alia_component{
+            .parent = nullptr,
+            .flags = 0,
+            // Discovery records are scratch memory, so they don't get routes.
+            .route = usage.mode == ALIA_SUBSTRATE_BLOCK_TRAVERSAL_INIT
+                       ? alia::component_table_acquire(
+                             system->component_table,
+                             system->allocator,
+                             component)
+                       : 0,
+            .generation = usage.generation,
+            .value_id = nullptr,
+            .value_id_spec = {0, 0},
+            .anchor = {.block = nullptr},
+            .content_spec = {0, 0},
+            .first_node = nullptr,
+            .last_next_ptr = nullptr,
+            .node_count = 0,
+            .retained_bytes = 0,
+            .layout_epoch = 0,
+            .geometry_scale = 0,
+            .placement_start = 0,
+            .placement_end = 0,
+            .placement_epoch = 0,
+            .retained_draw = nullptr,
+            .draw_epoch = 0};
+    }
+
+    auto& events = *ctx->events;
+    component_scope scope;
+    scope.component = component;
+    scope.parent = events.active_component;
+    scope.draw_recorder = nullptr;
+    scope.refreshing
+        = alia::is_refresh_event(*ctx)
+       && usage.mode != ALIA_SUBSTRATE_BLOCK_TRAVERSAL_DISCOVERY;
+    component->parent = events.active_component;
+    events.active_component = component;
+
+    if (scope.refreshing && component_can_be_skipped(ctx, component, value_id))
+    {
+        replay_cached_nodes(ctx, component);
+        scope.is_target = false;
+        scope.running = false;
+        alia::stack_push<component_scope>(ctx) = scope;
+        return false;
+    }
+
+    // Targeted traversals skip components that aren't on the route to the
+    // target (as long as they know how to step over the placements).
+    if (!enter_route(events, component, scope)
+        && step_over_placements(ctx, component))
+    {
+        scope.running = false;
+        alia::stack_push<component_scope>(ctx) = scope;
+        return false;
+    }
+
+    // Components that retain their drawing either replay it or record it.
+    if (ctx->draw && (component->flags & ALIA_COMPONENT_RETAIN_DRAW)
+        && usage.mode == ALIA_SUBSTRATE_BLOCK_TRAVERSAL_NORMAL)
+    {
+        if (alia::replay_retained_draw(ctx, component))
+        {
+            scope.running = false;
+            alia::stack_push<component_scope>(ctx) = scope;
+            return false;
+        }
+        scope.draw_recorder = alia::begin_draw_recording(ctx);
+    }
+
+    if (scope.refreshing)
+        begin_refresh(ctx, scope, value_id);
+    else if (ctx->layout)
+        scope.placement_start = ctx->layout->placement.offset;
+    scope.running = true;
+    alia_substrate_begin_block(
+        ctx, &component->anchor, &component->content_spec);
+    // The scope goes on top of the block's traversal state so that it can be
+    // popped first.
+    alia::stack_push<component_scope>(ctx) = scope;
+    return true;
+}
+
+void
+alia_component_end(alia_context* ctx)
+{
+    component_scope const scope = alia::stack_pop<component_scope>(ctx);
+    if (scope.running)
+    {
+        scope.component->content_spec = alia_substrate_end_block(ctx);
+        if (scope.refreshing)
+            end_refresh(ctx, scope);
+        else if (ctx->layout && !ctx->events->aborted)
+            record_placements(ctx, scope);
+        if (scope.draw_recorder)
+        {
+            alia::end_draw_recording(
+                ctx, scope.draw_recorder, scope.component);
+        }
+    }
+    if (scope.is_target)
+        ctx->events->inside_target = false;
+    ctx->events->active_component = scope.parent;
+}
+
+void
+alia_component_mark_dirty(alia_context* ctx)
+{
+    ALIA_ASSERT(ctx);
+    alia::mark_dirty_component(*ctx);
+    if (ctx->system)
+        alia_ui_mark_dirty(ctx->system);
+}
+
+void
+alia_component_mark_animating(alia_context* ctx)
+{
+    ALIA_ASSERT(ctx);
+    alia::mark_animating_component(*ctx);
+}
+
+void
+alia_component_retain_draw(alia_context* ctx)
+{
+    ALIA_ASSERT(ctx);
+    alia_component* component
+        = ctx->events ? ctx->events->active_component : nullptr;
+    if (component)
+        component->flags |= ALIA_COMPONENT_RETAIN_DRAW;
+}
+
+alia_route_node_id
+alia_active_route_node(alia_context* ctx)
+{
+    ALIA_ASSERT(ctx);
+    alia_component* component
+        = ctx->events ? ctx->events->active_component : nullptr;
+    return component ? component->route : 0;
+}
+
+alia_element_id
+alia_component_id(alia_context* ctx)
+{
+    ALIA_ASSERT(ctx);
+    alia_component* component
+        = ctx->events ? ctx->events->active_component : nullptr;
+    if (!component)
+        return alia_element_id{.ptr = nullptr, .generation = 0, .route = 0};
+    return alia_element_id{
+        .ptr = component,
+        .generation = component->generation,
+        .route = component->route};
+}
+
+} // extern "C"
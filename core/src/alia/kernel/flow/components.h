@@ -0,0 +1,84 @@
+#pragma once
+
+#include <alia/abi/kernel/components.h>
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/kernel/substrate.h>
+#include <alia/abi/ui/layout/protocol.h>
+
+#include <stdint.h>
+
+namespace alia {
+struct retained_draw;
+}
+
+enum : uint8_t
+{
+    // The component has been marked dirty since its last refresh.
+    ALIA_COMPONENT_DIRTY = 1u << 0,
+    // The component has requested an animation refresh since its last
+    // refresh.
+    ALIA_COMPONENT_ANIMATING = 1u << 1,
+    // The cached layout nodes (and value ID) reflect a complete refresh of
+    // the component's content.
+    ALIA_COMPONENT_CACHE_VALID = 1u << 2,
+    // The component retains its drawing (see `alia_component_retain_draw`).
+    ALIA_COMPONENT_RETAIN_DRAW = 1u << 3,
+    // The retained draw recording reflects the component's current content.
+    ALIA_COMPONENT_DRAW_CACHE_VALID = 1u << 4,
+};
+
+// `alia_component` is the persistent record for a skippable component. It
+// lives in the substrate block that contains the component, and the
+// component's content lives in a child block attached to `anchor`.
+struct alia_component
+{
+    // the enclosing component, as of the last pass through this one
+    // (Since this record lives inside the parent's content block, the parent
+    // always outlives it.)
+    alia_component* parent;
+
+    uint8_t flags;
+
+    // the component's route node ID (or 0 if the record is only being used
+    // for discovery)
+    alia_route_node_id route;
+    // the generation of the substrate block that holds this record
+    alia_generation_counter generation;
+
+    // the value ID from the last refresh (or null)
+    // The storage is allocated through the substrate's general allocator.
+    alia_captured_id* value_id;
+    alia_struct_spec value_id_spec;
+
+    alia_substrate_anchor anchor;
+    alia_struct_spec content_spec;
+
+    // the layout nodes emitted by the content on its last refresh
+    // These live in the layout system's retained node arena. `first_node` is
+    // null if no nodes were emitted.
+    alia_layout_node* first_node;
+    // the `next_sibling` field of the last top-level node
+    alia_layout_node** last_next_ptr;
+    // the number of nodes (at any level) that they include
+    uint32_t node_count;
+    // the number of retained bytes that were allocated while emitting them
+    size_t retained_bytes;
+    // the retained node epoch that they were emitted in
+    uint32_t layout_epoch;
+    // the geometry scale that they were emitted with
+    float geometry_scale;
+
+    // the range of the layout placement arena that the content consumed on
+    // its last complete non-refresh pass, and the placement epoch of that
+    // range (or 0 if there is none) - This allows targeted traversals to
+    // step over the content when it's not on the route to the target.
+    size_t placement_start;
+    size_t placement_end;
+    uint32_t placement_epoch;
+
+    // the draw commands recorded on the component's last draw pass (if it
+    // retains its drawing) and the retained draw epoch that they were
+    // recorded in - See `alia/ui/drawing/retention.h`.
+    alia::retained_draw* retained_draw;
+    uint32_t draw_epoch;
+};
@@ -7,6 +7,8 @@
 #include <alia/context.h>
 #include <alia/impl/base/arena.hpp>
 #include <alia/impl/events.hpp>
+#include <alia/kernel/flow/component_table.h>
+#include <alia/kernel/flow/components.h>
 #include <alia/ui/system/object.h>
 
 #include <cstring>
@@ -16,6 +18,8 @@ namespace alia {
 void
 invoke_controller(ui_system& sys, event_traversal& events)
 {
+    hit_index_note_event(sys.hit_index, *events.event, sys.input);
+
     alia_bump_allocator scratch;
     alia_bump_allocator_init(&scratch, &sys.scratch);
 
@@ -36,10 +40,13 @@ invoke_controller(ui_system& sys, event_traversal& events)
     };
 
     alia_layout_context layout;
+    layout.system = &sys.layout;
     if (events.event->type == ALIA_EVENT_REFRESH)
         layout.emission.next_ptr = &sys.layout.root.first_child;
+    layout.emission.node_count = 0;
     alia_bump_allocator_init(&layout.emission.arena, &sys.layout.node_arena);
     alia_bump_allocator_init(&layout.placement, &sys.layout.placement_arena);
+    layout.viewport = nullptr;
 
     alia_stack_reset(&sys.stack);
 
@@ -93,14 +100,17 @@ invoke_controller(ui_system& sys, event_traversal& events)
         sys.substrate.root_block_spec = alia_substrate_end_block(&ctx);
 
     if (events.event->type == ALIA_EVENT_REFRESH)
+    {
         *layout.emission.next_ptr = 0;
+        layout_system_end_refresh(sys.layout);
+    }
 }
 
 namespace {
 
 void
 route_event_(
-    ui_system& sys, event_traversal& traversal, component_container* target)
+    ui_system& sys, event_traversal& traversal, alia_component* target)
 {
     // In order to construct the path to the target, we start at the target
     // and follow the 'parent' pointers until we reach the root. We do this
@@ -112,7 +122,7 @@ route_event_(
         path_node.rest = traversal.path_to_target;
         path_node.node = target;
         traversal.path_to_target = &path_node;
-        route_event_(sys, traversal, target->parent.get());
+        route_event_(sys, traversal, target->parent);
     }
     else
     {
@@ -132,7 +142,7 @@ namespace detail {
 //
 void
 route_event(
-    ui_system& sys, event_traversal& traversal, component_container* target)
+    ui_system& sys, event_traversal& traversal, alia_component* target)
 {
     try
     {
@@ -146,4 +156,25 @@ route_event(
 
 } // namespace detail
 
+void
+dispatch_targeted_event(ui_system& sys, alia_event& event, alia_element_id id)
+{
+    if (!alia_element_id_is_valid(id))
+    {
+        detail::dispatch_untargeted_event(sys, event);
+        return;
+    }
+    event.target = id;
+    if (id.route == 0)
+    {
+        detail::dispatch_untargeted_event(sys, event);
+        return;
+    }
+    if (alia_component* target
+        = component_table_lookup(sys.substrate.component_table, id.route))
+    {
+        detail::dispatch_targeted_event(sys, event, target);
+    }
+}
+
 } // namespace alia
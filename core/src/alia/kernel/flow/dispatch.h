@@ -19,23 +19,16 @@ namespace detail {
 //
 void
 route_event(
-    ui_system& sys, event_traversal& traversal, component_container* target);
+    ui_system& sys, event_traversal& traversal, alia_component* target);
 
 inline void
 dispatch_targeted_event(
-    ui_system& sys, alia_event& event, component_identity const& target)
+    ui_system& sys, alia_event& event, alia_component* target)
 {
-    // `target` is a weak_ptr, so we have to acquire a lock on it. It's
-    // possible that the target has actually been destroyed and we're trying to
-    // deliver an event to an non-existent target, in which case the lock will
-    // fail.
-    if (auto target_container = target.lock())
-    {
-        event_traversal traversal;
-        traversal.targeted = true;
-        traversal.event = &event;
-        route_event(sys, traversal, target_container.get());
-    }
+    event_traversal traversal;
+    traversal.targeted = true;
+    traversal.event = &event;
+    route_event(sys, traversal, target);
 }
 
 inline void
@@ -55,21 +48,14 @@ dispatch_event(ui_system& sys, alia_event& event)
     detail::dispatch_untargeted_event(sys, event);
 }
 
-inline void
-dispatch_targeted_event(
-    ui_system& sys, alia_event& event, external_component_id component)
-{
-    detail::dispatch_targeted_event(sys, event, component.identity);
-}
-
-// Deliver a "targeted" event while still traversing the full controller tree.
-// TODO: Implement actual targeted traversal.
-inline void
-dispatch_targeted_event(ui_system& sys, alia_event& event, alia_element_id id)
-{
-    if (alia_element_id_is_valid(id))
-        event.target = id;
-    detail::dispatch_untargeted_event(sys, event);
-}
+// Deliver an event to the element identified by `id`.
+//
+// If `id` carries a route node ID, the event is routed through the component
+// that owns the element (and its ancestors). If that component no longer
+// exists, neither does the element, so the event is dropped. IDs without
+// route information fall back to a traversal of the full controller tree.
+//
+void
+dispatch_targeted_event(ui_system& sys, alia_event& event, alia_element_id id);
 
 } // namespace alia
@@ -1,115 +1,53 @@
 #include <alia/kernel/flow/traversal.h>
 
-#include <alia/abi/ui/styling.h>
 #include <alia/impl/events.hpp>
+#include <alia/kernel/flow/components.h>
 
-namespace alia {
+namespace {
 
+// Set `flag` on `component` and its ancestors. Since a flag is only ever set
+// on a component if it's also set on all of its ancestors, the walk can stop
+// at the first one that already has it.
 void
-mark_dirty_component(component_container_ptr const& container)
+mark_component_chain(alia_component* component, uint8_t flag)
 {
-    component_container* c = container.get();
-    while (c && !c->dirty)
+    while (component && !(component->flags & flag))
     {
-        c->dirty = true;
-        c = c->parent.get();
+        component->flags |= flag;
+        component = component->parent;
     }
 }
 
+} // namespace
+
+namespace alia {
+
+void
+mark_dirty_component(alia_component* component)
+{
+    mark_component_chain(component, ALIA_COMPONENT_DIRTY);
+}
+
 void
 mark_dirty_component(ephemeral_context& ctx)
 {
-    event_traversal& traversal = *ctx.events;
-    // TODO: There should always be an active component container, but the
-    // component container tree doesn't really exist yet. Once it does, this
-    // could be removed or replaced with an assert.
-    if (traversal.active_container != nullptr)
-        mark_dirty_component(*traversal.active_container);
+    // Content outside of any component is always refreshed, so there's
+    // nothing to mark there.
+    if (ctx.events)
+        mark_dirty_component(ctx.events->active_component);
 }
 
 void
-mark_animating_component(component_container_ptr const& container)
+mark_animating_component(alia_component* component)
 {
-    component_container* r = container.get();
-    while (r && !r->animating)
-    {
-        r->animating = true;
-        r = r->parent.get();
-    }
+    mark_component_chain(component, ALIA_COMPONENT_ANIMATING);
 }
 
 void
 mark_animating_component(ephemeral_context& ctx)
 {
-    event_traversal& traversal = *ctx.events;
-    // TODO: There should always be an active component container, but the
-    // component container tree doesn't really exist yet. Once it does, this
-    // could be removed or replaced with an assert.
-    if (traversal.active_container != nullptr)
-        mark_animating_component(*traversal.active_container);
+    if (ctx.events)
+        mark_animating_component(ctx.events->active_component);
 }
 
-// void
-// scoped_component_container::begin(
-//     ephemeral_context& ctx, component_container_ptr* container)
-// {
-//     event_traversal& traversal = *ctx.event;
-
-//     ctx_.reset(ctx);
-
-//     container_ = container;
-
-//     if (traversal.active_container)
-//     {
-//         if ((*container)->parent != *traversal.active_container)
-//             (*container)->parent = *traversal.active_container;
-//     }
-//     else
-//         (*container)->parent.reset();
-
-//     parent_ = traversal.active_container;
-//     traversal.active_container = container;
-
-//     is_dirty_ = (*container)->dirty;
-//     (*container)->dirty = false;
-
-//     is_animating_ = (*container)->animating;
-//     (*container)->animating = false;
-
-//     if (traversal.targeted)
-//     {
-//         if (traversal.path_to_target
-//             && traversal.path_to_target->node == container->get())
-//         {
-//             traversal.path_to_target = traversal.path_to_target->rest;
-//             is_on_route_ = true;
-//         }
-//         else
-//             is_on_route_ = false;
-//     }
-//     else
-//         is_on_route_ = true;
-// }
-
-// void
-// scoped_component_container::begin(core_context ctx)
-// {
-//     component_container_ptr* container;
-//     if (get_data(ctx, &container))
-//         container->reset(new component_container);
-
-//     this->begin(ctx, container);
-// }
-
-// void
-// scoped_component_container::end()
-// {
-//     if (ctx_)
-//     {
-//         auto ctx = *ctx_;
-//         ctx->events->active_container = parent_;
-//         ctx_.reset();
-//     }
-// }
-
 } // namespace alia
@@ -2,92 +2,26 @@
 
 #include <alia/context.h>
 
-#include <memory>
+struct alia_component;
 
 namespace alia {
 
-struct component_container;
-
-typedef std::shared_ptr<component_container> component_container_ptr;
-
-struct component_container
-{
-    component_container_ptr parent;
-    // The component is dirty and needs to be refreshed immediately.
-    bool dirty = false;
-    // The component is animating and would like to be refreshed soon.
-    bool animating = false;
-};
-
-// TODO: Move this to an API file.
-
+// Mark `component` and all its ancestors dirty, so that they're refreshed
+// immediately. This stops at the first ancestor that's already marked.
 void
-mark_dirty_component(component_container_ptr const& container);
+mark_dirty_component(alia_component* component);
 
+// Mark the component that's active in `ctx` (if any) dirty.
 void
 mark_dirty_component(ephemeral_context& ctx);
 
+// Mark `component` and all its ancestors as animating (i.e., they would like
+// to be refreshed soon).
 void
-mark_animating_component(component_container_ptr const& container);
+mark_animating_component(alia_component* component);
 
+// Mark the component that's active in `ctx` (if any) as animating.
 void
 mark_animating_component(ephemeral_context& ctx);
 
-// TODO: Make this a C-friendly API.
-
-// struct scoped_component_container
-// {
-//     scoped_component_container()
-//     {
-//     }
-//     scoped_component_container(core_context ctx)
-//     {
-//         begin(ctx);
-//     }
-//     scoped_component_container(
-//         core_context ctx, component_container_ptr* container)
-//     {
-//         begin(ctx, container);
-//     }
-//     ~scoped_component_container()
-//     {
-//         end();
-//     }
-
-//     void
-//     begin(dataless_core_context ctx, component_container_ptr* container);
-
-//     void
-//     begin(core_context ctx);
-
-//     void
-//     end();
-
-//     bool
-//     is_on_route() const
-//     {
-//         return is_on_route_;
-//     }
-
-//     bool
-//     is_dirty() const
-//     {
-//         return is_dirty_;
-//     }
-
-//     bool
-//     is_animating() const
-//     {
-//         return is_animating_;
-//     }
-
-//  private:
-//     optional_context<ephemeral_context> ctx_;
-//     component_container_ptr* container_;
-//     component_container_ptr* parent_;
-//     bool is_on_route_;
-//     bool is_dirty_;
-//     bool is_animating_;
-// };
-
 } // namespace alia
@@ -0,0 +1,160 @@
+#include <alia/kernel/key_map.h>
+
+#include <alia/kernel/substrate.h>
+
+#include <cstring>
+
+namespace {
+
+// The minimum number of slots allocated on first insertion.
+uint32_t const min_key_map_capacity = 16;
+
+// Grow once the table would be more than 3/4 full.
+bool
+key_map_needs_growth(alia_substrate_key_map const& map)
+{
+    return (map.count + 1) * 4 > map.capacity * 3;
+}
+
+alia_substrate_key_map_slot*
+allocate_slots(alia_general_allocator const& allocator, uint32_t capacity)
+{
+    void* mem = allocator.alloc(
+        allocator.user_data,
+        capacity * sizeof(alia_substrate_key_map_slot),
+        alignof(alia_substrate_key_map_slot));
+    std::memset(mem, 0, capacity * sizeof(alia_substrate_key_map_slot));
+    return static_cast<alia_substrate_key_map_slot*>(mem);
+}
+
+void
+free_slots(
+    alia_general_allocator const& allocator,
+    alia_substrate_key_map_slot* slots,
+    uint32_t capacity)
+{
+    allocator.free(
+        allocator.user_data,
+        slots,
+        capacity * sizeof(alia_substrate_key_map_slot),
+        alignof(alia_substrate_key_map_slot));
+}
+
+// Place a slot into a table that's known to have room for it and known not to
+// contain its key.
+void
+place_slot(
+    alia_substrate_key_map_slot* slots,
+    uint32_t mask,
+    alia_substrate_key_map_slot slot)
+{
+    uint32_t i = slot.hash & mask;
+    while (slots[i].entry)
+        i = (i + 1) & mask;
+    slots[i] = slot;
+}
+
+void
+grow_key_map(
+    alia_substrate_key_map& map, alia_general_allocator const& allocator)
+{
+    uint32_t const new_capacity
+        = map.capacity == 0 ? min_key_map_capacity : map.capacity * 2;
+    alia_substrate_key_map_slot* new_slots
+        = allocate_slots(allocator, new_capacity);
+    uint32_t const new_mask = new_capacity - 1;
+    for (uint32_t i = 0; i != map.capacity; ++i)
+    {
+        if (map.slots[i].entry)
+            place_slot(new_slots, new_mask, map.slots[i]);
+    }
+    if (map.slots)
+        free_slots(allocator, map.slots, map.capacity);
+    map.slots = new_slots;
+    map.capacity = new_capacity;
+}
+
+} // namespace
+
+namespace alia {
+
+void
+key_map_init(alia_substrate_key_map& map)
+{
+    map.slots = nullptr;
+    map.capacity = 0;
+    map.count = 0;
+}
+
+void
+key_map_destroy(
+    alia_substrate_key_map& map, alia_general_allocator const& allocator)
+{
+    if (map.slots)
+        free_slots(allocator, map.slots, map.capacity);
+    key_map_init(map);
+}
+
+alia_substrate_key_entry*
+key_map_find(alia_substrate_key_map const& map, alia_id_view key)
+{
+    if (map.count == 0)
+        return nullptr;
+
+    uint32_t const hash = alia_id_view_hash(key);
+    uint32_t const mask = map.capacity - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        alia_substrate_key_map_slot const& slot = map.slots[i];
+        if (!slot.entry)
+            return nullptr;
+        if (slot.hash == hash
+            && alia_captured_id_matches_view(&slot.entry->key, key))
+        {
+            return slot.entry;
+        }
+    }
+}
+
+void
+key_map_insert(
+    alia_substrate_key_map& map,
+    alia_general_allocator const& allocator,
+    alia_substrate_key_entry* entry)
+{
+    ALIA_ASSERT(entry);
+    if (key_map_needs_growth(map))
+        grow_key_map(map, allocator);
+    place_slot(
+        map.slots,
+        map.capacity - 1,
+        alia_substrate_key_map_slot{
+            .hash = alia_id_view_hash(entry->key.view), .entry = entry});
+    ++map.count;
+}
+
+void
+key_map_erase_at(alia_substrate_key_map& map, uint32_t index)
+{
+    ALIA_ASSERT(index < map.capacity && map.slots[index].entry);
+
+    // Backward-shift deletion: Walk the rest of the probe run and move back
+    // any entry whose home slot doesn't lie (cyclically) between the hole and
+    // the entry's current position.
+    uint32_t const mask = map.capacity - 1;
+    uint32_t hole = index;
+    for (uint32_t i = (index + 1) & mask; map.slots[i].entry;
+         i = (i + 1) & mask)
+    {
+        uint32_t const home = map.slots[i].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            map.slots[hole] = map.slots[i];
+            hole = i;
+        }
+    }
+    map.slots[hole] = alia_substrate_key_map_slot{.hash = 0, .entry = nullptr};
+    --map.count;
+}
+
+} // namespace alia
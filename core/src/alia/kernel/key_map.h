@@ -0,0 +1,71 @@
+#pragma once
+
+#include <alia/abi/base/allocator.h>
+#include <alia/abi/kernel/ids.h>
+#include <alia/abi/prelude.h>
+
+#include <stdint.h>
+
+struct alia_substrate_key_entry;
+
+// A single slot in an `alia_substrate_key_map`.
+// The 32-bit hash of the entry's key is stored inline so that probing and
+// rehashing never have to touch the entry itself. A null `entry` marks an
+// empty slot.
+struct alia_substrate_key_map_slot
+{
+    uint32_t hash;
+    alia_substrate_key_entry* entry;
+};
+
+// `alia_substrate_key_map` is the lookup structure behind a substrate key
+// table. It's a flat, open-addressing hash table (linear probing) that maps
+// key views to key entries.
+//
+// Removal uses backward-shift deletion, so the table never contains
+// tombstones and probe sequences stay as short after a sweep as they were
+// before it.
+//
+// Slot storage is allocated through the substrate's general allocator.
+//
+struct alia_substrate_key_map
+{
+    // `capacity` slots (or null if nothing has been inserted yet)
+    alia_substrate_key_map_slot* slots;
+    // always either zero or a power of two
+    uint32_t capacity;
+    // the number of occupied slots
+    uint32_t count;
+};
+
+namespace alia {
+
+void
+key_map_init(alia_substrate_key_map& map);
+
+// Release the slot storage. (This doesn't touch the entries.)
+void
+key_map_destroy(
+    alia_substrate_key_map& map, alia_general_allocator const& allocator);
+
+// Find the entry whose captured key matches `key`, or null if none does.
+alia_substrate_key_entry*
+key_map_find(alia_substrate_key_map const& map, alia_id_view key);
+
+// Insert `entry` into the map.
+// The entry's key must not already be present.
+void
+key_map_insert(
+    alia_substrate_key_map& map,
+    alia_general_allocator const& allocator,
+    alia_substrate_key_entry* entry);
+
+// Remove the entry in slot `index` (which must be occupied).
+//
+// Entries that follow it in the same probe run are shifted back to fill the
+// hole, so after this returns, slot `index` may hold a different entry. A scan
+// that erases as it goes should re-examine `index` before moving on.
+void
+key_map_erase_at(alia_substrate_key_map& map, uint32_t index);
+
+} // namespace alia
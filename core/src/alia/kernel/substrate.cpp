@@ -7,41 +7,7 @@
 #include <alia/kernel/substrate.h>
 
 #include <algorithm>
-#include <unordered_map>
-#include <vector>
-
-struct alia_substrate_key_map
-{
-    struct view_key
-    {
-        alia_id_view view;
-    };
-
-    struct view_key_hash
-    {
-        size_t
-        operator()(view_key const& key) const
-        {
-            return alia_id_view_hash(key.view);
-        }
-    };
-
-    struct view_key_eq
-    {
-        bool
-        operator()(view_key const& a, view_key const& b) const
-        {
-            return alia_id_view_equal(a.view, b.view);
-        }
-    };
-
-    std::unordered_map<
-        view_key,
-        alia_substrate_key_entry*,
-        view_key_hash,
-        view_key_eq>
-        entries;
-};
+#include <chrono>
 
 // Visibility tiers in this file:
 // 1. C ABI — alia_substrate_* inside ALIA_EXTERN_C_BEGIN…END
@@ -219,26 +185,26 @@ free_key_entry(alia_substrate_system* system, alia_substrate_key_entry* entry)
 }
 
 void
-clear_key_map_cache(alia_substrate_system* system, alia_substrate_key_map* map)
+clear_key_map_cache(alia_substrate_system* system, alia_substrate_key_map& map)
 {
-    ALIA_ASSERT(system && map);
-    for (auto& [key, entry] : map->entries)
-        alia_substrate_deactivate_anchor(system, &entry->anchor);
+    ALIA_ASSERT(system);
+    for (uint32_t i = 0; i != map.capacity; ++i)
+    {
+        alia_substrate_key_entry* entry = map.slots[i].entry;
+        if (entry)
+            alia_substrate_deactivate_anchor(system, &entry->anchor);
+    }
 }
 
 void
-destroy_key_map(alia_substrate_system* system, alia_substrate_key_map* map)
+destroy_key_map(alia_substrate_system* system, alia_substrate_key_map& map)
 {
-    if (!map)
-        return;
-    for (auto& i : map->entries)
-        free_key_entry(system, i.second);
-    map->entries.clear();
-    system->allocator.free(
-        system->allocator.user_data,
-        map,
-        sizeof(alia_substrate_key_map),
-        alignof(alia_substrate_key_map));
+    for (uint32_t i = 0; i != map.capacity; ++i)
+    {
+        if (map.slots[i].entry)
+            free_key_entry(system, map.slots[i].entry);
+    }
+    alia::key_map_destroy(map, system->allocator);
 }
 
 void
@@ -250,6 +216,8 @@ unregister_key_table(
     {
         if (*link == table)
         {
+            if (system->sweep_table == table)
+                system->sweep_table = table->registry_next;
             *link = table->registry_next;
             table->registry_next = nullptr;
             return;
@@ -273,35 +241,15 @@ key_table_cleanup(
     auto* table = static_cast<alia_substrate_key_table*>(ptr);
     if (mode == ALIA_SUBSTRATE_CLEAR_CACHE)
     {
-        if (table->map)
-            clear_key_map_cache(system, table->map);
+        clear_key_map_cache(system, table->map);
         return;
     }
 
     destroy_key_map(system, table->map);
-    table->map = nullptr;
     unregister_key_table(system, table);
     table->first = nullptr;
 }
 
-alia_substrate_key_map*
-create_key_map(alia_substrate_system* system)
-{
-    void* mem = system->allocator.alloc(
-        system->allocator.user_data,
-        sizeof(alia_substrate_key_map),
-        alignof(alia_substrate_key_map));
-    return new (mem) alia_substrate_key_map();
-}
-
-alia_substrate_key_entry*
-find_entry_by_view(alia_substrate_key_map* map, alia_id_view view)
-{
-    alia_substrate_key_map::view_key key{view};
-    auto i = map->entries.find(key);
-    return i == map->entries.end() ? nullptr : i->second;
-}
-
 alia_substrate_key_entry*
 create_key_entry(
     alia_substrate_system* system,
@@ -325,8 +273,7 @@ create_key_entry(
         .flags = 0,
         .next = nullptr};
 
-    alia_substrate_key_map::view_key map_key{entry->key.view};
-    table->map->entries.emplace(map_key, entry);
+    alia::key_map_insert(table->map, system->allocator, entry);
     return entry;
 }
 
@@ -356,7 +303,7 @@ resolve_key_entry(
     }
     else
     {
-        entry = find_entry_by_view(scope->table->map, key);
+        entry = alia::key_map_find(scope->table->map, key);
         if (!entry)
         {
             entry
@@ -373,26 +320,150 @@ resolve_key_entry(
 void
 sweep_key_table(alia_substrate_key_table* table)
 {
-    if (!table || !table->map)
+    if (!table)
         return;
 
     alia_substrate_system* system = table->system;
-    std::vector<alia_substrate_key_entry*> to_remove;
-    to_remove.reserve(table->map->entries.size());
-    for (auto& i : table->map->entries)
+    alia_substrate_key_map& map = table->map;
+    uint32_t i = 0;
+    while (i != map.capacity)
     {
-        if (entry_is_collectible(table, i.second))
-            to_remove.push_back(i.second);
+        alia_substrate_key_entry* entry = map.slots[i].entry;
+        if (entry && entry_is_collectible(table, entry))
+        {
+            // Erasing shifts later entries back into slot `i`, so don't
+            // advance.
+            alia::key_map_erase_at(map, i);
+            free_key_entry(system, entry);
+        }
+        else
+        {
+            ++i;
+        }
     }
+}
 
-    for (alia_substrate_key_entry* entry : to_remove)
+void
+free_pending_entries(alia_substrate_system* system)
+{
+    while (system->pending_frees)
     {
-        alia_substrate_key_map::view_key map_key{entry->key.view};
-        table->map->entries.erase(map_key);
+        alia_substrate_key_entry* entry = system->pending_frees;
+        system->pending_frees = entry->next;
+        --system->pending_free_count;
         free_key_entry(system, entry);
     }
 }
 
+void
+reset_incremental_sweep(alia_substrate_system* system)
+{
+    free_pending_entries(system);
+    for (alia_substrate_key_table* table = system->key_table_registry; table;
+         table = table->registry_next)
+    {
+        table->sweep_cursor = 0;
+    }
+    system->sweep_in_progress = false;
+    system->sweep_table = nullptr;
+}
+
+alia_nanosecond_count
+steady_clock_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Reading the clock costs far more than a unit of sweeping work, so deadlines
+// are only checked this often.
+size_t const sweep_clock_check_interval = 64;
+
+struct sweep_budget_tracker
+{
+    alia_substrate_sweep_budget budget;
+    size_t work_done = 0;
+    bool exhausted = false;
+
+    bool
+    allows_more_work()
+    {
+        if (exhausted)
+            return false;
+        if (budget.max_work != 0 && work_done >= budget.max_work)
+        {
+            exhausted = true;
+        }
+        else if (
+            budget.deadline != 0
+            && work_done % sweep_clock_check_interval == 0
+            && steady_clock_now_ns() >= budget.deadline)
+        {
+            exhausted = true;
+        }
+        return !exhausted;
+    }
+};
+
+void
+free_pending_entries(
+    alia_substrate_system* system, sweep_budget_tracker& tracker)
+{
+    while (system->pending_frees && tracker.allows_more_work())
+    {
+        alia_substrate_key_entry* entry = system->pending_frees;
+        system->pending_frees = entry->next;
+        --system->pending_free_count;
+        free_key_entry(system, entry);
+        ++tracker.work_done;
+    }
+}
+
+// Continue sweeping `table` from its cursor.
+// Stale entries are moved to the system's pending free list.
+// Returns true iff the end of the table was reached.
+bool
+sweep_key_table_incrementally(
+    alia_substrate_key_table* table, sweep_budget_tracker& tracker)
+{
+    alia_substrate_system* system = table->system;
+    alia_substrate_key_map& map = table->map;
+    while (table->sweep_cursor < map.capacity)
+    {
+        if (!tracker.allows_more_work())
+            return false;
+        ++tracker.work_done;
+        alia_substrate_key_entry* entry = map.slots[table->sweep_cursor].entry;
+        if (entry && entry_is_collectible(table, entry))
+        {
+            // As in `sweep_key_table`, the cursor stays put.
+            alia::key_map_erase_at(map, table->sweep_cursor);
+            entry->next = system->pending_frees;
+            system->pending_frees = entry;
+            ++system->pending_free_count;
+        }
+        else
+        {
+            ++table->sweep_cursor;
+        }
+    }
+    table->sweep_cursor = 0;
+    return true;
+}
+
+size_t
+count_pending_sweep_slots(alia_substrate_system const* system)
+{
+    size_t count = 0;
+    for (alia_substrate_key_table const* table = system->sweep_table; table;
+         table = table->registry_next)
+    {
+        count += table->map.capacity - table->sweep_cursor;
+    }
+    return count;
+}
+
 } // namespace
 
 namespace alia {
@@ -403,18 +474,22 @@ substrate_system_init(
 {
     memset(&system, 0, sizeof(system));
     system.allocator = allocator;
+    component_table_init(system.component_table);
 }
 
 void
 substrate_system_destroy(alia_substrate_system& system)
 {
+    free_pending_entries(&system);
     block_destroy(&system, system.root_anchor.block);
     system.root_anchor.block = nullptr;
+    component_table_destroy(system.component_table, system.allocator);
 }
 
 void
 substrate_system_reset(alia_substrate_system& system)
 {
+    reset_incremental_sweep(&system);
     if (system.root_anchor.block)
     {
         block_destroy(&system, system.root_anchor.block);
@@ -681,9 +756,10 @@ alia_substrate_use_key_table(
         table->requires_explicit_delete
             = flags == ALIA_SUBSTRATE_KEY_TABLE_REQUIRES_EXPLICIT_DELETE;
         table->first = nullptr;
-        table->map = create_key_map(system);
+        alia::key_map_init(table->map);
         table->system = system;
         table->registry_next = nullptr;
+        table->sweep_cursor = 0;
         register_key_table(system, table);
     }
     return table;
@@ -744,6 +820,7 @@ void
 alia_substrate_sweep_system_keys(alia_substrate_system* system)
 {
     ALIA_ASSERT(system);
+    reset_incremental_sweep(system);
     for (alia_substrate_key_table* table = system->key_table_registry; table;
          table = table->registry_next)
     {
@@ -751,11 +828,46 @@ alia_substrate_sweep_system_keys(alia_substrate_system* system)
     }
 }
 
+alia_substrate_sweep_progress
+alia_substrate_sweep_system_keys_incrementally(
+    alia_substrate_system* system, alia_substrate_sweep_budget budget)
+{
+    ALIA_ASSERT(system);
+
+    sweep_budget_tracker tracker{.budget = budget};
+
+    // Work off the blocks left over from earlier calls first so that the
+    // backlog can't grow without bound.
+    free_pending_entries(system, tracker);
+
+    if (!system->sweep_in_progress)
+    {
+        system->sweep_in_progress = true;
+        system->sweep_table = system->key_table_registry;
+    }
+
+    while (system->sweep_table
+           && sweep_key_table_incrementally(system->sweep_table, tracker))
+    {
+        system->sweep_table = system->sweep_table->registry_next;
+    }
+
+    free_pending_entries(system, tracker);
+
+    if (!system->sweep_table && !system->pending_frees)
+        system->sweep_in_progress = false;
+
+    return alia_substrate_sweep_progress{
+        .work_done = tracker.work_done,
+        .pending_slots = count_pending_sweep_slots(system),
+        .pending_frees = system->pending_free_count};
+}
+
 void
 alia_substrate_delete_key(alia_substrate_key_table* table, alia_id_view key)
 {
-    ALIA_ASSERT(table && table->map);
-    alia_substrate_key_entry* entry = find_entry_by_view(table->map, key);
+    ALIA_ASSERT(table);
+    alia_substrate_key_entry* entry = alia::key_map_find(table->map, key);
     if (!entry)
         return;
     entry->flags |= ALIA_SUBSTRATE_KEY_EXPLICITLY_DELETED;
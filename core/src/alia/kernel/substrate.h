@@ -4,11 +4,12 @@
 #include <alia/abi/kernel/ids.h>
 #include <alia/abi/kernel/substrate.h>
 #include <alia/abi/prelude.h>
+#include <alia/kernel/flow/component_table.h>
+#include <alia/kernel/key_map.h>
 
 #include <stdint.h>
 
 struct alia_substrate_system;
-struct alia_substrate_key_map;
 struct alia_substrate_key_table;
 
 struct alia_substrate_cleanup_record
@@ -54,10 +55,12 @@ struct alia_substrate_key_table
 {
     bool requires_explicit_delete;
     alia_substrate_key_entry* first;
-    alia_substrate_key_map* map;
+    alia_substrate_key_map map;
     alia_substrate_system* system;
     alia_substrate_key_table* registry_next;
     uint32_t last_seen;
+    // the slot where the incremental sweep resumes within this table
+    uint32_t sweep_cursor;
 };
 
 struct alia_substrate_system
@@ -68,6 +71,21 @@ struct alia_substrate_system
     // incremented whenever a block is freed (and thus might be reused)
     alia_generation_counter current_generation;
     alia_substrate_key_table* key_table_registry;
+
+    // incremental sweep state
+    // true while a sweep cycle is underway
+    bool sweep_in_progress;
+    // the table where the current cycle resumes (null once it has visited
+    // every table)
+    alia_substrate_key_table* sweep_table;
+    // stale entries that have been removed from their tables but still need
+    // to be freed (linked through `next`)
+    alia_substrate_key_entry* pending_frees;
+    size_t pending_free_count;
+
+    // maps route node IDs to the skippable components that live in this
+    // system's blocks
+    alia_component_table component_table;
 };
 
 struct alia_substrate_block_traversal_state
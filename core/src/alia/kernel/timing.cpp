@@ -1,11 +1,11 @@
 #include <alia/abi/kernel/timing.h>
 
+#include <alia/abi/kernel/components.h>
 #include <alia/abi/kernel/events.h>
 #include <alia/abi/kernel/substrate.h>
 #include <alia/abi/prelude.h>
 #include <alia/abi/ui/system/work.h>
 #include <alia/impl/events.hpp>
-#include <alia/kernel/flow/traversal.h>
 #include <alia/ui/system/object.h>
 
 #include <cstring>
@@ -46,8 +46,7 @@ alia_timing_request_animation_refresh(alia_context* ctx)
     ALIA_ASSERT(ctx->system);
 
     alia_ui_mark_dirty(ctx->system);
-    if (ctx->events)
-        alia::mark_animating_component(*ctx);
+    alia_component_mark_animating(ctx);
 }
 
 alia_timer_state*
@@ -71,8 +70,10 @@ alia_timer_use(alia_context* ctx)
         state->expected_fire_time = 0;
     }
 
-    // A stable target identifier for matching the timer event.
-    state->target = static_cast<alia_element_id>(state);
+    // A stable target identifier for matching the timer event. (This also
+    // carries the route to the enclosing component, so timer events don't
+    // have to visit the rest of the controller.)
+    state->target = alia_make_element_id(ctx, result);
 
     return state;
 }
@@ -24,6 +24,18 @@ target_from_key(uint64_t key)
     return alia_draw_target_id(key >> 48);
 }
 
+inline alia_z_index
+z_index_from_key(uint64_t key)
+{
+    return alia_z_index((key >> 32) & 0xffff);
+}
+
+inline alia_clip_id
+clip_from_key(uint64_t key)
+{
+    return alia_clip_id((key >> 16) & 0xffff);
+}
+
 inline alia_draw_material_id
 material_from_key(uint64_t key)
 {
@@ -0,0 +1,189 @@
+#include <alia/ui/drawing/bucket_table.h>
+
+#include <alia/impl/base/arena.hpp>
+
+#include <cstring>
+
+namespace {
+
+// the number of buckets allocated for the first bucket in a pass
+uint32_t const min_bucket_capacity = 64;
+
+uint32_t
+hash_bucket_key(uint64_t key)
+{
+    // Most of the entropy is in the low fields (clip and material), so mix
+    // the whole key down.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return uint32_t(key);
+}
+
+// Place bucket `index` into the index, which is known to have room for it.
+void
+place_bucket(alia_draw_bucket_table& table, uint32_t index)
+{
+    uint32_t const mask = table.slot_capacity - 1;
+    uint32_t i = hash_bucket_key(table.keys[index]) & mask;
+    while (table.slots[i] != 0)
+        i = (i + 1) & mask;
+    table.slots[i] = index + 1;
+}
+
+// Make room for another bucket.
+//
+// Since the storage comes from a bump allocator, the old arrays are simply
+// abandoned. (Growth is geometric, so this wastes at most as much space as
+// the final arrays use, and it's all reclaimed at the end of the pass.)
+//
+void
+grow_bucket_table(alia_draw_bucket_table& table)
+{
+    uint32_t const new_capacity = table.capacity == 0
+                                    ? min_bucket_capacity
+                                    : table.capacity * 2;
+    uint64_t* new_keys
+        = alia::arena_alloc_array<uint64_t>(*table.arena, new_capacity);
+    alia_draw_bucket* new_buckets = alia::arena_alloc_array<alia_draw_bucket>(
+        *table.arena, new_capacity);
+    uint32_t* new_stamps
+        = alia::arena_alloc_array<uint32_t>(*table.arena, new_capacity);
+    if (table.count != 0)
+    {
+        std::memcpy(new_keys, table.keys, table.count * sizeof(uint64_t));
+        std::memcpy(
+            new_buckets,
+            table.buckets,
+            table.count * sizeof(alia_draw_bucket));
+        std::memcpy(
+            new_stamps,
+            table.recorder_stamps,
+            table.count * sizeof(uint32_t));
+    }
+    table.keys = new_keys;
+    table.buckets = new_buckets;
+    table.recorder_stamps = new_stamps;
+    table.capacity = new_capacity;
+
+    // Keep the index at most half full.
+    table.slot_capacity = new_capacity * 2;
+    table.slots = alia::arena_alloc_array<uint32_t>(
+        *table.arena, table.slot_capacity);
+    std::memset(table.slots, 0, table.slot_capacity * sizeof(uint32_t));
+    for (uint32_t i = 0; i != table.count; ++i)
+        place_bucket(table, i);
+}
+
+} // namespace
+
+namespace alia {
+
+void
+draw_bucket_table_init(
+    alia_draw_bucket_table& table, alia_bump_allocator* arena)
+{
+    table = alia_draw_bucket_table{
+        .arena = arena,
+        .keys = nullptr,
+        .buckets = nullptr,
+        .count = 0,
+        .capacity = 0,
+        .recorder_stamps = nullptr,
+        .slots = nullptr,
+        .slot_capacity = 0,
+        .last = 0,
+        .recorder = nullptr,
+        .last_recorder_id = 0,
+        .damage_root = nullptr,
+    };
+}
+
+uint32_t
+draw_bucket_table_find_or_create(
+    alia_draw_bucket_table& table, uint64_t key, alia_box* clip_rect)
+{
+    if (table.last != table.count && table.keys[table.last] == key)
+        return table.last;
+
+    if (table.slot_capacity != 0)
+    {
+        uint32_t const mask = table.slot_capacity - 1;
+        for (uint32_t i = hash_bucket_key(key) & mask; table.slots[i] != 0;
+             i = (i + 1) & mask)
+        {
+            uint32_t const index = table.slots[i] - 1;
+            if (table.keys[index] == key)
+            {
+                table.last = index;
+                return index;
+            }
+        }
+    }
+
+    if (table.count == table.capacity)
+        grow_bucket_table(table);
+    uint32_t const index = table.count++;
+    table.keys[index] = key;
+    table.buckets[index] = alia_draw_bucket{
+        .clip_rect = clip_rect,
+        .head = nullptr,
+        .tail = nullptr,
+        .count = 0,
+        .instance_count = 0,
+    };
+    table.recorder_stamps[index] = 0;
+    place_bucket(table, index);
+    table.last = index;
+    return index;
+}
+
+sorted_draw_bucket*
+sort_draw_buckets(alia_draw_bucket_table& table)
+{
+    uint32_t const count = table.count;
+    sorted_draw_bucket* sorted
+        = alia::arena_alloc_array<sorted_draw_bucket>(*table.arena, count);
+    if (count == 0)
+        return sorted;
+    sorted_draw_bucket* temp
+        = alia::arena_alloc_array<sorted_draw_bucket>(*table.arena, count);
+
+    uint64_t varying = 0;
+    for (uint32_t i = 0; i != count; ++i)
+    {
+        sorted[i] = {table.keys[i], i};
+        varying |= table.keys[i] ^ table.keys[0];
+    }
+
+    // LSD radix sort, one byte at a time. Keys are unique, and within a frame
+    // most of the fields (the target and clip in particular) tend to take on
+    // only a few values, so bytes that are the same across all keys are
+    // skipped entirely.
+    for (unsigned shift = 0; shift != 64; shift += 8)
+    {
+        if (((varying >> shift) & 0xff) == 0)
+            continue;
+
+        uint32_t offsets[256] = {};
+        for (uint32_t i = 0; i != count; ++i)
+            ++offsets[(sorted[i].key >> shift) & 0xff];
+        uint32_t total = 0;
+        for (uint32_t& offset : offsets)
+        {
+            uint32_t const n = offset;
+            offset = total;
+            total += n;
+        }
+        for (uint32_t i = 0; i != count; ++i)
+            temp[offsets[(sorted[i].key >> shift) & 0xff]++] = sorted[i];
+
+        sorted_draw_bucket* swap = sorted;
+        sorted = temp;
+        temp = swap;
+    }
+
+    return sorted;
+}
+
+} // namespace alia
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <alia/abi/base/arena.h>
+#include <alia/abi/ui/drawing/commands.h>
+
+#include <cstdint>
+
+namespace alia {
+struct draw_damage_scope;
+struct draw_recorder;
+}
+
+extern "C" {
+
+// `alia_draw_bucket_table` collects the draw buckets for a single draw pass.
+//
+// Buckets are identified by their 64-bit bucket key (see `bucket_key.h`) and
+// stored in a flat array in creation order. A small open-addressing index
+// (linear probing) maps keys to bucket indices. All storage comes from a bump
+// allocator that's reset for every pass, so once the underlying arena has
+// grown to fit a typical frame, the table doesn't allocate at all.
+//
+struct alia_draw_bucket_table
+{
+    alia_bump_allocator* arena;
+
+    // the buckets and their keys, in creation order
+    uint64_t* keys;
+    alia_draw_bucket* buckets;
+    uint32_t count;
+    uint32_t capacity;
+    // for each bucket, the ID of the most recent draw recorder that it was
+    // registered with (or 0) - See `retention.h`.
+    uint32_t* recorder_stamps;
+
+    // the index - Each slot holds a bucket index plus one (or zero if empty).
+    uint32_t* slots;
+    // always either zero or a power of two
+    uint32_t slot_capacity;
+
+    // the index of the most recently used bucket (or `count` if none)
+    // Consecutive commands usually land in the same bucket, so this is checked
+    // before probing.
+    uint32_t last;
+
+    // the innermost active draw recorder (or null)
+    alia::draw_recorder* recorder;
+    // the ID of the last recorder that was started
+    uint32_t last_recorder_id;
+
+    // the damage scope for drawing outside of any recorder (or null if damage
+    // isn't being tracked) - See `damage.h`.
+    alia::draw_damage_scope* damage_root;
+};
+
+} // extern "C"
+
+namespace alia {
+
+// a bucket reference in draw order
+struct sorted_draw_bucket
+{
+    uint64_t key;
+    uint32_t bucket;
+};
+
+void
+draw_bucket_table_init(
+    alia_draw_bucket_table& table, alia_bump_allocator* arena);
+
+// Find the bucket for `key`, creating it (with `clip_rect`) if needed.
+// Returns the bucket's index.
+uint32_t
+draw_bucket_table_find_or_create(
+    alia_draw_bucket_table& table, uint64_t key, alia_box* clip_rect);
+
+// Get the table's buckets in draw (i.e., key) order.
+// The result is allocated from the table's arena and holds `table.count`
+// entries.
+sorted_draw_bucket*
+sort_draw_buckets(alia_draw_bucket_table& table);
+
+} // namespace alia
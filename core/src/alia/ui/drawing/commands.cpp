@@ -5,12 +5,17 @@
 
 #include <alia/context.h>
 #include <alia/ui/drawing/bucket_key.h>
+#include <alia/ui/drawing/bucket_table.h>
+#include <alia/ui/drawing/damage.h>
+#include <alia/ui/drawing/retention.h>
 #include <alia/ui/drawing/system.h>
 #include <alia/ui/system/object.h>
 
+#include <cstring>
+
 namespace {
 
-static alia_draw_bucket*
+static uint32_t
 find_or_create_draw_bucket(
     alia_context* ctx, alia_z_index z_index, alia_draw_material_id material_id)
 {
@@ -19,23 +24,12 @@ find_or_create_draw_bucket(
         z_index,
         ctx->geometry->clip.id,
         material_id);
-    alia_draw_bucket_table* const buckets = ctx->draw->buckets;
-    auto it = buckets->buckets.find(key);
-    if (it == buckets->buckets.end())
-    {
-        buckets->keys.push_back(key);
-        it = buckets->buckets.insert(
-            it,
-            {key,
-             alia_draw_bucket{
-                 .clip_rect = ctx->geometry->clip.pointer,
-                 .head = nullptr,
-                 .tail = nullptr,
-                 .count = 0,
-                 .instance_count = 0,
-             }});
-    }
-    return &it->second;
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    uint32_t const index = alia::draw_bucket_table_find_or_create(
+        table, key, ctx->geometry->clip.pointer);
+    if (table.recorder)
+        alia::note_draw_bucket_use(table, index);
+    return index;
 }
 
 static inline void
@@ -63,8 +57,18 @@ alia_draw_command_alloc(
 {
     auto* command = (alia_draw_command*) alia_arena_ptr(
         &ctx->draw->arena, alia_arena_alloc(&ctx->draw->arena, size));
-    auto* bucket = find_or_create_draw_bucket(ctx, z_index, material_id);
-    append_draw_command(bucket, command);
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    uint32_t const bucket
+        = find_or_create_draw_bucket(ctx, z_index, material_id);
+    append_draw_command(&table.buckets[bucket], command);
+    if (table.damage_root)
+    {
+        // Damage tracking hashes the command's bytes, so don't leave any
+        // padding uninitialized.
+        std::memset(command + 1, 0, size - sizeof(alia_draw_command));
+        alia::note_draw_command(table, command, size, table.keys[bucket]);
+    }
+    ++ctx->system->draw.stats.commands_recorded;
     return command;
 }
 
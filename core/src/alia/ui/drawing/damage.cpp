@@ -0,0 +1,370 @@
+#include <alia/ui/drawing/damage.h>
+
+#include <alia/abi/ui/system/renderer.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/ui/drawing/bucket_table.h>
+#include <alia/ui/drawing/retention.h>
+#include <alia/ui/system/object.h>
+
+#include <cmath>
+
+using namespace alia;
+
+namespace {
+
+uint64_t const hash_seed = 0xcbf29ce484222325ull;
+
+uint64_t
+hash_bytes(uint64_t h, void const* data, size_t size)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i != size; ++i)
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    return h;
+}
+
+template<class T>
+uint64_t
+hash_value(uint64_t h, T const& value)
+{
+    return hash_bytes(h, &value, sizeof(T));
+}
+
+draw_damage_scope*
+innermost_scope(alia_draw_bucket_table& table)
+{
+    return table.recorder ? &table.recorder->damage : table.damage_root;
+}
+
+void
+extend_bounds(alia_box& bounds, bool& has_bounds, alia_box box)
+{
+    bounds = has_bounds ? alia_box_union(bounds, box) : box;
+    has_bounds = true;
+}
+
+// Get the surface region that `box` (in the current frame of reference)
+// covers after clipping. This returns false if nothing is left.
+bool
+get_clipped_region(alia_context* ctx, alia_box box, alia_box& region)
+{
+    alia_box const translated
+        = alia_box_translate(box, ctx->geometry->offset);
+    alia_box const clip = alia_geometry_get_clip_box(ctx);
+    alia_vec2f const min = alia_vec2f_max(translated.min, clip.min);
+    alia_vec2f const max = alia_vec2f_min(
+        alia_vec2f_add(translated.min, translated.size),
+        alia_vec2f_add(clip.min, clip.size));
+    if (max.x <= min.x || max.y <= min.y)
+        return false;
+    region = alia_box_make(min, alia_vec2f_sub(max, min));
+    return true;
+}
+
+// Hash the commands drawn directly within `scope`.
+// The `next` links are left out since they depend on what else was drawn
+// into the same buckets.
+uint64_t
+hash_scope(draw_damage_scope const& scope)
+{
+    uint64_t h = hash_value(hash_seed, scope.child_hash);
+    for (draw_command_note const* note = scope.commands; note;
+         note = note->next)
+    {
+        h = hash_value(h, note->key);
+        h = hash_bytes(
+            h,
+            note->command + 1,
+            note->size - sizeof(alia_draw_command));
+        if (note->data)
+            h = hash_bytes(h, note->data, note->data_size);
+    }
+    return h;
+}
+
+float
+box_area(alia_box const& box)
+{
+    return box.size.x * box.size.y;
+}
+
+bool
+boxes_overlap(alia_box const& a, alia_box const& b)
+{
+    return a.min.x < b.min.x + b.size.x && b.min.x < a.min.x + a.size.x
+        && a.min.y < b.min.y + b.size.y && b.min.y < a.min.y + a.size.y;
+}
+
+} // namespace
+
+namespace alia {
+
+void
+draw_damage_scope_init(draw_damage_scope& scope)
+{
+    scope.commands = nullptr;
+    scope.child_hash = hash_seed;
+    scope.bounded = false;
+    scope.has_own_bounds = false;
+    scope.has_child_bounds = false;
+    scope.has_volatile_bounds = false;
+}
+
+void
+draw_damage_begin_pass(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_scope& root)
+{
+    alia_draw_damage& damage = system.draw.damage;
+    damage.full = false;
+    damage.count = 0;
+    if (!system.renderer.draw_pass_set_damage)
+    {
+        damage.full = true;
+        system.draw.damage_baseline_valid = false;
+        return;
+    }
+    draw_damage_scope_init(root);
+    table.damage_root = &root;
+}
+
+void
+draw_damage_end_pass(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_scope& root)
+{
+    if (!table.damage_root)
+        return;
+    table.damage_root = nullptr;
+
+    alia_draw_system& draw = system.draw;
+    uint64_t const hash = hash_scope(root);
+    if (!draw.damage_baseline_valid
+        || hash != draw.damage_root_hash
+        || draw.damage_retained_epoch != draw.retained_epoch
+        || draw.damage_surface_size.x != system.surface_size.x
+        || draw.damage_surface_size.y != system.surface_size.y)
+    {
+        draw.damage.full = true;
+    }
+    if (draw.damage.full)
+        draw.damage.count = 0;
+    if (root.has_volatile_bounds)
+    {
+        add_draw_damage(
+            draw.damage, root.volatile_bounds, system.surface_size);
+    }
+
+    draw.damage_baseline_valid = true;
+    draw.damage_root_hash = hash;
+    draw.damage_retained_epoch = draw.retained_epoch;
+    draw.damage_surface_size = system.surface_size;
+}
+
+void
+note_draw_command(
+    alia_draw_bucket_table& table,
+    alia_draw_command const* command,
+    size_t size,
+    uint64_t key)
+{
+    draw_damage_scope& scope = *innermost_scope(table);
+    draw_command_note* note = arena_new<draw_command_note>(*table.arena);
+    note->next = scope.commands;
+    note->command = command;
+    note->size = size;
+    note->key = key;
+    note->data = nullptr;
+    note->data_size = 0;
+    scope.commands = note;
+}
+
+void
+note_draw_command_data(
+    alia_draw_bucket_table& table,
+    alia_draw_command const* command,
+    void const* data,
+    size_t size)
+{
+    draw_command_note* note = innermost_scope(table)->commands;
+    ALIA_ASSERT(note && note->command == command);
+    note->data = data;
+    note->data_size = size;
+}
+
+void
+note_draw_child(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_summary const& summary)
+{
+    if (!summary.valid)
+        system.draw.damage.full = true;
+    draw_damage_scope& scope = *innermost_scope(table);
+    scope.child_hash = hash_value(scope.child_hash, summary.has_bounds);
+    if (summary.has_bounds)
+    {
+        scope.child_hash = hash_value(scope.child_hash, summary.bounds);
+        extend_bounds(
+            scope.child_bounds, scope.has_child_bounds, summary.bounds);
+    }
+    if (summary.has_volatile_bounds)
+    {
+        extend_bounds(
+            scope.volatile_bounds,
+            scope.has_volatile_bounds,
+            summary.volatile_bounds);
+    }
+}
+
+void
+end_draw_damage_scope(
+    alia_ui_system& system,
+    draw_damage_scope const& scope,
+    draw_damage_summary const* previous,
+    bool retainable,
+    draw_damage_summary& summary)
+{
+    summary.valid = true;
+    summary.hash = hash_scope(scope);
+    summary.has_bounds = false;
+    summary.volatile_bounds = scope.volatile_bounds;
+    summary.has_volatile_bounds = scope.has_volatile_bounds;
+    if (scope.has_own_bounds)
+        extend_bounds(summary.bounds, summary.has_bounds, scope.own_bounds);
+    if (scope.has_child_bounds)
+    {
+        extend_bounds(
+            summary.bounds, summary.has_bounds, scope.child_bounds);
+    }
+
+    alia_draw_damage& damage = system.draw.damage;
+    // If there's no previous recording to compare against or the drawing
+    // can't be bounded, there's no telling what changed.
+    if (!previous || !previous->valid || !retainable
+        || (scope.commands && !scope.bounded))
+    {
+        damage.full = true;
+        return;
+    }
+    if (previous->hash == summary.hash
+        && previous->has_bounds == summary.has_bounds
+        && (!summary.has_bounds
+            || alia_box_equal(previous->bounds, summary.bounds)))
+    {
+        return;
+    }
+    if (previous->has_bounds)
+        add_draw_damage(damage, previous->bounds, system.surface_size);
+    if (summary.has_bounds)
+        add_draw_damage(damage, summary.bounds, system.surface_size);
+}
+
+void
+add_draw_damage(alia_draw_damage& damage, alia_box box, alia_vec2i surface)
+{
+    if (damage.full)
+        return;
+
+    // Round out to whole pixels and clip to the surface.
+    float const x0 = std::fmax(std::floor(box.min.x), 0.f);
+    float const y0 = std::fmax(std::floor(box.min.y), 0.f);
+    float const x1 = std::fmin(std::ceil(box.min.x + box.size.x), surface.x);
+    float const y1 = std::fmin(std::ceil(box.min.y + box.size.y), surface.y);
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    box = alia_box_make({x0, y0}, {x1 - x0, y1 - y0});
+
+    // Absorb any rects that overlap the new one. (Each merge can create new
+    // overlaps, so this repeats until there are none.)
+    for (uint32_t i = 0; i != damage.count;)
+    {
+        if (boxes_overlap(damage.rects[i], box))
+        {
+            box = alia_box_union(box, damage.rects[i]);
+            damage.rects[i] = damage.rects[--damage.count];
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (damage.count == ALIA_MAX_DRAW_DAMAGE_RECTS)
+    {
+        // Merge with whichever rect grows the least from it.
+        uint32_t best = 0;
+        float best_growth = 0;
+        for (uint32_t i = 0; i != damage.count; ++i)
+        {
+            float const growth
+                = box_area(alia_box_union(damage.rects[i], box))
+                - box_area(damage.rects[i]);
+            if (i == 0 || growth < best_growth)
+            {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        box = alia_box_union(box, damage.rects[best]);
+        damage.rects[best] = damage.rects[--damage.count];
+        add_draw_damage(damage, box, surface);
+        return;
+    }
+
+    damage.rects[damage.count++] = box;
+}
+
+} // namespace alia
+
+extern "C" {
+
+alia_draw_damage const*
+alia_ui_get_draw_damage(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    return &system->draw.damage;
+}
+
+void
+alia_draw_note_bounds(alia_context* ctx, alia_box box)
+{
+    ALIA_ASSERT(ctx);
+    if (!ctx->draw)
+        return;
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    if (!table.damage_root || !table.recorder)
+        return;
+
+    // Bounds are only needed for retaining components, since any change
+    // outside of them damages the whole surface anyway.
+    draw_damage_scope& scope = table.recorder->damage;
+    scope.bounded = true;
+    alia_box region;
+    if (get_clipped_region(ctx, box, region))
+        extend_bounds(scope.own_bounds, scope.has_own_bounds, region);
+}
+
+void
+alia_draw_note_volatile(alia_context* ctx, alia_box box)
+{
+    ALIA_ASSERT(ctx);
+    if (!ctx->draw)
+        return;
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    if (!table.damage_root)
+        return;
+
+    draw_damage_scope& scope = *innermost_scope(table);
+    alia_box region;
+    if (get_clipped_region(ctx, box, region))
+    {
+        extend_bounds(
+            scope.volatile_bounds, scope.has_volatile_bounds, region);
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/context.h>
+#include <alia/abi/ui/drawing/commands.h>
+#include <alia/abi/ui/drawing/system.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// DAMAGE TRACKING
+//
+// When the renderer can preserve the primary target between passes, each
+// draw pass works out which parts of the surface actually changed, so that
+// only those need to be redrawn (and presented).
+//
+// This builds on retained drawing. Each retaining component that runs its
+// content (rather than replaying it) summarizes what it drew as a hash of its
+// own commands (along with the bounds of its retaining children) and the
+// surface bounds of everything it drew. If the summary differs from the one
+// stored with its previous recording, the old and new bounds are damaged.
+// Components that replay are unchanged by definition.
+//
+// Commands that aren't drawn by any retaining component are summarized the
+// same way for the pass as a whole, but since there are no bounds to go with
+// them, any change there damages the whole surface. (So does anything that
+// makes the previous frame unknowable, like resizing the surface or
+// reclaiming the retained arena.)
+//
+// Commands can also refer to data outside of themselves. Effect parameters
+// are hashed along with their commands, but content that draws from external
+// state (like viewports) notes its region as volatile, and volatile regions
+// are damaged on every pass (including ones where they're replayed).
+
+struct alia_draw_bucket_table;
+struct alia_ui_system;
+
+namespace alia {
+
+// a command that was drawn within a damage scope
+struct draw_command_note
+{
+    draw_command_note* next;
+    alia_draw_command const* command;
+    size_t size;
+    uint64_t key;
+    // out-of-line data that the command refers to (or null if none)
+    void const* data;
+    size_t data_size;
+};
+
+// what a component (or a whole pass) drew, as far as damage is concerned
+struct draw_damage_summary
+{
+    // false if damage wasn't being tracked when the summary was made
+    bool valid;
+    uint64_t hash;
+    // the surface bounds of the drawing (if `has_bounds` is set)
+    alia_box bounds;
+    bool has_bounds;
+    // the surface bounds of the volatile regions within the drawing
+    alia_box volatile_bounds;
+    bool has_volatile_bounds;
+};
+
+// the per-pass state of a component's (or the pass's) drawing
+struct draw_damage_scope
+{
+    // the commands drawn directly within the scope (most recent first)
+    draw_command_note* commands;
+    // a hash of the summaries of the retaining components within the scope
+    uint64_t child_hash;
+    // true iff any bounds were noted directly within the scope (even if they
+    // were clipped away)
+    bool bounded;
+    // the bounds noted directly within the scope
+    alia_box own_bounds;
+    bool has_own_bounds;
+    // the bounds of the scope's retaining components
+    alia_box child_bounds;
+    bool has_child_bounds;
+    // the bounds of the volatile regions within the scope (including those
+    // of its retaining components)
+    alia_box volatile_bounds;
+    bool has_volatile_bounds;
+};
+
+void
+draw_damage_scope_init(draw_damage_scope& scope);
+
+// Start tracking damage for a pass.
+// If the renderer doesn't support damage, this marks the whole surface as
+// damaged and leaves tracking disabled (i.e., `table.damage_root` null).
+void
+draw_damage_begin_pass(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_scope& root);
+
+// Finish tracking damage for a pass.
+void
+draw_damage_end_pass(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_scope& root);
+
+// Note that a command was drawn. This must only be called while tracking.
+void
+note_draw_command(
+    alia_draw_bucket_table& table,
+    alia_draw_command const* command,
+    size_t size,
+    uint64_t key);
+
+// Note that the command that was just drawn refers to `size` bytes of
+// out-of-line `data` (which must stay put until the end of the pass).
+// This must only be called while tracking.
+void
+note_draw_command_data(
+    alia_draw_bucket_table& table,
+    alia_draw_command const* command,
+    void const* data,
+    size_t size);
+
+// Note that a retaining component within the current scope drew what
+// `summary` describes (either by replaying it or by finishing its scope).
+void
+note_draw_child(
+    alia_ui_system& system,
+    alia_draw_bucket_table& table,
+    draw_damage_summary const& summary);
+
+// Finish a retaining component's scope and compare it against the summary
+// of its previous recording (if there is one - if not, the whole surface is
+// damaged, since there's no telling what was drawn before).
+// `retainable` indicates whether the component's drawing could be recorded.
+// The component's summary is written to `summary`.
+void
+end_draw_damage_scope(
+    alia_ui_system& system,
+    draw_damage_scope const& scope,
+    draw_damage_summary const* previous,
+    bool retainable,
+    draw_damage_summary& summary);
+
+// Add `box` (in surface pixels) to `damage`.
+void
+add_draw_damage(alia_draw_damage& damage, alia_box box, alia_vec2i surface);
+
+} // namespace alia
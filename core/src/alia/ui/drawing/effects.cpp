@@ -8,6 +8,8 @@
 #include <alia/abi/ui/system/renderer.h>
 #include <alia/impl/base/arena.hpp>
 #include <alia/impl/events.hpp>
+#include <alia/ui/drawing/bucket_table.h>
+#include <alia/ui/drawing/damage.h>
 #include <alia/ui/drawing/system.h>
 #include <alia/ui/system/object.h>
 
@@ -26,6 +28,42 @@ struct effect_data
 
 using namespace alia;
 
+namespace {
+
+// Copy the effect's parameters into the draw arena and attach them to
+// `command`.
+void
+attach_effect_params(
+    alia_context* ctx,
+    alia_effect_draw_command* command,
+    void const* params,
+    size_t params_size)
+{
+    command->params_size = (uint16_t) params_size;
+    command->params = nullptr;
+    if (params_size == 0)
+        return;
+
+    // (The arena only hands out whole multiples of its alignment.)
+    void* blob = alia_arena_ptr(
+        &ctx->draw->arena,
+        alia_arena_alloc(
+            &ctx->draw->arena, ALIA_MIN_ALIGNED_SIZE(params_size)));
+    std::memcpy(blob, params, params_size);
+    command->params = blob;
+
+    // The parameters live outside of the command, so damage tracking has to
+    // be told to hash them too.
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    if (table.damage_root)
+    {
+        note_draw_command_data(
+            table, &command->base, command->params, params_size);
+    }
+}
+
+} // namespace
+
 ALIA_EXTERN_C_BEGIN
 
 int
@@ -65,17 +103,7 @@ alia_draw_effect(
             ALIA_MIN_ALIGNED_SIZE(sizeof(alia_effect_draw_command)));
 
     command->region = alia_box_translate(region, ctx->geometry->offset);
-    command->params_size = (uint16_t) params_size;
-    command->params = nullptr;
-
-    if (params_size > 0)
-    {
-        void* blob = alia_arena_ptr(
-            &ctx->draw->arena,
-            alia_arena_alloc(&ctx->draw->arena, params_size));
-        std::memcpy(blob, params, params_size);
-        command->params = blob;
-    }
+    attach_effect_params(ctx, command, params, params_size);
 }
 
 alia_element_id
@@ -124,18 +152,9 @@ alia_do_effect(
                     material_id,
                     ALIA_MIN_ALIGNED_SIZE(sizeof(alia_effect_draw_command)));
             command->region = box;
-            command->params_size = (uint16_t) params_size;
-            command->params = nullptr;
-            if (params_size > 0)
-            {
-                ALIA_ASSERT(params != nullptr);
-                ALIA_ASSERT(params_size <= UINT16_MAX);
-                void* blob = alia_arena_ptr(
-                    &ctx->draw->arena,
-                    alia_arena_alloc(&ctx->draw->arena, params_size));
-                std::memcpy(blob, params, params_size);
-                command->params = blob;
-            }
+            ALIA_ASSERT(params_size == 0 || params != nullptr);
+            ALIA_ASSERT(params_size <= UINT16_MAX);
+            attach_effect_params(ctx, command, params, params_size);
             break;
         }
     }
@@ -0,0 +1,358 @@
+#include <alia/ui/drawing/retention.h>
+
+#include <alia/impl/base/arena.hpp>
+#include <alia/kernel/flow/components.h>
+#include <alia/ui/drawing/bucket_key.h>
+#include <alia/ui/drawing/bucket_table.h>
+#include <alia/ui/system/object.h>
+
+#include <cstring>
+
+namespace alia {
+
+struct draw_recorder_entry
+{
+    draw_recorder_entry* next;
+    uint32_t bucket;
+    // the bucket's tail and count before the content first used it
+    alia_draw_command* tail_before;
+    uint32_t count_before;
+};
+
+} // namespace alia
+
+using namespace alia;
+
+namespace {
+
+// The retained arena isn't worth reclaiming until it has accumulated at
+// least this much garbage.
+size_t const min_retained_draw_garbage = 256 * 1024;
+
+retained_draw_run*
+get_runs(retained_draw* record)
+{
+    return reinterpret_cast<retained_draw_run*>(record + 1);
+}
+
+uint8_t*
+get_placements(retained_draw* record)
+{
+    return reinterpret_cast<uint8_t*>(get_runs(record) + record->run_count);
+}
+
+uint8_t*
+get_styles(retained_draw* record)
+{
+    return get_placements(record) + record->placement_size;
+}
+
+bool
+vec2f_equal(alia_vec2f a, alia_vec2f b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+bool
+box_equal(alia_box const& a, alia_box const& b)
+{
+    return vec2f_equal(a.min, b.min) && vec2f_equal(a.size, b.size);
+}
+
+// Discard whatever recording `component` has (counting it as garbage).
+void
+discard_recording(alia_draw_system& draw, alia_component* component)
+{
+    if (component->retained_draw
+        && component->draw_epoch == draw.retained_epoch)
+    {
+        draw.retained_garbage += component->retained_draw->retained_bytes;
+    }
+    component->retained_draw = nullptr;
+    component->flags &= ~ALIA_COMPONENT_DRAW_CACHE_VALID;
+}
+
+bool
+recording_is_current(alia_context* ctx, alia_component const* component)
+{
+    alia_draw_system const& draw = ctx->system->draw;
+    if ((component->flags
+         & (ALIA_COMPONENT_DRAW_CACHE_VALID | ALIA_COMPONENT_DIRTY
+            | ALIA_COMPONENT_ANIMATING))
+            != ALIA_COMPONENT_DRAW_CACHE_VALID
+        || !component->retained_draw
+        || component->draw_epoch != draw.retained_epoch)
+    {
+        return false;
+    }
+
+    retained_draw* record = component->retained_draw;
+    if (record->ambient_generation != draw.ambient_generation
+        || record->target_id != ctx->draw->target_id
+        || !vec2f_equal(record->offset, ctx->geometry->offset)
+        || record->scale != ctx->geometry->scale
+        || !box_equal(record->clip_box, ctx->geometry->clip.box)
+        || record->font != ctx->active_font)
+    {
+        return false;
+    }
+
+    size_t const styles_size = ctx->system->styles.defaults_size;
+    if (record->styles_size != styles_size
+        || std::memcmp(get_styles(record), ctx->active_styles, styles_size)
+               != 0)
+    {
+        return false;
+    }
+
+    alia_bump_allocator const& placement = ctx->layout->placement;
+    return placement.offset + record->placement_size
+               <= ctx->layout->system->placement_size
+        && std::memcmp(
+               get_placements(record),
+               placement.base + placement.offset,
+               record->placement_size)
+               == 0;
+}
+
+} // namespace
+
+namespace alia {
+
+void
+draw_system_begin_pass(alia_ui_system& system)
+{
+    alia_draw_system& draw = system.draw;
+
+    // Reclaiming the arena forces every retaining component to redraw, so
+    // only do it once at least half of the arena is garbage.
+    if (draw.retained_garbage >= min_retained_draw_garbage
+        && draw.retained_garbage * 2 >= draw.retained_offset)
+    {
+        draw.retained_offset = 0;
+        draw.retained_garbage = 0;
+        ++draw.retained_epoch;
+    }
+
+    alia_input_state const& input = system.input;
+    if (std::memcmp(
+            &draw.palette_snapshot, &system.palette, sizeof(alia_palette))
+            != 0
+        || !alia_element_id_equal(
+            draw.hot_element_snapshot, input.hot_element)
+        || !alia_element_id_equal(
+            draw.capture_snapshot, input.element_with_capture)
+        || !alia_element_id_equal(
+            draw.focus_snapshot, input.element_with_focus)
+        || draw.window_focus_snapshot != input.window_has_focus
+        || draw.keyboard_interaction_snapshot != input.keyboard_interaction)
+    {
+        std::memcpy(
+            &draw.palette_snapshot, &system.palette, sizeof(alia_palette));
+        draw.hot_element_snapshot = input.hot_element;
+        draw.capture_snapshot = input.element_with_capture;
+        draw.focus_snapshot = input.element_with_focus;
+        draw.window_focus_snapshot = input.window_has_focus;
+        draw.keyboard_interaction_snapshot = input.keyboard_interaction;
+        ++draw.ambient_generation;
+    }
+}
+
+bool
+replay_retained_draw(alia_context* ctx, alia_component* component)
+{
+    if (!recording_is_current(ctx, component))
+        return false;
+
+    retained_draw* record = component->retained_draw;
+    ctx->layout->placement.offset += record->placement_size;
+
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    retained_draw_run const* runs = get_runs(record);
+    for (uint32_t i = 0; i != record->run_count; ++i)
+    {
+        retained_draw_run const& run = runs[i];
+        uint32_t const index = draw_bucket_table_find_or_create(
+            table,
+            make_bucket_key(
+                ctx->draw->target_id,
+                run.z_index,
+                ctx->geometry->clip.id,
+                run.material_id),
+            ctx->geometry->clip.pointer);
+        if (table.recorder)
+            note_draw_bucket_use(table, index);
+        alia_draw_bucket& bucket = table.buckets[index];
+        if (bucket.tail)
+            bucket.tail->next = run.head;
+        else
+            bucket.head = run.head;
+        bucket.tail = run.tail;
+        run.tail->next = nullptr;
+        bucket.count += run.count;
+    }
+    if (table.damage_root)
+        note_draw_child(*ctx->system, table, record->damage);
+    ctx->system->draw.stats.commands_replayed += record->command_count;
+    return true;
+}
+
+draw_recorder*
+begin_draw_recording(alia_context* ctx)
+{
+    if (!ctx->layout)
+        return nullptr;
+
+    alia_draw_system& draw = ctx->system->draw;
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    size_t const styles_size = ctx->system->styles.defaults_size;
+
+    draw_recorder* recorder = arena_new<draw_recorder>(*table.arena);
+    recorder->parent = table.recorder;
+    recorder->id = ++table.last_recorder_id;
+    recorder->entries = nullptr;
+    recorder->entry_count = 0;
+    recorder->retainable = true;
+    recorder->target_id = ctx->draw->target_id;
+    recorder->clip_id = ctx->geometry->clip.id;
+    recorder->placement_start = ctx->layout->placement.offset;
+    recorder->styles = arena_alloc_array<uint8_t>(*table.arena, styles_size);
+    std::memcpy(recorder->styles, ctx->active_styles, styles_size);
+    recorder->styles_size = styles_size;
+    draw_damage_scope_init(recorder->damage);
+
+    // Nested recorders just keep allocating from the retained arena.
+    alia_bump_allocator& arena = ctx->draw->arena;
+    recorder->owns_retained_arena = arena.arena != &draw.retained_arena;
+    if (recorder->owns_retained_arena)
+    {
+        recorder->outer_arena = arena;
+        alia_bump_allocator_init(&arena, &draw.retained_arena);
+        arena.offset = draw.retained_offset;
+    }
+    recorder->retained_start = arena.offset;
+
+    table.recorder = recorder;
+    return recorder;
+}
+
+void
+end_draw_recording(
+    alia_context* ctx, draw_recorder* recorder, alia_component* component)
+{
+    alia_draw_system& draw = ctx->system->draw;
+    alia_draw_bucket_table& table = *ctx->draw->buckets;
+    alia_bump_allocator& arena = ctx->draw->arena;
+    table.recorder = recorder->parent;
+    bool const retainable = recorder->retainable && !ctx->events->aborted;
+
+    draw_damage_summary damage;
+    damage.valid = false;
+    if (table.damage_root)
+    {
+        retained_draw const* previous
+            = component->draw_epoch == draw.retained_epoch
+                ? component->retained_draw
+                : nullptr;
+        end_draw_damage_scope(
+            *ctx->system,
+            recorder->damage,
+            previous ? &previous->damage : nullptr,
+            retainable,
+            damage);
+        note_draw_child(*ctx->system, table, damage);
+    }
+
+    discard_recording(draw, component);
+
+    if (retainable)
+    {
+        size_t const placement_size
+            = ctx->layout->placement.offset - recorder->placement_start;
+        retained_draw* record = arena_alloc_trailing<retained_draw>(
+            arena,
+            recorder->entry_count * sizeof(retained_draw_run)
+                + placement_size + recorder->styles_size);
+        record->ambient_generation = draw.ambient_generation;
+        record->target_id = recorder->target_id;
+        record->offset = ctx->geometry->offset;
+        record->scale = ctx->geometry->scale;
+        record->clip_box = ctx->geometry->clip.box;
+        record->font = ctx->active_font;
+        record->run_count = recorder->entry_count;
+        record->command_count = 0;
+        record->placement_size = placement_size;
+        record->styles_size = recorder->styles_size;
+        record->damage = damage;
+
+        retained_draw_run* run = get_runs(record);
+        for (draw_recorder_entry const* entry = recorder->entries; entry;
+             entry = entry->next, ++run)
+        {
+            alia_draw_bucket const& bucket = table.buckets[entry->bucket];
+            uint64_t const key = table.keys[entry->bucket];
+            run->z_index = z_index_from_key(key);
+            run->material_id = material_from_key(key);
+            run->count = bucket.count - entry->count_before;
+            run->head = entry->tail_before ? entry->tail_before->next
+                                           : bucket.head;
+            run->tail = bucket.tail;
+            record->command_count += run->count;
+        }
+        std::memcpy(
+            get_placements(record),
+            ctx->layout->placement.base + recorder->placement_start,
+            placement_size);
+        std::memcpy(
+            get_styles(record), recorder->styles, recorder->styles_size);
+
+        record->retained_bytes = arena.offset - recorder->retained_start;
+        component->retained_draw = record;
+        component->draw_epoch = draw.retained_epoch;
+        component->flags |= ALIA_COMPONENT_DRAW_CACHE_VALID;
+    }
+    else
+    {
+        draw.retained_garbage += arena.offset - recorder->retained_start;
+    }
+
+    if (recorder->owns_retained_arena)
+    {
+        draw.retained_offset = arena.offset;
+        alia_bump_allocator_commit_peak(&arena);
+        arena = recorder->outer_arena;
+    }
+}
+
+void
+note_draw_bucket_use(alia_draw_bucket_table& table, uint32_t bucket)
+{
+    // Register the bucket with every active recorder that doesn't know about
+    // it yet. Recorders nest and their IDs increase with nesting depth, so if
+    // the bucket was registered with a recorder at least as recent as this
+    // one, it's already registered with this one and all its ancestors.
+    uint32_t& stamp = table.recorder_stamps[bucket];
+    uint64_t const key = table.keys[bucket];
+    for (draw_recorder* recorder = table.recorder;
+         recorder && stamp < recorder->id;
+         recorder = recorder->parent)
+    {
+        draw_recorder_entry* entry
+            = arena_new<draw_recorder_entry>(*table.arena);
+        entry->next = recorder->entries;
+        entry->bucket = bucket;
+        entry->tail_before = table.buckets[bucket].tail;
+        entry->count_before = table.buckets[bucket].count;
+        recorder->entries = entry;
+        ++recorder->entry_count;
+        if (target_from_key(key) != recorder->target_id
+            || clip_from_key(key) != recorder->clip_id)
+        {
+            recorder->retainable = false;
+        }
+    }
+    if (stamp < table.recorder->id)
+        stamp = table.recorder->id;
+}
+
+} // namespace alia
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <alia/abi/base/arena.h>
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/context.h>
+#include <alia/abi/ui/drawing/commands.h>
+#include <alia/abi/ui/geometry.h>
+
+#include <alia/ui/drawing/damage.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// RETAINED DRAWING
+//
+// A skippable component that opts in (via `alia_component_retain_draw`)
+// records the draw commands that its content produces. On later draw passes,
+// if nothing that the drawing could depend on has changed, the content isn't
+// run at all. Instead, the recorded commands are spliced back into the
+// buckets that they came from.
+//
+// Recorded commands (and anything else the content allocates from the draw
+// arena) live in the draw system's retained arena, which persists across
+// passes and is reclaimed in bulk once enough of it is garbage (like the
+// layout system's retained node arena).
+//
+// A recording is reused only if all of the following still match the
+// current pass:
+// - the component's flags (i.e., it hasn't been refreshed, dirtied or
+//   animated since),
+// - the retained arena epoch and the system's ambient generation (palette
+//   and interaction state),
+// - the draw target, geometry offset, scale and clip box,
+// - the active styles and font,
+// - the layout placements that the content consumes.
+//
+// Content that switches draw targets or pushes its own clip regions can't be
+// retained (since those are identified per pass), so it's simply redrawn
+// every time.
+
+struct alia_component;
+struct alia_draw_system;
+struct alia_layout_system;
+struct alia_ui_system;
+
+namespace alia {
+
+// the commands that a recording contributed to a single bucket
+struct retained_draw_run
+{
+    alia_z_index z_index;
+    alia_draw_material_id material_id;
+    uint32_t count;
+    // The commands are already linked (from `head` to `tail`).
+    alia_draw_command* head;
+    alia_draw_command* tail;
+};
+
+// a component's recorded drawing (allocated in the retained arena)
+// The runs, the placements and the styles follow this header.
+struct retained_draw
+{
+    // the total number of retained bytes used by the recording (including
+    // the commands)
+    size_t retained_bytes;
+
+    uint32_t ambient_generation;
+    alia_draw_target_id target_id;
+    alia_vec2f offset;
+    float scale;
+    alia_box clip_box;
+    void const* font;
+
+    uint32_t run_count;
+    uint32_t command_count;
+    size_t placement_size;
+    size_t styles_size;
+
+    // what the recording drew, for damage tracking (see `damage.h`)
+    draw_damage_summary damage;
+};
+
+// the per-pass state of a recording in progress
+struct draw_recorder_entry;
+struct draw_recorder
+{
+    // the enclosing recorder (or null)
+    draw_recorder* parent;
+    uint32_t id;
+
+    // the buckets that the content has used
+    draw_recorder_entry* entries;
+    uint32_t entry_count;
+    // false if the content used a bucket for another target or clip region
+    bool retainable;
+
+    alia_draw_target_id target_id;
+    alia_clip_id clip_id;
+
+    // true iff this recorder switched the draw arena over to the retained
+    // arena (i.e., it's the outermost recorder)
+    bool owns_retained_arena;
+    // the draw arena that was active before the switch
+    alia_bump_allocator outer_arena;
+    // the retained arena offset when the content started
+    size_t retained_start;
+
+    // the placement arena offset when the content started
+    size_t placement_start;
+    // a copy of the active styles when the content started
+    void* styles;
+    size_t styles_size;
+
+    // the damage tracking state for the content (if damage is being tracked)
+    draw_damage_scope damage;
+};
+
+// Prepare the draw system's retained state for a new draw pass.
+// This reclaims the retained arena if enough of it is garbage and detects
+// changes in the ambient state.
+void
+draw_system_begin_pass(alia_ui_system& system);
+
+// Try to replay `component`'s retained drawing.
+// If this returns true, the content's commands have been added to the draw
+// buckets and its placements have been consumed.
+bool
+replay_retained_draw(alia_context* ctx, alia_component* component);
+
+// Start recording the drawing of `component`'s content.
+// This returns null if the drawing can't be recorded in this context.
+draw_recorder*
+begin_draw_recording(alia_context* ctx);
+
+// Finish a recording and (if possible) store it in `component`.
+void
+end_draw_recording(
+    alia_context* ctx, draw_recorder* recorder, alia_component* component);
+
+// Note that the content is about to add commands to bucket `bucket`.
+// This must be called whenever there's an active recorder.
+void
+note_draw_bucket_use(alia_draw_bucket_table& table, uint32_t bucket);
+
+} // namespace alia
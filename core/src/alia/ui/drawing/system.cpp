@@ -9,79 +9,134 @@
 #include <alia/kernel/flow/dispatch.h>
 #include <alia/prelude.hpp>
 #include <alia/ui/drawing/bucket_key.h>
+#include <alia/ui/drawing/bucket_table.h>
+#include <alia/ui/drawing/damage.h>
+#include <alia/ui/drawing/retention.h>
 #include <alia/ui/drawing/system.h>
+#include <alia/ui/msdf.h>
 #include <alia/ui/system/object.h>
 
 #include <algorithm>
 #include <cstdint>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
 
 namespace {
 
-// Kahn topological order: children (composited sources) before parents.
-std::vector<alia_draw_target_id>
-order_draw_targets(
-    std::unordered_set<alia_draw_target_id> const& targets,
-    std::vector<std::pair<alia_draw_target_id, alia_draw_target_id>> const&
-        edges)
+// the maximum number of distinct draw targets that a single draw pass can
+// order - Buckets for any targets beyond this are still drawn, but only after
+// all the others, in ID order.
+int const max_draw_targets_per_pass = 64;
+
+struct draw_pass_target
+{
+    alia_draw_target_id id;
+    // the range of this target's buckets within the sorted bucket list
+    uint32_t bucket_begin;
+    uint32_t bucket_end;
+    // the targets (by index) that composite this one, as a bit mask
+    uint64_t parents;
+    // the number of targets that this one composites
+    int indegree;
+};
+
+struct draw_pass_target_list
 {
-    // edge: child -> parent (child must be flushed first)
-    std::unordered_map<alia_draw_target_id, int> indegree;
-    std::unordered_map<alia_draw_target_id, std::vector<alia_draw_target_id>>
-        outs;
-    for (auto id : targets)
-        indegree[id] = 0;
-
-    for (auto const& e : edges)
+    draw_pass_target targets[max_draw_targets_per_pass];
+    int count;
+};
+
+// Find the index of target `id` in `list`, adding it if necessary.
+// Returns -1 if the list is full.
+int
+find_or_add_draw_target(draw_pass_target_list& list, alia_draw_target_id id)
+{
+    for (int i = 0; i != list.count; ++i)
     {
-        alia_draw_target_id const child = e.first;
-        alia_draw_target_id const parent = e.second;
-        if (!targets.count(child) || !targets.count(parent))
-            continue;
-        outs[child].push_back(parent);
-        ++indegree[parent];
+        if (list.targets[i].id == id)
+            return i;
     }
+    if (list.count == max_draw_targets_per_pass)
+        return -1;
+    list.targets[list.count] = draw_pass_target{
+        .id = id,
+        .bucket_begin = 0,
+        .bucket_end = 0,
+        .parents = 0,
+        .indegree = 0,
+    };
+    return list.count++;
+}
 
-    std::vector<alia_draw_target_id> ready;
-    ready.reserve(targets.size());
-    for (auto id : targets)
+// Kahn topological order: children (composited sources) before parents.
+// `order` receives `list.count` target indices.
+void
+order_draw_targets(draw_pass_target_list& list, int* order)
+{
+    int ready_count = 0;
+    for (int i = 0; i != list.count; ++i)
     {
-        if (indegree[id] == 0)
-            ready.push_back(id);
+        if (list.targets[i].indegree == 0)
+            order[ready_count++] = i;
     }
     // Prefer painting non-primary before primary when both are ready.
-    std::sort(ready.begin(), ready.end(), [](auto a, auto b) {
+    std::sort(order, order + ready_count, [&](int i, int j) {
+        alia_draw_target_id const a = list.targets[i].id;
+        alia_draw_target_id const b = list.targets[j].id;
         if ((a == ALIA_DRAW_TARGET_PRIMARY) != (b == ALIA_DRAW_TARGET_PRIMARY))
             return a != ALIA_DRAW_TARGET_PRIMARY;
         return a < b;
     });
 
-    std::vector<alia_draw_target_id> ordered;
-    ordered.reserve(targets.size());
-    size_t qi = 0;
-    while (qi < ready.size())
+    uint64_t ordered = 0;
+    for (int qi = 0; qi != ready_count; ++qi)
     {
-        alia_draw_target_id const id = ready[qi++];
-        ordered.push_back(id);
-        for (auto parent : outs[id])
+        int const index = order[qi];
+        ordered |= uint64_t(1) << index;
+        for (int parent = 0; parent != list.count; ++parent)
         {
-            if (--indegree[parent] == 0)
-                ready.push_back(parent);
+            if ((list.targets[index].parents & (uint64_t(1) << parent))
+                && --list.targets[parent].indegree == 0)
+            {
+                order[ready_count++] = parent;
+            }
         }
     }
 
-    // Cycle or missing nodes: append anything left (stable enough for debug).
-    if (ordered.size() != targets.size())
+    // Cycle: append anything left (stable enough for debug).
+    for (int i = 0; i != list.count; ++i)
     {
-        for (auto id : targets)
-        {
-            if (std::find(ordered.begin(), ordered.end(), id) == ordered.end())
-                ordered.push_back(id);
-        }
+        if (!(ordered & (uint64_t(1) << i)))
+            order[ready_count++] = i;
+    }
+}
+
+// Get the end of the run of buckets (in `sorted`) that belong to the same
+// target as bucket `begin`.
+uint32_t
+target_run_end(
+    alia::sorted_draw_bucket const* sorted, uint32_t count, uint32_t begin)
+{
+    alia_draw_target_id const target = target_from_key(sorted[begin].key);
+    uint32_t end = begin + 1;
+    while (end != count && target_from_key(sorted[end].key) == target)
+        ++end;
+    return end;
+}
+
+void
+draw_bucket_range(
+    alia_ui_system* system,
+    alia_draw_bucket_table& table,
+    alia::sorted_draw_bucket const* sorted,
+    uint32_t begin,
+    uint32_t end)
+{
+    for (uint32_t i = begin; i != end; ++i)
+    {
+        alia_draw_material* material
+            = &system->draw.materials[material_from_key(sorted[i].key)];
+        material->vtable.draw_bucket(
+            material->user, &table.buckets[sorted[i].bucket]);
     }
-    return ordered;
 }
 
 } // namespace
@@ -110,15 +165,40 @@ alia_material_register(
     system->draw.materials[id] = {.vtable = vtable, .user = user};
 }
 
+alia_draw_stats
+alia_ui_get_draw_stats(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    return system->draw.stats;
+}
+
+void
+alia_ui_reset_draw_stats(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    system->draw.stats = alia_draw_stats{
+        .commands_replayed = 0,
+        .commands_recorded = 0,
+    };
+}
+
 void
 alia_ui_execute_draw_pass(alia_ui_system* system)
 {
     ALIA_ASSERT(system);
 
-    alia_draw_bucket_table bucket_table = {
-        .buckets = {},
-        .keys = {},
-    };
+    alia::draw_system_begin_pass(*system);
+    // Evicting glyphs invalidates any retained drawing that might use them.
+    if (system->msdf_text_engine
+        && alia::msdf_begin_draw_pass(*system->msdf_text_engine))
+    {
+        ++system->draw.ambient_generation;
+    }
+
+    alia_bump_allocator bucket_arena;
+    alia_bump_allocator_init(&bucket_arena, &system->draw.bucket_arena);
+    alia_draw_bucket_table bucket_table;
+    alia::draw_bucket_table_init(bucket_table, &bucket_arena);
 
     alia_draw_context draw_context = {
         .buckets = &bucket_table,
@@ -127,68 +207,126 @@ alia_ui_execute_draw_pass(alia_ui_system* system)
     };
     alia_bump_allocator_init(&draw_context.arena, &system->draw.command_arena);
 
+    alia::draw_damage_scope root_damage;
+    alia::draw_damage_begin_pass(*system, bucket_table, root_damage);
+
     auto draw_event = alia_make_draw_event({.context = &draw_context});
     alia::dispatch_event(*system, draw_event);
 
+    alia::draw_damage_end_pass(*system, bucket_table, root_damage);
+
+    if (system->msdf_text_engine)
+        alia::msdf_flush_atlas_updates(*system->msdf_text_engine, *system);
+
     alia_bump_allocator_commit_peak(&draw_context.arena);
 
-    std::unordered_set<alia_draw_target_id> targets;
-    targets.insert(ALIA_DRAW_TARGET_PRIMARY);
-    std::vector<std::pair<alia_draw_target_id, alia_draw_target_id>> edges;
+    alia::sorted_draw_bucket const* const sorted
+        = alia::sort_draw_buckets(bucket_table);
+    uint32_t const bucket_count = bucket_table.count;
 
-    for (auto const key : bucket_table.keys)
+    // Since the target is the top field of the bucket key, each target's
+    // buckets form a contiguous run in the sorted list.
+    draw_pass_target_list targets;
+    targets.count = 0;
+    find_or_add_draw_target(targets, ALIA_DRAW_TARGET_PRIMARY);
+    bool overflowed = false;
+    for (uint32_t i = 0; i != bucket_count;)
     {
-        alia_draw_target_id const target = target_from_key(key);
-        targets.insert(target);
-        if (material_from_key(key) != ALIA_DRAW_TARGET_MATERIAL_ID)
+        uint32_t const end = target_run_end(sorted, bucket_count, i);
+        int const index
+            = find_or_add_draw_target(targets, target_from_key(sorted[i].key));
+        if (index >= 0)
+        {
+            targets.targets[index].bucket_begin = i;
+            targets.targets[index].bucket_end = end;
+        }
+        else
+        {
+            overflowed = true;
+        }
+        i = end;
+    }
+
+    for (uint32_t i = 0; i != bucket_count; ++i)
+    {
+        if (material_from_key(sorted[i].key) != ALIA_DRAW_TARGET_MATERIAL_ID)
             continue;
-        alia_draw_bucket const* bucket = &bucket_table.buckets[key];
+        int const parent
+            = find_or_add_draw_target(targets, target_from_key(sorted[i].key));
+        alia_draw_bucket const* bucket
+            = &bucket_table.buckets[sorted[i].bucket];
         for (auto const* cmd = bucket->head; cmd; cmd = cmd->next)
         {
             auto const* blit = alia::downcast<alia_draw_target_command>(cmd);
-            targets.insert(blit->source);
             // Source must be painted before the target that composites it.
-            edges.push_back({blit->source, target});
+            int const child = find_or_add_draw_target(targets, blit->source);
+            if (parent < 0 || child < 0)
+                continue;
+            uint64_t const bit = uint64_t(1) << parent;
+            if (!(targets.targets[child].parents & bit))
+            {
+                targets.targets[child].parents |= bit;
+                ++targets.targets[parent].indegree;
+            }
         }
     }
 
-    std::unordered_map<alia_draw_target_id, std::vector<uint64_t>>
-        keys_by_target;
-    for (auto const key : bucket_table.keys)
-        keys_by_target[target_from_key(key)].push_back(key);
-    for (auto& entry : keys_by_target)
-        std::sort(entry.second.begin(), entry.second.end());
-
-    std::vector<alia_draw_target_id> const order
-        = order_draw_targets(targets, edges);
+    int order[max_draw_targets_per_pass];
+    order_draw_targets(targets, order);
 
     alia_renderer_ops const& ops = system->renderer;
+    alia_draw_damage const& damage = system->draw.damage;
+    if (ops.draw_pass_set_damage)
+        ops.draw_pass_set_damage(ops.user, &damage);
     if (ops.draw_pass_begin)
         ops.draw_pass_begin(ops.user);
+    // If nothing changed, the renderer already has the whole frame.
+    if (!damage.full && damage.count == 0)
+    {
+        targets.count = 0;
+        overflowed = false;
+    }
 
     float const clear_transparent[4] = {0.f, 0.f, 0.f, 0.f};
-    for (alia_draw_target_id const target : order)
-    {
+    auto bind_target = [&](alia_draw_target_id target) {
         if (ops.draw_target_bind)
             ops.draw_target_bind(ops.user, target);
         if (target != ALIA_DRAW_TARGET_PRIMARY && ops.draw_target_clear)
             ops.draw_target_clear(ops.user, target, clear_transparent);
-
-        auto it = keys_by_target.find(target);
-        if (it == keys_by_target.end())
-            continue;
-        for (auto const key : it->second)
+    };
+    for (int i = 0; i != targets.count; ++i)
+    {
+        draw_pass_target const& target = targets.targets[order[i]];
+        bind_target(target.id);
+        draw_bucket_range(
+            system,
+            bucket_table,
+            sorted,
+            target.bucket_begin,
+            target.bucket_end);
+    }
+    if (overflowed)
+    {
+        for (uint32_t i = 0; i != bucket_count;)
         {
-            alia_draw_bucket* bucket = &bucket_table.buckets[key];
-            alia_draw_material_id const material_id = material_from_key(key);
-            alia_draw_material* material
-                = &system->draw.materials[material_id];
-            material->vtable.draw_bucket(material->user, bucket);
+            alia_draw_target_id const target = target_from_key(sorted[i].key);
+            uint32_t const end = target_run_end(sorted, bucket_count, i);
+            bool listed = false;
+            for (int j = 0; j != targets.count; ++j)
+                listed = listed || targets.targets[j].id == target;
+            if (!listed)
+            {
+                bind_target(target);
+                draw_bucket_range(system, bucket_table, sorted, i, end);
+            }
+            i = end;
         }
     }
 
     if (ops.draw_pass_end)
         ops.draw_pass_end(ops.user);
+
+    alia_bump_allocator_commit_peak(&bucket_arena);
 }
 
 } // extern "C"
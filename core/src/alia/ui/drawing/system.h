@@ -2,10 +2,11 @@
 
 #include <alia/abi/base/arena.h>
 #include <alia/abi/ui/drawing/system.h>
+#include <alia/abi/ui/input/state.h>
+#include <alia/abi/ui/palette.h>
 
 #include <alia/base/arena.h>
 
-#include <unordered_map>
 #include <vector>
 
 extern "C" {
@@ -22,12 +23,43 @@ struct alia_draw_system
     std::vector<alia_draw_material> materials;
     // Per-frame bump storage for draw commands emitted during the draw pass.
     alia_arena command_arena;
-};
+    // Per-frame bump storage for the draw pass's bucket table and ordering.
+    alia_arena bucket_arena;
 
-struct alia_draw_bucket_table
-{
-    std::unordered_map<uint64_t, alia_draw_bucket> buckets;
-    std::vector<uint64_t> keys;
+    // used to store the draw commands recorded by components that retain
+    // their drawing (see `alia_component_retain_draw`) - Unlike
+    // `command_arena`, this persists across draw passes.
+    alia_arena retained_arena;
+    // the allocation offset within `retained_arena`
+    size_t retained_offset;
+    // an estimate of the bytes in `retained_arena` that are no longer
+    // referenced by any component
+    size_t retained_garbage;
+    // incremented whenever `retained_arena` is reset (which invalidates all
+    // retained recordings)
+    uint32_t retained_epoch;
+
+    // the palette and interaction state as of the last draw pass
+    alia_palette palette_snapshot;
+    alia_element_id hot_element_snapshot;
+    alia_element_id capture_snapshot;
+    alia_element_id focus_snapshot;
+    bool window_focus_snapshot;
+    bool keyboard_interaction_snapshot;
+    // incremented whenever any of the above changes between draw passes
+    // (which invalidates all retained recordings)
+    uint32_t ambient_generation;
+
+    alia_draw_stats stats;
+
+    // the damage from the last draw pass (see `damage.h`)
+    alia_draw_damage damage;
+    // what the last draw pass drew, as far as damage tracking can tell -
+    // This is only valid if `damage_baseline_valid` is set.
+    bool damage_baseline_valid;
+    uint64_t damage_root_hash;
+    uint32_t damage_retained_epoch;
+    alia_vec2i damage_surface_size;
 };
 
 } // extern "C"
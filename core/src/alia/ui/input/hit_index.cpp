@@ -0,0 +1,178 @@
+#include <alia/ui/input/hit_index.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// the size of a grid cell, in surface pixels
+float const hit_index_cell_size = 64.f;
+
+// the maximum number of cells along either axis
+int const hit_index_max_grid_extent = 256;
+
+int
+cell_coordinate(float x, int extent)
+{
+    return std::clamp(
+        int(std::floor(x / hit_index_cell_size)), 0, extent - 1);
+}
+
+bool
+region_contains(alia::hit_region const& region, alia_vec2f p)
+{
+    return p.x >= region.min.x && p.x < region.max.x && p.y >= region.min.y
+        && p.y < region.max.y;
+}
+
+// Call `fn(cell_index)` for every grid cell that `region` overlaps.
+template<class Fn>
+void
+for_each_overlapping_cell(
+    alia::hit_index const& index, alia::hit_region const& region, Fn&& fn)
+{
+    int const x0 = cell_coordinate(region.min.x, index.grid_size.x);
+    int const x1 = cell_coordinate(region.max.x, index.grid_size.x);
+    int const y0 = cell_coordinate(region.min.y, index.grid_size.y);
+    int const y1 = cell_coordinate(region.max.y, index.grid_size.y);
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+            fn(y * index.grid_size.x + x);
+    }
+}
+
+} // namespace
+
+namespace alia {
+
+void
+hit_index_note_event(
+    hit_index& index, alia_event const& event, alia_input_state const& input)
+{
+    switch (event.type)
+    {
+        case ALIA_EVENT_MOUSE_HIT_TEST:
+        case ALIA_EVENT_SCROLL_INPUT_HIT_TEST:
+        case ALIA_EVENT_TOUCH_GESTURE_HIT_TEST:
+        case ALIA_EVENT_DRAW:
+        case ALIA_EVENT_CURSOR_QUERY:
+        case ALIA_EVENT_MOUSE_GAIN:
+        case ALIA_EVENT_MOUSE_LOSS:
+        case ALIA_EVENT_MOUSE_HOVER:
+            break;
+        case ALIA_EVENT_MOUSE_MOTION:
+            // Motion with a button down may be dragging something around.
+            if (input.mouse_button_state != 0)
+                hit_index_invalidate(index);
+            break;
+        default:
+            hit_index_invalidate(index);
+            break;
+    }
+}
+
+void
+hit_index_invalidate(hit_index& index)
+{
+    index.valid = false;
+}
+
+void
+hit_index_begin_recording(hit_index& index)
+{
+    index.regions.clear();
+    index.valid = false;
+    index.recording = true;
+    index.saw_undeclared_hit = false;
+}
+
+void
+hit_index_record(hit_index& index, hit_region const& region)
+{
+    ALIA_ASSERT(index.recording);
+    if (region.min.x < region.max.x && region.min.y < region.max.y)
+        index.regions.push_back(region);
+}
+
+void
+hit_index_end_recording(
+    hit_index& index, alia_vec2i surface_size, uint32_t placement_epoch)
+{
+    ALIA_ASSERT(index.recording);
+    index.recording = false;
+
+    auto grid_extent = [](int size) {
+        int const cells = int(std::ceil(float(size) / hit_index_cell_size));
+        return std::clamp(cells, 1, hit_index_max_grid_extent);
+    };
+    index.grid_size.x = grid_extent(surface_size.x);
+    index.grid_size.y = grid_extent(surface_size.y);
+    size_t const cell_count = size_t(index.grid_size.x) * index.grid_size.y;
+
+    // Count the entries in each cell (offset by one so that the prefix sum
+    // below leaves each cell's start in place)...
+    index.cell_starts.assign(cell_count + 1, 0);
+    for (hit_region const& region : index.regions)
+    {
+        for_each_overlapping_cell(
+            index, region, [&](int cell) { ++index.cell_starts[cell + 1]; });
+    }
+    for (size_t i = 0; i != cell_count; ++i)
+        index.cell_starts[i + 1] += index.cell_starts[i];
+
+    // ... and then fill them in (in region order).
+    index.cell_entries.resize(index.cell_starts[cell_count]);
+    std::vector<uint32_t>& cursors = index.cell_starts;
+    for (uint32_t i = 0; i != uint32_t(index.regions.size()); ++i)
+    {
+        for_each_overlapping_cell(index, index.regions[i], [&](int cell) {
+            index.cell_entries[cursors[cell]++] = i;
+        });
+    }
+    // Filling advanced each cell's start to the next cell's start, so shift
+    // them back.
+    for (size_t i = cell_count; i != 0; --i)
+        index.cell_starts[i] = index.cell_starts[i - 1];
+    index.cell_starts[0] = 0;
+
+    index.placement_epoch = placement_epoch;
+    index.valid = !index.saw_undeclared_hit;
+}
+
+bool
+hit_index_lookup(
+    hit_index const& index,
+    alia_vec2f point,
+    alia_mouse_hit_test_result& result)
+{
+    ALIA_ASSERT(index.valid);
+    result.id = alia_element_id{};
+    result.cursor = ALIA_CURSOR_DEFAULT;
+    result.region = {{0.f, 0.f}, {0.f, 0.f}};
+
+    int const cell = cell_coordinate(point.y, index.grid_size.y)
+                       * index.grid_size.x
+                   + cell_coordinate(point.x, index.grid_size.x);
+    uint32_t const* begin
+        = index.cell_entries.data() + index.cell_starts[cell];
+    uint32_t const* end
+        = index.cell_entries.data() + index.cell_starts[cell + 1];
+    // The topmost region is the last one recorded.
+    for (uint32_t const* i = end; i != begin;)
+    {
+        hit_region const& region = index.regions[*--i];
+        if (region_contains(region, point))
+        {
+            if (region.custom)
+                return false;
+            result.id = region.id;
+            result.cursor = region.cursor;
+            result.region = region.region;
+            return true;
+        }
+    }
+    return true;
+}
+
+} // namespace alia
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/ui/events.h>
+#include <alia/abi/ui/input/state.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace alia {
+
+// a mouse hit region, as recorded in a `hit_index`
+struct hit_region
+{
+    // the area where the region can be hit, in surface coordinates
+    // This is the element's region intersected with the active clip box.
+    alia_vec2f min;
+    alia_vec2f max;
+    // the element's (unclipped) region in surface coordinates
+    alia_box region;
+    alia_element_id id;
+    alia_cursor_t cursor;
+    // true iff the element does its own hit testing within the area (via
+    // `alia_element_report_hit`)
+    bool custom;
+};
+
+// `hit_index` is a spatial index of the mouse hit regions that elements
+// reported during the last full mouse hit test pass. As long as nothing
+// that could affect those regions has happened since, the hot element can
+// be found with a lookup rather than another pass through the controller.
+//
+// Regions are kept in traversal order (which is also z-order, since later
+// regions are drawn on top of earlier ones) and bucketed into a uniform grid
+// over the surface. Each grid cell lists the regions that overlap it, in
+// order, so a lookup scans a single cell from the back and stops at the first
+// region that contains the point.
+//
+struct hit_index
+{
+    std::vector<hit_region> regions;
+    // the grid cells, in row-major order - Cell `i` holds the region indices
+    // `cell_entries[cell_starts[i]]` through `cell_entries[cell_starts[i+1]]`.
+    std::vector<uint32_t> cell_starts;
+    std::vector<uint32_t> cell_entries;
+    alia_vec2i grid_size = {0, 0};
+
+    // true iff the index reflects the current hit regions
+    // (This only holds as long as `placement_epoch` is also current.)
+    bool valid = false;
+    // the layout placement epoch that the regions were recorded with
+    uint32_t placement_epoch = 0;
+
+    // true while a hit test pass is recording regions into the index
+    bool recording = false;
+    // set while recording if an element reported a hit without declaring a
+    // custom hit region first (which means the index can't be trusted)
+    bool saw_undeclared_hit = false;
+};
+
+// Note that `event` is about to be dispatched. Events that could change the
+// hit regions (i.e., anything other than hit tests, drawing and plain pointer
+// motion) invalidate the index.
+void
+hit_index_note_event(
+    hit_index& index, alia_event const& event, alia_input_state const& input);
+
+void
+hit_index_invalidate(hit_index& index);
+
+// Clear the index and start recording regions into it.
+void
+hit_index_begin_recording(hit_index& index);
+
+// Record a region. This must be called while recording.
+void
+hit_index_record(hit_index& index, hit_region const& region);
+
+// Finish recording and build the grid.
+void
+hit_index_end_recording(
+    hit_index& index, alia_vec2i surface_size, uint32_t placement_epoch);
+
+// Look up the hot element at `point`.
+// This returns false if the lookup can't be resolved from the index (because
+// the topmost candidate region does custom hit testing). Otherwise, it
+// returns true and fills in `result` (with a null ID if nothing was hit).
+bool
+hit_index_lookup(
+    hit_index const& index,
+    alia_vec2f point,
+    alia_mouse_hit_test_result& result);
+
+} // namespace alia
@@ -13,6 +13,69 @@ using namespace alia;
 
 namespace {
 
+// If the active mouse hit test pass is recording into the system's hit
+// index, record `box` (in layout coordinates) as a region for `id`.
+void
+record_mouse_region(
+    alia_context* ctx,
+    alia_element_id id,
+    alia_box const& box,
+    alia_cursor_t cursor,
+    bool custom)
+{
+    hit_index& index = ctx->system->hit_index;
+    if (!index.recording)
+        return;
+    alia_box const region = alia_box_translate(box, ctx->geometry->offset);
+    alia_box const clip = alia_geometry_get_clip_box(ctx);
+    hit_region entry;
+    entry.min = alia_vec2f_max(region.min, clip.min);
+    entry.max = alia_vec2f_min(
+        alia_vec2f_add(region.min, region.size),
+        alia_vec2f_add(clip.min, clip.size));
+    entry.region = region;
+    entry.id = id;
+    entry.cursor = cursor;
+    entry.custom = custom;
+    hit_index_record(index, entry);
+}
+
+void
+report_hit(
+    alia_context* ctx,
+    alia_element_id id,
+    alia_box const* bounding_box,
+    alia_hit_test_flags_t flags,
+    alia_cursor_t cursor)
+{
+    if (get_event_type(*ctx) == ALIA_EVENT_MOUSE_HIT_TEST
+        && (flags & ALIA_HIT_TEST_MOUSE))
+    {
+        auto& e = as_mouse_hit_test_event(*ctx);
+        e.result.id = id;
+        e.result.cursor = cursor;
+        e.result.region
+            = alia_box_translate(*bounding_box, ctx->geometry->offset);
+    }
+    else if (
+        get_event_type(*ctx) == ALIA_EVENT_SCROLL_INPUT_HIT_TEST
+        && (flags & ALIA_HIT_TEST_SCROLL_INPUT))
+    {
+        auto& e = as_scroll_input_hit_test_event(*ctx);
+        e.result = id;
+    }
+    else if (get_event_type(*ctx) == ALIA_EVENT_TOUCH_GESTURE_HIT_TEST)
+    {
+        auto& e = as_touch_gesture_hit_test_event(*ctx);
+        if (flags & ALIA_HIT_TEST_MOUSE)
+            e.result.pointer_target = id;
+        if (flags & ALIA_HIT_TEST_SCROLL_INPUT)
+            e.result.scroll_target = id;
+        if (flags & ALIA_HIT_TEST_TOUCH_DRAG)
+            e.result.touch_drag_target = id;
+    }
+}
+
 void
 hit_test_rect_region(
     alia_context* ctx,
@@ -24,7 +87,7 @@ hit_test_rect_region(
     ALIA_ASSERT(ctx);
     ALIA_ASSERT(box);
     if (alia_input_pointer_in_box(ctx, box))
-        alia_element_report_hit(ctx, id, box, flags, cursor);
+        report_hit(ctx, id, box, flags, cursor);
 }
 
 } // namespace
@@ -46,6 +109,7 @@ alia_element_box_region(
         case ALIA_EVENT_MOUSE_HIT_TEST:
             if (flags & ALIA_HIT_TEST_MOUSE)
             {
+                record_mouse_region(ctx, id, *region, cursor, false);
                 hit_test_rect_region(
                     ctx, id, region, ALIA_HIT_TEST_MOUSE, cursor);
             }
@@ -66,6 +130,19 @@ alia_element_box_region(
     }
 }
 
+void
+alia_element_custom_region(
+    alia_context* ctx,
+    alia_element_id id,
+    alia_box const* bounding_box,
+    alia_cursor_t cursor)
+{
+    ALIA_ASSERT(ctx);
+    ALIA_ASSERT(bounding_box);
+    if (get_event_type(*ctx) == ALIA_EVENT_MOUSE_HIT_TEST)
+        record_mouse_region(ctx, id, *bounding_box, cursor, true);
+}
+
 void
 alia_element_report_hit(
     alia_context* ctx,
@@ -79,29 +156,17 @@ alia_element_report_hit(
     if (get_event_type(*ctx) == ALIA_EVENT_MOUSE_HIT_TEST
         && (flags & ALIA_HIT_TEST_MOUSE))
     {
-        auto& e = as_mouse_hit_test_event(*ctx);
-        e.result.id = id;
-        e.result.cursor = cursor;
-        e.result.region
-            = alia_box_translate(*bounding_box, ctx->geometry->offset);
-    }
-    else if (
-        get_event_type(*ctx) == ALIA_EVENT_SCROLL_INPUT_HIT_TEST
-        && (flags & ALIA_HIT_TEST_SCROLL_INPUT))
-    {
-        auto& e = as_scroll_input_hit_test_event(*ctx);
-        e.result = id;
-    }
-    else if (get_event_type(*ctx) == ALIA_EVENT_TOUCH_GESTURE_HIT_TEST)
-    {
-        auto& e = as_touch_gesture_hit_test_event(*ctx);
-        if (flags & ALIA_HIT_TEST_MOUSE)
-            e.result.pointer_target = id;
-        if (flags & ALIA_HIT_TEST_SCROLL_INPUT)
-            e.result.scroll_target = id;
-        if (flags & ALIA_HIT_TEST_TOUCH_DRAG)
-            e.result.touch_drag_target = id;
+        // A hit that wasn't declared as a custom region beforehand means
+        // that the hit index doesn't cover everything that can be hit.
+        hit_index& index = ctx->system->hit_index;
+        if (index.recording
+            && (index.regions.empty() || !index.regions.back().custom
+                || !alia_element_id_equal(index.regions.back().id, id)))
+        {
+            index.saw_undeclared_hit = true;
+        }
     }
+    report_hit(ctx, id, bounding_box, flags, cursor);
 }
 
 void
@@ -0,0 +1,741 @@
+#include <alia/ui/layout/cache.h>
+
+#include <alia/abi/base/arena.h>
+#include <alia/abi/base/geometry.h>
+#include <alia/abi/ui/layout/utilities/dispatch.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/parallel.h>
+#include <alia/ui/layout/placements.h>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace alia;
+
+namespace {
+
+// The snapshot arena isn't worth reclaiming until it has accumulated at least
+// this much garbage.
+size_t const min_snapshot_garbage = 256 * 1024;
+
+// the number of slots that the entry table starts with
+uint32_t const min_cache_capacity = 64;
+
+// the per-pass record that a cached node keeps in the scratch arena
+struct layout_cache_record
+{
+    // true iff the node missed the cache and is being laid out in place
+    // (in which case its scratch data follows the record)
+    bool in_place;
+    // the arguments of the node's vertical measurement
+    alia_main_axis_index vertical_axis;
+    float vertical_width;
+};
+
+uint32_t
+slot_index(uint64_t hash, uint32_t capacity)
+{
+    return uint32_t(hash ^ (hash >> 32)) & (capacity - 1);
+}
+
+template<class Entry>
+Entry*
+find_entry(layout_cache_table<Entry>& table, uint64_t hash)
+{
+    if (table.capacity == 0)
+        return nullptr;
+    for (uint32_t i = slot_index(hash, table.capacity);;
+         i = (i + 1) & (table.capacity - 1))
+    {
+        Entry& entry = table.entries[i];
+        if (entry.hash == hash)
+            return &entry;
+        if (entry.hash == 0)
+            return nullptr;
+    }
+}
+
+template<class Entry>
+void
+touch_entry(
+    alia_layout_cache const& cache,
+    layout_cache_table<Entry>& table,
+    Entry& entry)
+{
+    if (entry.last_used != cache.resolve_serial)
+    {
+        entry.last_used = cache.resolve_serial;
+        ++table.used;
+    }
+}
+
+template<class Entry>
+void
+place_entry(Entry* entries, uint32_t capacity, Entry const& entry)
+{
+    uint32_t i = slot_index(entry.hash, capacity);
+    while (entries[i].hash != 0)
+        i = (i + 1) & (capacity - 1);
+    entries[i] = entry;
+}
+
+// Move the entries into a table with `capacity` slots, keeping only those
+// that `keep` accepts.
+template<class Entry, class Keep>
+void
+rebuild_table(layout_cache_table<Entry>& table, uint32_t capacity, Keep&& keep)
+{
+    auto* entries = static_cast<Entry*>(std::calloc(capacity, sizeof(Entry)));
+    uint32_t count = 0;
+    for (uint32_t i = 0; i != table.capacity; ++i)
+    {
+        Entry const& entry = table.entries[i];
+        if (entry.hash != 0 && keep(entry))
+        {
+            place_entry(entries, capacity, entry);
+            ++count;
+        }
+    }
+    std::free(table.entries);
+    table.entries = entries;
+    table.capacity = capacity;
+    table.count = count;
+}
+
+template<class Entry>
+void
+clear_table(layout_cache_table<Entry>& table)
+{
+    std::free(table.entries);
+    table.entries = nullptr;
+    table.capacity = 0;
+    table.count = 0;
+    table.used = 0;
+}
+
+void
+release_snapshot(alia_layout_cache& cache, layout_snapshot& snapshot)
+{
+    if (snapshot.epoch == cache.snapshot_epoch)
+        cache.snapshot_garbage += snapshot.size;
+    snapshot.epoch = 0;
+}
+
+template<class Entry>
+Entry&
+insert_entry(
+    alia_layout_cache const& cache,
+    layout_cache_table<Entry>& table,
+    uint64_t hash)
+{
+    if (Entry* existing = find_entry(table, hash))
+        return *existing;
+    // Keep the table at most half full.
+    if ((table.count + 1) * 2 > table.capacity)
+    {
+        uint32_t const capacity = table.capacity != 0 ? table.capacity * 2
+                                                      : min_cache_capacity;
+        rebuild_table(table, capacity, [](Entry const&) { return true; });
+    }
+    Entry entry = {};
+    entry.hash = hash;
+    place_entry(table.entries, table.capacity, entry);
+    ++table.count;
+    Entry& inserted = *find_entry(table, hash);
+    touch_entry(cache, table, inserted);
+    return inserted;
+}
+
+// Sweep the unused entries out of `table` once they outnumber the used ones.
+// `release(entry)` releases the snapshots of each entry that's swept.
+template<class Entry, class Release>
+void
+sweep_table(
+    alia_layout_cache const& cache,
+    layout_cache_table<Entry>& table,
+    Release&& release)
+{
+    if (table.count <= table.used * 2 + min_cache_capacity / 2)
+        return;
+    uint32_t capacity = min_cache_capacity;
+    while (table.used * 2 > capacity)
+        capacity *= 2;
+    rebuild_table(table, capacity, [&](Entry const& entry) {
+        if (entry.last_used == cache.resolve_serial)
+            return true;
+        release(entry);
+        return false;
+    });
+}
+
+bool
+snapshot_is_valid(alia_layout_cache const& cache, layout_snapshot const& s)
+{
+    return s.epoch == cache.snapshot_epoch;
+}
+
+uint8_t*
+snapshot_data(alia_layout_cache& cache, layout_snapshot const& snapshot)
+{
+    return cache.snapshot_arena.base + snapshot.offset;
+}
+
+// Copy `size` bytes of `data` into a new snapshot. If `extra` is nonzero, the
+// snapshot has room for that many more bytes after the data (for the caller
+// to fill in).
+layout_snapshot
+take_snapshot(
+    alia_layout_cache& cache,
+    void const* data,
+    size_t size,
+    bool cached,
+    size_t extra = 0)
+{
+    alia_bump_allocator alloc;
+    alia_bump_allocator_init(&alloc, &cache.snapshot_arena);
+    alloc.offset = cache.snapshot_offset;
+    alia_offset const offset = alia_arena_alloc(&alloc, size + extra);
+    std::memcpy(alia_arena_ptr(&alloc, offset), data, size);
+    cache.snapshot_offset = alloc.offset;
+    alia_bump_allocator_commit_peak(&alloc);
+    return layout_snapshot{
+        .epoch = cache.snapshot_epoch,
+        .cached = cached,
+        .offset = offset,
+        .size = size + extra};
+}
+
+bool
+vertical_matches(
+    layout_cache_entry const& entry,
+    alia_main_axis_index axis,
+    float assigned_width)
+{
+    return entry.has_vertical && entry.vertical_axis == axis
+        && entry.vertical_width == assigned_width;
+}
+
+layout_placement_key
+make_placement_key(
+    alia_layout_node const* node,
+    layout_cache_record const& record,
+    alia_main_axis_index axis,
+    alia_box box,
+    float baseline)
+{
+    return layout_placement_key{
+        .content_hash = node->content_hash,
+        .vertical_axis = record.vertical_axis,
+        .vertical_width = record.vertical_width,
+        .axis = axis,
+        .box = box,
+        .baseline = baseline};
+}
+
+uint64_t
+placement_key_hash(layout_placement_key const& key)
+{
+    uint64_t h = layout_hash_value(layout_hash_seed, key.content_hash);
+    h = layout_hash_word(h, uint32_t(key.vertical_axis) << 8 | key.axis);
+    h = layout_hash_word(h, key.vertical_width);
+    h = layout_hash_word(h, key.box.min.x);
+    h = layout_hash_word(h, key.box.min.y);
+    h = layout_hash_word(h, key.box.size.x);
+    h = layout_hash_word(h, key.box.size.y);
+    h = layout_hash_word(h, key.baseline);
+    return layout_hash_finish(h);
+}
+
+bool
+placement_keys_equal(
+    layout_placement_key const& a, layout_placement_key const& b)
+{
+    return a.content_hash == b.content_hash
+        && a.vertical_axis == b.vertical_axis
+        && a.vertical_width == b.vertical_width && a.axis == b.axis
+        && alia_box_equal(a.box, b.box) && a.baseline == b.baseline;
+}
+
+// Find the placement data that a node wrote under `key` (if it's still in the
+// cache).
+layout_placement_entry*
+find_placement(alia_layout_cache& cache, layout_placement_key const& key)
+{
+    layout_placement_entry* entry
+        = find_entry(cache.placements, placement_key_hash(key));
+    if (!entry || !snapshot_is_valid(cache, entry->placement)
+        || !placement_keys_equal(entry->key, key))
+    {
+        return nullptr;
+    }
+    return entry;
+}
+
+void
+store_vertical(
+    alia_layout_cache& cache,
+    layout_cache_entry& entry,
+    alia_main_axis_index axis,
+    float assigned_width,
+    alia_vertical_requirements vertical,
+    layout_snapshot scratch)
+{
+    release_snapshot(cache, entry.scratch);
+    entry.has_vertical = true;
+    entry.vertical_axis = axis;
+    entry.vertical_width = assigned_width;
+    entry.vertical = vertical;
+    entry.scratch = scratch;
+}
+
+// Record the placement data that a node just wrote to `arena` (starting at
+// `start`) under `key`, along with the tagged nodes that it added to
+// `placements` (starting at `first_tag`).
+void
+store_placement(
+    alia_layout_cache& cache,
+    layout_placement_key const& key,
+    alia_bump_allocator const& arena,
+    size_t start,
+    alia_layout_placement_table const* placements,
+    uint32_t first_tag)
+{
+    auto& entry
+        = insert_entry(cache, cache.placements, placement_key_hash(key));
+    touch_entry(cache, cache.placements, entry);
+    release_snapshot(cache, entry.placement);
+    entry.key = key;
+    size_t const size = arena.offset - start;
+    uint32_t const tag_count = layout_placement_count(placements) - first_tag;
+    entry.tag_count = tag_count;
+    entry.placement = take_snapshot(
+        cache,
+        static_cast<uint8_t const*>(arena.base) + start,
+        size,
+        false,
+        tag_count * sizeof(alia_layout_placement));
+    // The offsets of the tags are stored relative to the placement data.
+    uint8_t* tags = snapshot_data(cache, entry.placement) + size;
+    for (uint32_t i = 0; i != tag_count; ++i)
+    {
+        alia_layout_placement tag = placements->entries[first_tag + i];
+        tag.offset -= start;
+        std::memcpy(tags + i * sizeof(tag), &tag, sizeof(tag));
+    }
+}
+
+// Copy the placement data (and tagged nodes) that a node wrote the last time
+// it was assigned the same box.
+void
+copy_placement(
+    alia_layout_cache& cache,
+    alia_placement_context* ctx,
+    layout_placement_entry const& entry)
+{
+    uint32_t const tag_count = entry.tag_count;
+    size_t const size
+        = entry.placement.size - tag_count * sizeof(alia_layout_placement);
+    uint8_t const* data = snapshot_data(cache, entry.placement);
+    size_t const start = ctx->arena.offset;
+    std::memcpy(
+        alia_arena_ptr(&ctx->arena, alia_arena_alloc(&ctx->arena, size)),
+        data,
+        size);
+    if (!ctx->placements)
+        return;
+    for (uint32_t i = 0; i != tag_count; ++i)
+    {
+        alia_layout_placement tag;
+        std::memcpy(&tag, data + size + i * sizeof(tag), sizeof(tag));
+        layout_placement_add(
+            ctx->placements, tag.id, tag.box, start + tag.offset);
+    }
+}
+
+// Measure `node` from scratch in the rebuild arena (with the cache disabled)
+// and record the results in its entry.
+// On return, `scratch` is positioned at the start of the node's scratch data
+// (so that it can go on to assign boxes).
+alia_vertical_requirements
+rebuild_measurements(
+    alia_layout_cache& cache,
+    alia_layout_node* node,
+    alia_main_axis_index axis,
+    float assigned_width,
+    alia_bump_allocator& scratch)
+{
+    ++cache.stats.rebuilds;
+    alia_measurement_context ctx;
+    alia_bump_allocator_init(&ctx.scratch, &cache.rebuild_arena);
+    ctx.cache = nullptr;
+    ctx.line_breaks = &cache;
+    ctx.parallel = nullptr;
+    node->vtable->measure_horizontal(&ctx, node);
+    alia_arena_reset(&ctx.scratch);
+    auto const vertical
+        = node->vtable->measure_vertical(&ctx, axis, node, assigned_width);
+    if (auto* entry = find_entry(cache.nodes, node->content_hash))
+    {
+        store_vertical(
+            cache,
+            *entry,
+            axis,
+            assigned_width,
+            vertical,
+            take_snapshot(
+                cache, ctx.scratch.base, ctx.scratch.offset, false));
+    }
+    alia_arena_reset(&ctx.scratch);
+    alia_bump_allocator_commit_peak(&ctx.scratch);
+    scratch = ctx.scratch;
+    return vertical;
+}
+
+// Assign boxes to a cached node, given scratch data for it.
+void
+assign_with_scratch(
+    alia_layout_cache& cache,
+    alia_placement_context* ctx,
+    alia_bump_allocator const& scratch,
+    bool cached,
+    layout_placement_key const& key,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline)
+{
+    alia_placement_context inner;
+    inner.scratch = scratch;
+    inner.arena = ctx->arena;
+    inner.cache = cached ? &cache : nullptr;
+    inner.line_breaks = &cache;
+    inner.parallel = nullptr;
+    inner.placements = ctx->placements;
+    size_t const start = inner.arena.offset;
+    uint32_t const first_tag = layout_placement_count(ctx->placements);
+    node->vtable->assign_boxes(&inner, main_axis, node, box, baseline);
+    ctx->arena = inner.arena;
+    store_placement(
+        cache, key, ctx->arena, start, ctx->placements, first_tag);
+}
+
+// Subtrees that can fork in a parallel resolve bypass the cache, since their
+// scratch data refers to other threads' segments. (Only containers opt into
+// caching.)
+bool
+bypasses_cache(
+    alia_layout_fork_context const* parallel, alia_layout_node* node)
+{
+    return parallel
+        && layout_subtree_can_fork(
+               parallel,
+               reinterpret_cast<alia_layout_container*>(node)->subtree_size);
+}
+
+} // namespace
+
+namespace alia {
+
+void
+layout_cache_init(alia_layout_cache& cache)
+{
+    cache.nodes = {};
+    cache.placements = {};
+    cache.line_breaks = {};
+    cache.resolve_serial = 0;
+    initialize_lazy_commit_arena(&cache.snapshot_arena);
+    cache.snapshot_offset = 0;
+    cache.snapshot_garbage = 0;
+    cache.snapshot_epoch = 1;
+    initialize_lazy_commit_arena(&cache.rebuild_arena);
+    cache.stats = layout_cache_stats{};
+}
+
+void
+layout_cache_destroy(alia_layout_cache& cache)
+{
+    clear_table(cache.nodes);
+    clear_table(cache.placements);
+    clear_table(cache.line_breaks);
+    alia_arena_destroy(&cache.snapshot_arena);
+    alia_arena_destroy(&cache.rebuild_arena);
+}
+
+void
+layout_cache_clear(alia_layout_cache& cache)
+{
+    clear_table(cache.nodes);
+    clear_table(cache.placements);
+    clear_table(cache.line_breaks);
+    cache.snapshot_offset = 0;
+    cache.snapshot_garbage = 0;
+    ++cache.snapshot_epoch;
+}
+
+void
+layout_cache_begin_resolve(alia_layout_cache& cache)
+{
+    ++cache.resolve_serial;
+    cache.nodes.used = 0;
+    cache.placements.used = 0;
+    cache.line_breaks.used = 0;
+    cache.stats = layout_cache_stats{};
+}
+
+void
+layout_cache_end_resolve(alia_layout_cache& cache)
+{
+    // Sweep out the unused entries. (The snapshots that release_snapshot is
+    // given are copies, but it only needs them to count the garbage.)
+    sweep_table(cache, cache.nodes, [&](layout_cache_entry const& entry) {
+        layout_snapshot scratch = entry.scratch;
+        release_snapshot(cache, scratch);
+    });
+    sweep_table(
+        cache, cache.placements, [&](layout_placement_entry const& entry) {
+            layout_snapshot placement = entry.placement;
+            release_snapshot(cache, placement);
+        });
+    sweep_table(
+        cache, cache.line_breaks, [&](layout_line_break_entry const& entry) {
+            layout_snapshot lines = entry.lines;
+            release_snapshot(cache, lines);
+        });
+
+    // Reclaim the snapshot arena once at least half of it is garbage.
+    if (cache.snapshot_garbage >= min_snapshot_garbage
+        && cache.snapshot_garbage * 2 >= cache.snapshot_offset)
+    {
+        cache.snapshot_offset = 0;
+        cache.snapshot_garbage = 0;
+        ++cache.snapshot_epoch;
+    }
+}
+
+bool
+layout_cache_find_line_breaks(
+    alia_layout_cache& cache,
+    uint64_t hash,
+    float width,
+    layout_line_breaks* breaks)
+{
+    layout_line_break_entry* entry = find_entry(cache.line_breaks, hash);
+    if (!entry || !snapshot_is_valid(cache, entry->lines)
+        || !(entry->min_width <= width && width < entry->max_width))
+    {
+        ++cache.stats.line_break_misses;
+        return false;
+    }
+    ++cache.stats.line_break_hits;
+    touch_entry(cache, cache.line_breaks, *entry);
+    breaks->overall_height = entry->overall_height;
+    breaks->overall_ascent = entry->overall_ascent;
+    breaks->line_count = entry->line_count;
+    breaks->lines = reinterpret_cast<layout_cached_line const*>(
+        snapshot_data(cache, entry->lines));
+    return true;
+}
+
+void
+layout_cache_begin_lines(
+    alia_layout_cache& cache, layout_line_recorder& recorder)
+{
+    // The lines are recorded directly into the snapshot arena, so nothing
+    // else can take a snapshot until they're stored.
+    alia_bump_allocator_init(&recorder.lines, &cache.snapshot_arena);
+    recorder.lines.offset = cache.snapshot_offset;
+    recorder.start = cache.snapshot_offset;
+    recorder.line_count = 0;
+}
+
+void
+layout_cache_record_line(
+    layout_line_recorder& recorder, layout_cached_line const& line)
+{
+    static_assert(sizeof(layout_cached_line) % ALIA_MIN_ALIGN == 0);
+    *arena_alloc<layout_cached_line>(recorder.lines) = line;
+    ++recorder.line_count;
+}
+
+void
+layout_cache_store_line_breaks(
+    alia_layout_cache& cache,
+    layout_line_recorder& recorder,
+    uint64_t hash,
+    float min_width,
+    float max_width,
+    float overall_height,
+    float overall_ascent)
+{
+    ALIA_ASSERT(recorder.start == cache.snapshot_offset);
+    cache.snapshot_offset = recorder.lines.offset;
+    alia_bump_allocator_commit_peak(&recorder.lines);
+    auto& entry = insert_entry(cache, cache.line_breaks, hash);
+    touch_entry(cache, cache.line_breaks, entry);
+    release_snapshot(cache, entry.lines);
+    entry.min_width = min_width;
+    entry.max_width = max_width;
+    entry.overall_height = overall_height;
+    entry.overall_ascent = overall_ascent;
+    entry.line_count = recorder.line_count;
+    entry.lines = layout_snapshot{
+        .epoch = cache.snapshot_epoch,
+        .cached = false,
+        .offset = recorder.start,
+        .size = recorder.lines.offset - recorder.start};
+}
+
+} // namespace alia
+
+extern "C" {
+
+alia_horizontal_requirements
+alia_cached_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    if (bypasses_cache(ctx->parallel, node))
+        return node->vtable->measure_horizontal(ctx, node);
+    alia_layout_cache& cache = *ctx->cache;
+    auto& record = claim_scratch<layout_cache_record>(ctx->scratch);
+    if (auto* entry = find_entry(cache.nodes, node->content_hash))
+    {
+        ++cache.stats.hits;
+        touch_entry(cache, cache.nodes, *entry);
+        return entry->horizontal;
+    }
+    ++cache.stats.misses;
+    record.in_place = true;
+    auto const horizontal = node->vtable->measure_horizontal(ctx, node);
+    insert_entry(cache, cache.nodes, node->content_hash).horizontal
+        = horizontal;
+    return horizontal;
+}
+
+alia_vertical_requirements
+alia_cached_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width)
+{
+    if (bypasses_cache(ctx->parallel, node))
+    {
+        return node->vtable->measure_vertical(
+            ctx, main_axis, node, assigned_width);
+    }
+    alia_layout_cache& cache = *ctx->cache;
+    auto& record = use_scratch<layout_cache_record>(ctx->scratch);
+    record.vertical_axis = main_axis;
+    record.vertical_width = assigned_width;
+
+    if (record.in_place)
+    {
+        size_t const start = ctx->scratch.offset;
+        auto const vertical = node->vtable->measure_vertical(
+            ctx, main_axis, node, assigned_width);
+        layout_cache_entry* entry
+            = find_entry(cache.nodes, node->content_hash);
+        ALIA_ASSERT(entry);
+        store_vertical(
+            cache,
+            *entry,
+            main_axis,
+            assigned_width,
+            vertical,
+            take_snapshot(
+                cache,
+                alia_arena_ptr(&ctx->scratch, start),
+                ctx->scratch.offset - start,
+                true));
+        return vertical;
+    }
+
+    layout_cache_entry* entry = find_entry(cache.nodes, node->content_hash);
+    ALIA_ASSERT(entry);
+    if (vertical_matches(*entry, main_axis, assigned_width))
+        return entry->vertical;
+    alia_bump_allocator scratch;
+    return rebuild_measurements(
+        cache, node, main_axis, assigned_width, scratch);
+}
+
+void
+alia_cached_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline)
+{
+    if (bypasses_cache(ctx->parallel, node))
+    {
+        node->vtable->assign_boxes(ctx, main_axis, node, box, baseline);
+        return;
+    }
+    alia_layout_cache& cache = *ctx->cache;
+    auto const& record = use_scratch<layout_cache_record>(ctx->scratch);
+    layout_placement_key const key
+        = make_placement_key(node, record, main_axis, box, baseline);
+
+    if (record.in_place)
+    {
+        size_t const start = ctx->arena.offset;
+        uint32_t const first_tag = layout_placement_count(ctx->placements);
+        node->vtable->assign_boxes(ctx, main_axis, node, box, baseline);
+        store_placement(
+            cache, key, ctx->arena, start, ctx->placements, first_tag);
+        return;
+    }
+
+    // If the node got the same box in the last resolve, it would write the
+    // same placement data.
+    if (layout_placement_entry* placement = find_placement(cache, key))
+    {
+        ++cache.stats.placement_copies;
+        touch_entry(cache, cache.placements, *placement);
+        copy_placement(cache, ctx, *placement);
+        return;
+    }
+
+    layout_cache_entry* entry = find_entry(cache.nodes, node->content_hash);
+    if (entry
+        && vertical_matches(
+            *entry, record.vertical_axis, record.vertical_width))
+    {
+        touch_entry(cache, cache.nodes, *entry);
+
+        // Otherwise, it can assign boxes from the scratch data that its
+        // vertical measurement left behind.
+        if (snapshot_is_valid(cache, entry->scratch))
+        {
+            layout_snapshot const snapshot = entry->scratch;
+            alia_bump_allocator scratch;
+            scratch.arena = nullptr;
+            scratch.base = snapshot_data(cache, snapshot);
+            scratch.capacity = snapshot.size;
+            scratch.offset = 0;
+            scratch.peak = 0;
+            assign_with_scratch(
+                cache,
+                ctx,
+                scratch,
+                snapshot.cached,
+                key,
+                main_axis,
+                node,
+                box,
+                baseline);
+            return;
+        }
+    }
+
+    // There's nothing to go on, so measure the node from scratch.
+    alia_bump_allocator scratch;
+    rebuild_measurements(
+        cache, node, record.vertical_axis, record.vertical_width, scratch);
+    assign_with_scratch(
+        cache, ctx, scratch, false, key, main_axis, node, box, baseline);
+}
+
+} // extern "C"
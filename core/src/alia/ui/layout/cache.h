@@ -0,0 +1,357 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/base/arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// LAYOUT CACHE
+//
+// The layout cache remembers the results of laying out subtrees across
+// resolutions, keyed by the content hashes of their root nodes (see
+// `alia_layout_node::content_hash`). Hashes are computed as nodes are emitted,
+// and a container's hash covers its children's, so a change anywhere in the
+// tree changes the hashes along the path up to the root (and nowhere else).
+// Each resolve then only has to walk the changed paths:
+//
+// - The horizontal requirements of a subtree depend only on its content, so a
+//   cached subtree reports them without visiting its descendants.
+//
+// - Its vertical requirements also depend on its assigned width, so they're
+//   reused if the width matches the one they were measured with. Otherwise,
+//   the subtree is measured from scratch (in a separate arena, since the
+//   horizontal pass skipped it).
+//
+// - When placing a subtree, if it was given the same box in the last resolve,
+//   its placement data is copied from the cache. Otherwise, it assigns its
+//   boxes using a copy of the scratch data that its vertical measurement left
+//   behind, so it still doesn't have to be re-measured. (Placement data is
+//   keyed by box as well as content, since identical sibling subtrees, like
+//   the rows of a table, share a content hash but are placed in different
+//   boxes.)
+//
+// Cached subtrees don't use the scratch arena during the regular passes, so
+// each cached node claims a small record in the scratch arena instead, which
+// tracks how it's being handled through the passes.
+//
+// Copies of scratch and placement data are kept in a snapshot arena, which is
+// managed like the other retained arenas: Replaced snapshots are counted as
+// garbage, and the whole arena is reclaimed (invalidating all snapshots) once
+// enough of it is garbage. Entries that go unused are swept once they
+// outnumber the ones in use.
+//
+// The cache also holds the line breaks of flows, keyed by the hashes of their
+// fragment streams. A set of line breaks is valid over a whole range of
+// widths: Each break decision compares the extent of a fragment against the
+// available width, so as long as a new width falls on the same side of all of
+// those extents, the same breaks come out. (e.g., A window resize that stays
+// within the slack of every line doesn't rebreak anything.) The lines
+// themselves are stored as snapshots.
+
+namespace alia {
+
+// a copy of scratch or placement data, stored in the snapshot arena
+struct layout_snapshot
+{
+    // the snapshot epoch that this was taken in (or 0 if there's no snapshot)
+    uint32_t epoch;
+    // true iff this is scratch data that was produced with the cache active
+    // (and therefore contains cache records for nested nodes)
+    bool cached;
+    size_t offset;
+    size_t size;
+};
+
+struct layout_cache_entry
+{
+    // the content hash of the subtree (or 0 if the slot is empty)
+    uint64_t hash;
+    // the resolve in which the entry was last used
+    uint32_t last_used;
+
+    alia_horizontal_requirements horizontal;
+
+    // the results of the last vertical measurement, the arguments that it was
+    // made with, and the scratch data that it left behind
+    bool has_vertical;
+    alia_main_axis_index vertical_axis;
+    float vertical_width;
+    alia_vertical_requirements vertical;
+    layout_snapshot scratch;
+};
+
+// the arguments that a node's placement data was produced under
+struct layout_placement_key
+{
+    uint64_t content_hash;
+    // the arguments to the node's vertical measurement
+    alia_main_axis_index vertical_axis;
+    float vertical_width;
+    // the arguments to its box assignment
+    alia_main_axis_index axis;
+    alia_box box;
+    float baseline;
+};
+
+struct layout_placement_entry
+{
+    // the hash of `key` (or 0 if the slot is empty)
+    uint64_t hash;
+    // the resolve in which the entry was last used
+    uint32_t last_used;
+
+    layout_placement_key key;
+
+    // the placement data that the node wrote
+    layout_snapshot placement;
+    // the number of tagged nodes that the assignment recorded - Their table
+    // entries follow the placement data in `placement` (with offsets relative
+    // to the start of the data).
+    uint32_t tag_count;
+};
+
+// a line of a flow, as recorded in the cache
+struct layout_cached_line
+{
+    // the range of fragments that are anchored on the line
+    int first_anchor_index;
+    int last_anchor_index;
+    float anchored_width;
+    // the line's final requirements
+    alia_line_requirements requirements;
+    // the largest line gap that applies to the line
+    float line_gap;
+    // true iff the line ended with an explicit break (or the end of the flow)
+    bool is_explicit_break;
+};
+
+struct layout_line_break_entry
+{
+    // the hash of the fragment stream (or 0 if the slot is empty)
+    uint64_t hash;
+    // the resolve in which the entry was last used
+    uint32_t last_used;
+
+    // the widths that the breaks are valid for: [min_width, max_width)
+    float min_width;
+    float max_width;
+
+    // the overall requirements of the lines
+    float overall_height;
+    float overall_ascent;
+
+    // the lines, as an array of `layout_cached_line`
+    uint32_t line_count;
+    layout_snapshot lines;
+};
+
+// an open-addressing hash table of entries (with linear probing) -
+// `capacity` is always either zero or a power of two.
+template<class Entry>
+struct layout_cache_table
+{
+    Entry* entries;
+    uint32_t capacity;
+    uint32_t count;
+    // the number of entries used during the current resolve
+    uint32_t used;
+};
+
+// counts of what happened during the last resolve
+struct layout_cache_stats
+{
+    // cached nodes whose results were found in the cache
+    uint32_t hits;
+    // cached nodes that had to be laid out in place
+    uint32_t misses;
+    // cached nodes that had to be measured from scratch outside the regular
+    // passes
+    uint32_t rebuilds;
+    // cached nodes whose placement data was copied from the cache
+    uint32_t placement_copies;
+    // flow passes that reused line breaks from the cache
+    uint32_t line_break_hits;
+    // flow passes that had to break their lines
+    uint32_t line_break_misses;
+};
+
+} // namespace alia
+
+extern "C" {
+
+struct alia_layout_cache
+{
+    // the entries for nodes, keyed by content hash
+    alia::layout_cache_table<alia::layout_cache_entry> nodes;
+    // the placement data of nodes, keyed by content hash and box
+    alia::layout_cache_table<alia::layout_placement_entry> placements;
+    // the line breaks of flows, keyed by fragment stream hash
+    alia::layout_cache_table<alia::layout_line_break_entry> line_breaks;
+    // incremented at the start of each resolve
+    uint32_t resolve_serial;
+
+    // used to store snapshots
+    alia_arena snapshot_arena;
+    // the allocation offset within `snapshot_arena`
+    size_t snapshot_offset;
+    // the bytes in `snapshot_arena` that belong to replaced snapshots
+    size_t snapshot_garbage;
+    // incremented whenever `snapshot_arena` is reset - This starts at 1 so
+    // that 0 is never current.
+    uint32_t snapshot_epoch;
+
+    // used as scratch space for subtrees that have to be measured outside
+    // the regular passes
+    alia_arena rebuild_arena;
+
+    alia::layout_cache_stats stats;
+};
+
+} // extern "C"
+
+namespace alia {
+
+void
+layout_cache_init(alia_layout_cache& cache);
+
+void
+layout_cache_destroy(alia_layout_cache& cache);
+
+// Drop all entries and snapshots.
+void
+layout_cache_clear(alia_layout_cache& cache);
+
+void
+layout_cache_begin_resolve(alia_layout_cache& cache);
+
+// Sweep unused entries and reclaim the snapshot arena (if it's worth it).
+void
+layout_cache_end_resolve(alia_layout_cache& cache);
+
+// LINE BREAKS
+
+// the line breaks of a flow, as found in the cache
+struct layout_line_breaks
+{
+    float overall_height;
+    float overall_ascent;
+    uint32_t line_count;
+    layout_cached_line const* lines;
+};
+
+// Look up the line breaks of a fragment stream at `width`.
+// (The lines are only valid until the cache is next modified.)
+bool
+layout_cache_find_line_breaks(
+    alia_layout_cache& cache,
+    uint64_t hash,
+    float width,
+    layout_line_breaks* breaks);
+
+// used to record the lines of a flow as they're broken
+struct layout_line_recorder
+{
+    alia_bump_allocator lines;
+    size_t start;
+    uint32_t line_count;
+};
+
+// Start recording the lines of a flow. The lines go straight into the snapshot
+// arena, so nothing else can be stored in the cache until they're stored.
+void
+layout_cache_begin_lines(
+    alia_layout_cache& cache, layout_line_recorder& recorder);
+
+void
+layout_cache_record_line(
+    layout_line_recorder& recorder, layout_cached_line const& line);
+
+// Store the recorded lines as the breaks of a fragment stream over
+// [min_width, max_width).
+void
+layout_cache_store_line_breaks(
+    alia_layout_cache& cache,
+    layout_line_recorder& recorder,
+    uint64_t hash,
+    float min_width,
+    float max_width,
+    float overall_height,
+    float overall_ascent);
+
+// CONTENT HASHING
+
+uint64_t const layout_hash_seed = 0xcbf29ce484222325ull;
+
+inline uint64_t
+layout_hash_bytes(uint64_t h, void const* data, size_t size)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i != size; ++i)
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    return h;
+}
+
+template<class T>
+uint64_t
+layout_hash_value(uint64_t h, T const& value)
+{
+    return layout_hash_bytes(h, &value, sizeof(T));
+}
+
+// Fold a whole 32-bit word into `h`. This is much cheaper than hashing bytes
+// one at a time, so it's used for data that's hashed on every resolve (like
+// the fragment streams of flows).
+inline uint64_t
+layout_hash_word(uint64_t h, uint32_t word)
+{
+    h = (h ^ word) * 0x9e3779b97f4a7c15ull;
+    return h ^ (h >> 29);
+}
+
+inline uint64_t
+layout_hash_word(uint64_t h, float value)
+{
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    return layout_hash_word(h, word);
+}
+
+// Finish a content hash. (This keeps it from being 0, which means that there
+// is no hash.)
+inline uint64_t
+layout_hash_finish(uint64_t h)
+{
+    return h != 0 ? h : 1;
+}
+
+// Compute the content hash of a node from its vtable and whatever parameters
+// determine its layout. (The parameters are hashed bytewise, so they should be
+// free of padding.)
+template<class... Params>
+uint64_t
+layout_hash_node(
+    alia_layout_node_vtable const* vtable, Params const&... params)
+{
+    uint64_t h = layout_hash_value(layout_hash_seed, vtable);
+    ((h = layout_hash_value(h, params)), ...);
+    return layout_hash_finish(h);
+}
+
+// Fold the content hashes of the nodes in a sibling list into `h`.
+// If any of them lacks a hash, so does the result.
+inline uint64_t
+layout_hash_children(uint64_t h, alia_layout_node const* first_child)
+{
+    for (alia_layout_node const* child = first_child; child;
+         child = child->next_sibling)
+    {
+        if (child->content_hash == 0)
+            return 0;
+        h = layout_hash_value(h, child->content_hash);
+    }
+    return layout_hash_finish(h);
+}
+
+} // namespace alia
@@ -0,0 +1,615 @@
+#include <alia/ui/layout/compact.h>
+
+#include <alia/abi/ui/layout/utilities/emission.h>
+#include <alia/abi/ui/layout/utilities/placement.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/ui/layout/components/column.h>
+#include <alia/ui/layout/components/flow.h>
+#include <alia/ui/layout/components/grid.h>
+#include <alia/ui/layout/components/leaf.h>
+#include <alia/ui/layout/components/row.h>
+
+#include <algorithm>
+
+using namespace alia::operators;
+
+namespace alia {
+
+namespace {
+
+compact_node_kind
+classify_node(alia_layout_node const* node)
+{
+    alia_layout_node_vtable const* vtable = node->vtable;
+    if (vtable == &leaf_vtable)
+        return compact_node_kind::LEAF;
+    if (vtable == &row_vtable)
+        return compact_node_kind::ROW;
+    if (vtable == &column_vtable)
+        return compact_node_kind::COLUMN;
+    if (vtable == &grid_vtable)
+        return compact_node_kind::GRID;
+    if (vtable == &flow_vtable)
+        return compact_node_kind::FLOW;
+    return compact_node_kind::CUSTOM;
+}
+
+bool
+is_opaque(compact_node_kind kind)
+{
+    return kind != compact_node_kind::LEAF && kind != compact_node_kind::ROW
+        && kind != compact_node_kind::COLUMN;
+}
+
+// Append `node` (and, unless it's opaque, its subtree) to `tree` and return
+// its index.
+uint32_t
+flatten_node(compact_layout_tree& tree, alia_layout_node* node)
+{
+    uint32_t const index = uint32_t(tree.kind.size());
+    compact_node_kind const kind = classify_node(node);
+    alia_layout_flags_t flags = 0;
+    float spacing = 0;
+    alia_layout_content_metrics content = {};
+    if (kind == compact_node_kind::LEAF)
+    {
+        auto const& leaf = *reinterpret_cast<layout_leaf_node*>(node);
+        flags = leaf.flags;
+        spacing = (leaf.flags & ALIA_FLUSH) != 0 ? 0.f : leaf.spacing;
+        content = leaf.content;
+    }
+    else if (!is_opaque(kind))
+    {
+        auto const& container
+            = *reinterpret_cast<alia_layout_container*>(node);
+        flags = container.flags;
+        spacing = container.gap;
+    }
+    tree.kind.push_back(kind);
+    tree.flags.push_back(flags);
+    tree.first_child.push_back(compact_no_node);
+    tree.next_sibling.push_back(compact_no_node);
+    tree.child_count.push_back(0);
+    tree.spacing.push_back(spacing);
+    tree.content.push_back(content);
+    tree.node.push_back(node);
+    if (kind != compact_node_kind::LEAF)
+        tree.containers.push_back(index);
+
+    if (kind == compact_node_kind::ROW || kind == compact_node_kind::COLUMN)
+    {
+        auto const& container
+            = *reinterpret_cast<alia_layout_container*>(node);
+        uint32_t previous = compact_no_node;
+        uint32_t count = 0;
+        for (alia_layout_node* child = container.first_child; child != nullptr;
+             child = child->next_sibling)
+        {
+            uint32_t const child_index = flatten_node(tree, child);
+            if (previous == compact_no_node)
+                tree.first_child[index] = child_index;
+            else
+                tree.next_sibling[previous] = child_index;
+            previous = child_index;
+            ++count;
+        }
+        tree.child_count[index] = count;
+    }
+    return index;
+}
+
+// raw pointers to the arrays of a tree - The passes work through these rather
+// than through the vectors, since stores to the byte-sized arrays would
+// otherwise force the vectors' data pointers to be reloaded.
+struct compact_arrays
+{
+    compact_node_kind const* kind;
+    alia_layout_flags_t const* flags;
+    uint32_t const* first_child;
+    uint32_t const* next_sibling;
+    uint32_t const* child_count;
+    float const* spacing;
+    alia_layout_content_metrics const* content;
+    alia_layout_node* const* node;
+    alia_horizontal_requirements* horizontal;
+    float* horizontal_growth;
+    alia_main_axis_index* main_axis;
+    float* assigned_width;
+    alia_vertical_requirements* vertical;
+    alia_vertical_requirements* content_vertical;
+    size_t* scratch_offset;
+    alia_box* box;
+    float* baseline;
+};
+
+compact_arrays
+get_arrays(compact_layout_tree& tree)
+{
+    return compact_arrays{
+        .kind = tree.kind.data(),
+        .flags = tree.flags.data(),
+        .first_child = tree.first_child.data(),
+        .next_sibling = tree.next_sibling.data(),
+        .child_count = tree.child_count.data(),
+        .spacing = tree.spacing.data(),
+        .content = tree.content.data(),
+        .node = tree.node.data(),
+        .horizontal = tree.horizontal.data(),
+        .horizontal_growth = tree.horizontal_growth.data(),
+        .main_axis = tree.main_axis.data(),
+        .assigned_width = tree.assigned_width.data(),
+        .vertical = tree.vertical.data(),
+        .content_vertical = tree.content_vertical.data(),
+        .scratch_offset = tree.scratch_offset.data(),
+        .box = tree.box.data(),
+        .baseline = tree.baseline.data()};
+}
+
+// Get an allocator for revisiting the scratch data of the opaque node at
+// `index` (after the horizontal pass).
+alia_bump_allocator
+opaque_scratch(
+    compact_arrays const& a,
+    alia_bump_allocator const& scratch,
+    uint32_t index)
+{
+    alia_bump_allocator view = scratch;
+    view.offset = a.scratch_offset[index];
+    return view;
+}
+
+void
+measure_horizontal(compact_layout_tree& tree, alia_bump_allocator& scratch)
+{
+    compact_arrays const a = get_arrays(tree);
+    uint32_t const* const containers = tree.containers.data();
+    for (size_t j = tree.containers.size(); j-- != 0;)
+    {
+        uint32_t const i = containers[j];
+        alia_layout_flags_t const flags = a.flags[i];
+        switch (a.kind[i])
+        {
+            case compact_node_kind::LEAF:
+                break;
+            case compact_node_kind::ROW: {
+                float total_width = 0, total_growth = 0;
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    total_width += a.horizontal[child].min_size;
+                    total_growth += a.horizontal[child].growth_factor;
+                }
+                total_width += alia_layout_gap_total(
+                    a.spacing[i], a.child_count[i]);
+                a.horizontal_growth[i] = total_growth;
+                a.horizontal[i] = alia_horizontal_requirements{
+                    .min_size = total_width,
+                    .growth_factor = alia_resolve_growth_factor(flags)};
+                break;
+            }
+            case compact_node_kind::COLUMN: {
+                float max_width = 0;
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    max_width = (std::max) (
+                        max_width, a.horizontal[child].min_size);
+                }
+                a.horizontal[i] = alia_horizontal_requirements{
+                    .min_size = max_width,
+                    .growth_factor = alia_resolve_growth_factor(flags)};
+                break;
+            }
+            case compact_node_kind::GRID:
+            case compact_node_kind::FLOW:
+            case compact_node_kind::CUSTOM: {
+                a.scratch_offset[i] = scratch.offset;
+                alia_measurement_context ctx;
+                ctx.scratch = scratch;
+                ctx.cache = nullptr;
+                ctx.line_breaks = nullptr;
+                ctx.parallel = nullptr;
+                alia_layout_node* node = a.node[i];
+                switch (a.kind[i])
+                {
+                    case compact_node_kind::GRID:
+                        a.horizontal[i]
+                            = grid_measure_horizontal(&ctx, node);
+                        break;
+                    case compact_node_kind::FLOW:
+                        a.horizontal[i]
+                            = flow_measure_horizontal(&ctx, node);
+                        break;
+                    default:
+                        a.horizontal[i]
+                            = node->vtable->measure_horizontal(&ctx, node);
+                        break;
+                }
+                scratch = ctx.scratch;
+                break;
+            }
+        }
+    }
+}
+
+// Hand out the widths that each node is measured with vertically.
+void
+assign_widths(compact_layout_tree& tree)
+{
+    compact_arrays const a = get_arrays(tree);
+    uint32_t const* const containers = tree.containers.data();
+    size_t const container_count = tree.containers.size();
+    for (size_t j = 0; j != container_count; ++j)
+    {
+        uint32_t const i = containers[j];
+        alia_layout_flags_t const flags
+            = alia_fold_in_cross_axis_flags(a.flags[i], a.main_axis[i]);
+        switch (a.kind[i])
+        {
+            case compact_node_kind::ROW: {
+                float const total_width = a.horizontal[i].min_size;
+                auto const placement = alia_resolve_container_x(
+                    flags, a.assigned_width[i], total_width);
+                float const total_extra_space
+                    = (std::max) (0.f, placement.size - total_width);
+                float const one_over_total_growth
+                    = 1.0f / (std::max) (0.00001f, a.horizontal_growth[i]);
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    auto const child_x = a.horizontal[child];
+                    float const extra_space = total_extra_space
+                                            * child_x.growth_factor
+                                            * one_over_total_growth;
+                    a.main_axis[child] = ALIA_MAIN_AXIS_X;
+                    a.assigned_width[child]
+                        = child_x.min_size + extra_space;
+                }
+                break;
+            }
+            case compact_node_kind::COLUMN: {
+                auto const assignment = alia_resolve_container_x(
+                    flags,
+                    a.assigned_width[i],
+                    a.horizontal[i].min_size);
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    a.main_axis[child] = ALIA_MAIN_AXIS_Y;
+                    a.assigned_width[child] = assignment.size;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void
+measure_vertical(
+    compact_layout_tree& tree, alia_bump_allocator const& scratch)
+{
+    compact_arrays const a = get_arrays(tree);
+    uint32_t const* const containers = tree.containers.data();
+    for (size_t j = tree.containers.size(); j-- != 0;)
+    {
+        uint32_t const i = containers[j];
+        alia_layout_flags_t const flags = a.flags[i];
+        alia_main_axis_index const main_axis = a.main_axis[i];
+        switch (a.kind[i])
+        {
+            case compact_node_kind::LEAF:
+                break;
+            case compact_node_kind::ROW: {
+                float height = 0, ascent = 0, descent = 0;
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    auto const& child_y = a.vertical[child];
+                    height = (std::max) (height, child_y.min_size);
+                    ascent = (std::max) (ascent, child_y.ascent);
+                    descent = (std::max) (descent, child_y.descent);
+                }
+                a.content_vertical[i] = alia_vertical_requirements{
+                    .min_size = height,
+                    .growth_factor = 0,
+                    .ascent = ascent,
+                    .descent = descent};
+                a.vertical[i] = alia_mask_reported_vertical_requirements(
+                    flags,
+                    main_axis,
+                    alia_vertical_requirements{
+                        .min_size = (std::max) (height, ascent + descent),
+                        .growth_factor = alia_resolve_growth_factor(flags),
+                        .ascent = ascent,
+                        .descent = descent});
+                break;
+            }
+            case compact_node_kind::COLUMN: {
+                float total_height = 0, total_growth = 0;
+                uint32_t const first_child = a.first_child[i];
+                for (uint32_t child = first_child; child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    total_height += a.vertical[child].min_size;
+                    total_growth += a.vertical[child].growth_factor;
+                }
+                total_height += alia_layout_gap_total(
+                    a.spacing[i], a.child_count[i]);
+                float const baseline = first_child != compact_no_node
+                                         ? a.vertical[first_child].ascent
+                                         : 0;
+                a.content_vertical[i] = alia_vertical_requirements{
+                    .min_size = total_height,
+                    .growth_factor = total_growth,
+                    .ascent = baseline,
+                    .descent = 0};
+                a.vertical[i] = alia_mask_reported_vertical_requirements(
+                    flags,
+                    main_axis,
+                    alia_vertical_requirements{
+                        .min_size = total_height,
+                        .growth_factor = alia_resolve_growth_factor(flags),
+                        .ascent = baseline,
+                        .descent = total_height - baseline});
+                break;
+            }
+            case compact_node_kind::GRID:
+            case compact_node_kind::FLOW:
+            case compact_node_kind::CUSTOM: {
+                alia_measurement_context ctx;
+                ctx.scratch = opaque_scratch(a, scratch, i);
+                ctx.cache = nullptr;
+                ctx.line_breaks = nullptr;
+                ctx.parallel = nullptr;
+                alia_layout_node* node = a.node[i];
+                float const width = a.assigned_width[i];
+                switch (a.kind[i])
+                {
+                    case compact_node_kind::GRID:
+                        a.vertical[i] = grid_measure_vertical(
+                            &ctx, main_axis, node, width);
+                        break;
+                    case compact_node_kind::FLOW:
+                        a.vertical[i] = flow_measure_vertical(
+                            &ctx, main_axis, node, width);
+                        break;
+                    default:
+                        a.vertical[i] = node->vtable->measure_vertical(
+                            &ctx, main_axis, node, width);
+                        break;
+                }
+                break;
+            }
+        }
+    }
+}
+
+void
+assign_boxes(
+    compact_layout_tree& tree,
+    alia_bump_allocator const& scratch,
+    alia_bump_allocator& placement,
+    alia_layout_placement_table* placements)
+{
+    compact_arrays const a = get_arrays(tree);
+    uint32_t const node_count = uint32_t(tree.kind.size());
+    for (uint32_t i = 0; i != node_count; ++i)
+    {
+        alia_layout_flags_t const flags = a.flags[i];
+        alia_main_axis_index const main_axis = a.main_axis[i];
+        alia_box const box = a.box[i];
+        float const baseline = a.baseline[i];
+        switch (a.kind[i])
+        {
+            case compact_node_kind::LEAF: {
+                float const spacing = a.spacing[i];
+                alia_layout_content_metrics const& content = a.content[i];
+                alia_box* leaf_box = arena_alloc<alia_box>(placement);
+                auto const padded_placement = alia_resolve_leaf_box(
+                    alia_fold_in_cross_axis_flags(flags, main_axis),
+                    box.size,
+                    baseline,
+                    content.size,
+                    content.ascent,
+                    {spacing, spacing});
+                leaf_box->min = box.min + padded_placement.min;
+                leaf_box->size = padded_placement.size;
+                break;
+            }
+            case compact_node_kind::ROW: {
+                float const total_width = a.horizontal[i].min_size;
+                auto const& content_y = a.content_vertical[i];
+                auto const row_placement = alia_resolve_container_box(
+                    alia_fold_in_cross_axis_flags(flags, main_axis),
+                    box.size,
+                    baseline,
+                    {total_width, content_y.min_size},
+                    content_y.ascent);
+                if ((flags & ALIA_PROVIDE_BOX) != 0)
+                {
+                    alia_box* provided_box = arena_alloc<alia_box>(placement);
+                    provided_box->min = box.min + row_placement.min;
+                    provided_box->size = row_placement.size;
+                }
+                float const total_extra_space
+                    = (std::max) (0.f, row_placement.size.x - total_width);
+                float const one_over_total_growth
+                    = 1.0f / (std::max) (0.00001f, a.horizontal_growth[i]);
+                float current_x = box.min.x + row_placement.min.x;
+                float const baseline_in_row = alia_resolve_baseline(
+                    flags,
+                    row_placement.size.y,
+                    content_y.ascent,
+                    content_y.descent);
+                float const gap = a.spacing[i];
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    auto const child_x = a.horizontal[child];
+                    float const extra_space = total_extra_space
+                                            * child_x.growth_factor
+                                            * one_over_total_growth;
+                    a.box[child] = {
+                        .min = {current_x, box.min.y + row_placement.min.y},
+                        .size = {child_x.min_size + extra_space, box.size.y}};
+                    a.baseline[child] = baseline_in_row;
+                    current_x += child_x.min_size + extra_space + gap;
+                }
+                break;
+            }
+            case compact_node_kind::COLUMN: {
+                float const max_width = a.horizontal[i].min_size;
+                auto const& content_y = a.content_vertical[i];
+                auto const assignment = alia_resolve_container_box(
+                    alia_fold_in_cross_axis_flags(flags, main_axis),
+                    box.size,
+                    baseline,
+                    {max_width, content_y.min_size},
+                    content_y.ascent);
+                if ((flags & ALIA_PROVIDE_BOX) != 0)
+                {
+                    alia_box* provided_box = arena_alloc<alia_box>(placement);
+                    provided_box->min = box.min + assignment.min;
+                    provided_box->size = assignment.size;
+                }
+                float const total_extra_space = (std::max) (
+                    0.f, assignment.size.y - content_y.min_size);
+                float const total_growth
+                    = (std::max) (0.00001f, content_y.growth_factor);
+                float current_y = box.min.y + assignment.min.y;
+                float const gap = a.spacing[i];
+                for (uint32_t child = a.first_child[i];
+                     child != compact_no_node;
+                     child = a.next_sibling[child])
+                {
+                    auto const child_y = a.vertical[child];
+                    float const extra_space
+                        = total_extra_space * child_y.growth_factor
+                        / total_growth;
+                    float const assigned_height
+                        = child_y.min_size + extra_space;
+                    a.box[child]
+                        = {.min = {box.min.x + assignment.min.x, current_y},
+                           .size = {assignment.size.x, assigned_height}};
+                    a.baseline[child] = alia_resolve_baseline(
+                        flags,
+                        assigned_height,
+                        child_y.ascent,
+                        child_y.descent);
+                    current_y += assigned_height + gap;
+                }
+                break;
+            }
+            case compact_node_kind::GRID:
+            case compact_node_kind::FLOW:
+            case compact_node_kind::CUSTOM: {
+                alia_placement_context ctx;
+                ctx.scratch = opaque_scratch(a, scratch, i);
+                ctx.arena = placement;
+                ctx.cache = nullptr;
+                ctx.line_breaks = nullptr;
+                ctx.parallel = nullptr;
+                ctx.placements = placements;
+                alia_layout_node* node = a.node[i];
+                switch (a.kind[i])
+                {
+                    case compact_node_kind::GRID:
+                        grid_assign_boxes(
+                            &ctx, main_axis, node, box, baseline);
+                        break;
+                    case compact_node_kind::FLOW:
+                        flow_assign_boxes(
+                            &ctx, main_axis, node, box, baseline);
+                        break;
+                    default:
+                        node->vtable->assign_boxes(
+                            &ctx, main_axis, node, box, baseline);
+                        break;
+                }
+                placement = ctx.arena;
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void
+build_compact_layout_tree(compact_layout_tree& tree, alia_layout_node* root)
+{
+    tree.kind.clear();
+    tree.flags.clear();
+    tree.first_child.clear();
+    tree.next_sibling.clear();
+    tree.child_count.clear();
+    tree.spacing.clear();
+    tree.content.clear();
+    tree.node.clear();
+    tree.containers.clear();
+    if (root)
+        flatten_node(tree, root);
+
+    size_t const node_count = tree.kind.size();
+    tree.horizontal.resize(node_count);
+    tree.horizontal_growth.resize(node_count);
+    tree.main_axis.resize(node_count);
+    tree.assigned_width.resize(node_count);
+    tree.vertical.resize(node_count);
+    tree.content_vertical.resize(node_count);
+    tree.scratch_offset.resize(node_count);
+    tree.box.resize(node_count);
+    tree.baseline.resize(node_count);
+
+    // The requirements of leaves only depend on their content, so they're
+    // measured here rather than in every resolve.
+    for (size_t i = 0; i != node_count; ++i)
+    {
+        if (tree.kind[i] != compact_node_kind::LEAF)
+            continue;
+        alia_layout_content_metrics const& content = tree.content[i];
+        float const spacing = tree.spacing[i];
+        float const growth = alia_resolve_growth_factor(tree.flags[i]);
+        tree.horizontal[i] = alia_horizontal_requirements{
+            .min_size = content.size.x + spacing * 2,
+            .growth_factor = growth};
+        tree.vertical[i] = alia_vertical_requirements{
+            .min_size = content.size.y + spacing * 2,
+            .growth_factor = growth,
+            .ascent = content.ascent,
+            .descent = content.descent};
+    }
+}
+
+void
+resolve_compact_layout_tree(
+    compact_layout_tree& tree,
+    alia_bump_allocator& scratch,
+    alia_bump_allocator& placement,
+    alia_layout_placement_table* placements,
+    alia_vec2f available_space)
+{
+    if (tree.kind.empty())
+        return;
+
+    measure_horizontal(tree, scratch);
+
+    tree.main_axis[0] = ALIA_MAIN_AXIS_X;
+    tree.assigned_width[0] = available_space.x;
+    assign_widths(tree);
+    measure_vertical(tree, scratch);
+
+    tree.box[0] = {.min = {0, 0}, .size = available_space};
+    tree.baseline[0] = tree.vertical[0].ascent;
+    assign_boxes(tree, scratch, placement, placements);
+}
+
+} // namespace alia
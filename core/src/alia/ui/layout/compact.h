@@ -0,0 +1,117 @@
+#pragma once
+
+#include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/layout/protocol.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// COMPACT LAYOUT STORAGE
+//
+// In compact storage mode, resolves don't walk the linked node tree directly.
+// Instead, the tree is flattened (in preorder) into a set of parallel arrays,
+// one per field, and the passes sweep over those arrays:
+//
+// - Leaves are measured when the arrays are built, since their requirements
+//   only depend on their content.
+//
+// - The horizontal pass runs backwards over the other nodes, so each container
+//   sees its children's requirements before its own are needed.
+//
+// - The vertical pass runs forwards to hand out widths and then backwards to
+//   measure heights.
+//
+// - Box assignment runs forwards, so placement data is written in the same
+//   order as it is for linked resolves.
+//
+// Rows, columns and leaves are laid out entirely within the arrays, by
+// switching on their kind. Other nodes are opaque: Their subtrees aren't
+// flattened, and they're laid out through the usual protocol functions (with
+// the scratch data of each one kept separate, since the sweeps visit them in
+// different orders). Grids and flows are called directly, and only custom
+// nodes go through their vtables.
+//
+// The results are identical to those of linked resolves, but the layout cache
+// and parallelism aren't used.
+//
+// The arrays are rebuilt whenever the layout tree changes (i.e., after each
+// refresh).
+
+namespace alia {
+
+enum class compact_node_kind : uint8_t
+{
+    LEAF,
+    ROW,
+    COLUMN,
+    GRID,
+    FLOW,
+    CUSTOM
+};
+
+// the index that stands in for a missing node
+uint32_t const compact_no_node = ~uint32_t(0);
+
+struct compact_layout_tree
+{
+    // the layout tree version that the arrays were built from (see
+    // `alia_layout_system::tree_version`)
+    uint32_t version = 0;
+
+    // STRUCTURE
+    std::vector<compact_node_kind> kind;
+    std::vector<alia_layout_flags_t> flags;
+    std::vector<uint32_t> first_child;
+    std::vector<uint32_t> next_sibling;
+    std::vector<uint32_t> child_count;
+    // the gap between children (for containers) or the effective spacing
+    // around the content (for leaves)
+    std::vector<float> spacing;
+    // the content of leaves
+    std::vector<alia_layout_content_metrics> content;
+    // the nodes that the entries were built from
+    std::vector<alia_layout_node*> node;
+    // the indices of all nodes other than leaves (in order) - Leaves are
+    // measured when the arrays are built, so only these nodes have to be
+    // visited by the measurement passes.
+    std::vector<uint32_t> containers;
+
+    // MEASUREMENT
+    std::vector<alia_horizontal_requirements> horizontal;
+    // the total horizontal growth of a row's children
+    std::vector<float> horizontal_growth;
+    // the axis and width that each node is measured with vertically
+    std::vector<alia_main_axis_index> main_axis;
+    std::vector<float> assigned_width;
+    // the vertical requirements that each node reports to its parent
+    std::vector<alia_vertical_requirements> vertical;
+    // the combined vertical requirements of a container's children - For
+    // rows, this has the height, ascent and descent of the row's content. For
+    // columns, it has the total height, total growth and baseline (as ascent)
+    // of the column's content.
+    std::vector<alia_vertical_requirements> content_vertical;
+    // the offset of each opaque node's scratch data
+    std::vector<size_t> scratch_offset;
+
+    // PLACEMENT
+    // the box and baseline that each node is assigned by its parent
+    std::vector<alia_box> box;
+    std::vector<float> baseline;
+};
+
+// Flatten the subtree rooted at `root` into `tree`.
+void
+build_compact_layout_tree(compact_layout_tree& tree, alia_layout_node* root);
+
+// Resolve the layout of `tree` into `placement` (using `scratch` for the
+// scratch data of opaque nodes), recording any tagged nodes in `placements`.
+void
+resolve_compact_layout_tree(
+    compact_layout_tree& tree,
+    alia_bump_allocator& scratch,
+    alia_bump_allocator& placement,
+    alia_layout_placement_table* placements,
+    alia_vec2f available_space);
+
+} // namespace alia
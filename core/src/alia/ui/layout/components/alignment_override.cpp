@@ -4,17 +4,13 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/alignment_override.h>
 
 using namespace alia::operators;
 
 namespace alia {
 
-struct alignment_override_node
-{
-    alia_layout_container container;
-    alia_layout_flags_t flags;
-};
-
 struct alignment_override_scratch
 {
     alia_horizontal_requirements horizontal;
@@ -81,7 +77,9 @@ alia_layout_node_vtable alignment_override_vtable
        alignment_override_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "alignment_override"};
 
 } // namespace alia
 
@@ -110,6 +108,8 @@ alia_layout_alignment_override_begin(
                .flags = 0,
                .first_child = 0},
             .flags = flags};
+        node->container.base.content_hash
+            = layout_hash_node(&alignment_override_vtable, flags);
         scope.node = node;
         alia_layout_container_activate(ctx, &node->container);
     }
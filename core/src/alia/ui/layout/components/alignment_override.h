@@ -0,0 +1,16 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct alignment_override_node
+{
+    alia_layout_container container;
+    alia_layout_flags_t flags;
+};
+
+extern alia_layout_node_vtable alignment_override_vtable;
+
+} // namespace alia
@@ -4,21 +4,12 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/components/block_flow.h>
 
 using namespace alia::operators;
 
 namespace alia {
 
-struct block_flow_layout_node
-{
-    alia_layout_node base;
-    alia_layout_flags_t flags;
-    alia_layout_node* first_child;
-    float gap;
-    float line_gap;
-    float minimum_line_height;
-};
-
 static alia_layout_container*
 block_flow_as_container(block_flow_layout_node* node)
 {
@@ -346,7 +337,9 @@ alia_layout_node_vtable block_flow_vtable
        block_flow_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "block_flow"};
 
 } // namespace alia
 
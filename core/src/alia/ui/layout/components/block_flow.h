@@ -0,0 +1,21 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+
+namespace alia {
+
+struct block_flow_layout_node
+{
+    alia_layout_node base;
+    alia_layout_flags_t flags;
+    alia_layout_node* first_child;
+    float gap;
+    // (The fields above mirror `alia_layout_container`.)
+    uint32_t subtree_size;
+    float line_gap;
+    float minimum_line_height;
+};
+
+extern alia_layout_node_vtable block_flow_vtable;
+
+} // namespace alia
@@ -2,6 +2,7 @@
 
 #include <alia/abi/ui/layout/utilities/placement.h>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/parallel.h>
 
 using namespace alia::operators;
 
@@ -30,13 +31,17 @@ column_measure_horizontal(
     alia_vertical_requirements* y_requirements
         = arena_alloc_array<alia_vertical_requirements>(
             ctx->scratch, scratch.child_count);
+    layout_fork_plan* plan = claim_fork_plan(
+        ctx, column.subtree_size, column.first_child, scratch.child_count);
 
-    for (alia_layout_node* child = column.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
-        auto const child_x = alia_measure_horizontal(ctx, child);
-        scratch.max_width = (std::max) (scratch.max_width, child_x.min_size);
-    }
+    measure_children_horizontal(
+        ctx,
+        plan,
+        column.first_child,
+        [&](alia_horizontal_requirements const& child_x) {
+            scratch.max_width
+                = (std::max) (scratch.max_width, child_x.min_size);
+        });
     return alia_horizontal_requirements{
         .min_size = scratch.max_width,
         .growth_factor = alia_resolve_growth_factor(column.flags)};
@@ -54,20 +59,24 @@ column_measure_vertical(
     alia_vertical_requirements* y_requirements
         = arena_alloc_array<alia_vertical_requirements>(
             ctx->scratch, scratch.child_count);
+    layout_fork_plan* plan = use_fork_plan(
+        ctx->scratch, ctx->parallel, column.subtree_size);
     auto const assignment = alia_resolve_container_x(
         alia_fold_in_cross_axis_flags(column.flags, main_axis),
         assigned_width,
         scratch.max_width);
     alia_vertical_requirements* requirement_i = y_requirements;
-    for (alia_layout_node* child = column.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
-        auto const child_y = alia_measure_vertical(
-            ctx, ALIA_MAIN_AXIS_Y, child, assignment.size);
-        *requirement_i++ = child_y;
-        scratch.total_height += child_y.min_size;
-        scratch.total_growth += child_y.growth_factor;
-    }
+    measure_children_vertical(
+        ctx,
+        plan,
+        column.first_child,
+        ALIA_MAIN_AXIS_Y,
+        [&](uint32_t) { return assignment.size; },
+        [&](alia_vertical_requirements const& child_y) {
+            *requirement_i++ = child_y;
+            scratch.total_height += child_y.min_size;
+            scratch.total_growth += child_y.growth_factor;
+        });
     scratch.total_height
         += alia_layout_gap_total(column.gap, scratch.child_count);
     scratch.baseline = (scratch.child_count > 0) ? y_requirements->ascent : 0;
@@ -94,6 +103,8 @@ column_assign_boxes(
     alia_vertical_requirements* y_requirements
         = arena_alloc_array<alia_vertical_requirements>(
             ctx->scratch, scratch.child_count);
+    layout_fork_plan const* plan = use_fork_plan(
+        ctx->scratch, ctx->parallel, column.subtree_size);
     auto const assignment = alia_resolve_container_box(
         alia_fold_in_cross_axis_flags(column.flags, main_axis),
         box.size,
@@ -111,26 +122,25 @@ column_assign_boxes(
     // TODO: Figure out how to handle 0 total growth.
     float const total_growth = (std::max) (0.00001f, scratch.total_growth);
     float current_y = box.min.y + assignment.min.y;
-    for (alia_layout_node* child = column.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
-        auto const child_y = *y_requirements++;
-        float const extra_space
-            = total_extra_space * child_y.growth_factor / total_growth;
-        float const assigned_height = child_y.min_size + extra_space;
-        alia_assign_boxes(
-            ctx,
-            ALIA_MAIN_AXIS_Y,
-            child,
-            {.min = {box.min.x + assignment.min.x, current_y},
-             .size = {assignment.size.x, assigned_height}},
-            alia_resolve_baseline(
-                column.flags,
-                assigned_height,
-                child_y.ascent,
-                child_y.descent));
-        current_y += assigned_height + column.gap;
-    }
+    assign_children(
+        ctx, plan, column.first_child, [&](alia_layout_node* child) {
+            auto const child_y = *y_requirements++;
+            float const extra_space
+                = total_extra_space * child_y.growth_factor / total_growth;
+            float const assigned_height = child_y.min_size + extra_space;
+            alia_assign_boxes(
+                ctx,
+                ALIA_MAIN_AXIS_Y,
+                child,
+                {.min = {box.min.x + assignment.min.x, current_y},
+                 .size = {assignment.size.x, assigned_height}},
+                alia_resolve_baseline(
+                    column.flags,
+                    assigned_height,
+                    child_y.ascent,
+                    child_y.descent));
+            current_y += assigned_height + column.gap;
+        });
 }
 
 alia_layout_node_vtable column_vtable
@@ -139,7 +149,9 @@ alia_layout_node_vtable column_vtable
        column_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       true,
+       "column"};
 
 } // namespace alia
 
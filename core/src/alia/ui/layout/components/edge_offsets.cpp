@@ -6,17 +6,13 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/edge_offsets.h>
 
 using namespace alia::operators;
 
 namespace alia {
 
-struct edge_offsets_layout_node
-{
-    alia_layout_container container;
-    alia_edge_offsets offsets;
-};
-
 alia_horizontal_requirements
 edge_offsets_measure_horizontal(
     alia_measurement_context* ctx, alia_layout_node* node)
@@ -266,7 +262,9 @@ alia_layout_node_vtable edge_offsets_vtable
        edge_offsets_assign_boxes,
        edge_offsets_count_flow_emissions,
        edge_offsets_emit_flow_fragments,
-       edge_offsets_read_fragment_placements};
+       edge_offsets_read_fragment_placements,
+       false,
+       "edge_offsets"};
 
 } // namespace alia
 
@@ -294,6 +292,8 @@ alia_layout_edge_offsets_begin(
                .flags = flags,
                .first_child = 0},
             .offsets = offsets};
+        node->container.base.content_hash
+            = layout_hash_node(&edge_offsets_vtable, flags, offsets);
         scope.node = node;
         alia_layout_container_activate(ctx, &node->container);
     }
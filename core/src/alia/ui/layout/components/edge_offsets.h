@@ -0,0 +1,16 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct edge_offsets_layout_node
+{
+    alia_layout_container container;
+    alia_edge_offsets offsets;
+};
+
+extern alia_layout_node_vtable edge_offsets_vtable;
+
+} // namespace alia
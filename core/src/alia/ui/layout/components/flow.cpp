@@ -1,3 +1,5 @@
+#include <alia/ui/layout/components/flow.h>
+
 #include <alia/abi/ui/layout/utilities/emission.h>
 #include <alia/abi/ui/layout/utilities/flow.h>
 #include <alia/abi/ui/layout/utilities/line.h>
@@ -5,20 +7,17 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/fragment_batch.h>
+
+#include <cmath>
+#include <limits>
 
 using namespace alia::operators;
 
 namespace alia {
 
-struct flow_layout_node
-{
-    alia_layout_node base;
-    alia_layout_flags_t flags;
-    alia_layout_node* first_child;
-    float gap;
-    float line_gap;
-    float minimum_line_height;
-};
+int flow_batch_min_fragments = 64;
 
 // TODO: This is sketchy.
 static alia_layout_container*
@@ -39,6 +38,16 @@ struct flow_scratch
     float max_fragment_width = 0;
     float overall_height = 0, overall_ascent = 0;
     alia_arena_marker scratch_end = {};
+    // the hash of the fragment stream (or 0 if the line breaks aren't being
+    // cached)
+    uint64_t fragment_hash = 0;
+    // the total advance of the content fragments and gaps
+    float total_advance = 0;
+    // true iff space is reserved for packing the fragments into batches
+    bool batched = false;
+    // true iff the batches have been built (which only happens once lines are
+    // actually broken at a width where they pay off)
+    bool batches_built = false;
 };
 
 struct flow_line_wrapper_context
@@ -97,6 +106,14 @@ struct flow_line_wrapper_state
 
     alia_flow_layout_run_frame run_stack[ALIA_FLOW_LAYOUT_RUN_STACK_CAPACITY];
     int run_depth = 0;
+
+    // Every break decision compares the extent of a fragment (i.e., where it
+    // would end if it were placed on the current line) against the available
+    // width. These track the largest extent that fit and the smallest one that
+    // didn't, so the same decisions would be made for any width in
+    // [fit_extent, break_extent).
+    float fit_extent = -std::numeric_limits<float>::infinity();
+    float break_extent = std::numeric_limits<float>::infinity();
 };
 
 void
@@ -311,9 +328,13 @@ process_flow_fragment(
     // loop. (In theory this shouldn't happen with the current width
     // calculation logic, so this is mostly a check for the future and/or a
     // guard against floating point imprecision errors.)
-    if (state.have_anchors
-        && x_at_fragment + fragment_width + end_of_run_edge_offsets
-               > ctx.available_width)
+    float const extent
+        = x_at_fragment + fragment_width + end_of_run_edge_offsets;
+    if (extent > ctx.available_width)
+        state.break_extent = alia_min(state.break_extent, extent);
+    else
+        state.fit_extent = alia_max(state.fit_extent, extent);
+    if (state.have_anchors && extent > ctx.available_width)
     {
         flow_finalize_line(state, &state.line);
         on_wrap(false);
@@ -346,6 +367,40 @@ process_flow_fragment(
     }
 }
 
+// Fold everything about a fragment that affects how lines are broken (and
+// measured) into `h`.
+static uint64_t
+hash_flow_fragment(uint64_t h, alia_flow_fragment const& fragment)
+{
+    h = layout_hash_word(h, uint32_t(fragment.kind));
+    h = layout_hash_word(h, uint32_t(fragment.flags));
+    switch (fragment.kind)
+    {
+        case ALIA_FLOW_FRAGMENT_KIND_CONTENT:
+            h = layout_hash_word(h, fragment.content.size.x);
+            h = layout_hash_word(h, fragment.content.size.y);
+            h = layout_hash_word(h, fragment.content.ascent);
+            h = layout_hash_word(h, fragment.content.descent);
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_GAP:
+            h = layout_hash_word(h, fragment.gap.gap);
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_CONTEXT_PUSH:
+            h = layout_hash_word(h, fragment.context.line_gap);
+            h = layout_hash_word(h, fragment.context.minimum_line_height);
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_RUN_PUSH:
+            h = layout_hash_word(h, fragment.run.offsets.left);
+            h = layout_hash_word(h, fragment.run.offsets.right);
+            h = layout_hash_word(h, fragment.run.offsets.top);
+            h = layout_hash_word(h, fragment.run.offsets.bottom);
+            break;
+        default:
+            break;
+    }
+    return h;
+}
+
 alia_horizontal_requirements
 flow_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
 {
@@ -376,6 +431,12 @@ flow_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
     // Reserve space for the fragment placements.
     arena_alloc_array<alia_flow_fragment_placement>(
         ctx->scratch, totals.fragment_count);
+    // And for the packed form of the fragments (if there are enough of them
+    // to be worth it).
+    scratch.batched = totals.fragment_count >= flow_batch_min_fragments;
+    scratch.batches_built = false;
+    if (scratch.batched)
+        alloc_flow_fragment_batches(ctx->scratch, totals.fragment_count);
 
     // Invoke the children to emit their fragments.
     alia_flow_fragment_emitter emitter
@@ -386,19 +447,28 @@ flow_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
     // Mark the end of the scratch space for this overall node.
     scratch.scratch_end = alia_arena_mark(&ctx->scratch);
 
-    // Compute the maximum fragment width.
+    // Compute the maximum fragment width. (If the line breaks are being
+    // cached, the fragment stream is also hashed along the way.)
     // TODO: Add a flag that bypasses this computation and allows the flow to
     // be smaller than its largest fragment.
     float max_fragment_width = 0;
+    bool const hashing = ctx->line_breaks != nullptr;
+    uint64_t hash = layout_hash_seed;
     alia_flow_layout_run_frame run_stack[ALIA_FLOW_LAYOUT_RUN_STACK_CAPACITY];
     int run_depth = 0;
     alia_flow_layout_run_stack_seed_root(run_stack, run_depth);
     float current_x = 0.f;
+    float total_advance = 0.f;
     for (int i = 0; i < totals.fragment_count; ++i)
     {
         auto const& fragment = fragments[i];
+        if (hashing)
+            hash = hash_flow_fragment(hash, fragment);
         switch (fragment.kind)
         {
+            case ALIA_FLOW_FRAGMENT_KIND_GAP:
+                total_advance += fragment.gap.gap;
+                break;
             case ALIA_FLOW_FRAGMENT_KIND_RUN_PUSH:
                 alia_flow_layout_run_push(
                     run_stack, run_depth, fragment.run.offsets, current_x);
@@ -411,74 +481,318 @@ flow_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
                     max_fragment_width,
                     alia_flow_layout_content_horizontal_extent(
                         fragment.content.size.x, run_stack, run_depth));
+                total_advance += fragment.content.size.x;
                 break;
             default:
                 break;
         }
     }
     scratch.max_fragment_width = max_fragment_width;
+    scratch.total_advance = total_advance;
+    scratch.fragment_hash = hashing ? layout_hash_finish(hash) : 0;
 
     return alia_horizontal_requirements{
         .min_size = max_fragment_width,
         .growth_factor = alia_resolve_growth_factor(flow.flags)};
 }
 
-alia_vertical_requirements
-flow_measure_vertical(
-    alia_measurement_context* ctx,
-    alia_main_axis_index main_axis,
-    alia_layout_node* node,
-    float assigned_width)
+// Sweep through the fragments of a batch, starting at `i`, for as long as
+// they're sure to fit on the current line (which must already have anchors),
+// and fold them into the line. This returns the index of the first fragment
+// that still has to be processed individually.
+static int
+flow_advance_through_batch(
+    flow_line_wrapper_context const& ctx,
+    flow_line_wrapper_state& state,
+    flow_fragment_batches const& batches,
+    int i)
 {
-    auto& flow = *flow_from_node(node);
-    auto& scratch = use_scratch<flow_scratch>(ctx->scratch);
+    int const end = batches.batch_end[i];
+    // (The run stack doesn't change within a batch.)
+    float const right
+        = alia_flow_layout_run_total_right(state.run_stack, state.run_depth);
+    float const x = state.current_x;
+
+    int j;
+    if ((batches.bits[end - 1] & FLOW_BATCH_EXACT)
+        && flow_batch_value_is_exact(x)
+        && flow_batch_value_is_exact(right)
+        // (The limit is halved to allow for rounding in this check.)
+        && std::fabs(x) + std::fabs(right) + batches.prefix[end - 1]
+               < flow_batch_exact_limit / 2)
+    {
+        // All of the positions on the line are exact, so they can be
+        // computed from the prefix sums, and every fragment before the first
+        // one that extends past the available width fits.
+        float const base = batches.prefix[i] - batches.advance[i];
+        float const offset = (x - base) + right;
+        j = int(flow_batch_find_exceeding(
+            batches.prefix, i, end, offset, ctx.available_width));
+        if (j == i)
+            return i;
+        auto x_after = [&](int k) { return x + (batches.prefix[k] - base); };
+        state.current_x = x_after(j - 1);
+        // Find the last fragment that updated each piece of the anchor
+        // tracking.
+        for (int k = j - 1; k >= i; --k)
+        {
+            if (batches.bits[k] & FLOW_BATCH_CONTENT)
+            {
+                state.fit_extent
+                    = alia_max(state.fit_extent, x_after(k) + right);
+                break;
+            }
+        }
+        for (int k = j - 1; k >= i; --k)
+        {
+            if ((batches.bits[k] & FLOW_BATCH_CONTENT) == 0
+                || (batches.bits[k] & FLOW_BATCH_ANCHOR) != 0)
+            {
+                state.anchored_width = x_after(k) + right;
+                break;
+            }
+        }
+        for (int k = j - 1; k >= i; --k)
+        {
+            if (batches.bits[k] & FLOW_BATCH_ANCHOR)
+            {
+                state.last_anchor_index = k;
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Otherwise, add up the advances in order (as the individual path
+        // would).
+        float current_x = x;
+        float fit_extent = state.fit_extent;
+        float anchored_width = state.anchored_width;
+        int last_anchor_index = state.last_anchor_index;
+        for (j = i; j != end; ++j)
+        {
+            float const next_x = current_x + batches.advance[j];
+            float const extent = next_x + right;
+            uint8_t const bits = batches.bits[j];
+            if (bits & FLOW_BATCH_CONTENT)
+            {
+                if (extent > ctx.available_width)
+                    break;
+                fit_extent = alia_max(fit_extent, extent);
+                if (bits & FLOW_BATCH_ANCHOR)
+                {
+                    last_anchor_index = j;
+                    anchored_width = extent;
+                }
+            }
+            else
+            {
+                anchored_width = extent;
+            }
+            current_x = next_x;
+        }
+        if (j == i)
+            return i;
+        state.current_x = current_x;
+        state.fit_extent = fit_extent;
+        state.anchored_width = anchored_width;
+        state.last_anchor_index = last_anchor_index;
+    }
 
-    alia_flow_fragment* fragments = arena_alloc_array<alia_flow_fragment>(
-        ctx->scratch, scratch.fragment_count);
+    alia_line_requirements& line = state.line;
+    line.height = flow_batch_max(batches.height, i, j, line.height);
+    line.ascent = flow_batch_max(batches.ascent, i, j, line.ascent);
+    line.descent = flow_batch_max(batches.descent, i, j, line.descent);
+    return j;
+}
 
-    // We don't actually invoke the children at all during this step, so we
-    // need to jump over the scratch space that they would have used.
-    // (Note that we are also jumping over the fragment placements since we
-    // don't need them here either.)
-    alia_arena_jump(&ctx->scratch, scratch.scratch_end);
+// the overall requirements of a flow's lines
+struct flow_line_totals
+{
+    float height = 0.f;
+    float ascent = 0.f;
+    // the gap that goes before the next line
+    float line_gap = 0.f;
+    bool have_lines = false;
+};
 
-    auto const assignment = alia_resolve_container_x(
-        alia_fold_in_cross_axis_flags(flow.flags, main_axis),
-        assigned_width,
-        scratch.max_fragment_width);
+static void
+flow_add_line(flow_line_totals& totals, layout_cached_line const& line)
+{
+    totals.height += totals.line_gap;
+    totals.line_gap = line.line_gap;
+    if (!totals.have_lines)
+    {
+        totals.ascent = line.requirements.ascent;
+        totals.have_lines = true;
+    }
+    totals.height += line.requirements.height;
+}
 
-    int const fragment_count = scratch.fragment_count;
+// Building batches costs about as much as breaking the fragments into lines
+// one at a time, and using them has a fixed cost per line, so they're only
+// used when lines hold (on average) at least this many fragments.
+static float const flow_batch_min_line_fragments = 32;
+
+// Get the batches to use when breaking the fragments described by `scratch`
+// into lines at `available_width` (or null if they're not worth using). This
+// builds the batches if necessary.
+static flow_fragment_batches const*
+flow_batches_for_width(
+    flow_scratch& scratch,
+    flow_fragment_batches const& batches,
+    alia_flow_fragment const* fragments,
+    float available_width)
+{
+    if (!scratch.batched
+        || available_width * float(scratch.fragment_count)
+               < flow_batch_min_line_fragments * scratch.total_advance)
+    {
+        return nullptr;
+    }
+    if (!scratch.batches_built)
+    {
+        build_flow_fragment_batches(
+            batches, fragments, scratch.fragment_count);
+        scratch.batches_built = true;
+    }
+    return &batches;
+}
 
+// Break the fragments into lines at `available_width`, calling `on_line` for
+// each line (in order) and returning the overall requirements of the lines.
+// If `batches` is given, it's used to get through batched fragments faster.
+// If `cache` is given, the lines are also stored there (under `hash`).
+template<class OnLine>
+static flow_line_totals
+flow_break_lines(
+    alia_flow_fragment const* fragments,
+    flow_fragment_batches const* batches,
+    int fragment_count,
+    float available_width,
+    alia_layout_cache* cache,
+    uint64_t hash,
+    OnLine&& on_line)
+{
     flow_line_wrapper_context wrapper_ctx
         = {.fragments = fragments,
            .fragment_count = fragment_count,
-           .available_width = assignment.size};
+           .available_width = available_width};
 
     flow_line_wrapper_state state;
     seed_flow_line_wrapper_state(state);
 
-    bool wrapping_has_occurred = false;
-    float overall_height = 0.f, overall_ascent = 0.f;
-    float current_line_gap = 0;
+    layout_line_recorder recorder;
+    if (cache)
+        layout_cache_begin_lines(*cache, recorder);
+
+    flow_line_totals totals;
 
     auto on_wrap = [&](bool is_explicit_break) {
-        (void) is_explicit_break;
         flow_finalize_line(state, &state.line);
-        overall_height += current_line_gap;
-        current_line_gap = state.line_max_line_gap;
-        if (!wrapping_has_occurred)
-        {
-            overall_ascent = state.line.ascent;
-            wrapping_has_occurred = true;
-        }
-        overall_height += state.line.height;
+        layout_cached_line const line
+            = {.first_anchor_index = state.first_anchor_index,
+               .last_anchor_index = state.last_anchor_index,
+               .anchored_width = state.anchored_width,
+               .requirements = state.line,
+               .line_gap = state.line_max_line_gap,
+               .is_explicit_break = is_explicit_break};
+        if (cache)
+            layout_cache_record_line(recorder, line);
+        flow_add_line(totals, line);
+        on_line(line);
     };
 
-    for (int i = 0; i < fragment_count; ++i)
+    for (int i = 0; i < fragment_count;)
+    {
+        if (batches && state.have_anchors && batches->batch_end[i] != 0)
+        {
+            int const next
+                = flow_advance_through_batch(wrapper_ctx, state, *batches, i);
+            if (next != i)
+            {
+                i = next;
+                continue;
+            }
+        }
         process_flow_fragment(wrapper_ctx, state, &fragments[i], i, on_wrap);
+        ++i;
+    }
     // Process the final line.
     on_wrap(true);
 
+    if (cache)
+    {
+        layout_cache_store_line_breaks(
+            *cache,
+            recorder,
+            hash,
+            state.fit_extent,
+            state.break_extent,
+            totals.height,
+            totals.ascent);
+    }
+
+    return totals;
+}
+
+alia_vertical_requirements
+flow_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width)
+{
+    auto& flow = *flow_from_node(node);
+    auto& scratch = use_scratch<flow_scratch>(ctx->scratch);
+
+    int const fragment_count = scratch.fragment_count;
+    alia_flow_fragment* fragments
+        = arena_alloc_array<alia_flow_fragment>(ctx->scratch, fragment_count);
+    // (The fragment placements aren't needed here.)
+    arena_alloc_array<alia_flow_fragment_placement>(
+        ctx->scratch, fragment_count);
+    flow_fragment_batches batches;
+    if (scratch.batched)
+        batches = alloc_flow_fragment_batches(ctx->scratch, fragment_count);
+
+    // We don't actually invoke the children at all during this step, so we
+    // need to jump over the scratch space that they would have used.
+    alia_arena_jump(&ctx->scratch, scratch.scratch_end);
+
+    auto const assignment = alia_resolve_container_x(
+        alia_fold_in_cross_axis_flags(flow.flags, main_axis),
+        assigned_width,
+        scratch.max_fragment_width);
+
+    // If the fragments have been broken at a compatible width before, there's
+    // no need to break them again.
+    alia_layout_cache* const cache
+        = scratch.fragment_hash != 0 ? ctx->line_breaks : nullptr;
+    layout_line_breaks breaks;
+    float overall_height, overall_ascent;
+    if (cache
+        && layout_cache_find_line_breaks(
+            *cache, scratch.fragment_hash, assignment.size, &breaks))
+    {
+        overall_height = breaks.overall_height;
+        overall_ascent = breaks.overall_ascent;
+    }
+    else
+    {
+        auto const totals = flow_break_lines(
+            fragments,
+            flow_batches_for_width(
+                scratch, batches, fragments, assignment.size),
+            fragment_count,
+            assignment.size,
+            cache,
+            scratch.fragment_hash,
+            [](layout_cached_line const&) {});
+        overall_height = totals.height;
+        overall_ascent = totals.ascent;
+    }
+
     scratch.overall_height = overall_height;
     scratch.overall_ascent = overall_ascent;
 
@@ -556,11 +870,15 @@ flow_assign_boxes(
     auto& flow = *flow_from_node(node);
     auto& scratch = use_scratch<flow_scratch>(ctx->scratch);
 
-    alia_flow_fragment* fragments = arena_alloc_array<alia_flow_fragment>(
-        ctx->scratch, scratch.fragment_count);
+    int const fragment_count = scratch.fragment_count;
+    alia_flow_fragment* fragments
+        = arena_alloc_array<alia_flow_fragment>(ctx->scratch, fragment_count);
     alia_flow_fragment_placement* placements
         = arena_alloc_array<alia_flow_fragment_placement>(
-            ctx->scratch, scratch.fragment_count);
+            ctx->scratch, fragment_count);
+    flow_fragment_batches batches;
+    if (scratch.batched)
+        batches = alloc_flow_fragment_batches(ctx->scratch, fragment_count);
 
     auto const placement = alia_resolve_container_box(
         alia_fold_in_cross_axis_flags(flow.flags, main_axis),
@@ -576,29 +894,18 @@ flow_assign_boxes(
         provided_box->size = placement.size;
     }
 
-    int const fragment_count = scratch.fragment_count;
-
-    flow_line_wrapper_context wrapper_ctx
-        = {.fragments = fragments,
-           .fragment_count = fragment_count,
-           .available_width = placement.size.x};
-
-    flow_line_wrapper_state state;
-    seed_flow_line_wrapper_state(state);
-
     float const x_assignment_base = box.min.x + placement.min.x;
     float current_y = box.min.y + placement.min.y;
     float current_line_gap = 0;
 
     int first_suppressed_fragment_index = 0;
 
-    auto on_wrap = [&](bool is_explicit_break) {
-        flow_finalize_line(state, &state.line);
+    auto place_line = [&](layout_cached_line const& line) {
         current_y += current_line_gap;
-        current_line_gap = state.line_max_line_gap;
+        current_line_gap = line.line_gap;
 
         for (int i = first_suppressed_fragment_index;
-             i < state.first_anchor_index;
+             i < line.first_anchor_index;
              ++i)
         {
             placements[i]
@@ -609,7 +916,7 @@ flow_assign_boxes(
 
         // Count the number of expandable fragments on the line.
         int expandable_count = 0;
-        for (int i = state.first_anchor_index; i <= state.last_anchor_index;
+        for (int i = line.first_anchor_index; i <= line.last_anchor_index;
              ++i)
         {
             if (fragments[i].flags & ALIA_FLOW_FRAGMENT_EXPANDABLE)
@@ -621,38 +928,58 @@ flow_assign_boxes(
 
         alia_layout_line_justification_spacing line_spacing
             = alia_layout_justify_line(
-                is_explicit_break
+                line.is_explicit_break
                     ? alia_layout_justify_flags_for_incomplete_line(flow.flags)
                     : flow.flags,
-                placement.size.x - state.anchored_width,
+                placement.size.x - line.anchored_width,
                 // +1 because this parameter represents the number of items,
                 // not the expandable spaces between them.
                 expandable_count + 1);
 
         float const line_baseline = alia_resolve_baseline(
             flow.flags,
-            state.line.height,
-            state.line.ascent,
-            state.line.descent);
+            line.requirements.height,
+            line.requirements.ascent,
+            line.requirements.descent);
 
         flow_place_line(
             fragments,
             placements,
-            state.first_anchor_index,
-            state.last_anchor_index,
+            line.first_anchor_index,
+            line.last_anchor_index,
             {x_assignment_base + line_spacing.before_items, current_y},
             line_baseline,
             line_spacing.between_items);
 
-        first_suppressed_fragment_index = state.last_anchor_index + 1;
+        first_suppressed_fragment_index = line.last_anchor_index + 1;
 
-        current_y += state.line.height;
+        current_y += line.requirements.height;
     };
 
-    for (int i = 0; i < fragment_count; ++i)
-        process_flow_fragment(wrapper_ctx, state, &fragments[i], i, on_wrap);
-    // Process the final line.
-    on_wrap(true);
+    // Reuse the line breaks from the cache if possible. (The vertical pass
+    // will usually have just stored them.)
+    alia_layout_cache* const cache
+        = scratch.fragment_hash != 0 ? ctx->line_breaks : nullptr;
+    layout_line_breaks breaks;
+    if (cache
+        && layout_cache_find_line_breaks(
+            *cache, scratch.fragment_hash, placement.size.x, &breaks))
+    {
+        for (uint32_t i = 0; i != breaks.line_count; ++i)
+            place_line(breaks.lines[i]);
+    }
+    else
+    {
+        flow_break_lines(
+            fragments,
+            flow_batches_for_width(
+                scratch, batches, fragments, placement.size.x),
+            fragment_count,
+            placement.size.x,
+            cache,
+            scratch.fragment_hash,
+            place_line);
+    }
 
     for (int i = first_suppressed_fragment_index; i < fragment_count; ++i)
     {
@@ -727,6 +1054,8 @@ alia_layout_node_vtable flow_vtable = {
     flow_count_flow_emissions,
     flow_emit_flow_fragments,
     flow_read_fragment_placements,
+    false,
+    "flow",
 };
 
 } // namespace alia
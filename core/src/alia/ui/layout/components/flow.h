@@ -0,0 +1,45 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+
+namespace alia {
+
+struct flow_layout_node
+{
+    alia_layout_node base;
+    alia_layout_flags_t flags;
+    alia_layout_node* first_child;
+    float gap;
+    // (The fields above mirror `alia_layout_container`.)
+    uint32_t subtree_size;
+    float line_gap;
+    float minimum_line_height;
+};
+
+extern alia_layout_node_vtable flow_vtable;
+
+// Flows with at least this many fragments may pack their plain fragments into
+// batches for line breaking (see fragment_batch.h). This is only adjustable so
+// that tests and benchmarks can compare batched and unbatched layouts.
+extern int flow_batch_min_fragments;
+
+alia_horizontal_requirements
+flow_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node);
+
+alia_vertical_requirements
+flow_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width);
+
+void
+flow_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline);
+
+} // namespace alia
@@ -5,15 +5,11 @@
 
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/flow_spring.h>
 
 namespace alia {
 
-struct layout_flow_spring_node
-{
-    alia_layout_node base;
-    float min_width;
-};
-
 alia_horizontal_requirements
 flow_spring_measure_horizontal(
     alia_measurement_context* ctx, alia_layout_node* node)
@@ -92,7 +88,9 @@ alia_layout_node_vtable flow_spring_vtable
        flow_spring_assign_boxes,
        flow_spring_count_flow_emissions,
        flow_spring_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "flow_spring"};
 
 } // namespace alia
 
@@ -106,11 +104,12 @@ alia_layout_flow_spring_emit(alia_context* ctx, float min_width)
     auto& emission = ctx->layout->emission;
     layout_flow_spring_node* new_node
         = arena_alloc<layout_flow_spring_node>(emission.arena);
-    *emission.next_ptr = &new_node->base;
-    emission.next_ptr = &new_node->base.next_sibling;
+    alia_layout_emit_node(&emission, &new_node->base);
     *new_node = layout_flow_spring_node{
         .base = {.vtable = &flow_spring_vtable, .next_sibling = 0},
         .min_width = min_width};
+    new_node->base.content_hash
+        = layout_hash_node(&flow_spring_vtable, min_width);
 }
 
 } // extern "C"
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+
+namespace alia {
+
+struct layout_flow_spring_node
+{
+    alia_layout_node base;
+    float min_width;
+};
+
+extern alia_layout_node_vtable flow_spring_vtable;
+
+} // namespace alia
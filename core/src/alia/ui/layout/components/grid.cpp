@@ -1,10 +1,19 @@
+#include <alia/ui/layout/components/grid.h>
+
+#include <alia/abi/kernel/substrate.h>
 #include <alia/abi/ui/layout/api.h>
 #include <alia/abi/ui/layout/utilities/placement.h>
 #include <alia/context.h>
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
 #include <alia/ui/layout/components/column.h>
+#include <alia/ui/layout/parallel.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 namespace alia {
 
@@ -12,28 +21,112 @@ struct grid_row_layout_node;
 
 struct grid_scratch;
 
+// GRID COLUMN CACHE
+//
+// Each grid keeps the horizontal requirements of its rows' cells in its
+// substrate data, so that rows whose content hasn't changed don't have to be
+// re-measured on every resolve (which, for cells like text, is expensive).
+// There's an entry for each row (by position), which records the content hash
+// of the row that it was measured from and the epoch that it was measured in.
+//
+// A row can only reuse its entry if measuring its cells didn't leave anything
+// in the scratch arena, since the later passes would expect to find it there.
+// That holds for leaves and text, but not for containers that go through the
+// layout cache, for example, so rows with cells like those are re-measured
+// each time. Whether a cell uses the scratch arena can depend on whether the
+// layout cache and parallelism are active, so a change in either starts a new
+// epoch (which invalidates all entries).
+//
+// The cache also holds the combined requirements of the columns, so rows that
+// change can just be folded into them. They're only recomputed from all the
+// entries when a row that held one of the maximums changes in a way that might
+// lower it (or goes away).
+//
+// Grids whose rows are measured in parallel don't use the cache (and clear
+// it).
+
+struct grid_row_entry
+{
+    // the content hash of the row that the entry was measured from
+    uint64_t hash;
+    // the epoch that the entry was measured in (or 0 if it can't be reused)
+    uint32_t epoch;
+    uint32_t cell_count;
+};
+
+struct grid_column_cache
+{
+    // the current epoch (which starts at 1, so that 0 is never current)
+    uint32_t epoch;
+    // whether the layout cache and parallelism were active in the current
+    // epoch (as a combination of bits)
+    uint32_t mode;
+
+    // the entries for the rows
+    uint32_t row_count;
+    uint32_t row_capacity;
+    grid_row_entry* rows;
+    // the requirements of each row's cells, row by row, with room for
+    // `column_capacity` cells in each
+    uint32_t column_capacity;
+    alia_horizontal_requirements* cells;
+    // the previous requirements of the row being measured
+    alia_horizontal_requirements* previous;
+
+    // the combined requirements of the columns
+    uint32_t column_count;
+    alia_horizontal_requirements* columns;
+};
+
+// GRID SCRATCH DATA
+//
+// Grids go through the layout cache, which may replay their scratch data from
+// a copy (see alia/ui/layout/cache.h), so everything in it is located by
+// offsets from the start of the grid's data rather than by pointers or arena
+// markers. Each pass finds the start (which is wherever the pass enters the
+// grid) and re-derives the pointers that it needs from there.
+
 struct grid_layout_node
 {
-    alia_layout_node base = {};
+    // The grid's own node is laid out like a container, since that's what the
+    // layout cache expects of the nodes that it caches. (Its flags and
+    // children belong to `column`, though.)
+    alia_layout_container container = {};
     grid_row_layout_node* first_row = nullptr;
-    grid_scratch* scratch = nullptr;
+    grid_column_cache* column_cache = nullptr;
     column_layout_node column = {};
-    alia_arena_marker scratch_marker = {};
+    // where the current pass found the grid's scratch data
+    size_t scratch_start = 0;
+    grid_scratch* scratch = nullptr;
+    alia_horizontal_requirements* columns = nullptr;
+    size_t* row_offsets = nullptr;
 };
 
 struct grid_row_layout_node
 {
     alia_layout_container container = {};
     grid_layout_node* grid = nullptr;
-    alia_arena_marker scratch_marker = {};
+    // the row's position within the grid
+    uint32_t index = 0;
+    // If the rows were measured in parallel, this is the chunk that this row
+    // was measured in.
+    layout_fork_chunk const* chunk = nullptr;
     grid_row_layout_node* next_row = nullptr;
 };
 
 struct grid_scratch
 {
     int column_count = 0;
-    alia_horizontal_requirements* columns = nullptr;
+    // true iff the rows were measured in parallel
+    bool forked = false;
     float total_width = 0, total_growth = 0;
+    // the offsets of the combined requirements of the columns, the offsets of
+    // the rows' scratch data, and the scratch data of `grid.column` - The
+    // rows' offsets are relative to the start of the grid's data, or, if the
+    // rows were measured in parallel, to their chunks' segments.
+    size_t columns_offset = 0;
+    size_t row_offsets_offset = 0;
+    size_t column_offset = 0;
 };
 
 struct grid_row_scratch
@@ -41,71 +134,419 @@ struct grid_row_scratch
     float height = 0, ascent = 0;
 };
 
+uint32_t
+count_cells(grid_row_layout_node const& row)
+{
+    uint32_t count = 0;
+    for (auto child = row.container.first_child; child;
+         child = child->next_sibling)
+    {
+        ++count;
+    }
+    return count;
+}
+
 int
 count_columns(grid_layout_node* grid)
 {
-    // TODO: Add faster paths.
-    int max_column_count = 0;
+    uint32_t max_column_count = 0;
     for (auto row = grid->first_row; row; row = row->next_row)
+        max_column_count = (std::max) (max_column_count, count_cells(*row));
+    return int(max_column_count);
+}
+
+void
+fold_requirements(
+    alia_horizontal_requirements& total, alia_horizontal_requirements x)
+{
+    total.growth_factor = (std::max) (total.growth_factor, x.growth_factor);
+    total.min_size = (std::max) (total.min_size, x.min_size);
+}
+
+// Start a row's scratch data (which the row's cells follow), recording where
+// it is.
+void
+begin_row_scratch(alia_measurement_context* ctx, grid_row_layout_node& row)
+{
+    size_t const base = row.chunk ? 0 : row.grid->scratch_start;
+    row.grid->row_offsets[row.index] = ctx->scratch.offset - base;
+    claim_scratch<grid_row_scratch>(ctx->scratch);
+}
+
+// Measure the horizontal requirements of a row's cells, folding them into
+// `columns`.
+void
+measure_row_cells(
+    alia_measurement_context* ctx,
+    grid_row_layout_node& row,
+    alia_horizontal_requirements* columns)
+{
+    begin_row_scratch(ctx, row);
+    int column_index = 0;
+    for (alia_layout_node* child = row.container.first_child; child != nullptr;
+         child = child->next_sibling, ++column_index)
+    {
+        fold_requirements(
+            columns[column_index], alia_measure_horizontal(ctx, child));
+    }
+}
+
+void
+grid_column_cache_cleanup(
+    alia_substrate_system*, void* payload, alia_substrate_cleanup_mode)
+{
+    auto& cache = *reinterpret_cast<grid_column_cache*>(payload);
+    std::free(cache.rows);
+    std::free(cache.cells);
+    std::free(cache.previous);
+    std::free(cache.columns);
+    cache = grid_column_cache{};
+}
+
+alia_horizontal_requirements*
+row_cells(grid_column_cache const& cache, uint32_t row_index)
+{
+    return cache.cells + size_t(row_index) * cache.column_capacity;
+}
+
+void
+reserve_rows(grid_column_cache& cache, uint32_t row_count)
+{
+    if (row_count <= cache.row_capacity)
+        return;
+    uint32_t const capacity = (std::max) (row_count, cache.row_capacity * 2);
+    cache.rows = static_cast<grid_row_entry*>(
+        std::realloc(cache.rows, capacity * sizeof(grid_row_entry)));
+    cache.cells = static_cast<alia_horizontal_requirements*>(std::realloc(
+        cache.cells,
+        size_t(capacity) * cache.column_capacity
+            * sizeof(alia_horizontal_requirements)));
+    ALIA_ASSERT(cache.rows);
+    cache.row_capacity = capacity;
+}
+
+// Make room for `column_count` cells in each row, keeping the cells of the
+// first `valid_rows` rows.
+void
+reserve_columns(
+    grid_column_cache& cache, uint32_t column_count, uint32_t valid_rows)
+{
+    if (column_count <= cache.column_capacity)
+        return;
+    uint32_t const capacity
+        = (std::max) (column_count, cache.column_capacity * 2);
+    // Each row's cells are spaced out by the capacity, so they all move.
+    auto* cells = static_cast<alia_horizontal_requirements*>(std::malloc(
+        size_t(cache.row_capacity) * capacity
+        * sizeof(alia_horizontal_requirements)));
+    for (uint32_t i = 0; i != valid_rows; ++i)
     {
-        int column_count = 0;
-        for (auto child = row->container.first_child; child;
+        std::memcpy(
+            cells + size_t(i) * capacity,
+            row_cells(cache, i),
+            cache.rows[i].cell_count * sizeof(alia_horizontal_requirements));
+    }
+    std::free(cache.cells);
+    cache.cells = cells;
+    cache.previous = static_cast<alia_horizontal_requirements*>(std::realloc(
+        cache.previous, capacity * sizeof(alia_horizontal_requirements)));
+    cache.columns = static_cast<alia_horizontal_requirements*>(std::realloc(
+        cache.columns, capacity * sizeof(alia_horizontal_requirements)));
+    ALIA_ASSERT(cache.cells && cache.previous && cache.columns);
+    std::fill(
+        cache.columns + cache.column_capacity,
+        cache.columns + capacity,
+        alia_horizontal_requirements{});
+    cache.column_capacity = capacity;
+}
+
+// Could replacing a row's `old_cells` with `new_cells` lower the combined
+// requirements of the columns (or the column count)?
+bool
+lowers_columns(
+    grid_column_cache const& cache,
+    alia_horizontal_requirements const* old_cells,
+    uint32_t old_count,
+    alia_horizontal_requirements const* new_cells,
+    uint32_t new_count)
+{
+    if (old_count == cache.column_count && new_count < old_count)
+        return true;
+    for (uint32_t i = 0; i != old_count; ++i)
+    {
+        alia_horizontal_requirements const old_x = old_cells[i];
+        alia_horizontal_requirements const new_x
+            = i < new_count ? new_cells[i] : alia_horizontal_requirements{};
+        alia_horizontal_requirements const& column = cache.columns[i];
+        if ((old_x.min_size == column.min_size
+             && new_x.min_size < old_x.min_size)
+            || (old_x.growth_factor == column.growth_factor
+                && new_x.growth_factor < old_x.growth_factor))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Recompute the combined requirements of the columns from the entries.
+void
+recompute_columns(grid_column_cache& cache)
+{
+    uint32_t column_count = 0;
+    std::fill(
+        cache.columns,
+        cache.columns + cache.column_capacity,
+        alia_horizontal_requirements{});
+    for (uint32_t i = 0; i != cache.row_count; ++i)
+    {
+        uint32_t const cell_count = cache.rows[i].cell_count;
+        alia_horizontal_requirements const* cells = row_cells(cache, i);
+        for (uint32_t j = 0; j != cell_count; ++j)
+            fold_requirements(cache.columns[j], cells[j]);
+        column_count = (std::max) (column_count, cell_count);
+    }
+    cache.column_count = column_count;
+}
+
+// Measure a grid's rows (serially) through its column cache, leaving the
+// combined requirements of the columns in the cache.
+void
+measure_rows_through_cache(
+    alia_measurement_context* ctx, grid_layout_node& grid, uint32_t row_count)
+{
+    grid_column_cache& cache = *grid.column_cache;
+    uint32_t const mode = (ctx->cache != nullptr ? 1u : 0u)
+                        | (ctx->parallel != nullptr ? 2u : 0u);
+    if (cache.epoch == 0 || mode != cache.mode)
+    {
+        ++cache.epoch;
+        cache.mode = mode;
+    }
+    reserve_rows(cache, row_count);
+
+    uint32_t const old_row_count = cache.row_count;
+    bool recompute = false;
+    uint32_t row_index = 0;
+    for (auto row = grid.first_row; row; row = row->next_row, ++row_index)
+    {
+        row->chunk = nullptr;
+        begin_row_scratch(ctx, *row);
+
+        uint64_t const hash = row->container.base.content_hash;
+        bool const existing = row_index < old_row_count;
+        grid_row_entry& entry = cache.rows[row_index];
+        if (existing && entry.epoch == cache.epoch && entry.hash == hash)
+            continue;
+
+        uint32_t const cell_count = count_cells(*row);
+        reserve_columns(
+            cache, cell_count, (std::max) (old_row_count, row_index));
+        uint32_t const old_cell_count = existing ? entry.cell_count : 0;
+        alia_horizontal_requirements* cells = row_cells(cache, row_index);
+        std::copy(cells, cells + old_cell_count, cache.previous);
+
+        size_t const start = ctx->scratch.offset;
+        alia_horizontal_requirements* cell = cells;
+        for (alia_layout_node* child = row->container.first_child;
+             child != nullptr;
              child = child->next_sibling)
         {
-            ++column_count;
+            *cell++ = alia_measure_horizontal(ctx, child);
         }
-        max_column_count = (std::max) (max_column_count, column_count);
+        entry.hash = hash;
+        entry.epoch
+            = hash != 0 && ctx->scratch.offset == start ? cache.epoch : 0;
+        entry.cell_count = cell_count;
+
+        if (recompute)
+            continue;
+        if (existing
+            && lowers_columns(
+                cache, cache.previous, old_cell_count, cells, cell_count))
+        {
+            recompute = true;
+            continue;
+        }
+        for (uint32_t i = 0; i != cell_count; ++i)
+            fold_requirements(cache.columns[i], cells[i]);
+        cache.column_count = (std::max) (cache.column_count, cell_count);
+    }
+
+    // Check the rows that went away.
+    for (uint32_t i = row_count; i < old_row_count && !recompute; ++i)
+    {
+        recompute = lowers_columns(
+            cache, row_cells(cache, i), cache.rows[i].cell_count, nullptr, 0);
+    }
+    cache.row_count = row_count;
+
+    if (recompute)
+        recompute_columns(cache);
+}
+
+struct grid_row_fork
+{
+    layout_fork_plan* plan;
+    int column_count;
+};
+
+// Measure the rows in one chunk of a forked grid. The chunk folds its cells
+// into its own copy of the column requirements, at the start of its segment.
+void
+measure_row_chunk(
+    void* data, alia_layout_fork_context* chunk_ctx, uint32_t index)
+{
+    auto& fork = *static_cast<grid_row_fork*>(data);
+    layout_fork_chunk& chunk = fork.plan->chunks[index];
+    alia_measurement_context ctx;
+    ctx.scratch = open_scratch_segment(chunk_ctx);
+    ctx.cache = nullptr;
+    ctx.line_breaks = nullptr;
+    ctx.parallel = chunk_ctx;
+    auto* columns = arena_alloc_array<alia_horizontal_requirements>(
+        ctx.scratch, fork.column_count);
+    std::fill(
+        columns,
+        columns + fork.column_count,
+        alia_horizontal_requirements{});
+    auto* row = reinterpret_cast<grid_row_layout_node*>(chunk.first_node);
+    for (uint32_t i = 0; i != chunk.node_count; ++i, row = row->next_row)
+    {
+        row->chunk = &chunk;
+        measure_row_cells(&ctx, *row, columns);
     }
-    return max_column_count;
+    close_scratch_segment(chunk_ctx, ctx.scratch, chunk);
 }
 
 alia_horizontal_requirements
 grid_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
 {
     auto& grid = *reinterpret_cast<grid_layout_node*>(node);
+    size_t const start = ctx->scratch.offset;
+    grid.scratch_start = start;
     grid.scratch = &claim_scratch<grid_scratch>(ctx->scratch);
-    grid.scratch->column_count = count_columns(&grid);
-    grid.scratch->columns = arena_alloc_array<alia_horizontal_requirements>(
-        ctx->scratch, grid.scratch->column_count);
     // All the work of actually measuring the horizontal requirements of the
     // grid rows is done up-front, here. The grid rows will be contained within
     // the nested column below, and they will simply report these results back
     // to the column (uniformly).
+    uint32_t row_count = 0;
     for (auto row = grid.first_row; row; row = row->next_row)
+        ++row_count;
+    grid.scratch->row_offsets_offset = ctx->scratch.offset - start;
+    grid.row_offsets = arena_alloc_array<size_t>(ctx->scratch, row_count);
+    layout_fork_plan* plan = claim_fork_plan(
+        ctx, grid.container.subtree_size, nullptr, row_count);
+    grid.scratch->forked = is_forked(plan);
+    if (!is_forked(plan) && grid.column_cache)
     {
-        row->scratch_marker = alia_arena_mark(&ctx->scratch);
-        claim_scratch<grid_row_scratch>(ctx->scratch);
-        int column_index = 0;
-        for (alia_layout_node* child = row->container.first_child;
-             child != nullptr;
-             child = child->next_sibling, ++column_index)
+        measure_rows_through_cache(ctx, grid, row_count);
+        // The columns are copied out of the cache, since it only reflects the
+        // latest version of the grid.
+        int const column_count = int(grid.column_cache->column_count);
+        grid.scratch->column_count = column_count;
+        grid.scratch->columns_offset = ctx->scratch.offset - start;
+        grid.columns = arena_alloc_array<alia_horizontal_requirements>(
+            ctx->scratch, column_count);
+        std::copy(
+            grid.column_cache->columns,
+            grid.column_cache->columns + column_count,
+            grid.columns);
+    }
+    else
+    {
+        int const column_count = count_columns(&grid);
+        grid.scratch->column_count = column_count;
+        grid.scratch->columns_offset = ctx->scratch.offset - start;
+        grid.columns = arena_alloc_array<alia_horizontal_requirements>(
+            ctx->scratch, column_count);
+        std::fill(
+            grid.columns,
+            grid.columns + column_count,
+            alia_horizontal_requirements{});
+        if (is_forked(plan))
+        {
+            grid_row_layout_node* row = grid.first_row;
+            for (uint32_t i = 0; i != plan->chunk_count; ++i)
+            {
+                layout_fork_chunk& chunk = plan->chunks[i];
+                chunk.first_node = &row->container.base;
+                for (uint32_t j = 0; j != chunk.node_count; ++j)
+                    row = row->next_row;
+            }
+            grid_row_fork fork{.plan = plan, .column_count = column_count};
+            run_fork(
+                ctx->parallel, plan->chunk_count, measure_row_chunk, &fork);
+            for (uint32_t i = 0; i != plan->chunk_count; ++i)
+            {
+                auto const* chunk_columns
+                    = reinterpret_cast<alia_horizontal_requirements const*>(
+                        plan->chunks[i].scratch);
+                for (int j = 0; j != column_count; ++j)
+                    fold_requirements(grid.columns[j], chunk_columns[j]);
+            }
+        }
+        else
         {
-            auto const child_x = alia_measure_horizontal(ctx, child);
-            grid.scratch->columns[column_index].growth_factor
-                = (std::max) (grid.scratch->columns[column_index]
-                                  .growth_factor,
-                              child_x.growth_factor);
-            grid.scratch->columns[column_index].min_size
-                = (std::max) (grid.scratch->columns[column_index].min_size,
-                              child_x.min_size);
+            for (auto row = grid.first_row; row; row = row->next_row)
+            {
+                row->chunk = nullptr;
+                measure_row_cells(ctx, *row, grid.columns);
+            }
+        }
+        // The entries don't cover this resolve, so they can't be trusted
+        // afterwards.
+        if (grid.column_cache)
+        {
+            grid.column_cache->row_count = 0;
+            grid.column_cache->column_count = 0;
+            std::fill(
+                grid.column_cache->columns,
+                grid.column_cache->columns
+                    + grid.column_cache->column_capacity,
+                alia_horizontal_requirements{});
         }
     }
+    int const column_count = grid.scratch->column_count;
+    // The rows can only be measured vertically in parallel if they were
+    // measured horizontally in parallel (since they have to be able to find
+    // their segments).
+    grid.column.subtree_size
+        = is_forked(plan) ? grid.container.subtree_size : 0;
     float total_width = 0, total_growth = 0;
-    for (int i = 0; i < grid.scratch->column_count; ++i)
+    for (int i = 0; i < column_count; ++i)
     {
-        total_width += grid.scratch->columns[i].min_size;
-        total_growth += grid.scratch->columns[i].growth_factor;
+        total_width += grid.columns[i].min_size;
+        total_growth += grid.columns[i].growth_factor;
     }
     grid.scratch->total_width = total_width;
     grid.scratch->total_growth = total_growth;
     // We still invoke the column, even though we know what the rows are going
     // to contribute to it. There might be other nodes in the column that
     // affect the results.
-    grid.scratch_marker = alia_arena_mark(&ctx->scratch);
+    grid.scratch->column_offset = ctx->scratch.offset - start;
     return column_measure_horizontal(
         ctx, upcast<alia_layout_node>(&grid.column));
 }
 
+// Find the grid's scratch data at the current position of `scratch` and move
+// on to the column's.
+void
+enter_grid_scratch(alia_bump_allocator& scratch, grid_layout_node& grid)
+{
+    size_t const start = scratch.offset;
+    grid.scratch_start = start;
+    grid.scratch = &use_scratch<grid_scratch>(scratch);
+    grid.columns = static_cast<alia_horizontal_requirements*>(
+        alia_arena_ptr(&scratch, start + grid.scratch->columns_offset));
+    grid.row_offsets = static_cast<size_t*>(
+        alia_arena_ptr(&scratch, start + grid.scratch->row_offsets_offset));
+    grid.column.subtree_size
+        = grid.scratch->forked ? grid.container.subtree_size : 0;
+    alia_arena_jump(
+        &scratch, {.offset = start + grid.scratch->column_offset});
+}
+
 alia_vertical_requirements
 grid_measure_vertical(
     alia_measurement_context* ctx,
@@ -114,7 +555,7 @@ grid_measure_vertical(
     float assigned_width)
 {
     auto& grid = *reinterpret_cast<grid_layout_node*>(node);
-    alia_arena_jump(&ctx->scratch, grid.scratch_marker);
+    enter_grid_scratch(ctx->scratch, grid);
     return column_measure_vertical(
         ctx,
         main_axis,
@@ -131,7 +572,7 @@ grid_assign_boxes(
     float baseline)
 {
     auto& grid = *reinterpret_cast<grid_layout_node*>(node);
-    alia_arena_jump(&ctx->scratch, grid.scratch_marker);
+    enter_grid_scratch(ctx->scratch, grid);
     column_assign_boxes(
         ctx, main_axis, upcast<alia_layout_node>(&grid.column), box, baseline);
 }
@@ -142,17 +583,32 @@ alia_layout_node_vtable grid_vtable
        grid_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       true,
+       "grid"};
+
+// Switch `scratch` over to a row's scratch data, returning the allocator to
+// switch back to afterwards.
+alia_bump_allocator
+enter_row_scratch(
+    alia_bump_allocator& scratch, grid_row_layout_node const& row)
+{
+    alia_bump_allocator const outer = scratch;
+    grid_layout_node const& grid = *row.grid;
+    size_t offset = grid.row_offsets[row.index];
+    if (grid.scratch->forked)
+        scratch = chunk_scratch(*row.chunk);
+    else
+        offset += grid.scratch_start;
+    alia_arena_jump(&scratch, {.offset = offset});
+    return outer;
+}
 
 alia_horizontal_requirements
 grid_row_measure_horizontal(
     alia_measurement_context* ctx, alia_layout_node* node)
 {
     auto& grid_row = *reinterpret_cast<grid_row_layout_node*>(node);
-    auto const marker = alia_arena_mark(&ctx->scratch);
-    alia_arena_jump(&ctx->scratch, grid_row.scratch_marker);
-    auto& scratch = use_scratch<grid_row_scratch>(ctx->scratch);
-    alia_arena_jump(&ctx->scratch, marker);
     return alia_horizontal_requirements{
         .min_size = grid_row.grid->scratch->total_width,
         .growth_factor = alia_resolve_growth_factor(grid_row.container.flags)};
@@ -166,8 +622,8 @@ grid_row_measure_vertical(
     float assigned_width)
 {
     auto& grid_row = *reinterpret_cast<grid_row_layout_node*>(node);
-    auto const marker = alia_arena_mark(&ctx->scratch);
-    alia_arena_jump(&ctx->scratch, grid_row.scratch_marker);
+    alia_bump_allocator const outer_scratch
+        = enter_row_scratch(ctx->scratch, grid_row);
     auto& scratch = use_scratch<grid_row_scratch>(ctx->scratch);
     auto& grid = *grid_row.grid;
     auto const placement = alia_resolve_container_x(
@@ -180,7 +636,7 @@ grid_row_measure_vertical(
     float const one_over_total_growth
         = 1.0f / (std::max) (0.00001f, grid.scratch->total_growth);
     float height = 0, ascent = 0, descent = 0;
-    auto const* column_data = grid.scratch->columns;
+    auto const* column_data = grid.columns;
     for (alia_layout_node* child = grid_row.container.first_child;
          child != nullptr;
          child = child->next_sibling)
@@ -196,7 +652,7 @@ grid_row_measure_vertical(
     }
     scratch.height = height;
     scratch.ascent = ascent;
-    alia_arena_jump(&ctx->scratch, marker);
+    ctx->scratch = outer_scratch;
     return alia_mask_reported_vertical_requirements(
         grid_row.container.flags,
         main_axis,
@@ -217,8 +673,8 @@ grid_row_assign_boxes(
     float baseline)
 {
     auto& grid_row = *reinterpret_cast<grid_row_layout_node*>(node);
-    auto const marker = alia_arena_mark(&ctx->scratch);
-    alia_arena_jump(&ctx->scratch, grid_row.scratch_marker);
+    alia_bump_allocator const outer_scratch
+        = enter_row_scratch(ctx->scratch, grid_row);
     auto& scratch = use_scratch<grid_row_scratch>(ctx->scratch);
     auto& grid = *grid_row.grid;
     auto const placement = alia_resolve_container_box(
@@ -232,7 +688,7 @@ grid_row_assign_boxes(
         = (std::max) (0.f, placement.size.x - grid.scratch->total_width);
     float const one_over_total_growth
         = 1.0f / (std::max) (0.00001f, grid.scratch->total_growth);
-    auto const* column_data = grid.scratch->columns;
+    auto const* column_data = grid.columns;
     for (alia_layout_node* child = grid_row.container.first_child;
          child != nullptr;
          child = child->next_sibling)
@@ -249,15 +705,28 @@ grid_row_assign_boxes(
             baseline);
         current_x += child_x.min_size + extra_space;
     }
-    alia_arena_jump(&ctx->scratch, marker);
+    ctx->scratch = outer_scratch;
 }
 
+// (Rows aren't cached on their own, since they're laid out according to the
+// columns, which depend on the other rows.)
 alia_layout_node_vtable grid_row_vtable = {
     grid_row_measure_horizontal,
     grid_row_measure_vertical,
     grid_row_assign_boxes,
+    nullptr,
+    nullptr,
+    nullptr,
+    false,
+    "grid_row",
 };
 
+alia_layout_container const&
+grid_column(alia_layout_node const* grid)
+{
+    return reinterpret_cast<grid_layout_node const*>(grid)->column;
+}
+
 } // namespace alia
 
 using namespace alia;
@@ -268,11 +737,26 @@ typedef struct alia_layout_grid_scope
 {
     grid_layout_node* grid = nullptr;
     grid_row_layout_node** next_row_ptr = nullptr;
+    uint32_t row_count = 0;
 } alia_layout_grid_scope;
 
 alia_layout_grid_handle
 alia_layout_grid_begin(alia_context* ctx, alia_layout_flags_t flags)
 {
+    // The column cache lives in the substrate, so it's only available to
+    // contexts that have one.
+    grid_column_cache* column_cache = nullptr;
+    if (ctx->substrate)
+    {
+        alia_substrate_usage_result const result = alia_substrate_use_object(
+            ctx,
+            sizeof(grid_column_cache),
+            alignof(grid_column_cache),
+            grid_column_cache_cleanup);
+        column_cache = reinterpret_cast<grid_column_cache*>(result.ptr);
+        if (result.mode != ALIA_SUBSTRATE_BLOCK_TRAVERSAL_NORMAL)
+            *column_cache = grid_column_cache{};
+    }
     if (is_refresh_event(*ctx))
     {
         auto& scope = stack_push<alia_layout_grid_scope>(ctx);
@@ -280,18 +764,27 @@ alia_layout_grid_begin(alia_context* ctx, alia_layout_flags_t flags)
         grid_layout_node* node = arena_alloc<grid_layout_node>(emission.arena);
         scope.grid = node;
         scope.next_row_ptr = &node->first_row;
+        scope.row_count = 0;
         *node = grid_layout_node{
-            .base = {.vtable = &grid_vtable, .next_sibling = nullptr},
+            .container
+            = {.base = {.vtable = &grid_vtable, .next_sibling = nullptr},
+               .flags = flags,
+               .first_child = nullptr},
             .first_row = nullptr,
-            .scratch = nullptr,
+            .column_cache = column_cache,
             .column
             = {.base
                = {.vtable = &alia::column_vtable, .next_sibling = nullptr},
                .flags = flags,
                .first_child = nullptr},
         };
-        *emission.next_ptr = &node->base;
+        // (The rows' hashes are folded into this when the grid ends.)
+        node->container.base.content_hash
+            = layout_hash_node(&grid_vtable, flags);
+        *emission.next_ptr = &node->container.base;
         emission.next_ptr = &node->column.first_child;
+        // (This holds the starting count until the grid ends.)
+        node->container.subtree_size = emission.node_count++;
         return &scope;
     }
     return nullptr;
@@ -303,10 +796,15 @@ alia_layout_grid_end(alia_context* ctx)
     if (is_refresh_event(*ctx))
     {
         auto& scope = stack_pop<alia_layout_grid_scope>(ctx);
+        grid_layout_node& grid = *scope.grid;
         *scope.next_row_ptr = 0;
         auto& emission = ctx->layout->emission;
         *emission.next_ptr = 0;
-        emission.next_ptr = &scope.grid->base.next_sibling;
+        emission.next_ptr = &grid.container.base.next_sibling;
+        grid.container.subtree_size
+            = emission.node_count - grid.container.subtree_size;
+        grid.container.base.content_hash = layout_hash_children(
+            grid.container.base.content_hash, grid.column.first_child);
     }
 }
 
@@ -330,7 +828,14 @@ alia_layout_grid_row_begin(
                .flags = flags,
                .first_child = nullptr},
             .grid = grid->grid,
+            .index = grid->row_count++,
             .next_row = nullptr};
+        // The row's cells are folded into this when the row ends. This is
+        // what the grid's column cache checks to see if the row has changed
+        // (although the row's horizontal requirements only depend on its
+        // cells, the flags have to be covered by the grid's hash).
+        node->container.base.content_hash
+            = layout_hash_node(&grid_row_vtable, flags);
         scope.node = node;
         alia_layout_container_activate(ctx, &node->container);
         *grid->next_row_ptr = node;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+extern alia_layout_node_vtable grid_vtable;
+
+extern alia_layout_node_vtable grid_row_vtable;
+
+// Get the column that holds a grid's rows (along with anything else that was
+// emitted directly within the grid).
+alia_layout_container const&
+grid_column(alia_layout_node const* grid);
+
+alia_horizontal_requirements
+grid_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node);
+
+alia_vertical_requirements
+grid_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width);
+
+void
+grid_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline);
+
+} // namespace alia
@@ -3,15 +3,11 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/growth_override.h>
 
 namespace alia {
 
-struct growth_override_node
-{
-    alia_layout_container container;
-    float growth;
-};
-
 alia_horizontal_requirements
 growth_override_measure_horizontal(
     alia_measurement_context* ctx, alia_layout_node* node)
@@ -88,7 +84,9 @@ alia_layout_node_vtable growth_override_vtable
        growth_override_assign_boxes,
        growth_override_count_flow_emissions,
        growth_override_emit_flow_fragments,
-       growth_override_read_fragment_placements};
+       growth_override_read_fragment_placements,
+       false,
+       "growth_override"};
 
 } // namespace alia
 
@@ -115,6 +113,8 @@ alia_layout_growth_override_begin(alia_context* ctx, float growth)
                .flags = 0,
                .first_child = 0},
             .growth = growth};
+        node->container.base.content_hash
+            = layout_hash_node(&growth_override_vtable, growth);
         scope.node = node;
         alia_layout_container_activate(ctx, &node->container);
     }
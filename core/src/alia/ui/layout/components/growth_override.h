@@ -0,0 +1,16 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct growth_override_node
+{
+    alia_layout_container container;
+    float growth;
+};
+
+extern alia_layout_node_vtable growth_override_vtable;
+
+} // namespace alia
@@ -3,19 +3,13 @@
 
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/leaf.h>
 
 using namespace alia::operators;
 
 namespace alia {
 
-struct layout_leaf_node
-{
-    alia_layout_node base;
-    alia_layout_flags_t flags;
-    float spacing;
-    alia_layout_content_metrics content;
-};
-
 static float
 leaf_effective_spacing(layout_leaf_node const& leaf)
 {
@@ -76,7 +70,27 @@ alia_layout_node_vtable leaf_vtable
        leaf_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "leaf"};
+
+void
+emit_leaf(
+    alia_layout_emission& emission,
+    alia_layout_content_metrics content,
+    alia_layout_flags_t flags,
+    float spacing)
+{
+    layout_leaf_node* new_node = arena_alloc<layout_leaf_node>(emission.arena);
+    alia_layout_emit_node(&emission, &new_node->base);
+    *new_node = layout_leaf_node{
+        .base = {.vtable = &leaf_vtable, .next_sibling = 0},
+        .flags = flags,
+        .spacing = spacing,
+        .content = content};
+    new_node->base.content_hash = layout_hash_node(
+        &leaf_vtable, new_node->flags, new_node->spacing, content);
+}
 
 } // namespace alia
 
@@ -90,15 +104,11 @@ alia_layout_leaf_emit(
     alia_layout_content_metrics content,
     alia_layout_flags_t flags)
 {
-    auto& emission = ctx->layout->emission;
-    layout_leaf_node* new_node = arena_alloc<layout_leaf_node>(emission.arena);
-    *emission.next_ptr = &new_node->base;
-    emission.next_ptr = &new_node->base.next_sibling;
-    *new_node = layout_leaf_node{
-        .base = {.vtable = &leaf_vtable, .next_sibling = 0},
-        .flags = flags,
-        .spacing = alia_layout_style_active(ctx)->spacing,
-        .content = content};
+    emit_leaf(
+        ctx->layout->emission,
+        content,
+        flags,
+        alia_layout_style_active(ctx)->spacing);
 }
 
 } // extern "C"
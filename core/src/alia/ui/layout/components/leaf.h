@@ -0,0 +1,27 @@
+#pragma once
+
+#include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct layout_leaf_node
+{
+    alia_layout_node base;
+    alia_layout_flags_t flags;
+    float spacing;
+    alia_layout_content_metrics content;
+};
+
+extern alia_layout_node_vtable leaf_vtable;
+
+// Emit a leaf with explicit spacing (rather than the active style's).
+void
+emit_leaf(
+    alia_layout_emission& emission,
+    alia_layout_content_metrics content,
+    alia_layout_flags_t flags,
+    float spacing);
+
+} // namespace alia
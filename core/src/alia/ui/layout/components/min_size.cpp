@@ -2,15 +2,11 @@
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/min_size.h>
 
 namespace alia {
 
-struct min_size_node
-{
-    alia_layout_container container;
-    alia_vec2f min_size;
-};
-
 alia_horizontal_requirements
 min_size_measure_horizontal(
     alia_measurement_context* ctx, alia_layout_node* base_node)
@@ -59,7 +55,9 @@ alia_layout_node_vtable min_size_vtable
        min_size_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "min_size"};
 
 } // namespace alia
 
@@ -85,6 +83,8 @@ alia_layout_min_size_begin(alia_context* ctx, alia_vec2f min_size)
                .flags = 0,
                .first_child = 0},
             .min_size = min_size};
+        node->container.base.content_hash
+            = layout_hash_node(&min_size_vtable, min_size);
         scope.node = node;
         alia_layout_container_activate(ctx, &node->container);
     }
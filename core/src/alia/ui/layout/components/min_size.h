@@ -0,0 +1,16 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct min_size_node
+{
+    alia_layout_container container;
+    alia_vec2f min_size;
+};
+
+extern alia_layout_node_vtable min_size_vtable;
+
+} // namespace alia
@@ -1,3 +1,4 @@
+#include <alia/abi/ui/drawing/commands.h>
 #include <alia/abi/ui/layout/api.h>
 
 #include <alia/impl/events.hpp>
@@ -10,7 +11,13 @@ extern "C" {
 alia_box
 alia_layout_consume_box(alia_context* ctx)
 {
-    return *arena_alloc<alia_box>(*alia_layout_placement_arena(ctx));
+    alia_box const box
+        = *arena_alloc<alia_box>(*alia_layout_placement_arena(ctx));
+    // Content generally draws within the boxes it consumes, so this is what
+    // damage tracking goes by.
+    if (ctx->draw)
+        alia_draw_note_bounds(ctx, box);
+    return box;
 }
 
 alia_layout_box_array
@@ -19,6 +26,11 @@ alia_layout_consume_box_array(alia_context* ctx)
     uint32_t* count = arena_alloc<uint32_t>(*alia_layout_placement_arena(ctx));
     alia_box* boxes = arena_alloc_array<alia_box>(
         *alia_layout_placement_arena(ctx), *count);
+    if (ctx->draw)
+    {
+        for (uint32_t i = 0; i != *count; ++i)
+            alia_draw_note_bounds(ctx, boxes[i]);
+    }
     return {.count = *count, .boxes = boxes};
 }
 
@@ -1,5 +1,8 @@
+#include <alia/ui/layout/components/row.h>
+
 #include <alia/abi/ui/layout/utilities/placement.h>
 #include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/parallel.h>
 
 using namespace alia::operators;
 
@@ -27,14 +30,17 @@ row_measure_horizontal(alia_measurement_context* ctx, alia_layout_node* node)
     alia_horizontal_requirements* x_requirements
         = arena_alloc_array<alia_horizontal_requirements>(
             ctx->scratch, scratch.child_count);
-    for (alia_layout_node* child = row.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
-        auto const child_x = alia_measure_horizontal(ctx, child);
-        *x_requirements++ = child_x;
-        scratch.total_width += child_x.min_size;
-        scratch.total_growth += child_x.growth_factor;
-    }
+    layout_fork_plan* plan = claim_fork_plan(
+        ctx, row.subtree_size, row.first_child, scratch.child_count);
+    measure_children_horizontal(
+        ctx,
+        plan,
+        row.first_child,
+        [&](alia_horizontal_requirements const& child_x) {
+            *x_requirements++ = child_x;
+            scratch.total_width += child_x.min_size;
+            scratch.total_growth += child_x.growth_factor;
+        });
     scratch.total_width += alia_layout_gap_total(row.gap, scratch.child_count);
     return alia_horizontal_requirements{
         .min_size = scratch.total_width,
@@ -53,6 +59,8 @@ row_measure_vertical(
     alia_horizontal_requirements* x_requirements
         = arena_alloc_array<alia_horizontal_requirements>(
             ctx->scratch, scratch.child_count);
+    layout_fork_plan* plan
+        = use_fork_plan(ctx->scratch, ctx->parallel, row.subtree_size);
     // TODO: Stop repeating this logic everywhere.
     auto const placement = alia_resolve_container_x(
         alia_fold_in_cross_axis_flags(row.flags, main_axis),
@@ -64,18 +72,23 @@ row_measure_vertical(
     float const one_over_total_growth
         = 1.0f / (std::max) (0.00001f, scratch.total_growth);
     float height = 0, ascent = 0, descent = 0;
-    for (alia_layout_node* child = row.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
-        auto const child_x = *x_requirements++;
-        float const extra_space = total_extra_space * child_x.growth_factor
-                                * one_over_total_growth;
-        auto const child_y = alia_measure_vertical(
-            ctx, ALIA_MAIN_AXIS_X, child, child_x.min_size + extra_space);
-        height = (std::max) (height, child_y.min_size);
-        ascent = (std::max) (ascent, child_y.ascent);
-        descent = (std::max) (descent, child_y.descent);
-    }
+    measure_children_vertical(
+        ctx,
+        plan,
+        row.first_child,
+        ALIA_MAIN_AXIS_X,
+        [&](uint32_t i) {
+            auto const child_x = x_requirements[i];
+            float const extra_space = total_extra_space
+                                    * child_x.growth_factor
+                                    * one_over_total_growth;
+            return child_x.min_size + extra_space;
+        },
+        [&](alia_vertical_requirements const& child_y) {
+            height = (std::max) (height, child_y.min_size);
+            ascent = (std::max) (ascent, child_y.ascent);
+            descent = (std::max) (descent, child_y.descent);
+        });
     scratch.height = height;
     scratch.ascent = ascent;
     scratch.descent = descent;
@@ -102,6 +115,8 @@ row_assign_boxes(
     alia_horizontal_requirements* x_requirements
         = arena_alloc_array<alia_horizontal_requirements>(
             ctx->scratch, scratch.child_count);
+    layout_fork_plan const* plan
+        = use_fork_plan(ctx->scratch, ctx->parallel, row.subtree_size);
     auto const placement = alia_resolve_container_box(
         alia_fold_in_cross_axis_flags(row.flags, main_axis),
         box.size,
@@ -122,9 +137,7 @@ row_assign_boxes(
     float current_x = box.min.x + placement.min.x;
     float const baseline_in_row = alia_resolve_baseline(
         row.flags, placement.size.y, scratch.ascent, scratch.descent);
-    for (alia_layout_node* child = row.first_child; child != nullptr;
-         child = child->next_sibling)
-    {
+    assign_children(ctx, plan, row.first_child, [&](alia_layout_node* child) {
         auto const child_x = *x_requirements++;
         float const extra_space = total_extra_space * child_x.growth_factor
                                 * one_over_total_growth;
@@ -136,7 +149,7 @@ row_assign_boxes(
              .size = {child_x.min_size + extra_space, box.size.y}},
             baseline_in_row);
         current_x += child_x.min_size + extra_space + row.gap;
-    }
+    });
 }
 
 alia_layout_node_vtable row_vtable
@@ -145,7 +158,9 @@ alia_layout_node_vtable row_vtable
        row_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       true,
+       "row"};
 
 } // namespace alia
 
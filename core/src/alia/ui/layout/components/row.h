@@ -0,0 +1,28 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+
+namespace alia {
+
+extern alia_layout_node_vtable row_vtable;
+
+alia_horizontal_requirements
+row_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node);
+
+alia_vertical_requirements
+row_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width);
+
+void
+row_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline);
+
+} // namespace alia
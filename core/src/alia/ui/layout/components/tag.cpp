@@ -0,0 +1,150 @@
+#include <alia/abi/ui/layout/placements.h>
+
+#include <alia/abi/ui/layout/utilities/flow.h>
+#include <alia/context.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/base/stack.hpp>
+#include <alia/impl/events.hpp>
+#include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/tag.h>
+#include <alia/ui/layout/placements.h>
+
+namespace alia {
+
+alia_horizontal_requirements
+layout_tag_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    return alia_measure_horizontal(ctx, tag.container.first_child);
+}
+
+alia_vertical_requirements
+layout_tag_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    return alia_measure_vertical(
+        ctx, main_axis, tag.container.first_child, assigned_width);
+}
+
+void
+layout_tag_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    layout_placement_add(ctx->placements, tag.id, box, ctx->arena.offset);
+    alia_assign_boxes(
+        ctx, main_axis, tag.container.first_child, box, baseline);
+}
+
+alia_flow_emission_counts
+layout_tag_count_flow_emissions(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    return alia_count_flow_emissions(ctx, tag.container.first_child);
+}
+
+void
+layout_tag_emit_flow_fragments(
+    alia_measurement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_emitter* emitter)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    alia_emit_flow_fragments(ctx, tag.container.first_child, emitter);
+}
+
+void
+layout_tag_read_fragment_placements(
+    alia_placement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_reader* reader)
+{
+    auto& tag = *reinterpret_cast<layout_tag_node*>(node);
+    size_t const offset = ctx->arena.offset;
+    int const start = reader->index;
+    alia_layout_read_fragment_placements(
+        ctx, tag.container.first_child, reader);
+    if (!ctx->placements)
+        return;
+
+    // The tag's box is the bounds of its content fragments.
+    bool have_box = false;
+    alia_box box = {.min = {0, 0}, .size = {0, 0}};
+    for (int i = start; i != reader->index; ++i)
+    {
+        alia_flow_fragment const& fragment = reader->fragments[i];
+        if (!alia_flow_fragment_is_content(&fragment))
+            continue;
+        alia_box const fragment_box
+            = {reader->placements[i].position, fragment.content.size};
+        box = have_box ? alia_box_union(box, fragment_box) : fragment_box;
+        have_box = true;
+    }
+    // (This goes after the entries for any tags within it, but the tables
+    // don't promise any particular order for nested tags.)
+    layout_placement_add(ctx->placements, tag.id, box, offset);
+}
+
+alia_layout_node_vtable layout_tag_vtable
+    = {layout_tag_measure_horizontal,
+       layout_tag_measure_vertical,
+       layout_tag_assign_boxes,
+       layout_tag_count_flow_emissions,
+       layout_tag_emit_flow_fragments,
+       layout_tag_read_fragment_placements,
+       false,
+       "tag"};
+
+} // namespace alia
+
+using namespace alia;
+
+extern "C" {
+
+struct alia_layout_tag_scope
+{
+    layout_tag_node* node;
+};
+
+void
+alia_layout_tag_begin(alia_context* ctx, alia_element_id id)
+{
+    if (is_refresh_event(*ctx))
+    {
+        auto& scope = stack_push<alia_layout_tag_scope>(ctx);
+        auto* node = arena_alloc<layout_tag_node>(ctx->layout->emission.arena);
+        *node = layout_tag_node{
+            .container
+            = {.base = {.vtable = &layout_tag_vtable, .next_sibling = 0},
+               .flags = 0,
+               .first_child = 0},
+            .id = id};
+        node->container.base.content_hash = layout_hash_node(
+            &layout_tag_vtable, id.ptr, id.generation, id.route);
+        scope.node = node;
+        alia_layout_container_activate(ctx, &node->container);
+    }
+}
+
+void
+alia_layout_tag_end(alia_context* ctx)
+{
+    if (is_refresh_event(*ctx))
+    {
+        auto& scope = stack_pop<alia_layout_tag_scope>(ctx);
+        alia_layout_container_deactivate(ctx, &scope.node->container);
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <alia/abi/kernel/routing.h>
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+namespace alia {
+
+struct layout_tag_node
+{
+    alia_layout_container container;
+    alia_element_id id;
+};
+
+extern alia_layout_node_vtable layout_tag_vtable;
+
+} // namespace alia
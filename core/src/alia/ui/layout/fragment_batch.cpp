@@ -0,0 +1,314 @@
+#include <alia/ui/layout/fragment_batch.h>
+
+#include <alia/impl/base/arena.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ALIA_FLOW_BATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ALIA_FLOW_BATCH_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ALIA_FLOW_BATCH_NEON
+#endif
+
+namespace alia {
+
+namespace {
+
+// Runs shorter than this aren't worth batching.
+int const min_batch_length = 8;
+
+// Do maximums and sums of `value` come out the same regardless of order?
+// (This rules out NaNs, infinities, negative values and negative zero, which
+// are exactly the values whose bit patterns are at or above that of positive
+// infinity.)
+bool
+is_plain_value(float value)
+{
+    return std::bit_cast<uint32_t>(value) < 0x7f800000u;
+}
+
+// Finish the run of batchable fragments in [begin, end).
+void
+close_batch(flow_fragment_batches const& batches, int begin, int end)
+{
+    if (end - begin < min_batch_length)
+    {
+        std::fill(batches.batch_end + begin, batches.batch_end + end, 0);
+        return;
+    }
+
+    std::fill(batches.batch_end + begin, batches.batch_end + end, end);
+
+    // Check whether the advances are exact. (This is written as a count,
+    // without early exits, so that it vectorizes.)
+    int exact_count = 0;
+    for (int i = begin; i != end; ++i)
+        exact_count += int(flow_batch_value_is_exact(batches.advance[i]));
+    if (exact_count == end - begin)
+    {
+        float* const prefix = batches.prefix;
+        std::copy(
+            batches.advance + begin, batches.advance + end, prefix + begin);
+        flow_batch_prefix_sums(prefix + begin, size_t(end - begin));
+        // Since the advances are all nonnegative, the last sum is the
+        // largest, and if it's in range, all of them are exact.
+        if (prefix[end - 1] < flow_batch_exact_limit)
+            batches.bits[end - 1] |= FLOW_BATCH_EXACT;
+    }
+}
+
+} // namespace
+
+flow_fragment_batches
+alloc_flow_fragment_batches(alia_bump_allocator& scratch, int fragment_count)
+{
+    flow_fragment_batches batches;
+    batches.batch_end = arena_alloc_array<int>(scratch, fragment_count);
+    batches.bits = arena_alloc_array<uint8_t>(scratch, fragment_count);
+    batches.advance = arena_alloc_array<float>(scratch, fragment_count);
+    batches.prefix = arena_alloc_array<float>(scratch, fragment_count);
+    batches.height = arena_alloc_array<float>(scratch, fragment_count);
+    batches.ascent = arena_alloc_array<float>(scratch, fragment_count);
+    batches.descent = arena_alloc_array<float>(scratch, fragment_count);
+    return batches;
+}
+
+void
+build_flow_fragment_batches(
+    flow_fragment_batches const& batches,
+    alia_flow_fragment const* fragments,
+    int fragment_count)
+{
+    // (These are copied out so that the stores to `bits` don't force them to
+    // be reloaded.)
+    int* const batch_end = batches.batch_end;
+    uint8_t* const bits = batches.bits;
+    float* const advance = batches.advance;
+    float* const height = batches.height;
+    float* const ascent = batches.ascent;
+    float* const descent = batches.descent;
+
+    int begin = 0;
+    for (int i = 0; i != fragment_count; ++i)
+    {
+        alia_flow_fragment const& fragment = fragments[i];
+        bool batchable;
+        if (fragment.kind == ALIA_FLOW_FRAGMENT_KIND_CONTENT)
+        {
+            alia_layout_content_metrics const& content = fragment.content;
+            // (These are combined with `&` to avoid branches.)
+            batchable = !(fragment.flags & ALIA_FLOW_FRAGMENT_BREAK_AFTER)
+                      & is_plain_value(content.size.x)
+                      & is_plain_value(content.size.y)
+                      & is_plain_value(content.ascent)
+                      & is_plain_value(content.descent);
+            bits[i]
+                = (fragment.flags & ALIA_FLOW_FRAGMENT_SUPPRESS_AT_LINE_END)
+                    ? FLOW_BATCH_CONTENT
+                    : FLOW_BATCH_CONTENT | FLOW_BATCH_ANCHOR;
+            advance[i] = content.size.x;
+            height[i] = content.size.y;
+            ascent[i] = content.ascent;
+            descent[i] = content.descent;
+        }
+        else if (fragment.kind == ALIA_FLOW_FRAGMENT_KIND_GAP)
+        {
+            batchable = is_plain_value(fragment.gap.gap);
+            bits[i] = 0;
+            advance[i] = fragment.gap.gap;
+            height[i] = 0.f;
+            ascent[i] = 0.f;
+            descent[i] = 0.f;
+        }
+        else
+        {
+            batchable = false;
+        }
+
+        if (!batchable)
+        {
+            close_batch(batches, begin, i);
+            batch_end[i] = 0;
+            bits[i] = 0;
+            begin = i + 1;
+        }
+    }
+    close_batch(batches, begin, fragment_count);
+}
+
+bool
+flow_batch_value_is_exact(float value)
+{
+    // Scaling by a power of two is itself exact, and adding and subtracting
+    // 1.5 * 2^23 rounds the scaled value to an integer. (For the largest
+    // values, it rounds to even integers, which only makes this check more
+    // conservative.) Unlike std::trunc (a library call on baseline x86-64) or
+    // a conversion to an integer, this is cheap and vectorizes.
+    float const scaled = value * 64.f;
+    float const rounder = 12582912.f;
+    return (std::fabs(scaled) < 64.f * flow_batch_exact_limit)
+         & ((scaled + rounder) - rounder == scaled);
+}
+
+void
+flow_batch_prefix_sums(float* values, size_t count)
+{
+    size_t i = 0;
+#if defined(ALIA_FLOW_BATCH_AVX2)
+    __m256 carry = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(values + i);
+        // Sum within each 128-bit lane...
+        x = _mm256_add_ps(
+            x,
+            _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 4)));
+        x = _mm256_add_ps(
+            x,
+            _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 8)));
+        // then carry the low lane's total into the high lane.
+        __m256 const lane_totals = _mm256_permute_ps(x, 0xff);
+        x = _mm256_add_ps(
+            x, _mm256_permute2f128_ps(lane_totals, lane_totals, 0x08));
+        x = _mm256_add_ps(x, carry);
+        _mm256_storeu_ps(values + i, x);
+        __m256 const last = _mm256_permute_ps(x, 0xff);
+        carry = _mm256_permute2f128_ps(last, last, 0x11);
+    }
+#elif defined(ALIA_FLOW_BATCH_SSE2)
+    __m128 carry = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(values + i);
+        x = _mm_add_ps(
+            x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+        x = _mm_add_ps(
+            x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+        x = _mm_add_ps(x, carry);
+        _mm_storeu_ps(values + i, x);
+        carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+#elif defined(ALIA_FLOW_BATCH_NEON)
+    float32x4_t const zero = vdupq_n_f32(0.f);
+    float32x4_t carry = zero;
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t x = vld1q_f32(values + i);
+        x = vaddq_f32(x, vextq_f32(zero, x, 3));
+        x = vaddq_f32(x, vextq_f32(zero, x, 2));
+        x = vaddq_f32(x, carry);
+        vst1q_f32(values + i, x);
+        carry = vdupq_n_f32(vgetq_lane_f32(x, 3));
+    }
+#endif
+    float sum = i != 0 ? values[i - 1] : 0.f;
+    for (; i != count; ++i)
+    {
+        sum += values[i];
+        values[i] = sum;
+    }
+}
+
+size_t
+flow_batch_find_exceeding(
+    float const* values,
+    size_t begin,
+    size_t end,
+    float offset,
+    float limit)
+{
+    size_t i = begin;
+#if defined(ALIA_FLOW_BATCH_AVX2)
+    __m256 const offsets = _mm256_set1_ps(offset);
+    __m256 const limits = _mm256_set1_ps(limit);
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 const extents
+            = _mm256_add_ps(offsets, _mm256_loadu_ps(values + i));
+        unsigned const mask = unsigned(_mm256_movemask_ps(
+            _mm256_cmp_ps(extents, limits, _CMP_GT_OQ)));
+        if (mask != 0)
+            return i + size_t(std::countr_zero(mask));
+    }
+#elif defined(ALIA_FLOW_BATCH_SSE2)
+    __m128 const offsets = _mm_set1_ps(offset);
+    __m128 const limits = _mm_set1_ps(limit);
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 const extents = _mm_add_ps(offsets, _mm_loadu_ps(values + i));
+        unsigned const mask
+            = unsigned(_mm_movemask_ps(_mm_cmpgt_ps(extents, limits)));
+        if (mask != 0)
+            return i + size_t(std::countr_zero(mask));
+    }
+#elif defined(ALIA_FLOW_BATCH_NEON)
+    float32x4_t const offsets = vdupq_n_f32(offset);
+    float32x4_t const limits = vdupq_n_f32(limit);
+    for (; i + 4 <= end; i += 4)
+    {
+        uint32x4_t const exceeding = vcgtq_f32(
+            vaddq_f32(offsets, vld1q_f32(values + i)), limits);
+        uint64x2_t const halves = vreinterpretq_u64_u32(exceeding);
+        if ((vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1)) != 0)
+            break;
+    }
+#endif
+    for (; i != end; ++i)
+    {
+        if (offset + values[i] > limit)
+            return i;
+    }
+    return end;
+}
+
+float
+flow_batch_max(float const* values, size_t begin, size_t end, float initial)
+{
+    size_t i = begin;
+    float result = initial;
+#if defined(ALIA_FLOW_BATCH_AVX2)
+    if (i + 8 <= end)
+    {
+        __m256 maxima = _mm256_set1_ps(initial);
+        for (; i + 8 <= end; i += 8)
+            maxima = _mm256_max_ps(maxima, _mm256_loadu_ps(values + i));
+        __m128 m = _mm_max_ps(
+            _mm256_castps256_ps128(maxima), _mm256_extractf128_ps(maxima, 1));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        result = _mm_cvtss_f32(m);
+    }
+#elif defined(ALIA_FLOW_BATCH_SSE2)
+    if (i + 4 <= end)
+    {
+        __m128 m = _mm_set1_ps(initial);
+        for (; i + 4 <= end; i += 4)
+            m = _mm_max_ps(m, _mm_loadu_ps(values + i));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+        result = _mm_cvtss_f32(m);
+    }
+#elif defined(ALIA_FLOW_BATCH_NEON)
+    if (i + 4 <= end)
+    {
+        float32x4_t m = vdupq_n_f32(initial);
+        for (; i + 4 <= end; i += 4)
+            m = vmaxq_f32(m, vld1q_f32(values + i));
+        float32x2_t pair = vmax_f32(vget_low_f32(m), vget_high_f32(m));
+        pair = vpmax_f32(pair, pair);
+        result = vget_lane_f32(pair, 0);
+    }
+#endif
+    for (; i != end; ++i)
+        result = alia_max(result, values[i]);
+    return result;
+}
+
+} // namespace alia
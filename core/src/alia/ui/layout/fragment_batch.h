@@ -0,0 +1,110 @@
+#pragma once
+
+#include <alia/abi/ui/layout/protocol.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// FRAGMENT BATCHES
+//
+// Line breaking normally walks a flow's fragments one at a time, switching on
+// each one's kind and flags. Most fragments in text-heavy flows are plain
+// content and gaps, though, and within a run of those (with no controls that
+// push or pop contexts or runs, and no forced breaks), the only thing that
+// changes from one fragment to the next is the position on the line.
+//
+// So flows with enough fragments pack those runs into batches, which store the
+// fragments' advances and vertical metrics in separate arrays. Once a line has
+// anchors, the line breaker can sweep through a batch to the first fragment
+// that might not fit and fold in all of the fragments before it at once.
+//
+// If all of a batch's advances lie on a 1/64 pixel grid (like integer sizes or
+// 26.6 fixed-point font metrics), every partial sum of them is exact, so the
+// order of the additions doesn't matter. Those batches also store the prefix
+// sums of their advances (computed with SIMD), and the line breaker finds
+// break candidates by comparing them against the available width, several at
+// a time. Other batches fall back to a tight scalar loop that adds up the
+// advances in order. Either way, the results are identical to those of the
+// fragment-by-fragment path.
+//
+// Building the batches costs about as much as breaking the fragments into
+// lines one at a time, so flows only build them (lazily) when their lines are
+// long enough for the batches to pay off, and the savings are largest when
+// the same fragments are broken more than once (e.g., when the line breaks
+// aren't cached).
+
+namespace alia {
+
+// per-fragment bits in a batch
+enum : uint8_t
+{
+    // The fragment is content (rather than a gap).
+    FLOW_BATCH_CONTENT = 1 << 0,
+    // The fragment is content that anchors the end of a line.
+    FLOW_BATCH_ANCHOR = 1 << 1,
+    // The fragment ends a batch with exact prefix sums. (This is only set on
+    // the last fragment so that closing a batch doesn't have to revisit the
+    // others.)
+    FLOW_BATCH_EXACT = 1 << 2,
+};
+
+// the packed form of a flow's fragments (as parallel arrays, one entry per
+// fragment)
+struct flow_fragment_batches
+{
+    // the index just past the end of the batch that each fragment belongs to
+    // (or 0 if it isn't in one)
+    int* batch_end;
+    uint8_t* bits;
+    // the width of each content fragment or gap
+    float* advance;
+    // the inclusive prefix sums of `advance` within each exact batch
+    float* prefix;
+    // the vertical metrics of each content fragment (or 0 for gaps)
+    float* height;
+    float* ascent;
+    float* descent;
+};
+
+// Allocate the arrays for a flow with `fragment_count` fragments. (Every pass
+// allocates them in the same order.)
+flow_fragment_batches
+alloc_flow_fragment_batches(alia_bump_allocator& scratch, int fragment_count);
+
+// Pack the batchable runs of `fragments` into the arrays of `batches`.
+void
+build_flow_fragment_batches(
+    flow_fragment_batches const& batches,
+    alia_flow_fragment const* fragments,
+    int fragment_count);
+
+// Is `value` on the grid that exact batches use (and small enough that sums
+// of such values stay exact)?
+bool
+flow_batch_value_is_exact(float value);
+
+// the largest magnitude that sums within an exact batch can reach
+float const flow_batch_exact_limit = 262144.f;
+
+// SIMD KERNELS
+
+// Replace `values[0, count)` with their inclusive prefix sums.
+void
+flow_batch_prefix_sums(float* values, size_t count);
+
+// Find the first index `i` in [begin, end) where `offset + values[i] > limit`.
+// This returns `end` if there isn't one.
+size_t
+flow_batch_find_exceeding(
+    float const* values,
+    size_t begin,
+    size_t end,
+    float offset,
+    float limit);
+
+// Get the maximum of `initial` and `values[begin, end)`. (The values must be
+// finite and nonnegative.)
+float
+flow_batch_max(float const* values, size_t begin, size_t end, float initial);
+
+} // namespace alia
@@ -0,0 +1,458 @@
+#include <alia/ui/layout/parallel.h>
+
+#include <alia/base/arena.h>
+#include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/profile.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace alia {
+
+namespace {
+
+// the default minimum number of nodes in a subtree for it to fork
+uint32_t const default_min_fork_size = 1024;
+
+// Chunks can't be nested more deeply than this.
+uint32_t const max_fork_depth = 8;
+
+// Forks are divided into this many chunks per thread (so that threads that
+// finish early can pick up the slack).
+uint32_t const chunks_per_thread = 4;
+
+} // namespace
+
+struct layout_fork_job
+{
+    layout_chunk_fn run;
+    void* data;
+    // the depth of the job's chunks
+    uint32_t depth;
+    uint32_t chunk_count;
+    // the next chunk to hand out (protected by the pool's mutex)
+    uint32_t next_chunk;
+    // the number of chunks that haven't finished yet
+    std::atomic<uint32_t> unfinished;
+};
+
+// the scratch arena that a thread uses for the chunks at one depth
+struct layout_worker_scratch
+{
+    alia_arena arena;
+    bool initialized = false;
+    // the end of the last segment that was allocated in this resolve
+    size_t offset = 0;
+};
+
+struct layout_worker_pool
+{
+    uint32_t thread_count;
+    uint32_t min_fork_size;
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Workers look for chunks while this is set and sleep otherwise.
+    std::atomic<bool> active{false};
+    bool stopping = false;
+
+    // the jobs that still have chunks to hand out (protected by `mutex`)
+    std::vector<layout_fork_job*> jobs;
+    // the total number of chunks that haven't been handed out yet - This lets
+    // idle workers check for work without taking the lock.
+    std::atomic<uint32_t> pending_chunks{0};
+
+    // indexed by `worker * max_fork_depth + depth`
+    std::unique_ptr<layout_worker_scratch[]> scratch;
+
+#ifdef ALIA_LAYOUT_PROFILING
+    // the calls recorded on each worker thread (indexed by `worker`, where
+    // the first entry goes unused)
+    std::unique_ptr<layout_profiler[]> profilers;
+#endif
+};
+
+namespace {
+
+// Hand out a chunk from `preferred` or else from any job nested more deeply
+// than `min_depth`. Returns false if there are none.
+bool
+claim_chunk(
+    layout_worker_pool& pool,
+    layout_fork_job* preferred,
+    uint32_t min_depth,
+    layout_fork_job*& job,
+    uint32_t& chunk)
+{
+    if (pool.pending_chunks.load(std::memory_order_relaxed) == 0)
+        return false;
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    // Prefer the most recently posted jobs, since they're the most deeply
+    // nested.
+    auto i = std::find(pool.jobs.begin(), pool.jobs.end(), preferred);
+    if (i == pool.jobs.end())
+    {
+        i = std::find_if(
+            pool.jobs.rbegin(),
+            pool.jobs.rend(),
+            [&](layout_fork_job* candidate) {
+                return candidate->depth > min_depth;
+            })
+                .base();
+        if (i == pool.jobs.begin())
+            return false;
+        --i;
+    }
+    job = *i;
+    chunk = job->next_chunk++;
+    if (job->next_chunk == job->chunk_count)
+        pool.jobs.erase(i);
+    pool.pending_chunks.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void
+run_chunk(
+    layout_worker_pool& pool,
+    uint32_t worker,
+    layout_fork_job& job,
+    uint32_t chunk)
+{
+    alia_layout_fork_context chunk_ctx{
+        .pool = &pool, .worker = worker, .depth = job.depth};
+    job.run(job.data, &chunk_ctx, chunk);
+    job.unfinished.fetch_sub(1, std::memory_order_release);
+}
+
+void
+worker_loop(layout_worker_pool& pool, uint32_t worker)
+{
+#ifdef ALIA_LAYOUT_PROFILING
+    bind_layout_profiler(&pool.profilers[worker]);
+#endif
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(pool.mutex);
+            pool.wake.wait(lock, [&] {
+                return pool.stopping
+                    || pool.active.load(std::memory_order_relaxed);
+            });
+            if (pool.stopping)
+                return;
+        }
+        // Stay on the lookout for chunks until the measurement passes are
+        // over.
+        while (pool.active.load(std::memory_order_relaxed))
+        {
+            layout_fork_job* job;
+            uint32_t chunk;
+            if (claim_chunk(pool, nullptr, 0, job, chunk))
+                run_chunk(pool, worker, *job, chunk);
+            else
+                std::this_thread::yield();
+        }
+    }
+}
+
+layout_worker_scratch&
+get_worker_scratch(alia_layout_fork_context const* chunk_ctx)
+{
+    ALIA_ASSERT(chunk_ctx->depth < max_fork_depth);
+    return chunk_ctx->pool
+        ->scratch[chunk_ctx->worker * max_fork_depth + chunk_ctx->depth];
+}
+
+void
+allocate_plan_arrays(alia_bump_allocator& scratch, layout_fork_plan& plan)
+{
+    plan.chunks
+        = arena_alloc_array<layout_fork_chunk>(scratch, plan.chunk_count);
+    plan.horizontal = arena_alloc_array<alia_horizontal_requirements>(
+        scratch, plan.child_count);
+    plan.widths = arena_alloc_array<float>(scratch, plan.child_count);
+    plan.vertical = arena_alloc_array<alia_vertical_requirements>(
+        scratch, plan.child_count);
+}
+
+void
+measure_chunk_horizontal(
+    void* data, alia_layout_fork_context* chunk_ctx, uint32_t index)
+{
+    auto& plan = *static_cast<layout_fork_plan*>(data);
+    layout_fork_chunk& chunk = plan.chunks[index];
+    alia_measurement_context ctx;
+    ctx.scratch = open_scratch_segment(chunk_ctx);
+    ctx.cache = nullptr;
+    ctx.line_breaks = nullptr;
+    ctx.parallel = chunk_ctx;
+    alia_layout_node* child = chunk.first_node;
+    for (uint32_t i = 0; i != chunk.node_count; ++i)
+    {
+        plan.horizontal[chunk.first_index + i]
+            = alia_measure_horizontal(&ctx, child);
+        child = child->next_sibling;
+    }
+    close_scratch_segment(chunk_ctx, ctx.scratch, chunk);
+}
+
+struct vertical_fork
+{
+    layout_fork_plan* plan;
+    alia_main_axis_index main_axis;
+};
+
+void
+measure_chunk_vertical(
+    void* data, alia_layout_fork_context* chunk_ctx, uint32_t index)
+{
+    auto& fork = *static_cast<vertical_fork*>(data);
+    layout_fork_plan& plan = *fork.plan;
+    layout_fork_chunk const& chunk = plan.chunks[index];
+    alia_measurement_context ctx;
+    ctx.scratch = chunk_scratch(chunk);
+    ctx.cache = nullptr;
+    ctx.line_breaks = nullptr;
+    ctx.parallel = chunk_ctx;
+    alia_layout_node* child = chunk.first_node;
+    for (uint32_t i = 0; i != chunk.node_count; ++i)
+    {
+        uint32_t const child_index = chunk.first_index + i;
+        plan.vertical[child_index] = alia_measure_vertical(
+            &ctx, fork.main_axis, child, plan.widths[child_index]);
+        child = child->next_sibling;
+    }
+}
+
+} // namespace
+
+layout_worker_pool*
+create_layout_worker_pool(alia_layout_parallelism parallelism)
+{
+    auto* pool = new layout_worker_pool;
+    pool->thread_count = (std::max) (parallelism.thread_count, 1u);
+    pool->min_fork_size = parallelism.min_fork_size != 0
+                            ? parallelism.min_fork_size
+                            : default_min_fork_size;
+    pool->scratch = std::make_unique<layout_worker_scratch[]>(
+        pool->thread_count * max_fork_depth);
+#ifdef ALIA_LAYOUT_PROFILING
+    pool->profilers = std::make_unique<layout_profiler[]>(pool->thread_count);
+    for (uint32_t i = 0; i != pool->thread_count; ++i)
+        reset_layout_profile(pool->profilers[i].profile);
+#endif
+    for (uint32_t i = 1; i < pool->thread_count; ++i)
+        pool->threads.emplace_back(worker_loop, std::ref(*pool), i);
+    return pool;
+}
+
+void
+destroy_layout_worker_pool(layout_worker_pool* pool)
+{
+    if (!pool)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+    for (auto& thread : pool->threads)
+        thread.join();
+    for (uint32_t i = 0; i != pool->thread_count * max_fork_depth; ++i)
+    {
+        if (pool->scratch[i].initialized)
+            alia_arena_destroy(&pool->scratch[i].arena);
+    }
+    delete pool;
+}
+
+void
+layout_worker_pool_begin_measurement(layout_worker_pool& pool)
+{
+    for (uint32_t i = 0; i != pool.thread_count * max_fork_depth; ++i)
+        pool.scratch[i].offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.active.store(true, std::memory_order_relaxed);
+    }
+    pool.wake.notify_all();
+}
+
+void
+layout_worker_pool_end_measurement(layout_worker_pool& pool)
+{
+    pool.active.store(false, std::memory_order_relaxed);
+#ifdef ALIA_LAYOUT_PROFILING
+    // All of the chunks have finished by now, so the workers are done
+    // recording.
+    for (uint32_t i = 1; i < pool.thread_count; ++i)
+        absorb_layout_profile(pool.profilers[i]);
+#endif
+}
+
+bool
+layout_subtree_can_fork(
+    alia_layout_fork_context const* parallel, uint32_t subtree_size)
+{
+    return parallel && subtree_size >= parallel->pool->min_fork_size;
+}
+
+layout_fork_plan*
+claim_fork_plan(
+    alia_measurement_context* ctx,
+    uint32_t subtree_size,
+    alia_layout_node* first_child,
+    uint32_t child_count)
+{
+    alia_layout_fork_context const* parallel = ctx->parallel;
+    if (!layout_subtree_can_fork(parallel, subtree_size))
+        return nullptr;
+    auto& plan = claim_scratch<layout_fork_plan>(ctx->scratch);
+    plan.child_count = child_count;
+    if (child_count < 2 || parallel->depth + 1 >= max_fork_depth)
+        return &plan;
+
+    plan.chunk_count = (std::min) (
+        child_count, parallel->pool->thread_count * chunks_per_thread);
+    allocate_plan_arrays(ctx->scratch, plan);
+
+    // Divide the children as evenly as possible.
+    uint32_t const base_count = child_count / plan.chunk_count;
+    uint32_t const remainder = child_count % plan.chunk_count;
+    uint32_t first_index = 0;
+    alia_layout_node* child = first_child;
+    for (uint32_t i = 0; i != plan.chunk_count; ++i)
+    {
+        layout_fork_chunk& chunk = plan.chunks[i];
+        chunk.first_node = child;
+        chunk.first_index = first_index;
+        chunk.node_count = base_count + (i < remainder ? 1 : 0);
+        chunk.scratch = nullptr;
+        chunk.scratch_size = 0;
+        first_index += chunk.node_count;
+        if (child)
+        {
+            for (uint32_t j = 0; j != chunk.node_count; ++j)
+                child = child->next_sibling;
+        }
+    }
+    return &plan;
+}
+
+layout_fork_plan*
+use_fork_plan(
+    alia_bump_allocator& scratch,
+    alia_layout_fork_context const* parallel,
+    uint32_t subtree_size)
+{
+    if (!layout_subtree_can_fork(parallel, subtree_size))
+        return nullptr;
+    auto& plan = use_scratch<layout_fork_plan>(scratch);
+    if (plan.chunk_count != 0)
+        allocate_plan_arrays(scratch, plan);
+    return &plan;
+}
+
+void
+run_fork(
+    alia_layout_fork_context* parallel,
+    uint32_t chunk_count,
+    layout_chunk_fn fn,
+    void* data)
+{
+    layout_worker_pool& pool = *parallel->pool;
+    layout_fork_job job;
+    job.run = fn;
+    job.data = data;
+    job.depth = parallel->depth + 1;
+    job.chunk_count = chunk_count;
+    job.next_chunk = 0;
+    job.unfinished.store(chunk_count, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.jobs.push_back(&job);
+        pool.pending_chunks.fetch_add(chunk_count, std::memory_order_relaxed);
+    }
+    // Work on this job (and help out with any deeper ones) until all its
+    // chunks are finished.
+    while (job.unfinished.load(std::memory_order_acquire) != 0)
+    {
+        layout_fork_job* claimed;
+        uint32_t chunk;
+        if (claim_chunk(pool, &job, parallel->depth, claimed, chunk))
+            run_chunk(pool, parallel->worker, *claimed, chunk);
+        else
+            std::this_thread::yield();
+    }
+}
+
+alia_bump_allocator
+open_scratch_segment(alia_layout_fork_context* chunk_ctx)
+{
+    layout_worker_scratch& worker_scratch = get_worker_scratch(chunk_ctx);
+    if (!worker_scratch.initialized)
+    {
+        initialize_lazy_commit_arena(&worker_scratch.arena);
+        worker_scratch.initialized = true;
+    }
+    size_t const start = (worker_scratch.offset + (ALIA_MAX_ALIGN - 1))
+                       & ~size_t(ALIA_MAX_ALIGN - 1);
+    ALIA_ASSERT(start <= worker_scratch.arena.capacity);
+    alia_bump_allocator segment;
+    segment.arena = nullptr;
+    segment.base = worker_scratch.arena.base + start;
+    segment.capacity = worker_scratch.arena.capacity - start;
+    segment.offset = 0;
+    segment.peak = 0;
+    return segment;
+}
+
+void
+close_scratch_segment(
+    alia_layout_fork_context* chunk_ctx,
+    alia_bump_allocator& segment,
+    layout_fork_chunk& chunk)
+{
+    alia_update_peak_usage(&segment);
+    chunk.scratch = segment.base;
+    chunk.scratch_size = segment.peak;
+    layout_worker_scratch& worker_scratch = get_worker_scratch(chunk_ctx);
+    worker_scratch.offset
+        = size_t(segment.base - worker_scratch.arena.base) + segment.peak;
+}
+
+alia_bump_allocator
+chunk_scratch(layout_fork_chunk const& chunk)
+{
+    alia_bump_allocator scratch;
+    scratch.arena = nullptr;
+    scratch.base = chunk.scratch;
+    scratch.capacity = chunk.scratch_size;
+    scratch.offset = 0;
+    scratch.peak = 0;
+    return scratch;
+}
+
+void
+fork_measure_horizontal(alia_measurement_context* ctx, layout_fork_plan& plan)
+{
+    run_fork(ctx->parallel, plan.chunk_count, measure_chunk_horizontal, &plan);
+}
+
+void
+fork_measure_vertical(
+    alia_measurement_context* ctx,
+    layout_fork_plan& plan,
+    alia_main_axis_index main_axis)
+{
+    vertical_fork fork{.plan = &plan, .main_axis = main_axis};
+    run_fork(ctx->parallel, plan.chunk_count, measure_chunk_vertical, &fork);
+}
+
+} // namespace alia
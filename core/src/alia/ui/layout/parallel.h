@@ -0,0 +1,265 @@
+#pragma once
+
+#include <alia/abi/ui/layout/system.h>
+#include <alia/abi/ui/layout/utilities/dispatch.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// PARALLEL LAYOUT
+//
+// In a parallel resolve, containers with large enough subtrees measure their
+// children in parallel. The children are divided into chunks of consecutive
+// siblings, and each chunk is measured on a single thread. A chunk can't share
+// the container's scratch allocator, so it gets a segment of its own, which is
+// allocated from an arena belonging to the thread during the horizontal pass.
+// The later passes revisit each chunk's segment (and go through the same
+// allocations in the same order), so within each segment, the usual protocol
+// holds.
+//
+// The container records how its children are divided (and where each chunk's
+// segment is) in its own scratch data, and it combines the children's results
+// in their original order, so parallel resolves produce exactly the same
+// results as serial ones.
+//
+// Boxes are assigned serially (since placement data is written in order), but
+// containers still switch to their chunks' segments as they go.
+//
+// Chunks can fork in turn. A thread that's waiting on the chunks that it
+// forked only helps out with chunks that are nested more deeply than its own,
+// so it never has more than one segment open at each depth, and each depth
+// gets a separate arena.
+//
+// The layout cache isn't thread-safe, so subtrees inside chunks aren't cached
+// (and flows inside them don't cache their line breaks).
+// Subtrees that are large enough to fork aren't cached either, since their
+// scratch data refers to other segments.
+
+namespace alia {
+
+struct layout_worker_pool;
+
+// Create a pool of worker threads for parallel resolves.
+layout_worker_pool*
+create_layout_worker_pool(alia_layout_parallelism parallelism);
+
+void
+destroy_layout_worker_pool(layout_worker_pool* pool);
+
+// Wake up the workers for the measurement passes of a resolve.
+void
+layout_worker_pool_begin_measurement(layout_worker_pool& pool);
+
+// Let the workers go back to sleep.
+void
+layout_worker_pool_end_measurement(layout_worker_pool& pool);
+
+} // namespace alia
+
+extern "C" {
+
+struct alia_layout_fork_context
+{
+    alia::layout_worker_pool* pool;
+    // the thread that's doing the current work (where 0 is the thread that's
+    // resolving the layout)
+    uint32_t worker;
+    // how deeply the current work is nested within chunks (0 outside of any)
+    uint32_t depth;
+};
+
+} // extern "C"
+
+namespace alia {
+
+// Does a subtree of the given size get a fork plan?
+bool
+layout_subtree_can_fork(
+    alia_layout_fork_context const* parallel, uint32_t subtree_size);
+
+// a run of consecutive siblings that's measured on a single thread
+struct layout_fork_chunk
+{
+    alia_layout_node* first_node;
+    uint32_t first_index;
+    uint32_t node_count;
+    // the chunk's scratch segment (as used by the horizontal pass)
+    uint8_t* scratch;
+    size_t scratch_size;
+};
+
+// how a container's children are divided into chunks, along with space for
+// their results
+struct layout_fork_plan
+{
+    uint32_t child_count;
+    // the number of chunks (or 0 if the children are laid out serially)
+    uint32_t chunk_count;
+    layout_fork_chunk* chunks;
+    alia_horizontal_requirements* horizontal;
+    // the widths to measure the children's vertical requirements at
+    float* widths;
+    alia_vertical_requirements* vertical;
+};
+
+// Claim a fork plan in the scratch data of a container during the horizontal
+// pass. The children are found by following `next_sibling` from
+// `first_child`. (If that's null, the caller has to fill in `first_node` for
+// each chunk.)
+// This returns null unless the container is large enough to fork (in a
+// parallel resolve).
+layout_fork_plan*
+claim_fork_plan(
+    alia_measurement_context* ctx,
+    uint32_t subtree_size,
+    alia_layout_node* first_child,
+    uint32_t child_count);
+
+// Use the fork plan claimed above during a later pass.
+layout_fork_plan*
+use_fork_plan(
+    alia_bump_allocator& scratch,
+    alia_layout_fork_context const* parallel,
+    uint32_t subtree_size);
+
+inline bool
+is_forked(layout_fork_plan const* plan)
+{
+    return plan && plan->chunk_count != 0;
+}
+
+// the function that does the work for each chunk of a fork - This is given
+// the context for the chunk's thread.
+typedef void (*layout_chunk_fn)(
+    void* data, alia_layout_fork_context* chunk_ctx, uint32_t chunk);
+
+// Run `fn` on each chunk of a fork, in parallel, and wait for all of them to
+// finish.
+void
+run_fork(
+    alia_layout_fork_context* parallel,
+    uint32_t chunk_count,
+    layout_chunk_fn fn,
+    void* data);
+
+// Open a scratch segment for a chunk during the horizontal pass.
+alia_bump_allocator
+open_scratch_segment(alia_layout_fork_context* chunk_ctx);
+
+// Close the segment and record it as the chunk's.
+void
+close_scratch_segment(
+    alia_layout_fork_context* chunk_ctx,
+    alia_bump_allocator& segment,
+    layout_fork_chunk& chunk);
+
+// Get an allocator for revisiting a chunk's segment in a later pass.
+alia_bump_allocator
+chunk_scratch(layout_fork_chunk const& chunk);
+
+// Measure the horizontal requirements of the children in a forked plan (into
+// `plan.horizontal`).
+void
+fork_measure_horizontal(
+    alia_measurement_context* ctx, layout_fork_plan& plan);
+
+// Measure the vertical requirements of the children in a forked plan at
+// `plan.widths` (into `plan.vertical`).
+void
+fork_measure_vertical(
+    alia_measurement_context* ctx,
+    layout_fork_plan& plan,
+    alia_main_axis_index main_axis);
+
+// The following implement the passes over a container's children, forking
+// them if the container's plan calls for it. The results are always consumed
+// in order.
+
+template<class Consume>
+void
+measure_children_horizontal(
+    alia_measurement_context* ctx,
+    layout_fork_plan* plan,
+    alia_layout_node* first_child,
+    Consume&& consume)
+{
+    if (is_forked(plan))
+    {
+        fork_measure_horizontal(ctx, *plan);
+        for (uint32_t i = 0; i != plan->child_count; ++i)
+            consume(plan->horizontal[i]);
+        return;
+    }
+    for (alia_layout_node* child = first_child; child != nullptr;
+         child = child->next_sibling)
+    {
+        consume(alia_measure_horizontal(ctx, child));
+    }
+}
+
+// `width(i)` gives the width to assign to the `i`th child.
+template<class Width, class Consume>
+void
+measure_children_vertical(
+    alia_measurement_context* ctx,
+    layout_fork_plan* plan,
+    alia_layout_node* first_child,
+    alia_main_axis_index main_axis,
+    Width&& width,
+    Consume&& consume)
+{
+    if (is_forked(plan))
+    {
+        for (uint32_t i = 0; i != plan->child_count; ++i)
+            plan->widths[i] = width(i);
+        fork_measure_vertical(ctx, *plan, main_axis);
+        for (uint32_t i = 0; i != plan->child_count; ++i)
+            consume(plan->vertical[i]);
+        return;
+    }
+    uint32_t i = 0;
+    for (alia_layout_node* child = first_child; child != nullptr;
+         child = child->next_sibling)
+    {
+        consume(alia_measure_vertical(ctx, main_axis, child, width(i++)));
+    }
+}
+
+// `assign(child)` assigns the boxes of each child (in order).
+template<class Assign>
+void
+assign_children(
+    alia_placement_context* ctx,
+    layout_fork_plan const* plan,
+    alia_layout_node* first_child,
+    Assign&& assign)
+{
+    if (!is_forked(plan))
+    {
+        for (alia_layout_node* child = first_child; child != nullptr;
+             child = child->next_sibling)
+        {
+            assign(child);
+        }
+        return;
+    }
+    alia_bump_allocator const outer_scratch = ctx->scratch;
+    alia_layout_cache* const outer_cache = ctx->cache;
+    ctx->cache = nullptr;
+    for (uint32_t i = 0; i != plan->chunk_count; ++i)
+    {
+        layout_fork_chunk const& chunk = plan->chunks[i];
+        ctx->scratch = chunk_scratch(chunk);
+        alia_layout_node* child = chunk.first_node;
+        for (uint32_t j = 0; j != chunk.node_count; ++j)
+        {
+            assign(child);
+            child = child->next_sibling;
+        }
+    }
+    ctx->scratch = outer_scratch;
+    ctx->cache = outer_cache;
+}
+
+} // namespace alia
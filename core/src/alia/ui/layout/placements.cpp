@@ -0,0 +1,185 @@
+#include <alia/ui/layout/placements.h>
+
+#include <alia/ui/layout/system.h>
+
+namespace alia {
+
+namespace {
+
+uint32_t
+slot_index(alia_element_id id, size_t slot_count)
+{
+    uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(id.ptr));
+    h = (h ^ id.generation ^ (uint64_t(id.route) << 32))
+      * 0x9e3779b97f4a7c15ull;
+    return uint32_t((h ^ (h >> 32)) & (slot_count - 1));
+}
+
+void
+index_table(alia_layout_placement_table& table)
+{
+    size_t slot_count = 0;
+    if (!table.entries.empty())
+    {
+        // Keep the index at most half full.
+        slot_count = 16;
+        while (slot_count < table.entries.size() * 2)
+            slot_count *= 2;
+    }
+    table.slots.assign(slot_count, 0);
+    for (uint32_t i = 0; i != uint32_t(table.entries.size()); ++i)
+    {
+        alia_element_id const id = table.entries[i].id;
+        for (uint32_t slot = slot_index(id, slot_count);;
+             slot = (slot + 1) & uint32_t(slot_count - 1))
+        {
+            uint32_t const entry = table.slots[slot];
+            if (entry == 0)
+            {
+                table.slots[slot] = i + 1;
+                break;
+            }
+            // Later duplicates are left out of the index.
+            if (alia_element_id_equal(table.entries[entry - 1].id, id))
+                break;
+        }
+    }
+}
+
+} // namespace
+
+void
+layout_placements_begin_resolve(layout_placement_tables& tables)
+{
+    tables.current = 1 - tables.current;
+    alia_layout_placement_table& table = current_placements(tables);
+    table.entries.clear();
+    table.slots.clear();
+}
+
+void
+layout_placements_end_resolve(layout_placement_tables& tables)
+{
+    index_table(current_placements(tables));
+}
+
+} // namespace alia
+
+using namespace alia;
+
+extern "C" {
+
+alia_layout_placement_table const*
+alia_layout_system_placements(alia_layout_system const* system)
+{
+    layout_placement_tables const& tables = *system->placements;
+    return &tables.tables[tables.current];
+}
+
+alia_layout_placement_table const*
+alia_layout_system_previous_placements(alia_layout_system const* system)
+{
+    layout_placement_tables const& tables = *system->placements;
+    return &tables.tables[1 - tables.current];
+}
+
+void const*
+alia_layout_system_placement_data(
+    alia_layout_system const* system, size_t offset)
+{
+    ALIA_ASSERT(offset <= system->placement_size);
+    return system->placement_arena.base + offset;
+}
+
+uint32_t
+alia_layout_placement_table_size(alia_layout_placement_table const* table)
+{
+    return uint32_t(table->entries.size());
+}
+
+alia_layout_placement const*
+alia_layout_placement_table_entries(alia_layout_placement_table const* table)
+{
+    return table->entries.data();
+}
+
+alia_layout_placement const*
+alia_layout_placement_table_find(
+    alia_layout_placement_table const* table, alia_element_id id)
+{
+    size_t const slot_count = table->slots.size();
+    if (slot_count == 0)
+        return nullptr;
+    for (uint32_t slot = slot_index(id, slot_count);;
+         slot = (slot + 1) & uint32_t(slot_count - 1))
+    {
+        uint32_t const entry = table->slots[slot];
+        if (entry == 0)
+            return nullptr;
+        if (alia_element_id_equal(table->entries[entry - 1].id, id))
+            return &table->entries[entry - 1];
+    }
+}
+
+uint32_t
+alia_layout_placement_table_diff(
+    alia_layout_placement_table const* before,
+    alia_layout_placement_table const* after,
+    void (*report)(
+        void* user_data, alia_layout_placement_change const* change),
+    void* user_data)
+{
+    uint32_t count = 0;
+    auto note = [&](alia_layout_placement_change const& change) {
+        ++count;
+        if (report)
+            report(user_data, &change);
+    };
+    alia_box const no_box = {.min = {0, 0}, .size = {0, 0}};
+
+    for (alia_layout_placement const& entry : after->entries)
+    {
+        // Only the first entry for each ID counts.
+        alia_layout_placement const* first
+            = alia_layout_placement_table_find(after, entry.id);
+        if (first != &entry)
+            continue;
+        alia_layout_placement const* old
+            = alia_layout_placement_table_find(before, entry.id);
+        alia_layout_placement_change change
+            = {.id = entry.id,
+               .flags = 0,
+               .before = old ? old->box : no_box,
+               .after = entry.box};
+        if (!old)
+        {
+            change.flags = ALIA_LAYOUT_PLACEMENT_ADDED;
+        }
+        else
+        {
+            if (!alia_vec2f_equal(old->box.min, entry.box.min))
+                change.flags |= ALIA_LAYOUT_PLACEMENT_MOVED;
+            if (!alia_vec2f_equal(old->box.size, entry.box.size))
+                change.flags |= ALIA_LAYOUT_PLACEMENT_RESIZED;
+        }
+        if (change.flags != 0)
+            note(change);
+    }
+
+    for (alia_layout_placement const& entry : before->entries)
+    {
+        if (alia_layout_placement_table_find(before, entry.id) == &entry
+            && !alia_layout_placement_table_find(after, entry.id))
+        {
+            note(
+                {.id = entry.id,
+                 .flags = ALIA_LAYOUT_PLACEMENT_REMOVED,
+                 .before = entry.box,
+                 .after = no_box});
+        }
+    }
+
+    return count;
+}
+
+} // extern "C"
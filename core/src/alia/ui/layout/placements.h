@@ -0,0 +1,65 @@
+#pragma once
+
+#include <alia/abi/ui/layout/placements.h>
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+
+struct alia_layout_placement_table
+{
+    // the tagged elements, in placement order
+    std::vector<alia_layout_placement> entries;
+    // an open-addressing index into `entries` (with linear probing) - Each
+    // slot holds an entry index + 1 (or 0 if the slot is empty). Its size is
+    // always either zero or a power of two. It's only built once the table is
+    // complete.
+    std::vector<uint32_t> slots;
+};
+
+} // extern "C"
+
+namespace alia {
+
+// the placement tables of a layout system
+struct layout_placement_tables
+{
+    alia_layout_placement_table tables[2];
+    // the index of the table that the last resolve built
+    int current;
+};
+
+inline alia_layout_placement_table&
+current_placements(layout_placement_tables& tables)
+{
+    return tables.tables[tables.current];
+}
+
+// Start a new table for a resolve (keeping the current one as the previous
+// one).
+void
+layout_placements_begin_resolve(layout_placement_tables& tables);
+
+// Index the table that the resolve built.
+void
+layout_placements_end_resolve(layout_placement_tables& tables);
+
+inline uint32_t
+layout_placement_count(alia_layout_placement_table const* table)
+{
+    return table ? uint32_t(table->entries.size()) : 0;
+}
+
+inline void
+layout_placement_add(
+    alia_layout_placement_table* table,
+    alia_element_id id,
+    alia_box box,
+    size_t offset)
+{
+    if (table)
+        table->entries.push_back({.id = id, .box = box, .offset = offset});
+}
+
+} // namespace alia
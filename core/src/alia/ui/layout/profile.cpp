@@ -0,0 +1,208 @@
+#include <alia/ui/layout/profile.h>
+
+#include <alia/ui/layout/system.h>
+
+#ifdef ALIA_LAYOUT_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace alia {
+
+namespace {
+
+thread_local layout_profiler* current_profiler = nullptr;
+
+uint64_t
+now_ns()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+// Find (or add) the entry for `vtable`. This returns null if the profile is
+// out of entries.
+alia_layout_profile_node_type*
+find_node_type(
+    alia_layout_profile& profile, alia_layout_node_vtable const* vtable)
+{
+    for (uint32_t i = 0; i != profile.node_type_count; ++i)
+    {
+        if (profile.node_types[i].vtable == vtable)
+            return &profile.node_types[i];
+    }
+    if (profile.node_type_count == ALIA_LAYOUT_PROFILE_MAX_NODE_TYPES)
+        return nullptr;
+    alia_layout_profile_node_type& type
+        = profile.node_types[profile.node_type_count++];
+    std::memset(&type, 0, sizeof(type));
+    type.vtable = vtable;
+    return &type;
+}
+
+void
+add_calls(alia_layout_profile_calls& total, alia_layout_profile_calls const& x)
+{
+    total.count += x.count;
+    total.nanoseconds += x.nanoseconds;
+    total.self_nanoseconds += x.self_nanoseconds;
+}
+
+} // namespace
+
+void
+reset_layout_profile(alia_layout_profile& profile)
+{
+    // (The node type entries are cleared as they're claimed.)
+    profile.total_nanoseconds = 0;
+    std::fill(
+        std::begin(profile.phase_nanoseconds),
+        std::end(profile.phase_nanoseconds),
+        uint64_t(0));
+    profile.nodes_visited = 0;
+    profile.scratch_peak_bytes = 0;
+    profile.placement_bytes = 0;
+    profile.node_type_count = 0;
+    profile.untracked_calls = 0;
+}
+
+layout_profiler*
+bind_layout_profiler(layout_profiler* profiler)
+{
+    layout_profiler* previous = current_profiler;
+    current_profiler = profiler;
+    return previous;
+}
+
+void
+absorb_layout_profile(layout_profiler& other)
+{
+    layout_profiler* const profiler = current_profiler;
+    if (profiler)
+    {
+        alia_layout_profile& profile = profiler->profile;
+        profile.nodes_visited += other.profile.nodes_visited;
+        profile.untracked_calls += other.profile.untracked_calls;
+        for (uint32_t i = 0; i != other.profile.node_type_count; ++i)
+        {
+            alia_layout_profile_node_type const& source
+                = other.profile.node_types[i];
+            alia_layout_profile_node_type* type
+                = find_node_type(profile, source.vtable);
+            if (!type)
+            {
+                for (auto const& calls : source.calls)
+                    profile.untracked_calls += calls.count;
+                continue;
+            }
+            for (int j = 0; j != ALIA_LAYOUT_PROFILE_CALL_COUNT; ++j)
+                add_calls(type->calls[j], source.calls[j]);
+        }
+    }
+    reset_layout_profile(other.profile);
+}
+
+layout_profile_session::layout_profile_session(alia_layout_system& system)
+    : profiler(system.profiler),
+      outer(bind_layout_profiler(system.profiler))
+{
+    reset_layout_profile(profiler->profile);
+    profiler->nested_nanoseconds.clear();
+    start = now_ns();
+    phase_start = start;
+}
+
+layout_profile_session::~layout_profile_session()
+{
+    profiler->profile.total_nanoseconds = now_ns() - start;
+    bind_layout_profiler(outer);
+}
+
+void
+layout_profile_session::end_phase(int phase)
+{
+    uint64_t const now = now_ns();
+    profiler->profile.phase_nanoseconds[phase] = now - phase_start;
+    phase_start = now;
+}
+
+void
+layout_profile_session::note_scratch(alia_bump_allocator const& scratch)
+{
+    size_t& peak = profiler->profile.scratch_peak_bytes;
+    peak = (std::max) (peak, (std::max) (scratch.peak, scratch.offset));
+}
+
+void
+layout_profile_session::note_placement(alia_bump_allocator const& placement)
+{
+    profiler->profile.placement_bytes = placement.offset;
+}
+
+} // namespace alia
+
+using namespace alia;
+
+extern "C" {
+
+uint64_t
+alia_layout_profile_enter(void)
+{
+    layout_profiler* const profiler = current_profiler;
+    if (!profiler)
+        return 0;
+    profiler->nested_nanoseconds.push_back(0);
+    return now_ns();
+}
+
+void
+alia_layout_profile_exit(
+    alia_layout_node_vtable const* vtable, int call, uint64_t start)
+{
+    layout_profiler* const profiler = current_profiler;
+    if (!profiler)
+        return;
+    uint64_t const elapsed = now_ns() - start;
+    uint64_t const nested = profiler->nested_nanoseconds.back();
+    profiler->nested_nanoseconds.pop_back();
+    if (!profiler->nested_nanoseconds.empty())
+        profiler->nested_nanoseconds.back() += elapsed;
+
+    alia_layout_profile& profile = profiler->profile;
+    if (call <= ALIA_LAYOUT_PROFILE_ASSIGN_BOXES)
+        ++profile.nodes_visited;
+    alia_layout_profile_node_type* type = find_node_type(profile, vtable);
+    if (!type)
+    {
+        ++profile.untracked_calls;
+        return;
+    }
+    alia_layout_profile_calls& calls = type->calls[call];
+    ++calls.count;
+    calls.nanoseconds += elapsed;
+    calls.self_nanoseconds += elapsed - nested;
+}
+
+alia_layout_profile const*
+alia_layout_system_profile(alia_layout_system const* system)
+{
+    return &system->profiler->profile;
+}
+
+} // extern "C"
+
+#else
+
+extern "C" {
+
+alia_layout_profile const*
+alia_layout_system_profile(alia_layout_system const*)
+{
+    return nullptr;
+}
+
+} // extern "C"
+
+#endif
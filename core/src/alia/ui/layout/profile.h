@@ -0,0 +1,98 @@
+#pragma once
+
+#include <alia/abi/base/arena.h>
+#include <alia/abi/ui/layout/profile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+struct alia_layout_system;
+}
+
+// This is the internal side of layout profiling (see
+// alia/abi/ui/layout/profile.h). If profiling isn't compiled in, the session
+// below does nothing.
+
+namespace alia {
+
+#ifdef ALIA_LAYOUT_PROFILING
+
+// the calls recorded on a single thread
+struct layout_profiler
+{
+    alia_layout_profile profile;
+    // the time spent in nested calls, for each call that's in progress
+    std::vector<uint64_t> nested_nanoseconds;
+};
+
+void
+reset_layout_profile(alia_layout_profile& profile);
+
+// Make `profiler` the one that records the calls on this thread (or stop
+// recording if it's null). This returns the previous one.
+layout_profiler*
+bind_layout_profiler(layout_profiler* profiler);
+
+// Add the calls recorded by `other` (on another thread) to the profiler that's
+// bound to this thread, and reset `other`.
+void
+absorb_layout_profile(layout_profiler& other);
+
+// records a resolve of `system` while it's alive
+struct layout_profile_session
+{
+    explicit layout_profile_session(alia_layout_system& system);
+    ~layout_profile_session();
+
+    layout_profile_session(layout_profile_session const&) = delete;
+    layout_profile_session&
+    operator=(layout_profile_session const&) = delete;
+
+    // Record the end of a pass.
+    void
+    end_phase(int phase);
+
+    // Record the usage of an allocator that the resolve used for scratch
+    // data.
+    void
+    note_scratch(alia_bump_allocator const& scratch);
+
+    void
+    note_placement(alia_bump_allocator const& placement);
+
+    layout_profiler* profiler;
+    // the profiler that was bound to this thread before the session
+    layout_profiler* outer;
+    uint64_t start;
+    uint64_t phase_start;
+};
+
+#else
+
+struct layout_profile_session
+{
+    explicit layout_profile_session(alia_layout_system&)
+    {
+    }
+
+    void
+    end_phase(int)
+    {
+    }
+
+    void
+    note_scratch(alia_bump_allocator const&)
+    {
+    }
+
+    void
+    note_placement(alia_bump_allocator const&)
+    {
+    }
+};
+
+#endif
+
+} // namespace alia
@@ -0,0 +1,796 @@
+#include <alia/abi/ui/layout/snapshot.h>
+
+#include <alia/abi/ui/layout/utilities/defaults.h>
+#include <alia/abi/ui/layout/utilities/dispatch.h>
+#include <alia/abi/ui/layout/utilities/flow.h>
+#include <alia/context.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/components/alignment_override.h>
+#include <alia/ui/layout/components/block_flow.h>
+#include <alia/ui/layout/components/column.h>
+#include <alia/ui/layout/components/edge_offsets.h>
+#include <alia/ui/layout/components/flow.h>
+#include <alia/ui/layout/components/flow_spring.h>
+#include <alia/ui/layout/components/grid.h>
+#include <alia/ui/layout/components/growth_override.h>
+#include <alia/ui/layout/components/leaf.h>
+#include <alia/ui/layout/components/min_size.h>
+#include <alia/ui/layout/components/row.h>
+#include <alia/ui/layout/components/tag.h>
+#include <alia/ui/layout/system.h>
+
+#include <cstring>
+#include <vector>
+
+namespace alia {
+
+namespace {
+
+// OPAQUE NODES
+//
+// When a snapshot is replayed, each opaque node is replaced by one of these,
+// which just reports the requirements (and fragments) that were recorded.
+
+struct snapshot_opaque_node
+{
+    alia_layout_node base;
+    alia_horizontal_requirements horizontal;
+    alia_vertical_requirements vertical;
+    // If this is 0, the node emits a single content fragment (like most
+    // nodes do).
+    uint32_t fragment_count;
+    alia_flow_fragment* fragments;
+};
+
+alia_horizontal_requirements
+snapshot_opaque_measure_horizontal(
+    alia_measurement_context*, alia_layout_node* node)
+{
+    return reinterpret_cast<snapshot_opaque_node*>(node)->horizontal;
+}
+
+alia_vertical_requirements
+snapshot_opaque_measure_vertical(
+    alia_measurement_context*,
+    alia_main_axis_index,
+    alia_layout_node* node,
+    float)
+{
+    return reinterpret_cast<snapshot_opaque_node*>(node)->vertical;
+}
+
+void
+snapshot_opaque_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index,
+    alia_layout_node*,
+    alia_box box,
+    float)
+{
+    *arena_alloc<alia_box>(ctx->arena) = box;
+}
+
+alia_flow_emission_counts
+snapshot_opaque_count_flow_emissions(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    auto& opaque = *reinterpret_cast<snapshot_opaque_node*>(node);
+    if (opaque.fragment_count == 0)
+        return alia_default_count_flow_emissions(ctx, node);
+    return alia_flow_emission_counts{.fragment_count
+                                     = int(opaque.fragment_count)};
+}
+
+void
+snapshot_opaque_emit_flow_fragments(
+    alia_measurement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_emitter* emitter)
+{
+    auto& opaque = *reinterpret_cast<snapshot_opaque_node*>(node);
+    if (opaque.fragment_count == 0)
+    {
+        alia_default_emit_flow_fragments(ctx, node, emitter);
+        return;
+    }
+    for (uint32_t i = 0; i != opaque.fragment_count; ++i)
+        alia_layout_emit_flow_fragment_raw(emitter, opaque.fragments[i]);
+}
+
+void
+snapshot_opaque_read_fragment_placements(
+    alia_placement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_reader* reader)
+{
+    auto& opaque = *reinterpret_cast<snapshot_opaque_node*>(node);
+    if (opaque.fragment_count == 0)
+    {
+        alia_default_read_fragment_placements(ctx, node, reader);
+        return;
+    }
+    for (uint32_t i = 0; i != opaque.fragment_count; ++i)
+    {
+        auto const* fragment = alia_layout_read_fragment_spec(reader);
+        auto const* placement = alia_layout_read_fragment_placement(reader);
+        if (alia_flow_fragment_is_content(fragment))
+        {
+            alia_vec2f const size = alia_flow_fragment_content(fragment)->size;
+            *arena_alloc<alia_box>(ctx->arena)
+                = alia_box{placement->position, size};
+        }
+        alia_layout_advance_fragment(reader);
+    }
+}
+
+alia_layout_node_vtable snapshot_opaque_vtable
+    = {snapshot_opaque_measure_horizontal,
+       snapshot_opaque_measure_vertical,
+       snapshot_opaque_assign_boxes,
+       snapshot_opaque_count_flow_emissions,
+       snapshot_opaque_emit_flow_fragments,
+       snapshot_opaque_read_fragment_placements,
+       false,
+       "snapshot_opaque"};
+
+// WRITING
+
+struct snapshot_writer
+{
+    alia_layout_snapshot_writer output;
+    std::vector<uint8_t> buffer;
+    // for measuring opaque nodes
+    alia_measurement_context measurement;
+};
+
+// Pass the buffered bytes on to the output once there are enough of them
+// (or unconditionally if `force` is set).
+void
+flush(snapshot_writer& w, bool force)
+{
+    if (w.buffer.empty() || (!force && w.buffer.size() < 64 * 1024))
+        return;
+    w.output.write(w.output.user_data, w.buffer.data(), w.buffer.size());
+    w.buffer.clear();
+}
+
+void
+put_u8(snapshot_writer& w, uint8_t value)
+{
+    w.buffer.push_back(value);
+}
+
+void
+put_u16(snapshot_writer& w, uint16_t value)
+{
+    put_u8(w, uint8_t(value));
+    put_u8(w, uint8_t(value >> 8));
+}
+
+void
+put_u32(snapshot_writer& w, uint32_t value)
+{
+    put_u16(w, uint16_t(value));
+    put_u16(w, uint16_t(value >> 16));
+}
+
+void
+put_f32(snapshot_writer& w, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_u32(w, bits);
+}
+
+void
+put_fragment(snapshot_writer& w, alia_flow_fragment const& fragment)
+{
+    float payload[4] = {0, 0, 0, 0};
+    switch (fragment.kind)
+    {
+        case ALIA_FLOW_FRAGMENT_KIND_CONTENT:
+            payload[0] = fragment.content.size.x;
+            payload[1] = fragment.content.size.y;
+            payload[2] = fragment.content.ascent;
+            payload[3] = fragment.content.descent;
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_GAP:
+            payload[0] = fragment.gap.gap;
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_CONTEXT_PUSH:
+        case ALIA_FLOW_FRAGMENT_KIND_CONTEXT_POP:
+            payload[0] = fragment.context.line_gap;
+            payload[1] = fragment.context.minimum_line_height;
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_RUN_PUSH:
+        case ALIA_FLOW_FRAGMENT_KIND_RUN_POP:
+            payload[0] = fragment.run.offsets.left;
+            payload[1] = fragment.run.offsets.right;
+            payload[2] = fragment.run.offsets.top;
+            payload[3] = fragment.run.offsets.bottom;
+            break;
+    }
+    put_u16(w, fragment.flags);
+    put_u8(w, fragment.kind);
+    for (float value : payload)
+        put_f32(w, value);
+}
+
+void
+write_nodes(snapshot_writer& w, alia_layout_node* first);
+
+void
+write_opaque_node(snapshot_writer& w, alia_layout_node* node)
+{
+    alia_measurement_context& ctx = w.measurement;
+    alia_arena_marker const marker = alia_arena_mark(&ctx.scratch);
+    alia_horizontal_requirements const horizontal
+        = alia_measure_horizontal(&ctx, node);
+    alia_arena_jump(&ctx.scratch, marker);
+    alia_vertical_requirements const vertical = alia_measure_vertical(
+        &ctx, ALIA_MAIN_AXIS_X, node, horizontal.min_size);
+    alia_arena_jump(&ctx.scratch, marker);
+
+    put_u8(w, ALIA_LAYOUT_SNAPSHOT_OPAQUE);
+    put_u8(w, node->content_hash != 0 ? 1 : 0);
+    put_f32(w, horizontal.min_size);
+    put_f32(w, horizontal.growth_factor);
+    put_f32(w, vertical.min_size);
+    put_f32(w, vertical.growth_factor);
+    put_f32(w, vertical.ascent);
+    put_f32(w, vertical.descent);
+
+    if (node->vtable->emit_flow_fragments == alia_default_emit_flow_fragments)
+    {
+        put_u32(w, 0);
+        return;
+    }
+    int const count = alia_count_flow_emissions(&ctx, node).fragment_count;
+    alia_flow_fragment_emitter emitter;
+    emitter.fragments
+        = arena_alloc_array<alia_flow_fragment>(ctx.scratch, size_t(count));
+    emitter.fragment_count = 0;
+    emitter.child_gap = 0;
+    alia_flow_emitter_run_stack_seed_root(&emitter);
+    alia_emit_flow_fragments(&ctx, node, &emitter);
+    ALIA_ASSERT(emitter.fragment_count == count);
+    put_u32(w, uint32_t(emitter.fragment_count));
+    for (int i = 0; i != emitter.fragment_count; ++i)
+        put_fragment(w, emitter.fragments[i]);
+    alia_arena_jump(&ctx.scratch, marker);
+}
+
+void
+write_node(snapshot_writer& w, alia_layout_node* node)
+{
+    alia_layout_node_vtable const* vtable = node->vtable;
+    auto const& container = *reinterpret_cast<alia_layout_container*>(node);
+    if (vtable == &leaf_vtable)
+    {
+        auto const& leaf = *reinterpret_cast<layout_leaf_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_LEAF);
+        put_u32(w, leaf.flags);
+        put_f32(w, leaf.spacing);
+        put_f32(w, leaf.content.size.x);
+        put_f32(w, leaf.content.size.y);
+        put_f32(w, leaf.content.ascent);
+        put_f32(w, leaf.content.descent);
+    }
+    else if (vtable == &column_vtable || vtable == &row_vtable)
+    {
+        put_u8(
+            w,
+            vtable == &column_vtable ? ALIA_LAYOUT_SNAPSHOT_COLUMN
+                                     : ALIA_LAYOUT_SNAPSHOT_ROW);
+        put_u32(w, container.flags);
+        put_f32(w, container.gap);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &flow_vtable)
+    {
+        auto const& flow = *reinterpret_cast<flow_layout_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_FLOW);
+        put_u32(w, flow.flags);
+        put_f32(w, flow.gap);
+        put_f32(w, flow.line_gap);
+        put_f32(w, flow.minimum_line_height);
+        write_nodes(w, flow.first_child);
+    }
+    else if (vtable == &block_flow_vtable)
+    {
+        auto const& flow = *reinterpret_cast<block_flow_layout_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_BLOCK_FLOW);
+        put_u32(w, flow.flags);
+        put_f32(w, flow.gap);
+        put_f32(w, flow.line_gap);
+        put_f32(w, flow.minimum_line_height);
+        write_nodes(w, flow.first_child);
+    }
+    else if (vtable == &grid_vtable)
+    {
+        alia_layout_container const& column = grid_column(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_GRID);
+        put_u32(w, column.flags);
+        write_nodes(w, column.first_child);
+    }
+    else if (vtable == &grid_row_vtable)
+    {
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_GRID_ROW);
+        put_u32(w, container.flags);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &edge_offsets_vtable)
+    {
+        auto const& wrapper
+            = *reinterpret_cast<edge_offsets_layout_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_EDGE_OFFSETS);
+        put_u32(w, container.flags);
+        put_f32(w, wrapper.offsets.left);
+        put_f32(w, wrapper.offsets.right);
+        put_f32(w, wrapper.offsets.top);
+        put_f32(w, wrapper.offsets.bottom);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &alignment_override_vtable)
+    {
+        auto const& wrapper
+            = *reinterpret_cast<alignment_override_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_ALIGNMENT_OVERRIDE);
+        put_u32(w, wrapper.flags);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &growth_override_vtable)
+    {
+        auto const& wrapper = *reinterpret_cast<growth_override_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_GROWTH_OVERRIDE);
+        put_f32(w, wrapper.growth);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &min_size_vtable)
+    {
+        auto const& wrapper = *reinterpret_cast<min_size_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_MIN_SIZE);
+        put_f32(w, wrapper.min_size.x);
+        put_f32(w, wrapper.min_size.y);
+        write_nodes(w, container.first_child);
+    }
+    else if (vtable == &layout_tag_vtable)
+    {
+        // Tags don't affect the layout, and their IDs wouldn't mean anything
+        // outside the app, so they're left out.
+        if (container.first_child)
+            write_node(w, container.first_child);
+        return;
+    }
+    else if (vtable == &flow_spring_vtable)
+    {
+        auto const& spring = *reinterpret_cast<layout_flow_spring_node*>(node);
+        put_u8(w, ALIA_LAYOUT_SNAPSHOT_FLOW_SPRING);
+        put_f32(w, spring.min_width);
+    }
+    else
+    {
+        write_opaque_node(w, node);
+    }
+    flush(w, false);
+}
+
+void
+write_nodes(snapshot_writer& w, alia_layout_node* first)
+{
+    for (alia_layout_node* node = first; node; node = node->next_sibling)
+        write_node(w, node);
+    put_u8(w, ALIA_LAYOUT_SNAPSHOT_END);
+}
+
+// READING
+//
+// Snapshots are read twice: once to check that they're well-formed, and then
+// again to emit them (which can't be undone partway through).
+
+// Opaque nodes could go arbitrarily deep, but the recorded nodes shouldn't.
+int const max_snapshot_depth = 1024;
+
+struct snapshot_reader
+{
+    uint8_t const* p;
+    uint8_t const* end;
+    bool ok;
+    // the context to emit into (or null if the snapshot is only being
+    // checked)
+    alia_context* ctx;
+};
+
+uint8_t
+get_u8(snapshot_reader& r)
+{
+    if (r.p == r.end)
+    {
+        r.ok = false;
+        return 0;
+    }
+    return *r.p++;
+}
+
+uint16_t
+get_u16(snapshot_reader& r)
+{
+    uint16_t const low = get_u8(r);
+    return uint16_t(low | (uint16_t(get_u8(r)) << 8));
+}
+
+uint32_t
+get_u32(snapshot_reader& r)
+{
+    uint32_t const low = get_u16(r);
+    return low | (uint32_t(get_u16(r)) << 16);
+}
+
+float
+get_f32(snapshot_reader& r)
+{
+    uint32_t const bits = get_u32(r);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+alia_flow_fragment
+get_fragment(snapshot_reader& r)
+{
+    alia_flow_fragment fragment;
+    std::memset(&fragment, 0, sizeof(fragment));
+    fragment.flags = get_u16(r);
+    fragment.kind = get_u8(r);
+    float payload[4];
+    for (float& value : payload)
+        value = get_f32(r);
+    switch (fragment.kind)
+    {
+        case ALIA_FLOW_FRAGMENT_KIND_CONTENT:
+            fragment.content.size = alia_vec2f_make(payload[0], payload[1]);
+            fragment.content.ascent = payload[2];
+            fragment.content.descent = payload[3];
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_GAP:
+            fragment.gap.gap = payload[0];
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_CONTEXT_PUSH:
+        case ALIA_FLOW_FRAGMENT_KIND_CONTEXT_POP:
+            fragment.context.line_gap = payload[0];
+            fragment.context.minimum_line_height = payload[1];
+            break;
+        case ALIA_FLOW_FRAGMENT_KIND_RUN_PUSH:
+        case ALIA_FLOW_FRAGMENT_KIND_RUN_POP:
+            fragment.run.offsets.left = payload[0];
+            fragment.run.offsets.right = payload[1];
+            fragment.run.offsets.top = payload[2];
+            fragment.run.offsets.bottom = payload[3];
+            break;
+        default:
+            r.ok = false;
+            break;
+    }
+    return fragment;
+}
+
+bool
+read_header(snapshot_reader& r, alia_vec2f* available_space)
+{
+    uint32_t const magic = get_u32(r);
+    uint32_t const version = get_u32(r);
+    float const width = get_f32(r);
+    float const height = get_f32(r);
+    if (!r.ok || magic != ALIA_LAYOUT_SNAPSHOT_MAGIC
+        || version != ALIA_LAYOUT_SNAPSHOT_VERSION)
+    {
+        return false;
+    }
+    if (available_space)
+        *available_space = alia_vec2f_make(width, height);
+    return true;
+}
+
+void
+read_opaque_node(snapshot_reader& r)
+{
+    bool const hashed = get_u8(r) != 0;
+    alia_horizontal_requirements horizontal;
+    horizontal.min_size = get_f32(r);
+    horizontal.growth_factor = get_f32(r);
+    alia_vertical_requirements vertical;
+    vertical.min_size = get_f32(r);
+    vertical.growth_factor = get_f32(r);
+    vertical.ascent = get_f32(r);
+    vertical.descent = get_f32(r);
+    uint32_t const fragment_count = get_u32(r);
+    // Each fragment takes 19 bytes, so this rules out absurd counts before
+    // anything is allocated for them.
+    if (!r.ok || fragment_count > size_t(r.end - r.p) / 19)
+    {
+        r.ok = false;
+        return;
+    }
+
+    snapshot_opaque_node* node = nullptr;
+    if (r.ctx)
+    {
+        auto& emission = r.ctx->layout->emission;
+        node = arena_alloc<snapshot_opaque_node>(emission.arena);
+        alia_layout_emit_node(&emission, &node->base);
+        *node = snapshot_opaque_node{
+            .base
+                = {.vtable = &snapshot_opaque_vtable, .next_sibling = nullptr},
+            .horizontal = horizontal,
+            .vertical = vertical,
+            .fragment_count = fragment_count,
+            .fragments = arena_alloc_array<alia_flow_fragment>(
+                emission.arena, fragment_count)};
+    }
+    for (uint32_t i = 0; i != fragment_count; ++i)
+    {
+        alia_flow_fragment const fragment = get_fragment(r);
+        if (node)
+            node->fragments[i] = fragment;
+    }
+    if (node && hashed)
+    {
+        uint64_t const h = layout_hash_node(
+            &snapshot_opaque_vtable, horizontal, vertical, fragment_count);
+        node->base.content_hash = layout_hash_finish(layout_hash_bytes(
+            h, node->fragments, fragment_count * sizeof(alia_flow_fragment)));
+    }
+}
+
+void
+read_nodes(
+    snapshot_reader& r, alia_layout_grid_handle grid, bool in_grid, int depth);
+
+// Read one node (whose kind has already been read).
+void
+read_node(
+    snapshot_reader& r,
+    uint8_t kind,
+    alia_layout_grid_handle grid,
+    bool in_grid,
+    int depth)
+{
+    alia_context* ctx = r.ctx;
+    switch (kind)
+    {
+        case ALIA_LAYOUT_SNAPSHOT_LEAF: {
+            alia_layout_flags_t const flags = get_u32(r);
+            float const spacing = get_f32(r);
+            alia_layout_content_metrics content;
+            content.size.x = get_f32(r);
+            content.size.y = get_f32(r);
+            content.ascent = get_f32(r);
+            content.descent = get_f32(r);
+            if (ctx)
+                emit_leaf(ctx->layout->emission, content, flags, spacing);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_COLUMN:
+        case ALIA_LAYOUT_SNAPSHOT_ROW: {
+            alia_layout_flags_t const flags = get_u32(r);
+            float const gap = get_f32(r);
+            bool const column = kind == ALIA_LAYOUT_SNAPSHOT_COLUMN;
+            if (ctx)
+            {
+                if (column)
+                    alia_layout_column_begin(ctx, flags, gap);
+                else
+                    alia_layout_row_begin(ctx, flags, gap);
+            }
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+            {
+                if (column)
+                    alia_layout_column_end(ctx);
+                else
+                    alia_layout_row_end(ctx);
+            }
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_FLOW:
+        case ALIA_LAYOUT_SNAPSHOT_BLOCK_FLOW: {
+            alia_layout_flags_t const flags = get_u32(r);
+            float const gap = get_f32(r);
+            float const line_gap = get_f32(r);
+            float const minimum_line_height = get_f32(r);
+            bool const block = kind == ALIA_LAYOUT_SNAPSHOT_BLOCK_FLOW;
+            if (ctx)
+            {
+                if (block)
+                {
+                    alia_layout_block_flow_begin(
+                        ctx, flags, gap, line_gap, minimum_line_height);
+                }
+                else
+                {
+                    alia_layout_flow_begin(
+                        ctx, flags, gap, line_gap, minimum_line_height);
+                }
+            }
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+            {
+                if (block)
+                    alia_layout_block_flow_end(ctx);
+                else
+                    alia_layout_flow_end(ctx);
+            }
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_GRID: {
+            alia_layout_flags_t const flags = get_u32(r);
+            alia_layout_grid_handle const handle
+                = ctx ? alia_layout_grid_begin(ctx, flags) : nullptr;
+            read_nodes(r, handle, true, depth + 1);
+            if (ctx)
+                alia_layout_grid_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_GRID_ROW: {
+            alia_layout_flags_t const flags = get_u32(r);
+            if (!in_grid)
+            {
+                r.ok = false;
+                return;
+            }
+            if (ctx)
+                alia_layout_grid_row_begin(ctx, grid, flags);
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+                alia_layout_grid_row_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_EDGE_OFFSETS: {
+            alia_layout_flags_t const flags = get_u32(r);
+            alia_edge_offsets offsets;
+            offsets.left = get_f32(r);
+            offsets.right = get_f32(r);
+            offsets.top = get_f32(r);
+            offsets.bottom = get_f32(r);
+            if (ctx)
+                alia_layout_edge_offsets_begin(ctx, offsets, flags);
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+                alia_layout_edge_offsets_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_ALIGNMENT_OVERRIDE: {
+            alia_layout_flags_t const flags = get_u32(r);
+            if (ctx)
+                alia_layout_alignment_override_begin(ctx, flags);
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+                alia_layout_alignment_override_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_GROWTH_OVERRIDE: {
+            float const growth = get_f32(r);
+            if (ctx)
+                alia_layout_growth_override_begin(ctx, growth);
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+                alia_layout_growth_override_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_MIN_SIZE: {
+            alia_vec2f min_size;
+            min_size.x = get_f32(r);
+            min_size.y = get_f32(r);
+            if (ctx)
+                alia_layout_min_size_begin(ctx, min_size);
+            read_nodes(r, nullptr, false, depth + 1);
+            if (ctx)
+                alia_layout_min_size_end(ctx);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_FLOW_SPRING: {
+            float const min_width = get_f32(r);
+            if (ctx)
+                alia_layout_flow_spring_emit(ctx, min_width);
+            break;
+        }
+        case ALIA_LAYOUT_SNAPSHOT_OPAQUE:
+            read_opaque_node(r);
+            break;
+        default:
+            r.ok = false;
+            break;
+    }
+}
+
+// Read a list of sibling nodes, up to (and including) its END record.
+void
+read_nodes(
+    snapshot_reader& r, alia_layout_grid_handle grid, bool in_grid, int depth)
+{
+    if (depth > max_snapshot_depth)
+    {
+        r.ok = false;
+        return;
+    }
+    while (r.ok)
+    {
+        uint8_t const kind = get_u8(r);
+        if (!r.ok || kind == ALIA_LAYOUT_SNAPSHOT_END)
+            return;
+        read_node(r, kind, grid, in_grid, depth);
+    }
+}
+
+// Read (and possibly emit) a whole snapshot.
+bool
+read_snapshot(
+    void const* data,
+    size_t size,
+    alia_context* ctx,
+    alia_vec2f* available_space)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    snapshot_reader r{
+        .p = bytes, .end = bytes + (data ? size : 0), .ok = true, .ctx = ctx};
+    if (!read_header(r, available_space))
+        return false;
+    read_nodes(r, nullptr, false, 0);
+    return r.ok && r.p == r.end;
+}
+
+} // namespace
+
+} // namespace alia
+
+using namespace alia;
+
+extern "C" {
+
+void
+alia_layout_system_write_snapshot(
+    alia_layout_system* system,
+    alia_vec2f available_space,
+    alia_layout_snapshot_writer writer)
+{
+    snapshot_writer w;
+    w.output = writer;
+    alia_bump_allocator_init(&w.measurement.scratch, &system->scratch_arena);
+    w.measurement.cache = nullptr;
+    w.measurement.line_breaks = nullptr;
+    w.measurement.parallel = nullptr;
+
+    put_u32(w, ALIA_LAYOUT_SNAPSHOT_MAGIC);
+    put_u32(w, ALIA_LAYOUT_SNAPSHOT_VERSION);
+    put_f32(w, available_space.x);
+    put_f32(w, available_space.y);
+    write_nodes(w, system->root.first_child);
+    flush(w, true);
+}
+
+void
+alia_layout_system_capture_next_resolve(
+    alia_layout_system* system, alia_layout_snapshot_writer writer)
+{
+    system->snapshot_capture = writer;
+}
+
+bool
+alia_layout_snapshot_read(
+    void const* data, size_t size, alia_vec2f* available_space)
+{
+    return read_snapshot(data, size, nullptr, available_space);
+}
+
+bool
+alia_layout_snapshot_emit(alia_context* ctx, void const* data, size_t size)
+{
+    if (!read_snapshot(data, size, nullptr, nullptr))
+        return false;
+    read_snapshot(data, size, ctx, nullptr);
+    return true;
+}
+
+} // extern "C"
@@ -4,50 +4,259 @@
 #include <alia/abi/ui/layout/utilities.h>
 #include <alia/impl/base/arena.hpp>
 
+#include <cstring>
+
 using namespace alia;
 
-extern "C" {
+namespace {
 
-void
-alia_layout_system_init(alia_layout_system* system)
-{
-    initialize_lazy_commit_arena(&system->node_arena);
-    initialize_lazy_commit_arena(&system->placement_arena);
-    initialize_lazy_commit_arena(&system->scratch_arena);
-    system->root = alia_layout_container{
-        .base = {.vtable = nullptr, .next_sibling = nullptr},
-        .flags = 0,
-        .first_child = 0};
-}
+// The retained node arena isn't worth reclaiming until it has accumulated
+// at least this much garbage.
+size_t const min_retained_node_garbage = 256 * 1024;
 
+// Resolve the layout tree, writing its placements to the placement arena.
 void
-alia_layout_system_resolve(
-    alia_layout_system* system, alia_vec2f available_space)
+resolve_placements(alia_layout_system* system, alia_vec2f available_space)
 {
+    system->placement_size = 0;
+
+    // The snapshot is written before profiling starts so that it doesn't
+    // count towards the resolve.
+    if (system->snapshot_capture.write)
+    {
+        alia_layout_snapshot_writer const writer = system->snapshot_capture;
+        system->snapshot_capture = {.write = nullptr, .user_data = nullptr};
+        alia_layout_system_write_snapshot(system, available_space, writer);
+    }
+
+    layout_profile_session profiling(*system);
+
+    layout_placements_begin_resolve(*system->placements);
+    alia_layout_placement_table* placements
+        = &current_placements(*system->placements);
+
     alia_layout_node* root_node = system->root.first_child;
     if (!root_node)
         return;
 
+    if (system->compact)
+    {
+        compact_layout_tree& tree = *system->compact;
+        if (tree.version != system->tree_version)
+        {
+            build_compact_layout_tree(tree, root_node);
+            tree.version = system->tree_version;
+        }
+        alia_bump_allocator scratch, placement;
+        alia_bump_allocator_init(&scratch, &system->scratch_arena);
+        alia_bump_allocator_init(&placement, &system->placement_arena);
+        resolve_compact_layout_tree(
+            tree, scratch, placement, placements, available_space);
+        system->placement_size = placement.offset;
+        layout_placements_end_resolve(*system->placements);
+        profiling.note_scratch(scratch);
+        profiling.note_placement(placement);
+        return;
+    }
+
+    layout_cache_begin_resolve(system->cache);
+
+    alia_layout_fork_context fork_ctx{
+        .pool = system->worker_pool, .worker = 0, .depth = 0};
+    alia_layout_fork_context* parallel
+        = system->worker_pool ? &fork_ctx : nullptr;
+
     alia_vertical_requirements vertical;
     {
+        if (parallel)
+            layout_worker_pool_begin_measurement(*system->worker_pool);
         alia_measurement_context ctx;
         alia_bump_allocator_init(&ctx.scratch, &system->scratch_arena);
+        ctx.cache = &system->cache;
+        ctx.line_breaks = &system->cache;
+        ctx.parallel = parallel;
         alia_measure_horizontal(&ctx, root_node);
+        profiling.end_phase(ALIA_LAYOUT_PROFILE_HORIZONTAL);
         alia_arena_reset(&ctx.scratch);
         vertical = alia_measure_vertical(
             &ctx, ALIA_MAIN_AXIS_X, root_node, available_space.x);
+        if (parallel)
+            layout_worker_pool_end_measurement(*system->worker_pool);
+        profiling.end_phase(ALIA_LAYOUT_PROFILE_VERTICAL);
+        profiling.note_scratch(ctx.scratch);
     }
     {
         alia_placement_context ctx;
         alia_bump_allocator_init(&ctx.scratch, &system->scratch_arena);
         alia_bump_allocator_init(&ctx.arena, &system->placement_arena);
+        ctx.cache = &system->cache;
+        ctx.line_breaks = &system->cache;
+        ctx.parallel = parallel;
+        ctx.placements = placements;
         alia_assign_boxes(
             &ctx,
             ALIA_MAIN_AXIS_X,
             root_node,
             {.min = {0, 0}, .size = available_space},
             vertical.ascent);
+        system->placement_size = ctx.arena.offset;
+        layout_placements_end_resolve(*system->placements);
+        profiling.end_phase(ALIA_LAYOUT_PROFILE_ASSIGNMENT);
+        profiling.note_scratch(ctx.scratch);
+        profiling.note_placement(ctx.arena);
+    }
+
+    layout_cache_end_resolve(system->cache);
+}
+
+// Hash the bytes that the last resolve wrote to the placement arena.
+uint64_t
+hash_placements(alia_layout_system const& system)
+{
+    auto const* bytes
+        = static_cast<uint8_t const*>(system.placement_arena.base);
+    size_t const size = system.placement_size;
+    uint64_t h = layout_hash_value(layout_hash_seed, size);
+    size_t i = 0;
+    for (; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t))
+    {
+        uint32_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        h = layout_hash_word(h, word);
+    }
+    return layout_hash_bytes(h, bytes + i, size - i);
+}
+
+// Advance the placement epoch if the placements that were just resolved
+// might not line up with the ones from the previous resolve.
+// Components (and the hit index) record their placements against the epoch,
+// so bumping it needlessly forces a full pass to re-establish them.
+void
+note_resolved_placements(
+    alia_layout_system& system, alia_vec2f available_space)
+{
+    uint64_t const hash = hash_placements(system);
+    if (system.placement_tree_version != system.tree_version
+        || !alia_vec2f_equal(system.placement_space, available_space)
+        || system.placement_hash != hash)
+    {
+        ++system.placement_epoch;
+        system.placement_tree_version = system.tree_version;
+        system.placement_space = available_space;
+        system.placement_hash = hash;
     }
 }
 
+} // namespace
+
+namespace alia {
+
+void
+layout_system_collect_retained_nodes(alia_layout_system& system)
+{
+    // Reclaiming the arena forces every skippable component to re-emit its
+    // nodes, so only do it once at least half of the arena is garbage.
+    if (system.retained_node_garbage < min_retained_node_garbage
+        || system.retained_node_garbage * 2 < system.retained_node_offset)
+    {
+        return;
+    }
+    system.retained_node_offset = 0;
+    system.retained_node_garbage = 0;
+    ++system.retained_node_epoch;
+}
+
+void
+layout_system_end_refresh(alia_layout_system& system)
+{
+    ++system.tree_version;
+}
+
+} // namespace alia
+
+extern "C" {
+
+void
+alia_layout_system_init(alia_layout_system* system)
+{
+    initialize_lazy_commit_arena(&system->node_arena);
+    initialize_lazy_commit_arena(&system->placement_arena);
+    initialize_lazy_commit_arena(&system->scratch_arena);
+    initialize_lazy_commit_arena(&system->retained_node_arena);
+    system->retained_node_offset = 0;
+    system->retained_node_garbage = 0;
+    system->retained_node_epoch = 0;
+    system->placement_epoch = 1;
+    system->placement_size = 0;
+    system->placement_tree_version = 0;
+    system->placement_space = alia_vec2f_make(0.f, 0.f);
+    system->placement_hash = 0;
+    layout_cache_init(system->cache);
+    system->placements = new layout_placement_tables{.current = 0};
+    system->worker_pool = nullptr;
+    system->tree_version = 1;
+    system->compact = nullptr;
+    system->snapshot_capture = {.write = nullptr, .user_data = nullptr};
+#ifdef ALIA_LAYOUT_PROFILING
+    system->profiler = new layout_profiler;
+    reset_layout_profile(system->profiler->profile);
+#endif
+    system->root = alia_layout_container{
+        .base = {.vtable = nullptr, .next_sibling = nullptr},
+        .flags = 0,
+        .first_child = 0};
+}
+
+void
+alia_layout_system_destroy(alia_layout_system* system)
+{
+    alia_arena_destroy(&system->node_arena);
+    alia_arena_destroy(&system->placement_arena);
+    alia_arena_destroy(&system->scratch_arena);
+    alia_arena_destroy(&system->retained_node_arena);
+    layout_cache_destroy(system->cache);
+    delete system->placements;
+    destroy_layout_worker_pool(system->worker_pool);
+    delete system->compact;
+#ifdef ALIA_LAYOUT_PROFILING
+    delete system->profiler;
+#endif
+}
+
+void
+alia_layout_system_set_parallelism(
+    alia_layout_system* system, alia_layout_parallelism parallelism)
+{
+    destroy_layout_worker_pool(system->worker_pool);
+    system->worker_pool = nullptr;
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    if (parallelism.thread_count > 1)
+        system->worker_pool = create_layout_worker_pool(parallelism);
+#endif
+}
+
+void
+alia_layout_system_set_storage(
+    alia_layout_system* system, alia_layout_storage storage)
+{
+    if (storage == ALIA_LAYOUT_STORAGE_COMPACT)
+    {
+        if (!system->compact)
+            system->compact = new compact_layout_tree;
+    }
+    else
+    {
+        delete system->compact;
+        system->compact = nullptr;
+    }
+}
+
+void
+alia_layout_system_resolve(
+    alia_layout_system* system, alia_vec2f available_space)
+{
+    resolve_placements(system, available_space);
+    note_resolved_placements(*system, available_space);
+}
+
 } // extern "C"
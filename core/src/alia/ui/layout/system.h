@@ -1,7 +1,13 @@
 #pragma once
 
+#include <alia/abi/ui/layout/snapshot.h>
 #include <alia/abi/ui/layout/utilities/emission.h>
 #include <alia/base/arena.h>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/layout/compact.h>
+#include <alia/ui/layout/parallel.h>
+#include <alia/ui/layout/placements.h>
+#include <alia/ui/layout/profile.h>
 
 extern "C" {
 
@@ -15,6 +21,71 @@ struct alia_layout_system
     alia_layout_container root;
     // used to store the placement information for the nodes in the layout tree
     alia_arena placement_arena;
+
+    // used to store the nodes emitted by skippable components (see
+    // alia/abi/kernel/components.h) - Unlike `node_arena`, this persists
+    // across refreshes.
+    alia_arena retained_node_arena;
+    // the allocation offset within `retained_node_arena`
+    size_t retained_node_offset;
+    // an estimate of the bytes in `retained_node_arena` that are no longer
+    // referenced by any component
+    size_t retained_node_garbage;
+    // incremented whenever `retained_node_arena` is reset (which invalidates
+    // all node lists cached in it)
+    uint32_t retained_node_epoch;
+
+    // incremented whenever a resolve writes placements that might not line
+    // up with the previous ones (i.e., when the layout tree, the available
+    // space or the placements themselves change) - This starts at 1 so that
+    // 0 is never current.
+    uint32_t placement_epoch;
+    // the number of bytes of `placement_arena` written by the last resolve
+    size_t placement_size;
+    // the tree version, available space and placement hash as of the last
+    // time `placement_epoch` was advanced
+    uint32_t placement_tree_version;
+    alia_vec2f placement_space;
+    uint64_t placement_hash;
+
+    // the results of laying out subtrees in previous resolves
+    alia_layout_cache cache;
+
+    // the tagged nodes of the last two resolves
+    alia::layout_placement_tables* placements;
+
+    // the threads for parallel resolves (or null if resolves are serial)
+    alia::layout_worker_pool* worker_pool;
+
+    // incremented at the end of each refresh (since that's when the layout
+    // tree changes)
+    uint32_t tree_version;
+    // the compact form of the layout tree (or null unless the system is using
+    // compact storage)
+    alia::compact_layout_tree* compact;
+
+    // where to write a snapshot of the next resolve (or nulls if none has
+    // been requested)
+    alia_layout_snapshot_writer snapshot_capture;
+
+#ifdef ALIA_LAYOUT_PROFILING
+    // records the calls made by resolves on this thread
+    alia::layout_profiler* profiler;
+#endif
 };
 
 } // extern "C"
+
+namespace alia {
+
+// Reclaim the retained node arena if enough of it is garbage.
+// This must only be called at the start of a refresh, since it invalidates
+// nodes that the current layout tree may reference.
+void
+layout_system_collect_retained_nodes(alia_layout_system& system);
+
+// Note that a refresh has finished emitting a new layout tree.
+void
+layout_system_end_refresh(alia_layout_system& system);
+
+} // namespace alia
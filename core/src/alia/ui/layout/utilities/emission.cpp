@@ -3,6 +3,7 @@
 #include <alia/impl/base/arena.hpp>
 #include <alia/impl/base/stack.hpp>
 #include <alia/impl/events.hpp>
+#include <alia/ui/layout/cache.h>
 
 using namespace alia;
 
@@ -15,6 +16,8 @@ alia_layout_container_activate(
     auto& emission = ctx->layout->emission;
     *emission.next_ptr = &container->base;
     emission.next_ptr = &container->first_child;
+    // (This holds the starting count until the container is deactivated.)
+    container->subtree_size = emission.node_count++;
 }
 
 void
@@ -24,6 +27,13 @@ alia_layout_container_deactivate(
     auto& emission = ctx->layout->emission;
     *emission.next_ptr = 0;
     emission.next_ptr = &container->base.next_sibling;
+    container->subtree_size = emission.node_count - container->subtree_size;
+    // A container that hashes its own parameters also covers its children.
+    if (container->base.content_hash != 0)
+    {
+        container->base.content_hash = layout_hash_children(
+            container->base.content_hash, container->first_child);
+    }
 }
 
 struct alia_layout_container_scope
@@ -49,6 +59,7 @@ alia_layout_container_simple_begin(
             .flags = flags,
             .first_child = 0,
             .gap = gap};
+        container->base.content_hash = layout_hash_node(vtable, flags, gap);
         alia_layout_container_activate(ctx, container);
     }
 }
@@ -117,7 +117,9 @@ alia_layout_node_vtable collapsible_vtable
        collapsible_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "collapsible"};
 
 struct collapsible_scope
 {
@@ -65,6 +65,10 @@ struct scroll_view_state
     alia_vec2f content_size = {0.f, 0.f};
     alia_vec2f view_size = {0.f, 0.f};
     bool scrollbars_on[2] = {false, false};
+    // the viewport box as of the last resolve
+    alia_box viewport_box = {};
+    // the viewport as published to the content (see `alia_layout_context`)
+    alia_layout_viewport viewport = {};
 };
 
 static inline float
@@ -604,6 +608,7 @@ scroll_view_assign_boxes(
 
     alia_box viewport = box;
     viewport.size = view_size;
+    d.viewport_box = viewport;
 
     alia_vec2f content_box_size
         = {(std::max) (view_size.x, d.content_size.x),
@@ -640,7 +645,9 @@ alia_layout_node_vtable scroll_view_vtable
        scroll_view_assign_boxes,
        alia_default_count_flow_emissions,
        alia_default_emit_flow_fragments,
-       alia_default_read_fragment_placements};
+       alia_default_read_fragment_placements,
+       false,
+       "scroll_view"};
 
 struct scroll_view_scope
 {
@@ -648,8 +655,23 @@ struct scroll_view_scope
     scroll_view_state* data = nullptr;
     scroll_view_placement placement = {};
     alia_element_id id = ALIA_ELEMENT_ID_NONE;
+    // the viewport that was published before this one
+    alia_layout_viewport* outer_viewport = nullptr;
 };
 
+static void
+publish_viewport(
+    alia_context* ctx,
+    scroll_view_scope& scope,
+    scroll_view_state& data,
+    alia_box const& box)
+{
+    data.viewport = alia_layout_viewport{
+        .box = box, .scroll = {data.bar[0].smoothed, data.bar[1].smoothed}};
+    scope.outer_viewport = ctx->layout->viewport;
+    ctx->layout->viewport = &data.viewport;
+}
+
 } // namespace alia
 
 using namespace alia;
@@ -732,6 +754,7 @@ alia_ui_scroll_view_begin(
             .data = data};
         scope.node = node;
         alia_layout_container_activate(ctx, &node->base);
+        publish_viewport(ctx, scope, *data, data->viewport_box);
         return;
     }
 
@@ -795,6 +818,8 @@ alia_ui_scroll_view_begin(
         do_scrollbar_pass(ctx, scope.id, *data, scope.placement, axis);
     }
 
+    publish_viewport(ctx, scope, *data, scope.placement.viewport_box);
+
     alia_geometry_push_clip_box(ctx, scope.placement.viewport_box);
     alia_geometry_push_translation(
         ctx, {-data->bar[0].smoothed, -data->bar[1].smoothed});
@@ -811,8 +836,21 @@ alia_ui_scroll_view_end(alia_context* ctx)
         auto scope = stack_pop<scroll_view_scope>(ctx);
         if (!scope.data)
             return;
+        ctx->layout->viewport = scope.outer_viewport;
         if (scope.node)
             alia_layout_container_deactivate(ctx, &scope.node->base);
+        // Apply any scrolling that the content requested. (This is clamped
+        // on the next non-refresh pass, once the layout is known.)
+        auto& data = *scope.data;
+        for (unsigned axis = 0; axis != 2; ++axis)
+        {
+            float const scroll = axis_of(data.viewport.scroll, axis);
+            if (scroll != data.bar[axis].smoothed)
+            {
+                data.bar[axis].logical = (std::max) (0.f, scroll);
+                data.bar[axis].smoothed = data.bar[axis].logical;
+            }
+        }
         return;
     }
 
@@ -822,6 +860,7 @@ alia_ui_scroll_view_end(alia_context* ctx)
     auto scope = stack_pop<scroll_view_scope>(ctx);
     if (!scope.data)
         return;
+    ctx->layout->viewport = scope.outer_viewport;
 
     if (get_event_type(*ctx) == ALIA_EVENT_MAKE_WIDGET_VISIBLE)
     {
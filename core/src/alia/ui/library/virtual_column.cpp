@@ -0,0 +1,490 @@
+#include <alia/abi/ui/library.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include <alia/abi/kernel/components.h>
+#include <alia/abi/kernel/substrate.h>
+#include <alia/abi/prelude.h>
+#include <alia/abi/ui/context.h>
+#include <alia/abi/ui/layout/utilities.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/base/stack.hpp>
+#include <alia/impl/events.hpp>
+#include <alia/impl/ui/layout.hpp>
+
+using namespace alia::operators;
+
+namespace alia {
+
+// The persistent state of a virtual column, which lives in the substrate.
+//
+// Item heights are indexed with a Fenwick tree (in doubles, since the total
+// height of a long list exceeds the range over which floats are exact), so
+// prefix sums, point updates and searches by offset are all O(log n). The
+// tree can also grow in place by O(log n) per item, so lists that are
+// appended to (like logs) don't need to rebuild it.
+struct virtual_column_state
+{
+    uint32_t item_count;
+    uint32_t capacity;
+    float estimated_item_height;
+    // the measured height of each item (or a negative value if the item
+    // hasn't been measured yet)
+    float* heights;
+    // the Fenwick tree over the effective item heights (1-based, so this has
+    // `capacity + 1` entries)
+    double* height_index;
+    // the widest item that has been measured so far
+    float max_item_width;
+    // the items emitted by the last refresh
+    alia_virtual_column_range range;
+    // the item that's being scrolled into view - This persists until the
+    // item's position is final (i.e., until it and the items above it in the
+    // view have all been measured).
+    uint32_t pending_reveal = ALIA_VIRTUAL_COLUMN_NO_ITEM;
+    // the column's content box as of the last resolve
+    alia_box box;
+};
+
+struct virtual_column_layout_node
+{
+    alia_layout_container base;
+    virtual_column_state* state;
+    // the items that were emitted as children of the node
+    alia_virtual_column_range range;
+};
+
+struct virtual_column_scratch
+{
+    uint32_t child_count;
+    float max_width;
+    float total_height;
+};
+
+static float
+effective_height(virtual_column_state const& state, uint32_t item)
+{
+    float const height = state.heights[item];
+    return height >= 0.f ? height : state.estimated_item_height;
+}
+
+// Get the total height of the items before `item`.
+static double
+height_prefix(virtual_column_state const& state, uint32_t item)
+{
+    double sum = 0;
+    for (uint32_t i = item; i != 0; i &= i - 1)
+        sum += state.height_index[i];
+    return sum;
+}
+
+static double
+total_height(virtual_column_state const& state)
+{
+    return height_prefix(state, state.item_count);
+}
+
+static void
+adjust_height(virtual_column_state& state, uint32_t item, double delta)
+{
+    for (uint32_t i = item + 1; i <= state.item_count; i += i & (0u - i))
+        state.height_index[i] += delta;
+}
+
+// Find the item that contains `offset` (measured from the top of the
+// column). Offsets past the end map to `item_count`.
+static uint32_t
+find_item(virtual_column_state const& state, double offset)
+{
+    uint32_t item = 0;
+    uint32_t step = 1;
+    while (step <= state.item_count / 2)
+        step <<= 1;
+    for (; step != 0; step >>= 1)
+    {
+        uint32_t const next = item + step;
+        if (next <= state.item_count && state.height_index[next] <= offset)
+        {
+            item = next;
+            offset -= state.height_index[next];
+        }
+    }
+    return item;
+}
+
+static void
+rebuild_height_index(virtual_column_state& state)
+{
+    state.height_index[0] = 0;
+    for (uint32_t i = 1; i <= state.item_count; ++i)
+        state.height_index[i] = effective_height(state, i - 1);
+    for (uint32_t i = 1; i <= state.item_count; ++i)
+    {
+        uint32_t const parent = i + (i & (0u - i));
+        if (parent <= state.item_count)
+            state.height_index[parent] += state.height_index[i];
+    }
+}
+
+static void
+resize_items(virtual_column_state& state, uint32_t item_count)
+{
+    if (item_count > state.capacity)
+    {
+        uint32_t capacity = (std::max) (state.capacity * 2, 64u);
+        while (capacity < item_count)
+            capacity *= 2;
+        state.heights = static_cast<float*>(
+            std::realloc(state.heights, capacity * sizeof(float)));
+        state.height_index = static_cast<double*>(std::realloc(
+            state.height_index, (capacity + 1) * sizeof(double)));
+        ALIA_ASSERT(state.heights && state.height_index);
+        state.capacity = capacity;
+    }
+    // Entries of the tree only cover items at or before their own position,
+    // so shrinking just drops the tail, and each new item can be added on
+    // top of the existing entries.
+    for (uint32_t i = state.item_count; i < item_count; ++i)
+    {
+        state.heights[i] = -1.f;
+        uint32_t const position = i + 1;
+        state.height_index[position]
+            = state.estimated_item_height + height_prefix(state, i)
+            - height_prefix(state, position - (position & (0u - position)));
+    }
+    state.item_count = item_count;
+}
+
+static void
+release_items(virtual_column_state& state)
+{
+    std::free(state.heights);
+    std::free(state.height_index);
+    state.heights = nullptr;
+    state.height_index = nullptr;
+    state.item_count = 0;
+    state.capacity = 0;
+    state.range = {0, 0};
+}
+
+static void
+virtual_column_state_cleanup(
+    alia_substrate_system*, void* payload, alia_substrate_cleanup_mode)
+{
+    release_items(*reinterpret_cast<virtual_column_state*>(payload));
+}
+
+// Get the part of the column that's visible within `viewport`, as offsets
+// from the top of the column.
+static void
+get_visible_span(
+    virtual_column_state const& state,
+    alia_layout_viewport const& viewport,
+    double& top,
+    double& bottom)
+{
+    top = double(viewport.box.min.y) + viewport.scroll.y - state.box.min.y;
+    bottom = top + viewport.box.size.y;
+}
+
+// Scroll `viewport` so that `item` is visible.
+static void
+reveal_item(
+    virtual_column_state const& state,
+    alia_layout_viewport& viewport,
+    uint32_t item)
+{
+    double const item_top = height_prefix(state, item);
+    double const item_bottom = item_top + effective_height(state, item);
+    double top, bottom;
+    get_visible_span(state, viewport, top, bottom);
+    double correction = 0;
+    if (item_top < top || item_bottom - item_top > bottom - top)
+        correction = item_top - top;
+    else if (item_bottom > bottom)
+        correction = item_bottom - bottom;
+    viewport.scroll.y
+        = float((std::max) (0., double(viewport.scroll.y) + correction));
+}
+
+// Check if the position of `target` within the view is final, which is the
+// case once it and the other emitted items above it have all been measured.
+static bool
+target_is_settled(virtual_column_state const& state, uint32_t target)
+{
+    if (target < state.range.begin || target >= state.range.end)
+        return false;
+    for (uint32_t i = state.range.begin; i <= target; ++i)
+    {
+        if (state.heights[i] < 0)
+            return false;
+    }
+    return true;
+}
+
+static alia_virtual_column_range
+select_items(
+    virtual_column_state const& state,
+    alia_layout_viewport const* viewport,
+    float overscan)
+{
+    if (!viewport)
+        return {0, state.item_count};
+    if (state.item_count == 0)
+        return {0, 0};
+    double top, bottom;
+    get_visible_span(state, *viewport, top, bottom);
+    uint32_t const begin
+        = (std::min) (find_item(state, top - overscan), state.item_count - 1);
+    uint32_t const end = (std::min) (
+        find_item(state, bottom + overscan) + 1, state.item_count);
+    return {begin, (std::max) (begin + 1, end)};
+}
+
+// Check that the emitted items cover everything that's currently visible.
+static bool
+visible_span_is_covered(
+    virtual_column_state const& state, alia_layout_viewport const& viewport)
+{
+    double top, bottom;
+    get_visible_span(state, viewport, top, bottom);
+    top = (std::max) (top, 0.);
+    bottom = (std::min) (bottom, total_height(state));
+    if (bottom <= top)
+        return true;
+    return height_prefix(state, state.range.begin) <= top
+        && height_prefix(state, state.range.end) >= bottom;
+}
+
+alia_horizontal_requirements
+virtual_column_measure_horizontal(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    auto& column = *reinterpret_cast<virtual_column_layout_node*>(node);
+    auto& state = *column.state;
+    auto& scratch = claim_scratch<virtual_column_scratch>(ctx->scratch);
+
+    for (alia_layout_node* child = column.base.first_child; child != nullptr;
+         child = child->next_sibling)
+    {
+        ++scratch.child_count;
+    }
+    ALIA_ASSERT(scratch.child_count == column.range.end - column.range.begin);
+    arena_alloc_array<alia_vertical_requirements>(
+        ctx->scratch, scratch.child_count);
+
+    for (alia_layout_node* child = column.base.first_child; child != nullptr;
+         child = child->next_sibling)
+    {
+        auto const child_x = alia_measure_horizontal(ctx, child);
+        state.max_item_width
+            = (std::max) (state.max_item_width, child_x.min_size);
+    }
+    scratch.max_width = state.max_item_width;
+    return alia_horizontal_requirements{
+        .min_size = scratch.max_width,
+        .growth_factor = alia_resolve_growth_factor(column.base.flags)};
+}
+
+alia_vertical_requirements
+virtual_column_measure_vertical(
+    alia_measurement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    float assigned_width)
+{
+    auto& column = *reinterpret_cast<virtual_column_layout_node*>(node);
+    auto& state = *column.state;
+    auto& scratch = use_scratch<virtual_column_scratch>(ctx->scratch);
+    alia_vertical_requirements* y_requirements
+        = arena_alloc_array<alia_vertical_requirements>(
+            ctx->scratch, scratch.child_count);
+    auto const assignment = alia_resolve_container_x(
+        alia_fold_in_cross_axis_flags(column.base.flags, main_axis),
+        assigned_width,
+        scratch.max_width);
+    uint32_t item = column.range.begin;
+    for (alia_layout_node* child = column.base.first_child; child != nullptr;
+         child = child->next_sibling, ++item)
+    {
+        auto const child_y = alia_measure_vertical(
+            ctx, ALIA_MAIN_AXIS_Y, child, assignment.size);
+        *y_requirements++ = child_y;
+        // Record the item's actual height.
+        float const previous = effective_height(state, item);
+        state.heights[item] = child_y.min_size;
+        if (child_y.min_size != previous)
+            adjust_height(state, item, double(child_y.min_size) - previous);
+    }
+    scratch.total_height = float(total_height(state));
+    return alia_mask_reported_vertical_requirements(
+        column.base.flags,
+        main_axis,
+        alia_vertical_requirements{
+            .min_size = scratch.total_height,
+            .growth_factor = alia_resolve_growth_factor(column.base.flags),
+            .ascent = 0,
+            .descent = scratch.total_height});
+}
+
+void
+virtual_column_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index main_axis,
+    alia_layout_node* node,
+    alia_box box,
+    float baseline)
+{
+    auto& column = *reinterpret_cast<virtual_column_layout_node*>(node);
+    auto& state = *column.state;
+    auto& scratch = use_scratch<virtual_column_scratch>(ctx->scratch);
+    alia_vertical_requirements* y_requirements
+        = arena_alloc_array<alia_vertical_requirements>(
+            ctx->scratch, scratch.child_count);
+    auto const assignment = alia_resolve_container_box(
+        alia_fold_in_cross_axis_flags(column.base.flags, main_axis),
+        box.size,
+        baseline,
+        {scratch.max_width, scratch.total_height},
+        0);
+    state.box = {.min = box.min + assignment.min, .size = assignment.size};
+
+    // Only the first child's position needs the index. The rest follow from
+    // the heights that were just measured.
+    double y
+        = double(state.box.min.y) + height_prefix(state, column.range.begin);
+    for (alia_layout_node* child = column.base.first_child; child != nullptr;
+         child = child->next_sibling)
+    {
+        auto const child_y = *y_requirements++;
+        alia_assign_boxes(
+            ctx,
+            ALIA_MAIN_AXIS_Y,
+            child,
+            {.min = {state.box.min.x, float(y)},
+             .size = {state.box.size.x, child_y.min_size}},
+            alia_resolve_baseline(
+                column.base.flags,
+                child_y.min_size,
+                child_y.ascent,
+                child_y.descent));
+        y += child_y.min_size;
+    }
+}
+
+alia_layout_node_vtable virtual_column_vtable
+    = {virtual_column_measure_horizontal,
+       virtual_column_measure_vertical,
+       virtual_column_assign_boxes,
+       alia_default_count_flow_emissions,
+       alia_default_emit_flow_fragments,
+       alia_default_read_fragment_placements,
+       false,
+       "virtual_column"};
+
+struct virtual_column_scope
+{
+    virtual_column_layout_node* node = nullptr;
+};
+
+} // namespace alia
+
+using namespace alia;
+
+ALIA_EXTERN_C_BEGIN
+
+alia_virtual_column_range
+alia_ui_virtual_column_begin(
+    alia_context* ctx,
+    alia_layout_flags_t layout_flags,
+    uint32_t item_count,
+    float estimated_item_height,
+    float overscan,
+    uint32_t* reveal)
+{
+    auto& scope = stack_push<virtual_column_scope>(ctx);
+
+    alia_substrate_usage_result const result = alia_substrate_use_object(
+        ctx,
+        sizeof(virtual_column_state),
+        alignof(virtual_column_state),
+        virtual_column_state_cleanup);
+    auto* state = reinterpret_cast<virtual_column_state*>(result.ptr);
+    if (result.mode != ALIA_SUBSTRATE_BLOCK_TRAVERSAL_NORMAL)
+        *state = virtual_column_state{};
+
+    alia_layout_viewport* viewport = ctx->layout->viewport;
+
+    if (!is_refresh_event(*ctx))
+    {
+        // If the view has scrolled past the items that were emitted (or an
+        // item is still being revealed), the next refresh needs to emit
+        // different ones.
+        if (viewport
+            && (state->pending_reveal != ALIA_VIRTUAL_COLUMN_NO_ITEM
+                || !visible_span_is_covered(*state, *viewport)))
+            alia_component_mark_dirty(ctx);
+        return state->range;
+    }
+
+    if (estimated_item_height != state->estimated_item_height)
+    {
+        state->estimated_item_height = estimated_item_height;
+        resize_items(*state, item_count);
+        rebuild_height_index(*state);
+    }
+    else
+    {
+        resize_items(*state, item_count);
+    }
+
+    if (reveal && *reveal != ALIA_VIRTUAL_COLUMN_NO_ITEM)
+    {
+        state->pending_reveal = *reveal;
+        *reveal = ALIA_VIRTUAL_COLUMN_NO_ITEM;
+    }
+    uint32_t const target = state->pending_reveal;
+    if (target != ALIA_VIRTUAL_COLUMN_NO_ITEM
+        && (!viewport || target >= item_count))
+    {
+        state->pending_reveal = ALIA_VIRTUAL_COLUMN_NO_ITEM;
+    }
+
+    if (state->pending_reveal != ALIA_VIRTUAL_COLUMN_NO_ITEM)
+    {
+        reveal_item(*state, *viewport, target);
+        state->range = select_items(*state, viewport, overscan);
+        if (target_is_settled(*state, target))
+            state->pending_reveal = ALIA_VIRTUAL_COLUMN_NO_ITEM;
+    }
+    else
+    {
+        state->range = select_items(*state, viewport, overscan);
+    }
+
+    auto* node = arena_alloc<virtual_column_layout_node>(
+        ctx->layout->emission.arena);
+    *node = virtual_column_layout_node{
+        .base
+        = {.base
+           = {.vtable = &virtual_column_vtable, .next_sibling = nullptr},
+           .flags = layout_flags,
+           .first_child = nullptr},
+        .state = state,
+        .range = state->range};
+    scope.node = node;
+    alia_layout_container_activate(ctx, &node->base);
+    return state->range;
+}
+
+void
+alia_ui_virtual_column_end(alia_context* ctx)
+{
+    auto scope = stack_pop<virtual_column_scope>(ctx);
+    if (scope.node)
+        alia_layout_container_deactivate(ctx, &scope.node->base);
+}
+
+ALIA_EXTERN_C_END
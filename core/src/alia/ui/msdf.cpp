@@ -2,69 +2,447 @@
 
 #include <alia/abi/base/geometry/vec2.h>
 #include <alia/abi/prelude.h>
+#include <alia/abi/ui/drawing/primitives.h>
+#include <alia/abi/ui/system/renderer.h>
+#include <alia/abi/ui/system/work.h>
 #include <alia/abi/ui/text.h>
+#include <alia/ui/msdf.h>
 #include <alia/ui/system/object.h>
+#include <alia/ui/text/skyline.h>
 
-#include <cassert>
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
 #include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 namespace {
 
-struct kerning_pair_index
+// everything that measuring and drawing need to know about a glyph, packed
+// into a single cache line
+struct alignas(64) msdf_glyph_entry
 {
-    uint32_t left;
-    uint32_t right;
+    float advance;
+    float plane_left, plane_bottom, plane_right, plane_top;
+    float uv_rect[4];
+    uint32_t unicode;
+    // the glyph's index within the font's `glyph_metrics` (or
+    // `msdf_no_glyph_index` if it's a generated glyph that isn't currently in
+    // the atlas)
+    uint32_t index;
+    // the glyph's kerning classes, for when it's on the left and the right of
+    // a pair - Class 0 is for glyphs that aren't kerned on that side.
+    uint16_t left_class;
+    uint16_t right_class;
+    // the dynamic atlas page that holds the glyph, plus one (or 0 for baked
+    // glyphs and glyphs that aren't in the atlas)
+    uint16_t page;
+    // Is this glyph in the font? (Missing glyphs are empty.)
+    bool present;
+};
+static_assert(sizeof(msdf_glyph_entry) == 64);
 
-    bool
-    operator==(kerning_pair_index const& other) const
-    {
-        return left == other.left && right == other.right;
-    }
+uint32_t const msdf_no_glyph_index = 0xffffffff;
+
+// Codepoints below this have their glyphs in a dense array.
+uint32_t const msdf_dense_glyph_count = 256;
+
+struct msdf_font_data
+{
+    // the font's index within its engine
+    size_t font_index;
+    alia_msdf_font_metrics metrics;
+    // the glyphs for codepoints below `msdf_dense_glyph_count`, indexed by
+    // codepoint
+    std::vector<msdf_glyph_entry> dense_glyphs;
+    // the glyphs for all other codepoints, sorted by codepoint
+    std::vector<msdf_glyph_entry> sparse_glyphs;
+    // glyphs generated at runtime (if dynamic glyphs are enabled), including
+    // entries for codepoints that the font turned out not to have - Entries
+    // are never removed (and the map is node-based), so references to them
+    // stay valid.
+    std::unordered_map<uint32_t, msdf_glyph_entry> dynamic_glyphs;
+    // the glyph table that the font's glyph runs refer to - With dynamic
+    // glyphs, this has room reserved for them up front, so it never moves.
+    std::vector<alia_msdf_glyph_metrics> glyph_metrics;
+    // slots in `glyph_metrics` that generated glyphs have vacated
+    std::vector<uint32_t> free_glyph_slots;
+    // the kerning adjustments between each pair of classes, indexed by
+    // `left_class * right_class_count + right_class` - Glyphs whose kerning
+    // pairs are identical share a class, so this stays small, and a lookup is
+    // always just one load.
+    std::vector<float> kerning;
+    uint32_t right_class_count;
 };
 
-struct kerning_pair_index_hash
+// identifies a glyph within an engine
+struct msdf_glyph_key
 {
-    std::size_t
-    operator()(kerning_pair_index const& pair) const
-    {
-        return (pair.left << 4) ^ pair.right;
-    }
+    uint32_t font;
+    uint32_t unicode;
 };
 
-using kerning_lookup
-    = std::unordered_map<kerning_pair_index, float, kerning_pair_index_hash>;
+struct msdf_atlas_page
+{
+    alia::skyline_packer packer;
+    // the glyphs that are on the page
+    std::vector<msdf_glyph_key> glyphs;
+    // the last draw pass in which any of the page's glyphs was used
+    uint64_t last_used = 0;
+};
 
-using glyph_lookup = std::unordered_map<int, alia_msdf_glyph>;
+// an atlas update that hasn't been handed to the renderer yet
+struct msdf_pending_update
+{
+    int x, y, width, height;
+    // the offset of the pixels within `msdf_dynamic_atlas::pending_pixels`
+    size_t offset;
+};
 
-struct cached_glyph_data
+// the state of an engine's dynamic glyph pages
+struct msdf_dynamic_atlas
 {
-    float uv_rect[4];
+    alia_msdf_dynamic_glyph_config config;
+    // the size of the whole atlas texture
+    int width;
+    int height;
+    // the first row of the pages (i.e., the height of the baked atlas)
+    int page_top;
+    std::vector<msdf_atlas_page> pages;
+    // the number of the current draw pass
+    uint64_t pass = 1;
+    // Was a glyph left out of the atlas for lack of room? If so, a page is
+    // evicted at the start of the next pass. (Until then, no more glyphs are
+    // placed.)
+    bool starved = false;
+    std::vector<msdf_pending_update> pending_updates;
+    std::vector<uint8_t> pending_pixels;
 };
 
-struct msdf_font_data
+struct msdf_background_pool;
+
+} // namespace
+
+struct alia_msdf_text_engine
 {
-    alia_msdf_font_metrics metrics;
-    glyph_lookup glyphs;
-    std::unordered_map<int, cached_glyph_data> glyph_cache;
-    kerning_lookup kerning;
+    // abstract text-engine base - Must be first so an `alia_text_engine*`
+    // dispatched by the core can be cast back to `alia_msdf_text_engine*`.
+    alia_text_engine base;
+    alia_msdf_atlas_description atlas;
+    std::vector<msdf_font_data> fonts;
+    // the dynamic glyph pages, if enabled
+    std::unique_ptr<msdf_dynamic_atlas> dynamic;
+    // the background preparation workers, if enabled
+    msdf_background_pool* background = nullptr;
 };
 
-static inline alia_msdf_glyph const&
-require_glyph(msdf_font_data const& font, uint32_t unicode)
+namespace {
+
+msdf_glyph_entry const empty_glyph = {};
+
+// Find the entry for `unicode` in `font`'s baked tables (or return null if
+// there's no slot for it). Note that dense slots exist whether or not the
+// font has the glyph.
+template<class Font>
+static inline auto*
+find_glyph_slot(Font& font, uint32_t unicode)
+{
+    if (unicode < msdf_dense_glyph_count)
+        return &font.dense_glyphs[unicode];
+    auto& sparse = font.sparse_glyphs;
+    auto it = std::lower_bound(
+        sparse.begin(),
+        sparse.end(),
+        unicode,
+        [](msdf_glyph_entry const& glyph, uint32_t u) {
+            return glyph.unicode < u;
+        });
+    return it != sparse.end() && it->unicode == unicode ? &*it : nullptr;
+}
+
+// Get the baked glyph for `unicode` (or an empty one if there isn't one).
+static inline msdf_glyph_entry const&
+find_glyph(msdf_font_data const& font, uint32_t unicode)
+{
+    msdf_glyph_entry const* glyph = find_glyph_slot(font, unicode);
+    return glyph ? *glyph : empty_glyph;
+}
+
+// Place a generated glyph in one of the atlas pages, queueing its pixels for
+// upload. Returns false if there's no room for it.
+bool
+place_glyph(
+    alia_msdf_text_engine& engine,
+    msdf_font_data& font,
+    msdf_glyph_entry& glyph,
+    alia_msdf_generated_glyph const& generated)
+{
+    msdf_dynamic_atlas& dynamic = *engine.dynamic;
+
+    // Leave a pixel between glyphs so that they don't bleed into each other.
+    int const padding = 1;
+    int const width = generated.width + padding;
+    int const height = generated.height + padding;
+    // (A glyph that could never fit isn't worth evicting anything for.)
+    if (width > dynamic.width || height > dynamic.config.page_height)
+        return false;
+
+    if (dynamic.starved)
+        return false;
+    bool const have_slot
+        = !font.free_glyph_slots.empty()
+       || font.glyph_metrics.size() < font.glyph_metrics.capacity();
+    size_t page_index = 0;
+    int x = 0, y = 0;
+    while (have_slot && page_index != dynamic.pages.size()
+           && !alia::skyline_pack(
+               dynamic.pages[page_index].packer, width, height, &x, &y))
+    {
+        ++page_index;
+    }
+    if (!have_slot || page_index == dynamic.pages.size())
+    {
+        dynamic.starved = true;
+        return false;
+    }
+
+    uint32_t slot;
+    if (!font.free_glyph_slots.empty())
+    {
+        slot = font.free_glyph_slots.back();
+        font.free_glyph_slots.pop_back();
+    }
+    else
+    {
+        slot = uint32_t(font.glyph_metrics.size());
+        font.glyph_metrics.emplace_back();
+    }
+
+    y += dynamic.page_top + int(page_index) * dynamic.config.page_height;
+    float const atlas_width = float(dynamic.width);
+    float const atlas_height = float(dynamic.height);
+    glyph.uv_rect[0] = float(x) / atlas_width;
+    glyph.uv_rect[1] = float(y) / atlas_height;
+    glyph.uv_rect[2] = float(generated.width) / atlas_width;
+    glyph.uv_rect[3] = float(generated.height) / atlas_height;
+    glyph.index = slot;
+    glyph.page = uint16_t(page_index + 1);
+    font.glyph_metrics[slot]
+        = {.plane_left = glyph.plane_left,
+           .plane_bottom = glyph.plane_bottom,
+           .plane_right = glyph.plane_right,
+           .plane_top = glyph.plane_top,
+           .uv_rect
+           = {glyph.uv_rect[0],
+              glyph.uv_rect[1],
+              glyph.uv_rect[2],
+              glyph.uv_rect[3]}};
+
+    msdf_atlas_page& page = dynamic.pages[page_index];
+    page.glyphs.push_back(
+        {.font = uint32_t(font.font_index), .unicode = glyph.unicode});
+    page.last_used = dynamic.pass;
+
+    size_t const size = size_t(generated.width) * generated.height * 3;
+    size_t const offset = dynamic.pending_pixels.size();
+    dynamic.pending_pixels.insert(
+        dynamic.pending_pixels.end(), generated.rgb, generated.rgb + size);
+    dynamic.pending_updates.push_back(
+        {.x = x,
+         .y = y,
+         .width = generated.width,
+         .height = generated.height,
+         .offset = offset});
+    return true;
+}
+
+// Get the generated glyph for `unicode`, generating it if this is the first
+// time that it's been asked for.
+msdf_glyph_entry const&
+find_dynamic_glyph(
+    alia_msdf_text_engine& engine, msdf_font_data& font, uint32_t unicode)
 {
-    alia_msdf_glyph const& glyph = font.glyphs.at(static_cast<int>(unicode));
-    assert(glyph.unicode == unicode);
+    msdf_dynamic_atlas& dynamic = *engine.dynamic;
+    auto [it, inserted] = font.dynamic_glyphs.try_emplace(unicode);
+    msdf_glyph_entry& glyph = it->second;
+    if (!inserted)
+    {
+        if (glyph.page != 0)
+            dynamic.pages[glyph.page - 1].last_used = dynamic.pass;
+        return glyph;
+    }
+
+    glyph.unicode = unicode;
+    glyph.index = msdf_no_glyph_index;
+    alia_msdf_generated_glyph generated{};
+    if (!dynamic.config.generate(
+            dynamic.config.user, font.font_index, unicode, &generated))
+    {
+        return glyph;
+    }
+    glyph.present = true;
+    glyph.advance = generated.advance;
+    // Without an image, there's nothing to draw.
+    if (generated.rgb && generated.width > 0 && generated.height > 0)
+    {
+        glyph.plane_left = generated.plane_left;
+        glyph.plane_bottom = generated.plane_bottom;
+        glyph.plane_right = generated.plane_right;
+        glyph.plane_top = generated.plane_top;
+        place_glyph(engine, font, glyph, generated);
+    }
     return glyph;
 }
 
+// Make sure that a generated glyph is in the atlas (since its page may have
+// been evicted). Returns false if there's no room for it.
+bool
+make_glyph_resident(
+    alia_msdf_text_engine& engine, msdf_font_data& font, uint32_t unicode)
+{
+    msdf_dynamic_atlas& dynamic = *engine.dynamic;
+    if (dynamic.starved)
+        return false;
+    alia_msdf_generated_glyph generated{};
+    if (!dynamic.config.generate(
+            dynamic.config.user, font.font_index, unicode, &generated)
+        || !generated.rgb)
+    {
+        return false;
+    }
+    return place_glyph(
+        engine, font, font.dynamic_glyphs.at(unicode), generated);
+}
+
+// Get the glyph for `unicode` (or an empty one if the font doesn't have it).
+msdf_glyph_entry const&
+lookup_glyph(
+    alia_msdf_text_engine& engine, msdf_font_data& font, uint32_t unicode)
+{
+    msdf_glyph_entry const* glyph = find_glyph_slot(font, unicode);
+    if (glyph && glyph->present)
+        return *glyph;
+    if (!engine.dynamic)
+        return glyph ? *glyph : empty_glyph;
+    return find_dynamic_glyph(engine, font, unicode);
+}
+
+uint32_t const replacement_character = 0xfffd;
+
+// Decode the multibyte UTF-8 sequence at `text[i]`, advancing `i` past it.
+// Malformed sequences decode to U+FFFD, one byte at a time.
+uint32_t
+decode_utf8_sequence(char const* text, size_t length, size_t& i)
+{
+    auto const byte
+        = [&](size_t j) { return static_cast<unsigned char>(text[j]); };
+    unsigned char const lead = byte(i);
+    size_t extra;
+    uint32_t codepoint, minimum;
+    if (lead >= 0xc2 && lead <= 0xdf)
+    {
+        extra = 1;
+        codepoint = lead & 0x1f;
+        minimum = 0x80;
+    }
+    else if ((lead & 0xf0) == 0xe0)
+    {
+        extra = 2;
+        codepoint = lead & 0x0f;
+        minimum = 0x800;
+    }
+    else if (lead >= 0xf0 && lead <= 0xf4)
+    {
+        extra = 3;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    }
+    else
+    {
+        ++i;
+        return replacement_character;
+    }
+    if (length - i <= extra)
+    {
+        ++i;
+        return replacement_character;
+    }
+    for (size_t k = 1; k <= extra; ++k)
+    {
+        unsigned char const c = byte(i + k);
+        if ((c & 0xc0) != 0x80)
+        {
+            ++i;
+            return replacement_character;
+        }
+        codepoint = (codepoint << 6) | (c & 0x3f);
+    }
+    // Reject overlong encodings, surrogates and anything past U+10FFFF.
+    if (codepoint < minimum || codepoint > 0x10ffff
+        || (codepoint >= 0xd800 && codepoint < 0xe000))
+    {
+        ++i;
+        return replacement_character;
+    }
+    i += extra + 1;
+    return codepoint;
+}
+
+// Decode the character at `text[i]` (advancing `i` past it) and get its
+// glyph. ASCII characters go straight to the dense table.
+static inline msdf_glyph_entry const&
+next_glyph(
+    alia_msdf_text_engine& engine,
+    msdf_font_data& font,
+    char const* text,
+    size_t length,
+    size_t& i)
+{
+    unsigned char const c = static_cast<unsigned char>(text[i]);
+    if (c < 0x80)
+    {
+        ++i;
+        msdf_glyph_entry const& glyph = font.dense_glyphs[c];
+        if (glyph.present || !engine.dynamic)
+            return glyph;
+        return find_dynamic_glyph(engine, font, c);
+    }
+    return lookup_glyph(engine, font, decode_utf8_sequence(text, length, i));
+}
+
+static inline bool
+is_control_character(char c)
+{
+    return static_cast<unsigned char>(c) < 32;
+}
+
+static inline float
+get_kerning(
+    msdf_font_data const& font, uint16_t left_class, uint16_t right_class)
+{
+    return font.kerning[left_class * font.right_class_count + right_class];
+}
+
+static inline float
+get_kerning(
+    msdf_font_data const& font,
+    msdf_glyph_entry const& left,
+    msdf_glyph_entry const& right)
+{
+    return get_kerning(font, left.left_class, right.right_class);
+}
+
 static inline void
 emit_glyph_draw_command(
     alia_context* ctx,
     alia_z_index z_index,
-    alia_msdf_glyph const& glyph,
-    cached_glyph_data const& cached_glyph,
+    msdf_glyph_entry const& glyph,
     float sdf_scale,
     alia_vec2f cursor,
     float scale,
@@ -88,39 +466,279 @@ emit_glyph_draw_command(
     command->color = color;
     std::memcpy(
         command->payload.msdf_glyph.uv_rect,
-        cached_glyph.uv_rect,
-        sizeof(cached_glyph.uv_rect));
+        glyph.uv_rect,
+        sizeof(glyph.uv_rect));
     command->payload.msdf_glyph.sdf_scale = sdf_scale;
 }
 
-float
-get_kerning(msdf_font_data const& font, uint32_t left, uint32_t right)
+// Does drawing `glyph` actually cover anything? (Spaces, for example, don't.)
+static inline bool
+glyph_has_quad(msdf_glyph_entry const& glyph)
 {
-    auto it = font.kerning.find(kerning_pair_index{left, right});
-    if (it != font.kerning.end())
-        return it->second;
-    return 0.0f;
+    return glyph.plane_right > glyph.plane_left
+        && glyph.plane_top > glyph.plane_bottom;
 }
 
-} // namespace
+// Can `glyph` be drawn? This makes generated glyphs resident as necessary.
+static inline bool
+prepare_glyph_for_drawing(
+    alia_msdf_text_engine& engine,
+    msdf_font_data& font,
+    msdf_glyph_entry const& glyph)
+{
+    return glyph_has_quad(glyph)
+        && (glyph.index != msdf_no_glyph_index
+            || make_glyph_resident(engine, font, glyph.unicode));
+}
 
-struct alia_msdf_text_engine
+static_assert(
+    offsetof(alia_draw_msdf_glyph_run_command, primitive_type)
+    == offsetof(alia_draw_primitive_command, primitive_type));
+
+// Draw the UTF-8 `text` as a glyph run, with the pen starting at `origin` on
+// the baseline. Control characters and characters that the font doesn't have
+// are skipped.
+void
+emit_glyph_run(
+    alia_context* ctx,
+    alia_z_index z_index,
+    alia_msdf_text_engine& engine,
+    msdf_font_data& font,
+    char const* text,
+    size_t length,
+    alia_vec2f origin,
+    float scale,
+    float sdf_scale,
+    alia_srgba8 color)
 {
-    // abstract text-engine base - Must be first so an `alia_text_engine*`
-    // dispatched by the core can be cast back to `alia_msdf_text_engine*`.
-    alia_text_engine base;
-    alia_msdf_atlas_description atlas;
-    std::vector<msdf_font_data> fonts;
-};
+    uint32_t count = 0;
+    for (size_t i = 0; i < length;)
+    {
+        if (is_control_character(text[i]))
+        {
+            ++i;
+            continue;
+        }
+        msdf_glyph_entry const& glyph
+            = next_glyph(engine, font, text, length, i);
+        if (prepare_glyph_for_drawing(engine, font, glyph))
+            ++count;
+    }
+    if (count == 0)
+        return;
 
-namespace {
+    auto* run = reinterpret_cast<alia_draw_msdf_glyph_run_command*>(
+        alia_draw_command_alloc(
+            ctx,
+            z_index,
+            ALIA_PRIMITIVE_MATERIAL_ID,
+            alia_msdf_glyph_run_size(count)));
+    run->primitive_type = ALIA_PRIMITIVE_MSDF_GLYPH_RUN;
+    run->color = color;
+    run->origin = origin;
+    run->scale = scale;
+    run->sdf_scale = sdf_scale;
+    run->glyphs = font.glyph_metrics.data();
+    run->count = count;
+
+    // (Since nothing is evicted mid-pass, every glyph that was counted above
+    // is still resident.)
+    alia_msdf_glyph_run_entry* entries = alia_msdf_glyph_run_entries(run);
+    uint32_t n = 0;
+    float x = 0;
+    uint16_t previous_class = 0;
+    for (size_t i = 0; i < length;)
+    {
+        if (is_control_character(text[i]))
+        {
+            ++i;
+            previous_class = 0;
+            continue;
+        }
+        msdf_glyph_entry const& glyph
+            = next_glyph(engine, font, text, length, i);
+        x += get_kerning(font, previous_class, glyph.right_class) * scale;
+        if (glyph_has_quad(glyph) && glyph.index != msdf_no_glyph_index)
+            entries[n++] = {.glyph = glyph.index, .x = x};
+        x += glyph.advance * scale;
+        previous_class = glyph.left_class;
+    }
+    ALIA_ASSERT(n == count);
+
+    alia_vec2f low = {0, 0}, high = {0, 0};
+    for (uint32_t i = 0; i != count; ++i)
+    {
+        alia_box const box = alia_msdf_glyph_run_entry_box(run, entries[i]);
+        alia_vec2f const box_high = alia_vec2f_add(box.min, box.size);
+        low = i == 0 ? box.min : alia_vec2f_min(low, box.min);
+        high = i == 0 ? box_high : alia_vec2f_max(high, box_high);
+    }
+    run->box = {.min = low, .size = alia_vec2f_sub(high, low)};
+}
+
+// Assign the font's glyphs to kerning classes and build its kerning table.
+void
+build_kerning_classes(
+    msdf_font_data& font, alia_msdf_font_description const& description)
+{
+    // Collect the pairs between glyphs in the font, sorted by left and then
+    // right glyph. (As with a map, later duplicates replace earlier ones.)
+    std::vector<alia_msdf_kerning_pair> pairs;
+    for (size_t i = 0; i < description.kerning_pair_count; ++i)
+    {
+        alia_msdf_kerning_pair const& pair = description.kerning_pairs[i];
+        if (find_glyph(font, pair.left).present
+            && find_glyph(font, pair.right).present)
+        {
+            pairs.push_back(pair);
+        }
+    }
+    std::stable_sort(
+        pairs.begin(),
+        pairs.end(),
+        [](alia_msdf_kerning_pair const& a, alia_msdf_kerning_pair const& b) {
+            return a.left != b.left ? a.left < b.left : a.right < b.right;
+        });
+    size_t kept = 0;
+    for (size_t i = 0; i != pairs.size(); ++i)
+    {
+        if (kept != 0 && pairs[kept - 1].left == pairs[i].left
+            && pairs[kept - 1].right == pairs[i].right)
+        {
+            pairs[kept - 1] = pairs[i];
+        }
+        else
+            pairs[kept++] = pairs[i];
+    }
+    pairs.resize(kept);
+
+    // Left glyphs with identical rows of pairs share a class.
+    std::map<std::vector<std::pair<uint32_t, float>>, uint16_t> rows;
+    std::vector<uint16_t> pair_left_classes(pairs.size());
+    for (size_t i = 0; i != pairs.size();)
+    {
+        size_t end = i;
+        std::vector<std::pair<uint32_t, float>> row;
+        for (; end != pairs.size() && pairs[end].left == pairs[i].left; ++end)
+            row.emplace_back(pairs[end].right, pairs[end].adjustment);
+        uint16_t const left_class
+            = rows.emplace(std::move(row), uint16_t(rows.size() + 1))
+                  .first->second;
+        find_glyph_slot(font, pairs[i].left)->left_class = left_class;
+        for (; i != end; ++i)
+            pair_left_classes[i] = left_class;
+    }
+
+    // Likewise, right glyphs with identical columns (of left classes) share a
+    // class.
+    std::map<uint32_t, std::vector<std::pair<uint16_t, float>>> columns;
+    for (size_t i = 0; i != pairs.size(); ++i)
+    {
+        columns[pairs[i].right].emplace_back(
+            pair_left_classes[i], pairs[i].adjustment);
+    }
+    std::map<std::vector<std::pair<uint16_t, float>>, uint16_t> column_classes;
+    for (auto& [right, column] : columns)
+    {
+        std::sort(column.begin(), column.end());
+        column.erase(std::unique(column.begin(), column.end()), column.end());
+        find_glyph_slot(font, right)->right_class
+            = column_classes
+                  .emplace(column, uint16_t(column_classes.size() + 1))
+                  .first->second;
+    }
+
+    font.right_class_count = uint32_t(column_classes.size() + 1);
+    font.kerning.assign((rows.size() + 1) * font.right_class_count, 0.0f);
+    for (size_t i = 0; i != pairs.size(); ++i)
+    {
+        font.kerning
+            [pair_left_classes[i] * font.right_class_count
+             + find_glyph(font, pairs[i].right).right_class]
+            = pairs[i].adjustment;
+    }
+}
+
+// Build the glyph and kerning tables for a font.
+void
+build_font_tables(
+    msdf_font_data& font, alia_msdf_font_description const& description)
+{
+    alia_msdf_atlas_description const& atlas = description.atlas;
+
+    font.dense_glyphs.assign(msdf_dense_glyph_count, msdf_glyph_entry{});
+    for (uint32_t i = 0; i != msdf_dense_glyph_count; ++i)
+        font.dense_glyphs[i].unicode = i;
+    for (size_t i = 0; i < description.glyph_count; ++i)
+    {
+        alia_msdf_glyph const& glyph = description.glyphs[i];
+        msdf_glyph_entry entry{};
+        entry.advance = glyph.advance;
+        entry.plane_left = glyph.plane_left;
+        entry.plane_bottom = glyph.plane_bottom;
+        entry.plane_right = glyph.plane_right;
+        entry.plane_top = glyph.plane_top;
+        entry.uv_rect[0] = glyph.atlas_left / atlas.width;
+        entry.uv_rect[1] = glyph.atlas_bottom / atlas.height;
+        entry.uv_rect[2]
+            = (glyph.atlas_right - glyph.atlas_left) / atlas.width;
+        entry.uv_rect[3]
+            = (glyph.atlas_top - glyph.atlas_bottom) / atlas.height;
+        entry.unicode = glyph.unicode;
+        entry.present = true;
+        // (As with a map, later duplicates replace earlier ones.)
+        if (glyph.unicode < msdf_dense_glyph_count)
+            font.dense_glyphs[glyph.unicode] = entry;
+        else
+            font.sparse_glyphs.push_back(entry);
+    }
+    std::stable_sort(
+        font.sparse_glyphs.begin(),
+        font.sparse_glyphs.end(),
+        [](msdf_glyph_entry const& a, msdf_glyph_entry const& b) {
+            return a.unicode < b.unicode;
+        });
+    // Keep the last of any duplicates.
+    auto& sparse = font.sparse_glyphs;
+    size_t kept = 0;
+    for (size_t i = 0; i != sparse.size(); ++i)
+    {
+        if (kept != 0 && sparse[kept - 1].unicode == sparse[i].unicode)
+            sparse[kept - 1] = sparse[i];
+        else
+            sparse[kept++] = sparse[i];
+    }
+    sparse.resize(kept);
+
+    auto add_metrics = [&](msdf_glyph_entry& glyph) {
+        if (!glyph.present)
+            return;
+        glyph.index = uint32_t(font.glyph_metrics.size());
+        font.glyph_metrics.push_back(
+            {.plane_left = glyph.plane_left,
+             .plane_bottom = glyph.plane_bottom,
+             .plane_right = glyph.plane_right,
+             .plane_top = glyph.plane_top,
+             .uv_rect
+             = {glyph.uv_rect[0],
+                glyph.uv_rect[1],
+                glyph.uv_rect[2],
+                glyph.uv_rect[3]}});
+    };
+    for (msdf_glyph_entry& glyph : font.dense_glyphs)
+        add_metrics(glyph);
+    for (msdf_glyph_entry& glyph : font.sparse_glyphs)
+        add_metrics(glyph);
+
+    build_kerning_classes(font, description);
+}
 
 // a prepared text block for the MSDF engine - It holds a private copy of the
 // source bytes plus the segmentation/measurement produced by `prepare_block`.
 // This is what an opaque `alia_text_block*` points at for this engine.
 struct msdf_text_block
 {
-    msdf_font_data const* font;
+    msdf_font_data* font;
     float font_size;
     std::vector<char> text;
     std::vector<alia_text_segment> segments;
@@ -148,30 +766,28 @@ msdf_engine_get_font_metrics(
     out->cap_height = m.cap_height * size;
 }
 
-alia_text_block*
-msdf_engine_prepare_block(
-    alia_text_engine* engine,
-    void* engine_handle,
-    float font_size,
-    alia_text_direction base_direction,
-    char const* utf8,
-    size_t length)
+msdf_text_block*
+create_text_block(
+    void* engine_handle, float font_size, char const* utf8, size_t length)
 {
-    (void) engine;
-    // MSDF is LTR-only; base direction is ignored.
-    (void) base_direction;
-    auto const* font = reinterpret_cast<msdf_font_data const*>(engine_handle);
-
     auto* block = new msdf_text_block{};
-    block->font = font;
+    block->font = reinterpret_cast<msdf_font_data*>(engine_handle);
     block->font_size = font_size;
     block->text.assign(utf8, utf8 + length);
+    return block;
+}
 
-    auto const& glyphs = font->glyphs;
+// Break the block's text into content/space/hard-break segments and measure
+// each one's advance (in logical pixels at its font size). Kerning is
+// accumulated between consecutive characters within a single segment.
+void
+segment_text_block(alia_msdf_text_engine& eng, msdf_text_block& block)
+{
+    msdf_font_data* font = block.font;
+    float const font_size = block.font_size;
+    char const* utf8 = block.text.data();
+    size_t const length = block.text.size();
 
-    // Break the text into content/space/hard-break segments and measure each
-    // one's advance (in logical pixels at `font_size`). Kerning is accumulated
-    // between consecutive characters within a single segment.
     size_t i = 0;
     while (i < length)
     {
@@ -186,7 +802,7 @@ msdf_engine_prepare_block(
                 ALIA_TEXT_SEGMENT_HARD_BREAK);
             seg.direction
                 = static_cast<alia_text_direction>(ALIA_TEXT_DIRECTION_LTR);
-            block->segments.push_back(seg);
+            block.segments.push_back(seg);
             ++i;
             continue;
         }
@@ -199,24 +815,17 @@ msdf_engine_prepare_block(
         bool const is_space = (c == ' ');
         size_t const start = i;
         float width = 0.0f;
+        uint16_t previous_class = 0;
         while (i < length)
         {
             char const d = utf8[i];
             if (d == '\n' || d == '\r' || ((d == ' ') != is_space))
                 break;
-            width += glyphs.at(static_cast<int>(d)).advance;
-            ++i;
-            if (i < length)
-            {
-                char const e = utf8[i];
-                bool const continues
-                    = e != '\n' && e != '\r' && ((e == ' ') == is_space);
-                if (continues)
-                    width += get_kerning(
-                        *font,
-                        static_cast<uint32_t>(static_cast<unsigned char>(d)),
-                        static_cast<uint32_t>(static_cast<unsigned char>(e)));
-            }
+            msdf_glyph_entry const& glyph
+                = next_glyph(eng, *font, utf8, length, i);
+            width += get_kerning(*font, previous_class, glyph.right_class);
+            width += glyph.advance;
+            previous_class = glyph.left_class;
         }
 
         alia_text_segment seg{};
@@ -227,9 +836,25 @@ msdf_engine_prepare_block(
             is_space ? ALIA_TEXT_SEGMENT_SPACE : ALIA_TEXT_SEGMENT_CONTENT);
         seg.direction
             = static_cast<alia_text_direction>(ALIA_TEXT_DIRECTION_LTR);
-        block->segments.push_back(seg);
+        block.segments.push_back(seg);
     }
+}
 
+alia_text_block*
+msdf_engine_prepare_block(
+    alia_text_engine* engine,
+    void* engine_handle,
+    float font_size,
+    alia_text_direction base_direction,
+    char const* utf8,
+    size_t length)
+{
+    // MSDF is LTR-only; base direction is ignored.
+    (void) base_direction;
+    auto& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
+    msdf_text_block* block
+        = create_text_block(engine_handle, font_size, utf8, length);
+    segment_text_block(eng, *block);
     return reinterpret_cast<alia_text_block*>(block);
 }
 
@@ -273,9 +898,9 @@ msdf_engine_draw_block_range(
 {
     // MSDF is LTR-only; direction is ignored.
     (void) direction;
-    auto const& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
+    auto& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
     auto const& block = *reinterpret_cast<msdf_text_block*>(block_opaque);
-    msdf_font_data const& font = *block.font;
+    msdf_font_data& font = *block.font;
     alia_msdf_atlas_description const& atlas = eng.atlas;
     float const scale = block.font_size;
 
@@ -284,30 +909,187 @@ msdf_engine_draw_block_range(
     alia_vec2f cursor = alia_vec2f_add(baseline_origin, ctx->geometry->offset);
     float const sdf_scale = scale * atlas.distance_range / atlas.font_size;
 
-    char const* text = block.text.data();
     size_t const end
         = byte_end < block.text.size() ? byte_end : block.text.size();
-    for (size_t i = byte_start; i < end; ++i)
+    if (byte_start >= end)
+        return;
+    emit_glyph_run(
+        ctx,
+        z_index,
+        eng,
+        font,
+        block.text.data() + byte_start,
+        end - byte_start,
+        cursor,
+        scale,
+        sdf_scale,
+        color);
+}
+
+// BACKGROUND PREPARATION
+
+size_t const default_background_min_length = 64 * 1024;
+
+enum class msdf_preparation_state
+{
+    queued,
+    running,
+    // cancelled while running - The worker cleans it up when it's done.
+    abandoned,
+    finished,
+};
+
+// a block that's being prepared in the background - This is what an opaque
+// `alia_text_preparation*` points at for this engine.
+struct msdf_preparation
+{
+    msdf_text_block* block;
+    void (*on_ready)(void* user);
+    void* user;
+    // protected by the pool's mutex
+    msdf_preparation_state state;
+};
+
+struct msdf_background_pool
+{
+    size_t min_length;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // the preparations that are waiting for a worker (protected by `mutex`)
+    std::deque<msdf_preparation*> queue;
+    bool stopping = false;
+};
+
+void
+discard_preparation(msdf_preparation* preparation)
+{
+    delete preparation->block;
+    delete preparation;
+}
+
+void
+background_worker_loop(
+    alia_msdf_text_engine& engine, msdf_background_pool& pool)
+{
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    while (true)
     {
-        char const c = text[i];
-        if (c < 32)
+        pool.wake.wait(
+            lock, [&] { return pool.stopping || !pool.queue.empty(); });
+        if (pool.stopping)
+            return;
+        msdf_preparation* preparation = pool.queue.front();
+        pool.queue.pop_front();
+        preparation->state = msdf_preparation_state::running;
+
+        lock.unlock();
+        segment_text_block(engine, *preparation->block);
+        lock.lock();
+
+        if (preparation->state == msdf_preparation_state::abandoned)
+        {
+            discard_preparation(preparation);
             continue;
-        uint32_t const unicode = static_cast<uint32_t>(c);
-        alia_msdf_glyph const& glyph = require_glyph(font, unicode);
-        auto const& cached_glyph
-            = font.glyph_cache.at(static_cast<int>(unicode));
-        emit_glyph_draw_command(
-            ctx,
-            z_index,
-            glyph,
-            cached_glyph,
-            sdf_scale,
-            cursor,
-            scale,
-            color);
-        cursor.x += glyph.advance * scale;
-        if (i + 1 < end)
-            cursor.x += get_kerning(font, c, text[i + 1]) * scale;
+        }
+        preparation->state = msdf_preparation_state::finished;
+        // This happens under the lock so that a cancellation can't slip in
+        // between the state change and the notification.
+        preparation->on_ready(preparation->user);
+    }
+}
+
+void
+stop_background_workers(alia_msdf_text_engine& engine)
+{
+    msdf_background_pool* pool = engine.background;
+    if (!pool)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+    for (auto& thread : pool->threads)
+        thread.join();
+    for (msdf_preparation* preparation : pool->queue)
+        discard_preparation(preparation);
+    delete pool;
+    engine.background = nullptr;
+}
+
+alia_text_preparation*
+msdf_engine_begin_prepare_block(
+    alia_text_engine* engine,
+    void* engine_handle,
+    float font_size,
+    alia_text_direction base_direction,
+    char const* utf8,
+    size_t length,
+    void (*on_ready)(void* user),
+    void* user)
+{
+    (void) base_direction;
+    auto& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
+    msdf_background_pool* pool = eng.background;
+    if (!pool || length < pool->min_length)
+        return nullptr;
+
+    auto* preparation = new msdf_preparation{
+        .block = create_text_block(engine_handle, font_size, utf8, length),
+        .on_ready = on_ready,
+        .user = user,
+        .state = msdf_preparation_state::queued};
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->queue.push_back(preparation);
+    }
+    pool->wake.notify_one();
+    return reinterpret_cast<alia_text_preparation*>(preparation);
+}
+
+alia_text_block*
+msdf_engine_finish_prepare_block(
+    alia_text_engine* engine, alia_text_preparation* preparation_opaque)
+{
+    auto& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
+    auto* preparation
+        = reinterpret_cast<msdf_preparation*>(preparation_opaque);
+    msdf_text_block* block;
+    {
+        std::lock_guard<std::mutex> lock(eng.background->mutex);
+        ALIA_ASSERT(preparation->state == msdf_preparation_state::finished);
+        block = preparation->block;
+    }
+    delete preparation;
+    return reinterpret_cast<alia_text_block*>(block);
+}
+
+void
+msdf_engine_cancel_prepare_block(
+    alia_text_engine* engine, alia_text_preparation* preparation_opaque)
+{
+    auto& eng = *reinterpret_cast<alia_msdf_text_engine*>(engine);
+    auto* preparation
+        = reinterpret_cast<msdf_preparation*>(preparation_opaque);
+    msdf_background_pool& pool = *eng.background;
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    switch (preparation->state)
+    {
+        case msdf_preparation_state::queued:
+            pool.queue.erase(
+                std::find(pool.queue.begin(), pool.queue.end(), preparation));
+            discard_preparation(preparation);
+            break;
+        case msdf_preparation_state::running:
+            preparation->state = msdf_preparation_state::abandoned;
+            break;
+        case msdf_preparation_state::finished:
+            discard_preparation(preparation);
+            break;
+        case msdf_preparation_state::abandoned:
+            ALIA_ASSERT(false);
+            break;
     }
 }
 
@@ -318,6 +1100,9 @@ alia_text_engine_vtable const msdf_text_engine_vtable = {
     msdf_engine_segment_count,
     msdf_engine_segment_info,
     msdf_engine_draw_block_range,
+    msdf_engine_begin_prepare_block,
+    msdf_engine_finish_prepare_block,
+    msdf_engine_cancel_prepare_block,
 };
 
 } // namespace
@@ -412,42 +1197,169 @@ alia_msdf_create_text_engine(
     {
         alia_msdf_font_description const& font = font_descriptions[f];
         msdf_font_data fd;
+        fd.font_index = f;
         fd.metrics = font.metrics;
-        for (size_t i = 0; i < font.kerning_pair_count; ++i)
+        build_font_tables(fd, font);
+        ctx->fonts.push_back(std::move(fd));
+    }
+    return ctx;
+}
+
+extern "C" void
+alia_msdf_destroy_text_engine(alia_msdf_text_engine* ctx)
+{
+    stop_background_workers(*ctx);
+    delete ctx;
+}
+
+extern "C" void
+alia_msdf_enable_dynamic_glyphs(
+    alia_msdf_text_engine* engine,
+    alia_msdf_dynamic_glyph_config const* config)
+{
+    ALIA_ASSERT(engine && config);
+    ALIA_ASSERT(config->generate);
+    ALIA_ASSERT(config->page_height > 0 && config->page_count > 0);
+    ALIA_ASSERT(!engine->dynamic);
+    // Generating glyphs on the workers would race with the UI thread.
+    ALIA_ASSERT(!engine->background);
+
+    auto dynamic = std::make_unique<msdf_dynamic_atlas>();
+    dynamic->config = *config;
+    dynamic->width = int(engine->atlas.width);
+    dynamic->page_top = int(engine->atlas.height);
+    dynamic->height
+        = dynamic->page_top + config->page_count * config->page_height;
+    dynamic->pages.resize(size_t(config->page_count));
+    for (msdf_atlas_page& page : dynamic->pages)
+        alia::skyline_reset(page.packer, dynamic->width, config->page_height);
+
+    // The baked glyphs' v coordinates were relative to the baked atlas, which
+    // is now just the top of the texture.
+    float const v_scale = engine->atlas.height / float(dynamic->height);
+    for (msdf_font_data& font : engine->fonts)
+    {
+        for (msdf_glyph_entry& glyph : font.dense_glyphs)
         {
-            fd.kerning[kerning_pair_index{
-                font.kerning_pairs[i].left, font.kerning_pairs[i].right}]
-                = font.kerning_pairs[i].adjustment;
+            glyph.uv_rect[1] *= v_scale;
+            glyph.uv_rect[3] *= v_scale;
         }
-        for (size_t i = 0; i < font.glyph_count; ++i)
+        for (msdf_glyph_entry& glyph : font.sparse_glyphs)
         {
-            fd.glyphs[font.glyphs[i].unicode] = font.glyphs[i];
+            glyph.uv_rect[1] *= v_scale;
+            glyph.uv_rect[3] *= v_scale;
         }
-        for (size_t i = 0; i < font.glyph_count; ++i)
+        for (alia_msdf_glyph_metrics& glyph : font.glyph_metrics)
         {
-            auto& cached_glyph = fd.glyph_cache[font.glyphs[i].unicode];
-            cached_glyph.uv_rect[0]
-                = font.glyphs[i].atlas_left / font.atlas.width;
-            cached_glyph.uv_rect[1]
-                = font.glyphs[i].atlas_bottom / font.atlas.height;
-            cached_glyph.uv_rect[2]
-                = (font.glyphs[i].atlas_right - font.glyphs[i].atlas_left)
-                / font.atlas.width;
-            cached_glyph.uv_rect[3]
-                = (font.glyphs[i].atlas_top - font.glyphs[i].atlas_bottom)
-                / font.atlas.height;
+            glyph.uv_rect[1] *= v_scale;
+            glyph.uv_rect[3] *= v_scale;
         }
-        ctx->fonts.push_back(std::move(fd));
+        font.glyph_metrics.reserve(
+            font.glyph_metrics.size() + config->glyph_capacity);
     }
-    return ctx;
+
+    engine->dynamic = std::move(dynamic);
 }
 
 extern "C" void
-alia_msdf_destroy_text_engine(alia_msdf_text_engine* ctx)
+alia_msdf_enable_background_preparation(
+    alia_msdf_text_engine* engine,
+    alia_msdf_background_config const* config)
 {
-    delete ctx;
+    ALIA_ASSERT(engine && config);
+    ALIA_ASSERT(config->thread_count > 0);
+    ALIA_ASSERT(!engine->background);
+    ALIA_ASSERT(!engine->dynamic);
+
+    auto* pool = new msdf_background_pool;
+    pool->min_length = config->min_length != 0
+                         ? config->min_length
+                         : default_background_min_length;
+    engine->background = pool;
+    for (uint32_t i = 0; i != config->thread_count; ++i)
+    {
+        pool->threads.emplace_back(
+            background_worker_loop, std::ref(*engine), std::ref(*pool));
+    }
 }
 
+extern "C" alia_vec2i
+alia_msdf_get_atlas_texture_size(alia_msdf_text_engine* engine)
+{
+    ALIA_ASSERT(engine);
+    if (engine->dynamic)
+        return {engine->dynamic->width, engine->dynamic->height};
+    return {int(engine->atlas.width), int(engine->atlas.height)};
+}
+
+namespace alia {
+
+bool
+msdf_begin_draw_pass(alia_msdf_text_engine& engine)
+{
+    if (!engine.dynamic)
+        return false;
+    msdf_dynamic_atlas& dynamic = *engine.dynamic;
+    ++dynamic.pass;
+    if (!dynamic.starved)
+        return false;
+    dynamic.starved = false;
+
+    // Evict the least recently used page that has anything on it.
+    msdf_atlas_page* victim = nullptr;
+    for (msdf_atlas_page& page : dynamic.pages)
+    {
+        if (!page.glyphs.empty()
+            && (!victim || page.last_used < victim->last_used))
+        {
+            victim = &page;
+        }
+    }
+    if (!victim)
+        return false;
+    for (msdf_glyph_key const& key : victim->glyphs)
+    {
+        msdf_font_data& font = engine.fonts[key.font];
+        msdf_glyph_entry& glyph = font.dynamic_glyphs.at(key.unicode);
+        font.free_glyph_slots.push_back(glyph.index);
+        glyph.index = msdf_no_glyph_index;
+        glyph.page = 0;
+    }
+    victim->glyphs.clear();
+    skyline_reset(victim->packer, dynamic.width, dynamic.config.page_height);
+    return true;
+}
+
+void
+msdf_flush_atlas_updates(alia_msdf_text_engine& engine, alia_ui_system& ui)
+{
+    if (!engine.dynamic)
+        return;
+    msdf_dynamic_atlas& dynamic = *engine.dynamic;
+    alia_renderer_ops const& ops = ui.renderer;
+    if (ops.update_msdf_atlas)
+    {
+        for (msdf_pending_update const& update : dynamic.pending_updates)
+        {
+            alia_msdf_atlas_region const region = {
+                .rgb = dynamic.pending_pixels.data() + update.offset,
+                .x = update.x,
+                .y = update.y,
+                .width = update.width,
+                .height = update.height,
+            };
+            ops.update_msdf_atlas(ops.user, &region);
+        }
+    }
+    dynamic.pending_updates.clear();
+    dynamic.pending_pixels.clear();
+    // If glyphs were left out, another pass is needed to make room for them.
+    if (dynamic.starved)
+        alia_ui_mark_dirty(&ui);
+}
+
+} // namespace alia
+
 extern "C" alia_typeface_id
 alia_msdf_register_typeface(
     alia_ui_system* ui, alia_msdf_text_engine* engine, size_t font_index)
@@ -472,27 +1384,20 @@ alia_msdf_measure_text_width(
     size_t length,
     float font_size)
 {
-    auto& glyphs = ctx->fonts[font_index].glyphs;
+    msdf_font_data& font = ctx->fonts[font_index];
+    if (length == 0)
+        return 0;
+    size_t i = 0;
+    msdf_glyph_entry const* glyph = &next_glyph(*ctx, font, text, length, i);
     float width = 0;
-    for (size_t i = 0; i < length; ++i)
+    while (i < length)
     {
-        char const c = text[i];
-
-        alia_msdf_glyph const& glyph = glyphs.at(static_cast<int>(c));
-        assert(glyph.unicode == static_cast<uint32_t>(c));
-
-        if (i + 1 < length)
-        {
-            width += (glyph.advance
-                      + get_kerning(ctx->fonts[font_index], c, text[i + 1]))
-                   * font_size;
-        }
-        else
-        {
-            width += glyph.advance * font_size;
-        }
+        msdf_glyph_entry const& next = next_glyph(*ctx, font, text, length, i);
+        width
+            += (glyph->advance + get_kerning(font, *glyph, next)) * font_size;
+        glyph = &next;
     }
-    return width;
+    return width + glyph->advance * font_size;
 }
 
 extern "C" float
@@ -502,8 +1407,9 @@ alia_msdf_measure_codepoint_width(
     uint32_t codepoint,
     float font_size)
 {
-    msdf_font_data const& font = ctx->fonts[font_index];
-    alia_msdf_glyph const& glyph = require_glyph(font, codepoint);
+    msdf_font_data& font = ctx->fonts[font_index];
+    msdf_glyph_entry const& glyph = lookup_glyph(*ctx, font, codepoint);
+    ALIA_ASSERT(glyph.present);
     return glyph.advance * font_size;
 }
 
@@ -520,16 +1426,16 @@ alia_msdf_break_text(
     bool force_break)
 {
     (void) buffer_length;
-    auto& glyphs = ctx->fonts[font_index].glyphs;
+    msdf_font_data& font = ctx->fonts[font_index];
     size_t last_space = start;
     float x = 0;
-    for (size_t i = start; i < end; ++i)
+    for (size_t i = start; i < end;)
     {
-        char const c = text[i];
-
-        switch (c)
+        size_t const character_start = i;
+        switch (text[i])
         {
             case '\r':
+                ++i;
                 continue;
             case '\n':
                 return {i + 1, x};
@@ -538,20 +1444,25 @@ alia_msdf_break_text(
                 break;
         }
 
-        alia_msdf_glyph const& glyph = glyphs.at(static_cast<int>(c));
-        assert(glyph.unicode == static_cast<uint32_t>(c));
+        msdf_glyph_entry const& glyph = next_glyph(*ctx, font, text, end, i);
 
         float kern = 0;
-        if (i + 1 < end)
-            kern = get_kerning(ctx->fonts[font_index], c, text[i + 1]);
+        if (i < end)
+        {
+            size_t j = i;
+            kern = get_kerning(
+                font, glyph, next_glyph(*ctx, font, text, end, j));
+        }
 
         x += (glyph.advance + kern) * scale;
         if (x > width)
         {
+            // If we have to break mid-word, break before this character
+            // (unless it's the first one).
+            size_t const forced
+                = character_start == start ? i : character_start;
             return {
-                last_space == start && force_break ? (i == start ? i + 1 : i)
-                                                   : last_space,
-                x};
+                last_space == start && force_break ? forced : last_space, x};
         }
     }
     return {end, x};
@@ -578,30 +1489,17 @@ alia_msdf_draw_text(
 
     float const sdf_scale = scale * atlas.distance_range / atlas.font_size;
 
-    for (size_t i = 0; i < length; ++i)
-    {
-        char const c = text[i];
-        if (c < 32)
-            continue;
-
-        uint32_t unicode = static_cast<uint32_t>(c);
-        alia_msdf_glyph const& glyph = require_glyph(font, unicode);
-        auto const& cached_glyph
-            = font.glyph_cache.at(static_cast<int>(unicode));
-        emit_glyph_draw_command(
-            ctx,
-            z_index,
-            glyph,
-            cached_glyph,
-            sdf_scale,
-            cursor,
-            scale,
-            color);
-
-        cursor.x += glyph.advance * scale;
-        if (i + 1 < length)
-            cursor.x += get_kerning(font, c, text[i + 1]) * scale;
-    }
+    emit_glyph_run(
+        ctx,
+        z_index,
+        *fonts,
+        font,
+        text,
+        length,
+        cursor,
+        scale,
+        sdf_scale,
+        color);
 }
 
 extern "C" void
@@ -617,9 +1515,10 @@ alia_msdf_draw_codepoint(
 {
     msdf_font_data& font = fonts->fonts[font_index];
     alia_msdf_atlas_description const& atlas = fonts->atlas;
-    alia_msdf_glyph const& glyph = require_glyph(font, codepoint);
-    auto const& cached_glyph
-        = font.glyph_cache.at(static_cast<int>(codepoint));
+    msdf_glyph_entry const& glyph = lookup_glyph(*fonts, font, codepoint);
+    ALIA_ASSERT(glyph.present);
+    if (!prepare_glyph_for_drawing(*fonts, font, glyph))
+        return;
 
     alia_vec2f cursor = alia_vec2f_add(
         alia_vec2f_add(position, ctx->geometry->offset),
@@ -627,5 +1526,5 @@ alia_msdf_draw_codepoint(
     float const sdf_scale = scale * atlas.distance_range / atlas.font_size;
 
     emit_glyph_draw_command(
-        ctx, z_index, glyph, cached_glyph, sdf_scale, cursor, scale, color);
+        ctx, z_index, glyph, sdf_scale, cursor, scale, color);
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+struct alia_msdf_text_engine;
+struct alia_ui_system;
+
+namespace alia {
+
+// Prepare `engine`'s dynamic glyph pages for a new draw pass, evicting a page
+// if the last pass ran out of room. Returns true if anything was evicted, in
+// which case drawing that was recorded in earlier passes may refer to glyphs
+// that are no longer in the atlas.
+bool
+msdf_begin_draw_pass(alia_msdf_text_engine& engine);
+
+// Hand any newly generated glyphs to the renderer. This must happen after a
+// pass's commands are recorded and before they're rendered.
+void
+msdf_flush_atlas_updates(alia_msdf_text_engine& engine, alia_ui_system& ui);
+
+} // namespace alia
@@ -5,6 +5,7 @@
 #include <alia/ui/system/work_internal.h>
 
 #include <alia/abi/ui/input/constants.h>
+#include <alia/abi/ui/drawing/system.h>
 #include <alia/abi/ui/layout/system.h>
 #include <alia/abi/ui/system/renderer.h>
 #include <alia/impl/base/arena.hpp>
@@ -14,6 +15,7 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 
 using namespace alia::operators;
 
@@ -68,7 +70,7 @@ process_due_timers(ui_system& ui, alia_nanosecond_count now, uint64_t cycle)
             alia_timer payload{
                 .target = req.target, .fire_time = req.fire_time};
             alia_event event = alia_make_timer_event(payload);
-            dispatch_event(ui, event);
+            dispatch_targeted_event(ui, event, req.target);
             refresh_system(ui);
         });
 }
@@ -116,6 +118,22 @@ alia_ui_system_init(
     // TODO: Sort this out.
     alia::initialize_lazy_commit_arena(&ui->scratch, 1024 * 1024);
     alia::initialize_lazy_commit_arena(&ui->draw.command_arena);
+    alia::initialize_lazy_commit_arena(&ui->draw.bucket_arena);
+    alia::initialize_lazy_commit_arena(&ui->draw.retained_arena);
+    ui->draw.retained_offset = 0;
+    ui->draw.retained_garbage = 0;
+    ui->draw.retained_epoch = 0;
+    std::memset(&ui->draw.palette_snapshot, 0, sizeof(alia_palette));
+    ui->draw.hot_element_snapshot = alia_element_id{};
+    ui->draw.capture_snapshot = alia_element_id{};
+    ui->draw.focus_snapshot = alia_element_id{};
+    ui->draw.window_focus_snapshot = false;
+    ui->draw.keyboard_interaction_snapshot = false;
+    ui->draw.ambient_generation = 0;
+    alia_ui_reset_draw_stats(ui);
+    ui->draw.damage.full = true;
+    ui->draw.damage.count = 0;
+    ui->draw.damage_baseline_valid = false;
 
     ui->draw.next_material_id = ALIA_BUILTIN_MATERIAL_COUNT;
 
@@ -245,6 +263,8 @@ refresh_system(ui_system& sys)
     // std::chrono::steady_clock::time_point begin
     //     = std::chrono::steady_clock::now();
 
+    layout_system_collect_retained_nodes(sys.layout);
+
     int attempts = 0;
     ++sys.frame_counter;
     while (true)
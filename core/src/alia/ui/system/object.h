@@ -12,6 +12,7 @@
 #include <alia/impl/events.hpp>
 #include <alia/kernel/animation.h>
 #include <alia/kernel/substrate.h>
+#include <alia/ui/input/hit_index.h>
 #include <alia/ui/layout/system.h>
 // #include <alia/system/os_interface.hpp>
 // #include <alia/system/window_interface.hpp>
@@ -22,6 +23,8 @@
 #include <alia/abi/ui/system/work.h>
 #include <alia/ui/drawing/system.h>
 #include <alia/ui/styling.h>
+#include <alia/ui/text/block_cache.h>
+#include <alia/ui/text/completions.h>
 
 #include <cstdint>
 #include <deque>
@@ -76,6 +79,9 @@ struct alia_ui_system
 
     alia_input_state input;
 
+    // the mouse hit regions from the last full hit test pass
+    alia::hit_index hit_index;
+
     alia_layout_system layout;
 
     alia_substrate_system substrate;
@@ -103,6 +109,9 @@ struct alia_ui_system
     // typeface registry
     std::vector<alia_resolved_typeface> typefaces;
 
+    // prepared text blocks shared between text elements
+    alia::shared_text_block_cache text_blocks;
+
     // pending timer events
     std::priority_queue<
         alia_ui_timer_request,
@@ -120,6 +129,10 @@ struct alia_ui_system
     // pending dispatch events (input and other queueable work)
     std::deque<alia_event> event_queue;
 
+    // text blocks that have finished preparing in the background (see
+    // `alia/ui/text/completions.h`)
+    alia::text_completion_queue text_completions;
+
     alia_ui_refresh_policy refresh_policy{};
 
     // TODO: Create a hierarchical component status tree.
@@ -5,6 +5,7 @@
 #include <alia/kernel/flow/dispatch.h>
 #include <alia/ui/system/internal_api.h>
 #include <alia/ui/system/work_internal.h>
+#include <alia/ui/text/completions.h>
 
 #include <cstdint>
 
@@ -102,6 +103,20 @@ update_hot_from_pointer(ui_system& ui)
 {
     if (ui.input.mouse_inside_window)
     {
+        // If the hit regions haven't changed since the last hit test pass,
+        // the index can usually resolve the hot element on its own.
+        hit_index& index = ui.hit_index;
+        bool const current
+            = index.valid
+           && index.placement_epoch == ui.layout.placement_epoch;
+        alia_mouse_hit_test_result result;
+        if (current
+            && hit_index_lookup(index, ui.input.mouse_position, result))
+        {
+            set_hot_element(ui, result.id);
+            return;
+        }
+
         alia_event event = alia_make_mouse_hit_test_event(
             {.x = ui.input.mouse_position.x,
              .y = ui.input.mouse_position.y,
@@ -110,7 +125,17 @@ update_hot_from_pointer(ui_system& ui)
                  .cursor = ALIA_CURSOR_DEFAULT,
                  .region = {{0.f, 0.f}, {0.f, 0.f}},
              }});
+        // Record the regions while we're at it (unless the index is still
+        // current and just couldn't resolve this particular lookup).
+        bool const recording = !current;
+        if (recording)
+            hit_index_begin_recording(index);
         dispatch_event(ui, event);
+        if (recording)
+        {
+            hit_index_end_recording(
+                index, ui.surface_size, ui.layout.placement_epoch);
+        }
         if (alia_element_id_is_valid(as_mouse_hit_test_event(event).result.id))
         {
             set_hot_element(ui, as_mouse_hit_test_event(event).result.id);
@@ -219,6 +244,11 @@ deliver_queued_event(ui_system& ui, alia_event& ev)
             dispatch_event(ui, ev);
             break;
 
+        case ALIA_EVENT_TEXT_BLOCK_READY:
+            dispatch_targeted_event(
+                ui, ev, as_text_block_ready_event(ev).target);
+            break;
+
         default:
             break;
     }
@@ -285,6 +315,8 @@ alia_ui_system_begin_update(alia_ui_system* ui)
     ++ui->timer_event_cycle;
     ui->update_timer_cycle = ui->timer_event_cycle;
 
+    alia::enqueue_text_completions(*ui);
+
     // TODO: This really doesn't belong here.
     if (ui->event_queue.empty())
         alia::apply_refresh_hook_policy(*ui, ui->refresh_policy.before_draw);
@@ -318,6 +350,7 @@ bool
 alia_ui_needs_tick(alia_ui_system* ui)
 {
     ALIA_ASSERT(ui);
+    alia::enqueue_text_completions(*ui);
     if (!ui->event_queue.empty())
         return true;
     if (alia::timer_is_due(*ui))
@@ -333,6 +366,7 @@ alia_ui_next_wake_ns(alia_ui_system* ui, alia_nanosecond_count* out_wake_ns)
     ALIA_ASSERT(ui);
     ALIA_ASSERT(out_wake_ns);
 
+    alia::enqueue_text_completions(*ui);
     if (!ui->event_queue.empty())
     {
         *out_wake_ns = ui->tick_count;
@@ -348,6 +382,14 @@ alia_ui_next_wake_ns(alia_ui_system* ui, alia_nanosecond_count* out_wake_ns)
     return false;
 }
 
+alia_substrate_sweep_progress
+alia_ui_sweep_keys(alia_ui_system* ui, alia_substrate_sweep_budget budget)
+{
+    ALIA_ASSERT(ui);
+    return alia_substrate_sweep_system_keys_incrementally(
+        &ui->substrate, budget);
+}
+
 void
 alia_ui_enqueue_event(alia_ui_system* ui, alia_event const* event)
 {
@@ -0,0 +1,184 @@
+#include <alia/ui/text/block_cache.h>
+
+#include <alia/abi/prelude.h>
+#include <alia/ui/system/object.h>
+
+#include <cstring>
+
+namespace alia {
+
+namespace {
+
+bool
+key_matches(shared_text_block const& block, text_block_key const& key)
+{
+    return block.engine == key.engine
+        && block.engine_handle == key.engine_handle
+        && block.physical_size == key.physical_size
+        && block.text.size() == key.length
+        && (key.length == 0
+            || std::memcmp(block.text.data(), key.text, key.length) == 0);
+}
+
+// The core can't see how much memory an engine uses for a block, so this
+// assumes that the block holds a copy of the text plus its segments.
+size_t
+estimate_block_size(text_block_key const& key, alia_text_block* block)
+{
+    int const segment_count
+        = key.engine->vtable->segment_count(key.engine, block);
+    return sizeof(shared_text_block) + 2 * key.length
+         + size_t(segment_count) * sizeof(alia_text_segment);
+}
+
+void
+lru_unlink(shared_text_block_cache& cache, shared_text_block* block)
+{
+    if (block->lru_prev)
+        block->lru_prev->lru_next = block->lru_next;
+    else
+        cache.lru_head = block->lru_next;
+    if (block->lru_next)
+        block->lru_next->lru_prev = block->lru_prev;
+    else
+        cache.lru_tail = block->lru_prev;
+    block->lru_prev = nullptr;
+    block->lru_next = nullptr;
+}
+
+void
+lru_push_back(shared_text_block_cache& cache, shared_text_block* block)
+{
+    block->lru_prev = cache.lru_tail;
+    block->lru_next = nullptr;
+    if (cache.lru_tail)
+        cache.lru_tail->lru_next = block;
+    else
+        cache.lru_head = block;
+    cache.lru_tail = block;
+}
+
+void
+evict(shared_text_block_cache& cache, shared_text_block* block)
+{
+    ALIA_ASSERT(block->reference_count == 0);
+    lru_unlink(cache, block);
+    auto [first, last] = cache.blocks.equal_range(block->hash);
+    for (auto i = first; i != last; ++i)
+    {
+        if (i->second == block)
+        {
+            cache.blocks.erase(i);
+            break;
+        }
+    }
+    block->engine->vtable->release_block(block->engine, block->block);
+    --cache.stats.resident_blocks;
+    cache.stats.resident_bytes -= block->size;
+    ++cache.stats.evictions;
+    delete block;
+}
+
+} // namespace
+
+shared_text_block*
+find_shared_text_block(
+    shared_text_block_cache& cache, text_block_key const& key)
+{
+    auto [first, last] = cache.blocks.equal_range(key.hash);
+    for (auto i = first; i != last; ++i)
+    {
+        shared_text_block* block = i->second;
+        if (key_matches(*block, key))
+        {
+            if (block->reference_count == 0)
+                lru_unlink(cache, block);
+            ++block->reference_count;
+            ++cache.stats.hits;
+            return block;
+        }
+    }
+    ++cache.stats.misses;
+    return nullptr;
+}
+
+shared_text_block*
+add_shared_text_block(
+    shared_text_block_cache& cache,
+    text_block_key const& key,
+    alia_text_block* block)
+{
+    auto* shared = new shared_text_block{
+        .engine = key.engine,
+        .engine_handle = key.engine_handle,
+        .physical_size = key.physical_size,
+        .text = std::vector<char>(key.text, key.text + key.length),
+        .hash = key.hash,
+        .block = block,
+        .reference_count = 1,
+        .size = estimate_block_size(key, block),
+        .lru_prev = nullptr,
+        .lru_next = nullptr};
+    cache.blocks.emplace(key.hash, shared);
+    ++cache.stats.resident_blocks;
+    cache.stats.resident_bytes += shared->size;
+    trim_shared_text_blocks(cache, cache.budget);
+    return shared;
+}
+
+void
+release_shared_text_block(
+    shared_text_block_cache& cache, shared_text_block* block)
+{
+    ALIA_ASSERT(block->reference_count > 0);
+    if (--block->reference_count == 0)
+    {
+        lru_push_back(cache, block);
+        trim_shared_text_blocks(cache, cache.budget);
+    }
+}
+
+void
+trim_shared_text_blocks(shared_text_block_cache& cache, size_t budget)
+{
+    while (cache.stats.resident_bytes > budget && cache.lru_head)
+        evict(cache, cache.lru_head);
+}
+
+} // namespace alia
+
+extern "C" {
+
+void
+alia_ui_set_text_block_cache_budget(alia_ui_system* system, size_t bytes)
+{
+    ALIA_ASSERT(system);
+    system->text_blocks.budget = bytes;
+    alia::trim_shared_text_blocks(system->text_blocks, bytes);
+}
+
+void
+alia_ui_clear_text_block_cache(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    alia::trim_shared_text_blocks(system->text_blocks, 0);
+}
+
+alia_text_block_cache_stats
+alia_ui_get_text_block_cache_stats(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    return system->text_blocks.stats;
+}
+
+void
+alia_ui_reset_text_block_cache_stats(alia_ui_system* system)
+{
+    ALIA_ASSERT(system);
+    alia_text_block_cache_stats& stats = system->text_blocks.stats;
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+}
+
+} // extern "C"
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <alia/abi/ui/text.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// SHARED TEXT BLOCKS
+//
+// The same strings tend to show up all over a UI (e.g., "OK" in every row of
+// a table, or unit suffixes), so rather than each `alia_text` call site
+// preparing its own block, call sites share blocks through a system-wide
+// cache. Blocks are keyed by engine handle, physical size and content, and
+// they're reference counted. A block that's no longer referenced stays in the
+// cache (in case it's wanted again) until it's evicted, least recently used
+// first, to keep the cache within its memory budget.
+//
+// Blocks that an engine prepares in the background belong to their call
+// sites and aren't shared. (They're only used for large text, which is
+// unlikely to repeat and would blow through the budget anyway.)
+
+namespace alia {
+
+// everything that identifies a prepared block
+struct text_block_key
+{
+    alia_text_engine* engine;
+    void* engine_handle;
+    float physical_size;
+    char const* text;
+    size_t length;
+    // a hash of all of the above
+    uint64_t hash;
+};
+
+struct shared_text_block
+{
+    alia_text_engine* engine;
+    void* engine_handle;
+    float physical_size;
+    std::vector<char> text;
+    uint64_t hash;
+    alia_text_block* block;
+    // the number of call sites using the block
+    size_t reference_count;
+    // the estimated memory used by the block (including this record)
+    size_t size;
+    // neighbors in the cache's list of unreferenced blocks
+    shared_text_block* lru_prev;
+    shared_text_block* lru_next;
+};
+
+size_t const default_text_block_cache_budget = 8 * 1024 * 1024;
+
+struct shared_text_block_cache
+{
+    std::unordered_multimap<uint64_t, shared_text_block*> blocks;
+    // the unreferenced blocks, from least to most recently used
+    shared_text_block* lru_head = nullptr;
+    shared_text_block* lru_tail = nullptr;
+    size_t budget = default_text_block_cache_budget;
+    alia_text_block_cache_stats stats{};
+};
+
+// Find the block for `key` and take a reference to it. Returns null if it's
+// not in the cache.
+shared_text_block*
+find_shared_text_block(
+    shared_text_block_cache& cache, text_block_key const& key);
+
+// Add a newly prepared block for `key` to the cache and take a reference to
+// it. (The cache takes ownership of `block`.)
+shared_text_block*
+add_shared_text_block(
+    shared_text_block_cache& cache,
+    text_block_key const& key,
+    alia_text_block* block);
+
+void
+release_shared_text_block(
+    shared_text_block_cache& cache, shared_text_block* block);
+
+// Evict unreferenced blocks until the cache is within `budget`.
+void
+trim_shared_text_blocks(shared_text_block_cache& cache, size_t budget);
+
+} // namespace alia
@@ -0,0 +1,50 @@
+#include <alia/ui/text/completions.h>
+
+#include <alia/abi/ui/events.h>
+#include <alia/abi/ui/system/work.h>
+#include <alia/ui/system/object.h>
+
+namespace alia {
+
+uint64_t
+next_text_completion_serial(alia_ui_system& ui)
+{
+    return ++ui.text_completions.last_serial;
+}
+
+void
+post_text_completion(alia_ui_system& ui, text_completion completion)
+{
+    text_completion_queue& queue = ui.text_completions;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.completions.push_back(completion);
+        queue.pending.store(true, std::memory_order_release);
+    }
+    if (ui.host_window.wake)
+        ui.host_window.wake(ui.host_window.user);
+}
+
+bool
+enqueue_text_completions(alia_ui_system& ui)
+{
+    text_completion_queue& queue = ui.text_completions;
+    if (!queue.pending.load(std::memory_order_acquire))
+        return false;
+
+    std::vector<text_completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        completions.swap(queue.completions);
+        queue.pending.store(false, std::memory_order_relaxed);
+    }
+    for (text_completion const& completion : completions)
+    {
+        alia_event const event = alia_make_text_block_ready_event(
+            {.target = completion.target, .serial = completion.serial});
+        alia_ui_enqueue_event(&ui, &event);
+    }
+    return !completions.empty();
+}
+
+} // namespace alia
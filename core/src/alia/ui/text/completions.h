@@ -0,0 +1,55 @@
+#pragma once
+
+#include <alia/abi/kernel/routing.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct alia_ui_system;
+
+// BACKGROUND TEXT COMPLETIONS
+//
+// Text engines finish preparing blocks on their own worker threads, but the
+// event queue belongs to the UI thread. Completions are collected here and
+// turned into `ALIA_EVENT_TEXT_BLOCK_READY` events the next time the UI
+// thread looks for work.
+
+namespace alia {
+
+// `serial` identifies the preparation that completed. Serials are unique
+// within the system, so a completion from an abandoned preparation can't be
+// mistaken for one from its replacement.
+struct text_completion
+{
+    alia_element_id target;
+    uint64_t serial;
+};
+
+struct text_completion_queue
+{
+    std::mutex mutex;
+    // protected by `mutex`
+    std::vector<text_completion> completions;
+    // set while `completions` is nonempty, so that the UI thread can check
+    // for completions without locking
+    std::atomic<bool> pending{false};
+    // the last serial handed out (only used on the UI thread)
+    uint64_t last_serial = 0;
+};
+
+// Get a serial for a new preparation.
+uint64_t
+next_text_completion_serial(alia_ui_system& ui);
+
+// Record a completion and wake the host. This may be called from any thread.
+void
+post_text_completion(alia_ui_system& ui, text_completion completion);
+
+// Enqueue events for the recorded completions. Returns true if there were
+// any.
+bool
+enqueue_text_completions(alia_ui_system& ui);
+
+} // namespace alia
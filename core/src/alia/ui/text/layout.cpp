@@ -1,9 +1,11 @@
 #include <alia/abi/ui/text.h>
 
+#include <alia/abi/kernel/components.h>
 #include <alia/abi/kernel/ids.h>
 #include <alia/abi/kernel/routing.h>
 #include <alia/abi/kernel/substrate.h>
 #include <alia/abi/ui/context.h>
+#include <alia/abi/ui/drawing/commands.h>
 #include <alia/abi/ui/geometry.h>
 #include <alia/abi/ui/input/regions.h>
 #include <alia/abi/ui/layout/api.h>
@@ -16,6 +18,12 @@
 
 #include <alia/impl/base/arena.hpp>
 #include <alia/impl/events.hpp>
+#include <alia/ui/layout/cache.h>
+#include <alia/ui/system/object.h>
+#include <alia/ui/text/block_cache.h>
+#include <alia/ui/text/completions.h>
+
+#include <cstring>
 
 namespace alia {
 
@@ -25,6 +33,11 @@ namespace alia {
 // - never have to reach back for the active font or geometry scale. The
 // prepared `block` and `engine` are borrowed from the per-call-site substrate
 // cache (see `text_block_cache`), which outlives any single layout resolution.
+//
+// While the block is being prepared in the background, `block` is null, and
+// the node stands in for the text with estimated metrics: `estimated_lines`
+// lines whose widths add up to `estimated_width`. It doesn't place any
+// fragments, so nothing is drawn or hit tested until the block arrives.
 struct text_layout_node
 {
     alia_layout_node base;
@@ -41,6 +54,8 @@ struct text_layout_node
     float line_height;
     float ascender;
     float descender;
+    float estimated_width;
+    int estimated_lines;
 };
 
 // Placement records are written into the placement arena during layout
@@ -66,6 +81,8 @@ struct text_placement_fragment
 static float
 text_measure_total_width(text_layout_node const& node)
 {
+    if (!node.block)
+        return node.estimated_width;
     alia_text_engine* engine = node.engine;
     int const count = engine->vtable->segment_count(engine, node.block);
     float total = 0.f;
@@ -140,7 +157,9 @@ text_assign_boxes(
         alia_vec2f_add(box.min, placement.min), placement.size};
 
     auto* header = arena_alloc<text_placement_header>(ctx->arena);
-    header->fragment_count = 1;
+    header->fragment_count = text.block ? 1 : 0;
+    if (!text.block)
+        return;
     auto* frag = arena_alloc<text_placement_fragment>(ctx->arena);
     frag->box = resolved;
     frag->baseline_origin
@@ -158,7 +177,9 @@ text_count_flow_emissions(
     (void) ctx;
     auto& text = *reinterpret_cast<text_layout_node*>(node);
     int const count
-        = text.engine->vtable->segment_count(text.engine, text.block);
+        = text.block
+            ? text.engine->vtable->segment_count(text.engine, text.block)
+            : text.estimated_lines;
     return alia_flow_emission_counts_with_run_scope(
         alia_flow_emission_counts{.fragment_count = count});
 }
@@ -178,6 +199,34 @@ text_emit_flow_fragments(
         emitter,
         alia_edge_offsets{.left = text.spacing, .right = text.spacing});
 
+    if (!text.block)
+    {
+        alia_line_requirements const line
+            = alia_layout_line_requirements_with_run_offsets(
+                emitter,
+                alia_line_requirements{
+                    .height = text.line_height,
+                    .ascent = text.ascender,
+                    .descent = -text.descender});
+        float const line_width
+            = text.estimated_width / float(text.estimated_lines);
+        for (int i = 0; i < text.estimated_lines; ++i)
+        {
+            alia_flow_fragment fragment;
+            fragment.kind = ALIA_FLOW_FRAGMENT_KIND_CONTENT;
+            fragment.content = alia_layout_content_metrics{
+                .size = alia_vec2f{line_width, line.height},
+                .ascent = line.ascent,
+                .descent = line.descent};
+            fragment.flags = i + 1 < text.estimated_lines
+                               ? ALIA_FLOW_FRAGMENT_BREAK_AFTER
+                               : 0;
+            alia_layout_emit_flow_fragment(emitter, fragment);
+        }
+        alia_flow_emit_run_pop_control(emitter);
+        return;
+    }
+
     int const count = engine->vtable->segment_count(engine, text.block);
     for (int i = 0; i < count; ++i)
     {
@@ -234,6 +283,14 @@ text_read_fragment_placements(
     auto* header = arena_alloc<text_placement_header>(ctx->arena);
     header->fragment_count = 0;
 
+    if (!text.block)
+    {
+        for (int i = 0; i < text.estimated_lines; ++i)
+            alia_layout_advance_fragment(reader);
+        alia_layout_skip_flow_run_pop_fragment(reader);
+        return;
+    }
+
     int const count = engine->vtable->segment_count(engine, text.block);
     for (int i = 0; i < count; ++i)
     {
@@ -276,40 +333,145 @@ static alia_layout_node_vtable text_layout_vtable
        text_assign_boxes,
        text_count_flow_emissions,
        text_emit_flow_fragments,
-       text_read_fragment_placements};
+       text_read_fragment_placements,
+       false,
+       "text_layout"};
 
 // PER-CALL-SITE BLOCK CACHE (Tier B)
 
 // One of these lives in the substrate at each `alia_text` call site. It holds
-// the engine's prepared block across frames and the keys that determine when
-// it must be rebuilt: the content (`value_id`), the typeface
+// the call site's prepared block across frames and the keys that determine
+// when it must be looked up again: the content (`value_id`), the typeface
 // (`engine_handle`), and the physical size (which folds in the geometry scale,
 // since the block is prepared - and drawn - in physical pixels).
+//
+// The block itself usually belongs to the system-wide cache (see
+// `alia/ui/text/block_cache.h`), and the call site just holds a reference to
+// it. If the engine prepares the block in the background, though, the call
+// site holds the preparation until its completion event arrives, and then it
+// owns the block.
 struct text_block_cache
 {
     alia_text_engine* engine;
     alia_text_block* block;
+    // the shared block that `block` belongs to (if any)
+    shared_text_block* shared;
+    alia_text_preparation* preparation;
+    // identifies the current preparation in its completion event
+    uint64_t preparation_serial;
+    // set once the current preparation's completion event has arrived
+    bool preparation_ready;
+    // the system that `shared` belongs to and where completions are sent -
+    // These are read from the engine's worker threads, so they mustn't change
+    // while a preparation is in progress.
+    alia_ui_system* ui;
+    alia_element_id id;
+    // the placeholder metrics for the layout node (in physical pixels)
+    float estimated_width;
+    int estimated_lines;
     void* engine_handle;
     float physical_size;
     // resolved byte length of the prepared text (a null-terminated signal's
     // length is computed here, once, when the block is prepared)
     size_t text_length;
+    // a hash of the prepared text and the keys above (which is also the
+    // block's hash in the shared cache and the basis for the layout node's
+    // content hash)
+    uint64_t content_hash;
     alia_captured_id value_id;
 };
 
+// Release the cache's block (or abandon its preparation).
 static void
-text_block_cache_cleanup(
-    alia_substrate_system*, void* payload, alia_substrate_cleanup_mode)
+text_block_cache_discard_block(text_block_cache* cache)
 {
-    auto* cache = reinterpret_cast<text_block_cache*>(payload);
-    if (cache->block && cache->engine)
+    if (!cache->engine)
+        return;
+    if (cache->shared)
+    {
+        release_shared_text_block(cache->ui->text_blocks, cache->shared);
+        cache->shared = nullptr;
+        cache->block = nullptr;
+    }
+    else if (cache->block)
     {
         cache->engine->vtable->release_block(cache->engine, cache->block);
         cache->block = nullptr;
     }
+    if (cache->preparation)
+    {
+        cache->engine->vtable->cancel_prepare_block(
+            cache->engine, cache->preparation);
+        cache->preparation = nullptr;
+    }
+}
+
+static void
+text_block_cache_cleanup(
+    alia_substrate_system*, void* payload, alia_substrate_cleanup_mode)
+{
+    auto* cache = reinterpret_cast<text_block_cache*>(payload);
+    text_block_cache_discard_block(cache);
     alia_captured_id_release(&cache->value_id);
 }
 
+// This is called on the engine's worker thread when a preparation finishes.
+static void
+text_block_cache_preparation_ready(void* user)
+{
+    auto const* cache = reinterpret_cast<text_block_cache const*>(user);
+    post_text_completion(
+        *cache->ui,
+        text_completion{
+            .target = cache->id, .serial = cache->preparation_serial});
+}
+
+// a rough average advance (in ems) for a byte of text, for estimating the
+// size of text that's still being prepared
+float const placeholder_advance = 0.5f;
+
+// Start preparing `text` in the background (if the engine is willing) and
+// set up the placeholder metrics.
+static void
+text_block_cache_begin_preparation(
+    alia_context* ctx,
+    text_block_cache* cache,
+    alia_element_id id,
+    float em_size,
+    char const* text,
+    size_t length)
+{
+    alia_text_engine* engine = cache->engine;
+    if (!engine->vtable->begin_prepare_block)
+        return;
+
+    size_t newlines = 0;
+    for (char const* p = text;
+         (p = static_cast<char const*>(
+              std::memchr(p, '\n', size_t(text + length - p))))
+         != nullptr;
+         ++p)
+    {
+        ++newlines;
+    }
+    cache->estimated_width
+        = float(length - newlines) * placeholder_advance * em_size;
+    cache->estimated_lines = int(newlines) + 1;
+
+    cache->id = id;
+    cache->preparation_serial = next_text_completion_serial(*ctx->system);
+    cache->preparation_ready = false;
+    cache->preparation = engine->vtable->begin_prepare_block(
+        engine,
+        cache->engine_handle,
+        cache->physical_size,
+        ALIA_TEXT_DIRECTION_LTR,
+        text,
+        length,
+        text_block_cache_preparation_ready,
+        cache);
+}
+
 } // namespace alia
 
 using namespace alia;
@@ -373,9 +535,7 @@ alia_text(
             || cache->physical_size != physical_size
             || !alia_captured_id_matches_view(&cache->value_id, text.value_id))
         {
-            if (cache->block && cache->engine)
-                cache->engine->vtable->release_block(
-                    cache->engine, cache->block);
+            text_block_cache_discard_block(cache);
             alia_captured_id_release(&cache->value_id);
 
             // Capture the ID.
@@ -393,23 +553,64 @@ alia_text(
                     ? (text.text ? strlen(text.text) : 0)
                     : text.length;
 
+            cache->ui = ctx->system;
             cache->engine = engine;
             cache->engine_handle = engine_handle;
             cache->physical_size = physical_size;
             cache->text_length = length;
-            cache->block = engine->vtable->prepare_block(
-                engine,
-                engine_handle,
-                physical_size,
-                ALIA_TEXT_DIRECTION_LTR,
-                text.text,
-                length);
+            cache->content_hash = layout_hash_value(
+                layout_hash_value(
+                    layout_hash_bytes(layout_hash_seed, text.text, length),
+                    engine_handle),
+                physical_size);
+
+            // Share an existing block if there is one. Otherwise, prepare
+            // one (in the background, if the engine is willing).
+            text_block_key const key{
+                .engine = engine,
+                .engine_handle = engine_handle,
+                .physical_size = physical_size,
+                .text = text.text,
+                .length = length,
+                .hash = cache->content_hash};
+            shared_text_block_cache& shared_blocks = ctx->system->text_blocks;
+            cache->shared = find_shared_text_block(shared_blocks, key);
+            if (!cache->shared)
+            {
+                text_block_cache_begin_preparation(
+                    ctx,
+                    cache,
+                    id,
+                    font->metrics.em_size * geometry_scale,
+                    text.text,
+                    length);
+            }
+            if (!cache->shared && !cache->preparation)
+            {
+                cache->shared = add_shared_text_block(
+                    shared_blocks,
+                    key,
+                    engine->vtable->prepare_block(
+                        engine,
+                        engine_handle,
+                        physical_size,
+                        ALIA_TEXT_DIRECTION_LTR,
+                        text.text,
+                        length));
+            }
+            if (cache->shared)
+                cache->block = cache->shared->block;
+        }
+        else if (cache->preparation && cache->preparation_ready)
+        {
+            cache->block = engine->vtable->finish_prepare_block(
+                engine, cache->preparation);
+            cache->preparation = nullptr;
         }
 
         auto& emission = ctx->layout->emission;
         auto* node = arena_alloc<text_layout_node>(emission.arena);
-        *emission.next_ptr = &node->base;
-        emission.next_ptr = &node->base.next_sibling;
+        alia_layout_emit_node(&emission, &node->base);
         *node = text_layout_node{
             .base = {.vtable = &text_layout_vtable, .next_sibling = nullptr},
             .flags = flags,
@@ -420,7 +621,21 @@ alia_text(
             .font_size = physical_size,
             .line_height = font->metrics.line_height * geometry_scale,
             .ascender = font->metrics.ascender * geometry_scale,
-            .descender = font->metrics.descender * geometry_scale};
+            .descender = font->metrics.descender * geometry_scale,
+            .estimated_width = cache->estimated_width,
+            .estimated_lines = cache->estimated_lines};
+        // The placeholder and the real block lay out differently, so they
+        // can't share cached layout results.
+        node->base.content_hash = layout_hash_node(
+            &text_layout_vtable,
+            layout_hash_value(cache->content_hash, cache->block != nullptr),
+            node->flags,
+            node->spacing,
+            node->engine,
+            node->font_size,
+            node->line_height,
+            node->ascender,
+            node->descender);
         return;
     }
 
@@ -446,6 +661,7 @@ alia_text(
             case ALIA_CATEGORY_DRAWING: {
                 alia_srgba8 const color = alia_palette_color_resolve(
                     alia_ctx_palette(ctx), effective_style->color);
+                alia_draw_note_bounds(ctx, frag->box);
                 cache->engine->vtable->draw_block_range(
                     cache->engine,
                     ctx,
@@ -462,6 +678,19 @@ alia_text(
                 break;
         }
     }
+
+    // Pick up the block from a finished background preparation on the next
+    // refresh.
+    if (get_event_type(*ctx) == ALIA_EVENT_TEXT_BLOCK_READY)
+    {
+        alia_text_block_ready const& ready = as_text_block_ready_event(*ctx);
+        if (cache->preparation && alia_element_id_equal(ready.target, id)
+            && ready.serial == cache->preparation_serial)
+        {
+            cache->preparation_ready = true;
+            alia_component_mark_dirty(ctx);
+        }
+    }
 }
 
 ALIA_EXTERN_C_END
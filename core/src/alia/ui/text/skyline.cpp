@@ -0,0 +1,107 @@
+#include <alia/ui/text/skyline.h>
+
+#include <alia/abi/prelude.h>
+
+namespace alia {
+
+namespace {
+
+// Get the height at which a rectangle of `width` would rest if its left edge
+// were at the start of segment `index`, or -1 if it would hang off the right
+// edge of the region.
+int
+resting_height(skyline_packer const& packer, size_t index, int width)
+{
+    int const x = packer.skyline[index].x;
+    if (x + width > packer.width)
+        return -1;
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; ++i)
+    {
+        ALIA_ASSERT(i < packer.skyline.size());
+        skyline_segment const& segment = packer.skyline[i];
+        if (segment.y > y)
+            y = segment.y;
+        remaining -= segment.width;
+    }
+    return y;
+}
+
+} // namespace
+
+void
+skyline_reset(skyline_packer& packer, int width, int height)
+{
+    packer.width = width;
+    packer.height = height;
+    packer.skyline.assign(1, {.x = 0, .y = 0, .width = width});
+}
+
+bool
+skyline_pack(skyline_packer& packer, int width, int height, int* x, int* y)
+{
+    ALIA_ASSERT(width > 0 && height > 0);
+
+    // Find the lowest spot, breaking ties in favor of the narrowest segment
+    // (which wastes the least space beside the rectangle).
+    size_t best_index = 0;
+    int best_y = -1;
+    int best_width = 0;
+    for (size_t i = 0; i != packer.skyline.size(); ++i)
+    {
+        int const resting_y = resting_height(packer, i, width);
+        if (resting_y < 0 || resting_y + height > packer.height)
+            continue;
+        int const segment_width = packer.skyline[i].width;
+        if (best_y < 0 || resting_y < best_y
+            || (resting_y == best_y && segment_width < best_width))
+        {
+            best_index = i;
+            best_y = resting_y;
+            best_width = segment_width;
+        }
+    }
+    if (best_y < 0)
+        return false;
+
+    // Raise the skyline over the rectangle, trimming away the segments (or
+    // parts of segments) that it covers.
+    int const left = packer.skyline[best_index].x;
+    int const right = left + width;
+    auto& skyline = packer.skyline;
+    skyline.insert(
+        skyline.begin() + best_index,
+        {.x = left, .y = best_y + height, .width = width});
+    size_t i = best_index + 1;
+    while (i != skyline.size() && skyline[i].x < right)
+    {
+        int const segment_right = skyline[i].x + skyline[i].width;
+        if (segment_right <= right)
+        {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+        skyline[i].width = segment_right - right;
+        skyline[i].x = right;
+        break;
+    }
+
+    // Merge neighboring segments that ended up at the same height.
+    for (size_t j = 0; j + 1 < skyline.size();)
+    {
+        if (skyline[j].y == skyline[j + 1].y)
+        {
+            skyline[j].width += skyline[j + 1].width;
+            skyline.erase(skyline.begin() + j + 1);
+        }
+        else
+            ++j;
+    }
+
+    *x = left;
+    *y = best_y;
+    return true;
+}
+
+} // namespace alia
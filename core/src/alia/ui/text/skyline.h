@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+// SKYLINE PACKING
+//
+// A skyline packer places rectangles into a fixed-size region by tracking
+// only the top edge (the "skyline") of what's been placed so far, as a list
+// of horizontal segments. Each rectangle goes wherever it would sit lowest
+// (the bottom-left heuristic), so glyph-sized rectangles fill the region in
+// rough rows without any per-pixel bookkeeping. Space under the skyline
+// that a rectangle overhangs is lost, and nothing can be removed
+// individually: the whole region is reset at once.
+
+namespace alia {
+
+struct skyline_segment
+{
+    int x;
+    int y;
+    int width;
+};
+
+struct skyline_packer
+{
+    int width = 0;
+    int height = 0;
+    // the top edge of the packed rectangles, from left to right - The
+    // segments always span the full width.
+    std::vector<skyline_segment> skyline;
+};
+
+// Reset `packer` to an empty region of the given size.
+void
+skyline_reset(skyline_packer& packer, int width, int height);
+
+// Find a spot for a `width` x `height` rectangle and claim it, returning
+// its lower-left corner in `x` and `y`. Returns false (and leaves `packer`
+// untouched) if it doesn't fit.
+bool
+skyline_pack(skyline_packer& packer, int width, int height, int* x, int* y);
+
+} // namespace alia
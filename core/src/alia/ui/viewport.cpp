@@ -91,6 +91,9 @@ alia_do_viewport(
                     ALIA_MIN_ALIGNED_SIZE(sizeof(alia_viewport_draw_command)));
             command->region = box;
             command->scene_to_surface = alia_affine2_identity();
+            // The scene isn't part of the command, so there's no telling
+            // when it changes.
+            alia_draw_note_volatile(ctx, box);
             break;
         }
     }
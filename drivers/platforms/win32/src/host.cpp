@@ -761,6 +761,14 @@ host_toggle_fullscreen_cb(void* user)
     host_toggle_fullscreen(static_cast<alia_win32_host*>(user));
 }
 
+// This is called from other threads, so it just nudges the message loop, which
+// then checks for work.
+void
+host_wake_cb(void* user)
+{
+    PostMessageW(static_cast<alia_win32_host*>(user)->hwnd, WM_NULL, 0, 0);
+}
+
 bool
 host_should_tick(alia_win32_host* host)
 {
@@ -1245,6 +1253,7 @@ alia_win32_host_run(
         alia_win32_host_install(host, config->ui);
         alia_host_window_ops const ops = {
             .toggle_fullscreen = host_toggle_fullscreen_cb,
+            .wake = host_wake_cb,
             .user = host,
         };
         alia_ui_system_set_host_window_ops(config->ui, &ops);
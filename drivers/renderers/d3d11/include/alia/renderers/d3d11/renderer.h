@@ -33,6 +33,11 @@ void
 alia_d3d11_renderer_upload_msdf_atlas(
     alia_d3d11_renderer* renderer, alia_msdf_atlas_image const* image);
 
+// Update a region of the MSDF atlas (which must already be uploaded).
+void
+alia_d3d11_renderer_update_msdf_atlas(
+    alia_d3d11_renderer* renderer, alia_msdf_atlas_region const* region);
+
 // Native-source hatch: compile HLSL to DXBC and register. Prefer
 // `alia_ui_register_effect` with format `ALIA_FOURCC('D','X','B','C')` for
 // portable registration. The pixel shader should declare:
@@ -1045,8 +1045,24 @@ render_primitive_command_list(void* user, alia_draw_bucket const* bucket)
 
     alia_bump_allocator rect_alloc;
     alia_bump_allocator_init(&rect_alloc, &renderer->rect_instance_arena);
+    // Glyph runs expand to one instance per glyph, so count instances
+    // rather than commands.
+    size_t instance_count = 0;
+    for (auto const* cmd = bucket->head; cmd; cmd = cmd->next)
+    {
+        auto const* primitive
+            = alia::downcast<alia_draw_primitive_command>(cmd);
+        if (primitive->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN)
+        {
+            instance_count
+                += alia::downcast<alia_draw_msdf_glyph_run_command>(cmd)
+                       ->count;
+        }
+        else
+            ++instance_count;
+    }
     auto* instances = alia::arena_alloc_array<primitive_instance>(
-        rect_alloc, bucket->count);
+        rect_alloc, instance_count);
 
     auto pack_border_color = [](alia_srgba8 c) -> float {
         uint32_t packed = uint32_t(c.r) | (uint32_t(c.g) << 8u)
@@ -1062,6 +1078,35 @@ render_primitive_command_list(void* user, alia_draw_bucket const* bucket)
         auto const* primitive
             = alia::downcast<alia_draw_primitive_command>(cmd);
 
+        if (primitive->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN)
+        {
+            auto const* run
+                = alia::downcast<alia_draw_msdf_glyph_run_command>(cmd);
+            alia_msdf_glyph_run_entry const* entries
+                = alia_msdf_glyph_run_entries(run);
+            for (uint32_t i = 0; i != run->count; ++i)
+            {
+                alia_box const box
+                    = alia_msdf_glyph_run_entry_box(run, entries[i]);
+                alia_msdf_glyph_metrics const& glyph
+                    = run->glyphs[entries[i].glyph];
+                primitive_instance& inst = instances[written++];
+                inst.min[0] = box.min.x;
+                inst.min[1] = box.min.y;
+                inst.size[0] = box.size.x;
+                inst.size[1] = box.size.y;
+                inst.color[0] = run->color.r / 255.f;
+                inst.color[1] = run->color.g / 255.f;
+                inst.color[2] = run->color.b / 255.f;
+                inst.color[3] = run->color.a / 255.f;
+                inst.primitive_type = int(ALIA_PRIMITIVE_MSDF_GLYPH);
+                std::memcpy(inst.data_a, glyph.uv_rect, sizeof(inst.data_a));
+                std::memset(inst.data_b, 0, sizeof(inst.data_b));
+                inst.data_b[0] = run->sdf_scale;
+            }
+            continue;
+        }
+
         primitive_instance& inst = instances[written++];
         inst.min[0] = primitive->box.min.x;
         inst.min[1] = primitive->box.min.y;
@@ -1468,6 +1513,11 @@ alia_d3d11_renderer_attach(
                 alia_d3d11_renderer_upload_msdf_atlas(
                     static_cast<alia_d3d11_renderer*>(user), image);
             },
+        .update_msdf_atlas =
+            [](void* user, alia_msdf_atlas_region const* region) {
+                alia_d3d11_renderer_update_msdf_atlas(
+                    static_cast<alia_d3d11_renderer*>(user), region);
+            },
         .register_effect =
             [](void* user,
                alia_effect_desc const* desc,
@@ -1557,7 +1607,8 @@ alia_d3d11_renderer_upload_msdf_atlas(
     td.ArraySize = 1;
     td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     td.SampleDesc.Count = 1;
-    td.Usage = D3D11_USAGE_IMMUTABLE;
+    // (This isn't immutable, since dynamic glyphs are added to it later.)
+    td.Usage = D3D11_USAGE_DEFAULT;
     td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
     D3D11_SUBRESOURCE_DATA init{};
@@ -1581,6 +1632,40 @@ alia_d3d11_renderer_upload_msdf_atlas(
     }
 }
 
+void
+alia_d3d11_renderer_update_msdf_atlas(
+    alia_d3d11_renderer* renderer, alia_msdf_atlas_region const* region)
+{
+    ALIA_ASSERT(renderer);
+    ALIA_ASSERT(region);
+    ALIA_ASSERT(region->rgb);
+    if (!renderer->msdf_atlas || !renderer->context)
+        return;
+
+    int const width = region->width;
+    int const height = region->height;
+    // D3D11 has no RGB8 texture format; pad to RGBA8.
+    std::vector<uint8_t> rgba(size_t(width) * size_t(height) * 4u);
+    uint8_t const* rgb = region->rgb;
+    for (int i = 0; i < width * height; ++i)
+    {
+        rgba[size_t(i) * 4u + 0] = rgb[size_t(i) * 3u + 0];
+        rgba[size_t(i) * 4u + 1] = rgb[size_t(i) * 3u + 1];
+        rgba[size_t(i) * 4u + 2] = rgb[size_t(i) * 3u + 2];
+        rgba[size_t(i) * 4u + 3] = 255;
+    }
+
+    D3D11_BOX box{};
+    box.left = UINT(region->x);
+    box.top = UINT(region->y);
+    box.front = 0;
+    box.right = UINT(region->x + width);
+    box.bottom = UINT(region->y + height);
+    box.back = 1;
+    renderer->context->UpdateSubresource(
+        renderer->msdf_atlas, 0, &box, rgba.data(), UINT(width) * 4u, 0);
+}
+
 void
 alia_d3d11_renderer_destroy(alia_d3d11_renderer* renderer)
 {
@@ -28,6 +28,11 @@ void
 alia_gl_renderer_upload_msdf_atlas(
     alia_gl_renderer* renderer, alia_msdf_atlas_image const* image);
 
+// Update a region of the MSDF atlas (which must already be uploaded).
+void
+alia_gl_renderer_update_msdf_atlas(
+    alia_gl_renderer* renderer, alia_msdf_atlas_region const* region);
+
 // Native-source hatch: compile `fragment_shader_source` (body-only; version
 // prepended) and register. Prefer `alia_ui_register_effect` with format
 // `ALIA_FOURCC('G','L','E','S')` for portable registration.
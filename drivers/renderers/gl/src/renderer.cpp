@@ -17,6 +17,7 @@
 
 // TODO: Remove these.
 #include <alia/ui/drawing/system.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <memory>
@@ -405,6 +406,185 @@ ensure_present_pipeline(alia_gl_renderer* renderer)
     return true;
 }
 
+// the number of instances that each frame's segment of the instance ring
+// starts out with room for
+size_t const initial_instance_ring_segment_size = 4096;
+
+bool
+buffer_storage_available()
+{
+#if defined(__EMSCRIPTEN__) || !defined(GL_MAP_PERSISTENT_BIT)
+    return false;
+#else
+    return glBufferStorage != nullptr;
+#endif
+}
+
+void
+instance_ring_create(gl_instance_ring& ring, size_t segment_size)
+{
+    ring.segment_size = segment_size;
+    ring.segment = 0;
+    ring.offset = 0;
+    ring.mapped = nullptr;
+    glGenBuffers(1, &ring.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+#if !defined(__EMSCRIPTEN__) && defined(GL_MAP_PERSISTENT_BIT)
+    if (buffer_storage_available())
+    {
+        GLbitfield const flags
+            = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr const size
+            = GLsizeiptr(segment_size * gl_instance_ring_frames);
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        ring.mapped = static_cast<uint8_t*>(
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+        return;
+    }
+#endif
+    glBufferData(
+        GL_ARRAY_BUFFER, GLsizeiptr(segment_size), nullptr, GL_STREAM_DRAW);
+}
+
+void
+instance_ring_destroy(gl_instance_ring& ring)
+{
+    for (GLsync& fence : ring.fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (ring.buffer != 0)
+    {
+        // (Deleting the buffer also unmaps it.)
+        glDeleteBuffers(1, &ring.buffer);
+        ring.buffer = 0;
+    }
+    ring.mapped = nullptr;
+}
+
+// Start writing the instance data for a new frame.
+void
+instance_ring_begin_frame(gl_instance_ring& ring)
+{
+    ring.offset = 0;
+    if (ring.mapped)
+    {
+        // Wait until the GPU is done with the frame that last used this
+        // segment. (With three segments, this rarely actually waits.)
+        ring.segment = (ring.segment + 1) % gl_instance_ring_frames;
+        GLsync& fence = ring.fences[ring.segment];
+        if (fence)
+        {
+            while (glClientWaitSync(
+                       fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000)
+                   == GL_TIMEOUT_EXPIRED)
+            {
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    else
+    {
+        // Orphan the old storage so that the driver can hand out fresh
+        // storage rather than waiting for the GPU to finish with it.
+        glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            GLsizeiptr(ring.segment_size),
+            nullptr,
+            GL_STREAM_DRAW);
+    }
+}
+
+void
+instance_ring_end_frame(gl_instance_ring& ring)
+{
+    if (ring.mapped)
+    {
+        GLsync& fence = ring.fences[ring.segment];
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+// Reserve `size` bytes in the current frame's segment and return their
+// offset within the buffer.
+GLintptr
+instance_ring_reserve(gl_instance_ring& ring, size_t size)
+{
+    if (ring.offset + size > ring.segment_size)
+    {
+        // Replace the buffer with a larger one. Draws that are already
+        // queued keep the old storage alive until they're done with it.
+        size_t new_size = ring.segment_size * 2;
+        while (new_size < size)
+            new_size *= 2;
+        instance_ring_destroy(ring);
+        instance_ring_create(ring, new_size);
+    }
+    GLintptr const offset
+        = GLintptr(ring.segment * ring.segment_size + ring.offset);
+    ring.offset += size;
+    return offset;
+}
+
+// Point the per-instance vertex attributes (in the currently bound VAO) at
+// the instances starting at byte `base` within `buffer`.
+void
+bind_primitive_instance_attributes(GLuint buffer, GLintptr base)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    auto pointer = [&](size_t field_offset) {
+        return reinterpret_cast<void*>(base + GLintptr(field_offset));
+    };
+    GLsizei const stride = sizeof(primitive_instance);
+    glVertexAttribPointer(
+        1,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        stride,
+        pointer(offsetof(primitive_instance, min)));
+    glVertexAttribPointer(
+        2,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        stride,
+        pointer(offsetof(primitive_instance, size)));
+    glVertexAttribPointer(
+        3,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        stride,
+        pointer(offsetof(primitive_instance, color)));
+    glVertexAttribIPointer(
+        4,
+        1,
+        GL_INT,
+        stride,
+        pointer(offsetof(primitive_instance, primitive_type)));
+    glVertexAttribPointer(
+        5,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        stride,
+        pointer(offsetof(primitive_instance, data_a)));
+    glVertexAttribPointer(
+        6,
+        4,
+        GL_FLOAT,
+        GL_FALSE,
+        stride,
+        pointer(offsetof(primitive_instance, data_b)));
+}
+
 void
 gl_draw_pass_begin(void* user)
 {
@@ -412,6 +592,8 @@ gl_draw_pass_begin(void* user)
     if (!renderer || !renderer->system)
         return;
 
+    instance_ring_begin_frame(renderer->instances);
+
     alia_vec2i const size = alia_ui_surface_get_size(renderer->system);
     if (!ensure_linear_target(renderer->primary_target, size.x, size.y))
         return;
@@ -425,18 +607,83 @@ gl_draw_pass_begin(void* user)
     glBindFramebuffer(GL_FRAMEBUFFER, renderer->primary_target.fbo);
     glViewport(
         0, 0, renderer->primary_target.width, renderer->primary_target.height);
+    // With partial damage, the rest of the primary target still holds the
+    // previous frame, so only the damaged part is cleared and redrawn.
+    if (renderer->pass_has_damage)
+    {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(
+            renderer->damage_scissor[0],
+            renderer->damage_scissor[1],
+            renderer->damage_scissor[2],
+            renderer->damage_scissor[3]);
+    }
     glClearColor(0.f, 0.f, 0.f, 0.f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
+void
+gl_draw_pass_set_damage(void* user, alia_draw_damage const* damage)
+{
+    auto* renderer = static_cast<alia_gl_renderer*>(user);
+    if (!renderer || !renderer->system)
+        return;
+
+    // If the primary target is about to be (re)created, there's nothing to
+    // preserve.
+    alia_vec2i const size = alia_ui_surface_get_size(renderer->system);
+    renderer->pass_has_damage = !damage->full
+                             && renderer->primary_target.fbo != 0
+                             && renderer->primary_target.width == size.x
+                             && renderer->primary_target.height == size.y;
+    if (!renderer->pass_has_damage)
+        return;
+
+    // A single scissor box covers all the damage.
+    float x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    for (uint32_t i = 0; i != damage->count; ++i)
+    {
+        alia_box const& rect = damage->rects[i];
+        float const rx1 = rect.min.x + rect.size.x;
+        float const ry1 = rect.min.y + rect.size.y;
+        if (i == 0)
+        {
+            x0 = rect.min.x;
+            y0 = rect.min.y;
+            x1 = rx1;
+            y1 = ry1;
+        }
+        else
+        {
+            x0 = std::min(x0, rect.min.x);
+            y0 = std::min(y0, rect.min.y);
+            x1 = std::max(x1, rx1);
+            y1 = std::max(y1, ry1);
+        }
+    }
+    // The surface is top-down, but GL window coordinates are bottom-up.
+    renderer->damage_scissor[0] = GLint(x0);
+    renderer->damage_scissor[1] = GLint(float(size.y) - y1);
+    renderer->damage_scissor[2] = GLint(x1 - x0);
+    renderer->damage_scissor[3] = GLint(y1 - y0);
+}
+
 void
 gl_draw_pass_end(void* user)
 {
     auto* renderer = static_cast<alia_gl_renderer*>(user);
+    if (renderer)
+        instance_ring_end_frame(renderer->instances);
     if (!renderer || renderer->primary_target.fbo == 0
         || renderer->present_program == 0 || renderer->effect_vao == 0)
         return;
 
+    if (renderer->pass_has_damage)
+    {
+        glDisable(GL_SCISSOR_TEST);
+        renderer->pass_has_damage = false;
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, GLuint(renderer->pass_draw_fbo));
     glViewport(
         0, 0, renderer->primary_target.width, renderer->primary_target.height);
@@ -511,72 +758,15 @@ renderer_init_gpu(alia_ui_system* system, alia_gl_renderer* renderer)
 
     check_gl_errors();
 
-    GLuint instance_vbo;
-    glGenBuffers(1, &instance_vbo);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
-
-    check_gl_errors();
-
-    glVertexAttribPointer(
-        1,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, min));
-    glEnableVertexAttribArray(1);
-    glVertexAttribDivisor(1, 1);
-
-    glVertexAttribPointer(
-        2,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, size));
-    glEnableVertexAttribArray(2);
-    glVertexAttribDivisor(2, 1);
-
-    glVertexAttribPointer(
-        3,
-        4,
-        GL_UNSIGNED_BYTE,
-        GL_TRUE,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, color));
-    glEnableVertexAttribArray(3);
-    glVertexAttribDivisor(3, 1);
-
-    glVertexAttribIPointer(
-        4,
-        1,
-        GL_INT,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, primitive_type));
-    glEnableVertexAttribArray(4);
-    glVertexAttribDivisor(4, 1);
-
-    glVertexAttribPointer(
-        5,
-        4,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, data_a));
-    glEnableVertexAttribArray(5);
-    glVertexAttribDivisor(5, 1);
-
-    glVertexAttribPointer(
-        6,
-        4,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(primitive_instance),
-        (void*) offsetof(primitive_instance, data_b));
-    glEnableVertexAttribArray(6);
-    glVertexAttribDivisor(6, 1);
+    instance_ring_create(
+        renderer->instances,
+        initial_instance_ring_segment_size * sizeof(primitive_instance));
+    bind_primitive_instance_attributes(renderer->instances.buffer, 0);
+    for (GLuint attribute = 1; attribute <= 6; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
 
     check_gl_errors();
 
@@ -584,7 +774,6 @@ renderer_init_gpu(alia_ui_system* system, alia_gl_renderer* renderer)
     renderer->primitive_shader_program = primitive_shader_program;
     renderer->vao = vao;
     renderer->vbo = vbo;
-    renderer->instance_vbo = instance_vbo;
     renderer->primitive_matrix_location = primitive_matrix_location;
     renderer->msdf_sampler_location = msdf_sampler_location;
     renderer->msdf_atlas_texture = 0;
@@ -592,6 +781,134 @@ renderer_init_gpu(alia_ui_system* system, alia_gl_renderer* renderer)
     alia::initialize_lazy_commit_arena(&renderer->rect_instance_arena);
 }
 
+// Count the instances that the primitive commands in `bucket` expand to.
+// (Glyph runs expand to one instance per glyph.)
+size_t
+count_primitive_instances(alia_draw_bucket const& bucket)
+{
+    size_t count = 0;
+    for (auto const* cmd = bucket.head; cmd; cmd = cmd->next)
+    {
+        auto const* primitive_cmd
+            = alia::downcast<alia_draw_primitive_command>(cmd);
+        if (primitive_cmd->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN)
+        {
+            count += alia::downcast<alia_draw_msdf_glyph_run_command>(cmd)
+                         ->count;
+        }
+        else
+            ++count;
+    }
+    return count;
+}
+
+// Expand a glyph run into glyph instances, writing them to `out`.
+// Returns a pointer past the last instance written.
+primitive_instance*
+write_glyph_run_instances(
+    alia_draw_msdf_glyph_run_command const& run, primitive_instance* out)
+{
+    alia_msdf_glyph_run_entry const* entries
+        = alia_msdf_glyph_run_entries(&run);
+    for (uint32_t i = 0; i != run.count; ++i)
+    {
+        alia_box const box = alia_msdf_glyph_run_entry_box(&run, entries[i]);
+        alia_msdf_glyph_metrics const& glyph = run.glyphs[entries[i].glyph];
+        out->min = box.min;
+        out->size = box.size;
+        out->color = run.color;
+        out->primitive_type = ALIA_PRIMITIVE_MSDF_GLYPH;
+        std::memcpy(out->data_a, glyph.uv_rect, sizeof(out->data_a));
+        out->data_b[0] = run.sdf_scale;
+        out->data_b[1] = 0.0f;
+        out->data_b[2] = 0.0f;
+        out->data_b[3] = 0.0f;
+        ++out;
+    }
+    return out;
+}
+
+// Convert the primitive commands in `bucket` to instances, writing them to
+// `out`. `out` must have room for `count_primitive_instances(bucket)`.
+void
+write_primitive_instances(
+    alia_draw_bucket const& bucket, primitive_instance* out)
+{
+    auto pack_border_color = [](alia_srgba8 c) -> float {
+        uint32_t packed = uint32_t(c.r) | (uint32_t(c.g) << 8u)
+                        | (uint32_t(c.b) << 16u) | (uint32_t(c.a) << 24u);
+        float f;
+        std::memcpy(&f, &packed, sizeof(f));
+        return f;
+    };
+
+    primitive_instance* instance = out;
+    for (auto const* cmd = bucket.head; cmd; cmd = cmd->next)
+    {
+        auto const* primitive_cmd
+            = alia::downcast<alia_draw_primitive_command>(cmd);
+        if (primitive_cmd->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN)
+        {
+            instance = write_glyph_run_instances(
+                *alia::downcast<alia_draw_msdf_glyph_run_command>(cmd),
+                instance);
+            continue;
+        }
+        instance->min = primitive_cmd->box.min;
+        instance->size = primitive_cmd->box.size;
+        instance->color = primitive_cmd->color;
+        instance->primitive_type = int(primitive_cmd->primitive_type);
+        std::memset(instance->data_a, 0, sizeof(instance->data_a));
+        std::memset(instance->data_b, 0, sizeof(instance->data_b));
+
+        switch (primitive_cmd->primitive_type)
+        {
+            case ALIA_PRIMITIVE_BOX: {
+                instance->data_a[0] = primitive_cmd->payload.box.corner_radius;
+                instance->data_a[1] = primitive_cmd->payload.box.border_width;
+                instance->data_a[2] = pack_border_color(
+                    primitive_cmd->payload.box.border_color);
+                instance->data_a[3] = 0.0f;
+                break;
+            }
+            case ALIA_PRIMITIVE_EQUILATERAL_TRIANGLE: {
+                float const degrees_to_radians
+                    = 3.14159265358979323846f / 180.0f;
+                instance->data_a[0]
+                    = primitive_cmd->payload.triangle.rotation_degrees
+                    * degrees_to_radians;
+                break;
+            }
+            case ALIA_PRIMITIVE_SQUIRCLE: {
+                instance->data_a[0] = primitive_cmd->payload.squircle.radius;
+                instance->data_a[1]
+                    = primitive_cmd->payload.squircle.border_width;
+                instance->data_a[2] = pack_border_color(
+                    primitive_cmd->payload.squircle.border_color);
+                instance->data_a[3] = 0.0f;
+                break;
+            }
+            case ALIA_PRIMITIVE_MSDF_GLYPH: {
+                instance->data_a[0]
+                    = primitive_cmd->payload.msdf_glyph.uv_rect[0];
+                instance->data_a[1]
+                    = primitive_cmd->payload.msdf_glyph.uv_rect[1];
+                instance->data_a[2]
+                    = primitive_cmd->payload.msdf_glyph.uv_rect[2];
+                instance->data_a[3]
+                    = primitive_cmd->payload.msdf_glyph.uv_rect[3];
+                instance->data_b[0]
+                    = primitive_cmd->payload.msdf_glyph.sdf_scale;
+                instance->data_b[1] = 0.0f;
+                instance->data_b[2] = 0.0f;
+                instance->data_b[3] = 0.0f;
+                break;
+            }
+        }
+        ++instance;
+    }
+}
+
 void
 render_primitive_command_list(void* user, alia_draw_bucket const* bucket)
 {
@@ -650,81 +967,32 @@ render_primitive_command_list(void* user, alia_draw_bucket const* bucket)
 
     check_gl_errors();
 
-    alia_bump_allocator rect_alloc;
-    alia_bump_allocator_init(&rect_alloc, &renderer->rect_instance_arena);
-    primitive_instance* primitive_instances
-        = alia::arena_alloc_array<primitive_instance>(rect_alloc, boxes.count);
-
-    auto pack_border_color = [](alia_srgba8 c) -> float {
-        uint32_t packed = uint32_t(c.r) | (uint32_t(c.g) << 8u)
-                        | (uint32_t(c.b) << 16u) | (uint32_t(c.a) << 24u);
-        float f;
-        std::memcpy(&f, &packed, sizeof(f));
-        return f;
-    };
-
+    // Convert the commands straight into the mapped ring buffer if possible
+    // (or into staging memory otherwise).
+    gl_instance_ring& ring = renderer->instances;
+    size_t const instance_count = count_primitive_instances(boxes);
+    size_t const instance_bytes = sizeof(primitive_instance) * instance_count;
+    GLintptr const ring_offset = instance_ring_reserve(ring, instance_bytes);
+    if (ring.mapped)
     {
-        primitive_instance* instance = primitive_instances;
-        for (auto const* cmd = boxes.head; cmd; cmd = cmd->next)
-        {
-            auto const* primitive_cmd
-                = alia::downcast<alia_draw_primitive_command>(cmd);
-            instance->min = primitive_cmd->box.min;
-            instance->size = primitive_cmd->box.size;
-            instance->color = primitive_cmd->color;
-            instance->primitive_type = int(primitive_cmd->primitive_type);
-            std::memset(instance->data_a, 0, sizeof(instance->data_a));
-            std::memset(instance->data_b, 0, sizeof(instance->data_b));
-
-            switch (primitive_cmd->primitive_type)
-            {
-                case ALIA_PRIMITIVE_BOX: {
-                    instance->data_a[0]
-                        = primitive_cmd->payload.box.corner_radius;
-                    instance->data_a[1]
-                        = primitive_cmd->payload.box.border_width;
-                    instance->data_a[2] = pack_border_color(
-                        primitive_cmd->payload.box.border_color);
-                    instance->data_a[3] = 0.0f;
-                    break;
-                }
-                case ALIA_PRIMITIVE_EQUILATERAL_TRIANGLE: {
-                    float const degrees_to_radians
-                        = 3.14159265358979323846f / 180.0f;
-                    instance->data_a[0]
-                        = primitive_cmd->payload.triangle.rotation_degrees
-                        * degrees_to_radians;
-                    break;
-                }
-                case ALIA_PRIMITIVE_SQUIRCLE: {
-                    instance->data_a[0]
-                        = primitive_cmd->payload.squircle.radius;
-                    instance->data_a[1]
-                        = primitive_cmd->payload.squircle.border_width;
-                    instance->data_a[2] = pack_border_color(
-                        primitive_cmd->payload.squircle.border_color);
-                    instance->data_a[3] = 0.0f;
-                    break;
-                }
-                case ALIA_PRIMITIVE_MSDF_GLYPH: {
-                    instance->data_a[0]
-                        = primitive_cmd->payload.msdf_glyph.uv_rect[0];
-                    instance->data_a[1]
-                        = primitive_cmd->payload.msdf_glyph.uv_rect[1];
-                    instance->data_a[2]
-                        = primitive_cmd->payload.msdf_glyph.uv_rect[2];
-                    instance->data_a[3]
-                        = primitive_cmd->payload.msdf_glyph.uv_rect[3];
-                    instance->data_b[0]
-                        = primitive_cmd->payload.msdf_glyph.sdf_scale;
-                    instance->data_b[1] = 0.0f;
-                    instance->data_b[2] = 0.0f;
-                    instance->data_b[3] = 0.0f;
-                    break;
-                }
-            }
-            ++instance;
-        }
+        write_primitive_instances(
+            boxes,
+            reinterpret_cast<primitive_instance*>(ring.mapped + ring_offset));
+    }
+    else
+    {
+        alia_bump_allocator rect_alloc;
+        alia_bump_allocator_init(&rect_alloc, &renderer->rect_instance_arena);
+        primitive_instance* primitive_instances
+            = alia::arena_alloc_array<primitive_instance>(
+                rect_alloc, instance_count);
+        write_primitive_instances(boxes, primitive_instances);
+        glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+        glBufferSubData(
+            GL_ARRAY_BUFFER,
+            ring_offset,
+            GLsizeiptr(instance_bytes),
+            primitive_instances);
     }
 
     if (renderer->msdf_atlas_texture != 0)
@@ -734,17 +1002,12 @@ render_primitive_command_list(void* user, alia_draw_bucket const* bucket)
         glUniform1i(renderer->msdf_sampler_location, 0);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->instance_vbo);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        sizeof(primitive_instance) * boxes.count,
-        primitive_instances,
-        GL_STREAM_DRAW);
-
     check_gl_errors();
 
     glBindVertexArray(renderer->vao);
-    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, boxes.count);
+    bind_primitive_instance_attributes(ring.buffer, ring_offset);
+    glDrawArraysInstanced(
+        GL_TRIANGLE_STRIP, 0, 4, GLsizei(instance_count));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -1070,6 +1333,11 @@ alia_gl_renderer_attach(alia_gl_renderer* renderer, alia_ui_system* ui)
                 alia_gl_renderer_upload_msdf_atlas(
                     static_cast<alia_gl_renderer*>(user), image);
             },
+        .update_msdf_atlas =
+            [](void* user, alia_msdf_atlas_region const* region) {
+                alia_gl_renderer_update_msdf_atlas(
+                    static_cast<alia_gl_renderer*>(user), region);
+            },
         .register_effect =
             [](void* user,
                alia_effect_desc const* desc,
@@ -1081,6 +1349,7 @@ alia_gl_renderer_attach(alia_gl_renderer* renderer, alia_ui_system* ui)
             },
         .draw_pass_begin = gl_draw_pass_begin,
         .draw_pass_end = gl_draw_pass_end,
+        .draw_pass_set_damage = gl_draw_pass_set_damage,
         .draw_target_bind = gl_draw_target_bind,
         .user = renderer,
     };
@@ -1144,6 +1413,31 @@ alia_gl_renderer_upload_msdf_atlas(
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
 
+void
+alia_gl_renderer_update_msdf_atlas(
+    alia_gl_renderer* renderer, alia_msdf_atlas_region const* region)
+{
+    ALIA_ASSERT(renderer);
+    ALIA_ASSERT(region);
+    ALIA_ASSERT(region->rgb);
+    ALIA_ASSERT(renderer->msdf_atlas_texture != 0);
+
+    glBindTexture(GL_TEXTURE_2D, renderer->msdf_atlas_texture);
+    // Glyph rows are tightly packed RGB, so they're rarely 4-byte aligned.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0,
+        region->x,
+        region->y,
+        region->width,
+        region->height,
+        GL_RGB,
+        GL_UNSIGNED_BYTE,
+        region->rgb);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 void
 alia_gl_renderer_destroy(alia_gl_renderer* renderer)
 {
@@ -1190,11 +1484,7 @@ alia_gl_renderer_destroy(alia_gl_renderer* renderer)
         glDeleteBuffers(1, &renderer->vbo);
         renderer->vbo = 0;
     }
-    if (renderer->instance_vbo != 0)
-    {
-        glDeleteBuffers(1, &renderer->instance_vbo);
-        renderer->instance_vbo = 0;
-    }
+    instance_ring_destroy(renderer->instances);
     if (renderer->vao != 0)
     {
         glDeleteVertexArrays(1, &renderer->vao);
@@ -4,6 +4,8 @@
 
 #include <alia/base/arena.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -29,6 +31,36 @@ struct gl_effect_slot
     size_t ubo_bytes = 0;
 };
 
+// the number of frames of primitive instance data that can be in flight
+int const gl_instance_ring_frames = 3;
+
+// `gl_instance_ring` streams primitive instance data to the GPU without
+// respecifying buffer storage for every bucket.
+//
+// Where buffer storage is available (GL 4.4 or ARB_buffer_storage), the
+// buffer is persistently mapped and split into one segment per in-flight
+// frame. Instances are written straight into the current frame's segment,
+// and a fence at the end of each frame guards its segment until the GPU is
+// done with it.
+//
+// Otherwise (e.g., on GLES/WebGL), the buffer is orphaned at the start of
+// each frame and written with `glBufferSubData`.
+//
+struct gl_instance_ring
+{
+    GLuint buffer = 0;
+    // the size of each frame's segment, in bytes
+    size_t segment_size = 0;
+    // the segment that the current frame is writing and the write offset
+    // within it
+    int segment = 0;
+    size_t offset = 0;
+    // the buffer's storage if it's persistently mapped (or null)
+    uint8_t* mapped = nullptr;
+    // for each segment, a fence for the last frame that used it (or null)
+    GLsync fences[gl_instance_ring_frames] = {};
+};
+
 struct gl_linear_target
 {
     GLuint fbo = 0;
@@ -43,10 +75,11 @@ struct alia_gl_renderer
     GLuint primitive_shader_program = 0;
     GLuint vao = 0;
     GLuint vbo = 0;
-    GLuint instance_vbo = 0;
+    gl_instance_ring instances{};
     GLint primitive_matrix_location = 0;
     GLint msdf_sampler_location = 0;
     GLuint msdf_atlas_texture = 0;
+    // staging for instance data when the ring isn't persistently mapped
     alia_arena rect_instance_arena{};
     // shared effect geometry - Each registered effect is its own material.
     GLuint effect_vao = 0;
@@ -62,4 +95,9 @@ struct alia_gl_renderer
     GLint present_sampler_location = -1;
     // draw-framebuffer binding captured at draw_pass_begin (usually 0)
     GLint pass_draw_fbo = 0;
+    // If set, the current pass only redraws the part of `primary_target`
+    // within `damage_scissor` (x, y, width, height in GL window coordinates)
+    // and preserves the rest.
+    bool pass_has_damage = false;
+    GLint damage_scissor[4] = {0, 0, 0, 0};
 };
@@ -464,8 +464,7 @@ do_text(
             new_node->engine = the_msdf_text_engine;
             new_node->font_index = font_index;
             new_node->spacing = alia_layout_style_active(&ctx)->spacing;
-            *emission.next_ptr = &new_node->base;
-            emission.next_ptr = &new_node->base.next_sibling;
+            alia_layout_emit_node(&emission, &new_node->base);
             break;
         }
         case ALIA_CATEGORY_SPATIAL: {
@@ -0,0 +1,642 @@
+#include <alia/abi/kernel/components.h>
+
+#include <alia/test/kernel/substrate_fixture.hpp>
+#include <alia/test/layout/layout_test_helpers.hpp>
+
+#include <alia/abi/kernel/events.h>
+#include <alia/abi/ui/drawing/commands.h>
+#include <alia/abi/ui/drawing/effects.h>
+#include <alia/abi/ui/drawing/system.h>
+#include <alia/abi/ui/input/elements.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/abi/ui/system/renderer.h>
+#include <alia/abi/ui/viewport.h>
+#include <alia/kernel/flow/dispatch.h>
+#include <alia/kernel/id.hpp>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/system/object.h>
+
+#include <doctest/doctest.h>
+
+#include <new>
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+using namespace alia::test;
+
+namespace {
+
+// This combines the substrate and layout fixtures so that controllers can use
+// both (which skippable components require).
+struct component_harness
+{
+    substrate_fixture substrate;
+    layout_fixture* layout = layout_fixture_create();
+    alia_struct_spec root_spec = {.size = 1024u, .align = 16u};
+
+    component_harness()
+    {
+        REQUIRE(layout);
+    }
+
+    ~component_harness()
+    {
+        substrate.cleanup_root_block();
+        layout_fixture_destroy(layout);
+    }
+
+    template<class Fn>
+    void
+    run_root(alia_context* ctx, Fn& fn)
+    {
+        ctx->substrate = substrate.ctx.substrate;
+        alia_substrate_begin_block(ctx, substrate.root_anchor(), &root_spec);
+        fn(*ctx);
+        (void) alia_substrate_end_block(ctx);
+    }
+
+    // Refresh (repeating passes until the substrate is fully discovered),
+    // resolve the layout, and then do a spatial pass.
+    template<class Fn>
+    void
+    update(Fn&& fn)
+    {
+        substrate.advance_frame();
+        bool incomplete;
+        do
+        {
+            substrate.reset_traversal();
+            layout_fixture_run_refresh(layout, [&](alia_context* ctx) {
+                run_root(ctx, fn);
+                incomplete = as_refresh_event(*ctx).incomplete;
+            });
+        } while (incomplete);
+
+        layout_fixture_resolve(layout, alia_vec2f_make(100.f, 100.f));
+
+        substrate.reset_traversal();
+        layout_fixture_run_spatial(
+            layout, [&](alia_context* ctx) { run_root(ctx, fn); });
+    }
+};
+
+// a column of sibling components, each with a single element, driven by a
+// full UI system
+struct routed_list
+{
+    std::vector<alia_element_id> ids;
+    // the number of times each component's content has seen a timer event
+    std::vector<int> timer_runs;
+    // the number of timer events that reached their target
+    int deliveries = 0;
+
+    alia_ui_system* ui = nullptr;
+
+    explicit routed_list(size_t count) : ids(count), timer_runs(count)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {100, 10000});
+        alia_ui_system_update(ui);
+        // Do a full non-refresh pass so that the components know their
+        // placements.
+        alia_event hit_test = alia_make_mouse_hit_test_event(
+            {.x = -1.f, .y = -1.f, .result = {}});
+        dispatch_event(*ui, hit_test);
+    }
+
+    ~routed_list()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    void
+    send_timer(alia_element_id target)
+    {
+        alia_event event
+            = alia_make_timer_event({.target = target, .fire_time = 0});
+        dispatch_targeted_event(*ui, event, target);
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& list = *static_cast<routed_list*>(user_data);
+        alia_layout_column_begin(ctx, 0, 0.f);
+        for (size_t i = 0; i != list.ids.size(); ++i)
+        {
+            if (alia_component_begin(ctx, unit_id()))
+            {
+                alia_element_id const id = alia_element_get_identity(ctx);
+                list.ids[i] = id;
+                if (is_refresh_event(*ctx))
+                {
+                    alia_layout_leaf_emit(
+                        ctx,
+                        alia_layout_content_metrics_make(
+                            alia_vec2f_make(10.f, 10.f)),
+                        0);
+                }
+                else
+                {
+                    (void) alia_layout_consume_box(ctx);
+                    if (get_event_type(*ctx) == ALIA_EVENT_TIMER)
+                    {
+                        ++list.timer_runs[i];
+                        if (alia_element_id_equal(get_event_target(*ctx), id))
+                            ++list.deliveries;
+                    }
+                }
+            }
+            alia_component_end(ctx);
+        }
+        alia_layout_column_end(ctx);
+    }
+};
+
+// a column of components that retain their drawing, each drawing a single
+// command with a custom material
+struct retained_drawing_list
+{
+    struct command
+    {
+        alia_draw_command base;
+        int value;
+    };
+
+    std::vector<int> values;
+    // the number of times each component's content has drawn
+    std::vector<int> draw_runs;
+    // the values of the commands that the material saw on the last pass
+    std::vector<int> drawn;
+    // the box that each component's content last drew in
+    std::vector<alia_box> boxes;
+
+    // if set, the column ends with an effect (with `effect_param` as its
+    // parameter) and a viewport (within its own retaining component)
+    bool with_externals;
+    float effect_param = 0;
+
+    alia_ui_system* ui = nullptr;
+    alia_draw_material_id material = 0;
+    // the material for the effect and viewport (which draws nothing)
+    alia_draw_material_id external_material = 0;
+
+    explicit retained_drawing_list(size_t count, bool with_externals = false)
+        : values(count),
+          draw_runs(count),
+          boxes(count),
+          with_externals(with_externals)
+    {
+        for (size_t i = 0; i != count; ++i)
+            values[i] = int(i);
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {100, 10000});
+        material = alia_material_alloc_ids(ui, 2);
+        alia_material_register(ui, material, {.draw_bucket = draw}, this);
+        external_material = material + 1;
+        alia_material_register(
+            ui,
+            external_material,
+            {.draw_bucket = [](void*, alia_draw_bucket const*) {}},
+            nullptr);
+        // The effect and viewport are sized in logical pixels.
+        alia_ui_surface_set_dpi(ui, 96.f);
+        alia_ui_system_update(ui);
+    }
+
+    ~retained_drawing_list()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    void
+    draw_pass()
+    {
+        drawn.clear();
+        alia_ui_execute_draw_pass(ui);
+    }
+
+    // Enable damage tracking (by providing a renderer that supports it).
+    void
+    track_damage()
+    {
+        alia_renderer_ops ops{};
+        ops.draw_pass_set_damage = [](void*, alia_draw_damage const*) {};
+        alia_ui_system_set_renderer_ops(ui, &ops);
+    }
+
+    static void
+    draw(void* user, alia_draw_bucket const* bucket)
+    {
+        auto& list = *static_cast<retained_drawing_list*>(user);
+        for (alia_draw_command const* cmd = bucket->head; cmd; cmd = cmd->next)
+            list.drawn.push_back(reinterpret_cast<command const*>(cmd)->value);
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& list = *static_cast<retained_drawing_list*>(user_data);
+        alia_layout_column_begin(ctx, 0, 0.f);
+        for (size_t i = 0; i != list.values.size(); ++i)
+        {
+            if (alia_component_begin(ctx, make_id(list.values[i])))
+            {
+                alia_component_retain_draw(ctx);
+                if (is_refresh_event(*ctx))
+                {
+                    alia_layout_leaf_emit(
+                        ctx,
+                        alia_layout_content_metrics_make(
+                            alia_vec2f_make(10.f, 10.f)),
+                        0);
+                }
+                else
+                {
+                    alia_box const box = alia_layout_consume_box(ctx);
+                    if (get_event_type(*ctx) == ALIA_EVENT_DRAW)
+                    {
+                        ++list.draw_runs[i];
+                        list.boxes[i] = box;
+                        auto* cmd = reinterpret_cast<command*>(
+                            alia_draw_command_alloc(
+                                ctx,
+                                0,
+                                list.material,
+                                ALIA_MIN_ALIGNED_SIZE(sizeof(command))));
+                        cmd->value = list.values[i];
+                    }
+                }
+            }
+            alia_component_end(ctx);
+        }
+        if (list.with_externals)
+        {
+            alia_do_effect(
+                ctx,
+                0,
+                list.external_material,
+                &list.effect_param,
+                sizeof(list.effect_param),
+                0,
+                alia_vec2f_make(10.f, 10.f));
+            if (alia_component_begin(ctx, unit_id()))
+            {
+                alia_component_retain_draw(ctx);
+                alia_do_viewport(ctx, 0, list.external_material, 0, nullptr);
+            }
+            alia_component_end(ctx);
+        }
+        alia_layout_column_end(ctx);
+    }
+};
+
+} // namespace
+
+TEST_CASE("skippable component skips clean content on refresh")
+{
+    component_harness t;
+
+    int value = 1;
+    int refresh_runs = 0;
+    int spatial_runs = 0;
+    alia_box before, inside, after;
+
+    auto controller = [&](alia_context& ctx) {
+        column(ctx, [&]() {
+            test_leaf(ctx, alia_vec2f_make(10.f, 10.f), NO_FLAGS, &before);
+            if (alia_component_begin(&ctx, make_id(value)))
+            {
+                if (is_refresh_event(ctx))
+                    ++refresh_runs;
+                else
+                    ++spatial_runs;
+                test_leaf(
+                    ctx,
+                    alia_vec2f_make(20.f, float(value)),
+                    NO_FLAGS,
+                    &inside);
+            }
+            alia_component_end(&ctx);
+            test_leaf(ctx, alia_vec2f_make(30.f, 10.f), NO_FLAGS, &after);
+        });
+    };
+
+    t.update(controller);
+    int const initial_runs = refresh_runs;
+    CHECK(initial_runs >= 1);
+    CHECK(check_box_eq(
+        inside, alia_vec2f_make(0.f, 10.f), alia_vec2f_make(20.f, 1.f)));
+    CHECK(check_box_eq(
+        after, alia_vec2f_make(0.f, 11.f), alia_vec2f_make(30.f, 10.f)));
+
+    // With the same value ID, the content is skipped on refresh, but its
+    // layout nodes are still part of the tree.
+    t.update(controller);
+    CHECK(refresh_runs == initial_runs);
+    CHECK(spatial_runs == 2);
+    CHECK(check_box_eq(
+        before, alia_vec2f_make(0.f, 0.f), alia_vec2f_make(10.f, 10.f)));
+    CHECK(check_box_eq(
+        inside, alia_vec2f_make(0.f, 10.f), alia_vec2f_make(20.f, 1.f)));
+    CHECK(check_box_eq(
+        after, alia_vec2f_make(0.f, 11.f), alia_vec2f_make(30.f, 10.f)));
+
+    // Changing the value ID reruns the content.
+    value = 5;
+    t.update(controller);
+    CHECK(refresh_runs == initial_runs + 1);
+    CHECK(check_box_eq(
+        inside, alia_vec2f_make(0.f, 10.f), alia_vec2f_make(20.f, 5.f)));
+    CHECK(check_box_eq(
+        after, alia_vec2f_make(0.f, 15.f), alia_vec2f_make(30.f, 10.f)));
+
+    t.update(controller);
+    CHECK(refresh_runs == initial_runs + 1);
+}
+
+TEST_CASE("dirty skippable components are refreshed with their ancestors")
+{
+    component_harness t;
+
+    int outer_runs = 0;
+    int inner_runs = 0;
+    bool mark_inner_dirty = false;
+    alia_box inner_box;
+
+    auto controller = [&](alia_context& ctx) {
+        if (alia_component_begin(&ctx, unit_id()))
+        {
+            if (is_refresh_event(ctx))
+                ++outer_runs;
+            column(ctx, [&]() {
+                test_leaf(ctx, alia_vec2f_make(10.f, 10.f));
+                if (alia_component_begin(&ctx, unit_id()))
+                {
+                    if (is_refresh_event(ctx))
+                        ++inner_runs;
+                    else if (mark_inner_dirty)
+                        alia_component_mark_dirty(&ctx);
+                    test_leaf(
+                        ctx,
+                        alia_vec2f_make(10.f, 10.f),
+                        NO_FLAGS,
+                        &inner_box);
+                }
+                alia_component_end(&ctx);
+            });
+        }
+        alia_component_end(&ctx);
+    };
+
+    t.update(controller);
+    int const initial_outer_runs = outer_runs;
+    int const initial_inner_runs = inner_runs;
+
+    t.update(controller);
+    CHECK(outer_runs == initial_outer_runs);
+    CHECK(inner_runs == initial_inner_runs);
+
+    // Marking the inner component dirty (on a non-refresh pass) forces both
+    // it and the outer component to run on the next refresh.
+    mark_inner_dirty = true;
+    t.update(controller);
+    mark_inner_dirty = false;
+    CHECK(outer_runs == initial_outer_runs);
+    t.update(controller);
+    CHECK(outer_runs == initial_outer_runs + 1);
+    CHECK(inner_runs == initial_inner_runs + 1);
+    CHECK(check_box_eq(
+        inner_box, alia_vec2f_make(0.f, 10.f), alia_vec2f_make(10.f, 10.f)));
+
+    t.update(controller);
+    CHECK(outer_runs == initial_outer_runs + 1);
+    CHECK(inner_runs == initial_inner_runs + 1);
+}
+
+TEST_CASE("skippable component with a null value ID always runs")
+{
+    component_harness t;
+
+    int runs = 0;
+    auto controller = [&](alia_context& ctx) {
+        if (alia_component_begin(&ctx, null_id()))
+        {
+            if (is_refresh_event(ctx))
+                ++runs;
+            test_leaf(ctx, alia_vec2f_make(10.f, 10.f));
+        }
+        alia_component_end(&ctx);
+    };
+
+    t.update(controller);
+    int const initial_runs = runs;
+    t.update(controller);
+    CHECK(runs == initial_runs + 1);
+}
+
+TEST_CASE("skippable components have stable routed IDs")
+{
+    component_harness t;
+
+    alia_element_id outer_id, inner_id;
+    auto controller = [&](alia_context& ctx) {
+        CHECK(!alia_element_id_is_valid(alia_component_id(&ctx)));
+        if (alia_component_begin(&ctx, null_id()))
+        {
+            outer_id = alia_component_id(&ctx);
+            if (alia_component_begin(&ctx, null_id()))
+                inner_id = alia_component_id(&ctx);
+            alia_component_end(&ctx);
+            CHECK(alia_element_id_equal(alia_component_id(&ctx), outer_id));
+        }
+        alia_component_end(&ctx);
+    };
+
+    t.update(controller);
+    alia_element_id const initial_outer_id = outer_id;
+    alia_element_id const initial_inner_id = inner_id;
+    CHECK(initial_outer_id.route != 0);
+    CHECK(initial_inner_id.route != 0);
+    CHECK(initial_outer_id.route != initial_inner_id.route);
+
+    t.update(controller);
+    CHECK(alia_element_id_equal(outer_id, initial_outer_id));
+    CHECK(alia_element_id_equal(inner_id, initial_inner_id));
+}
+
+TEST_CASE("targeted events only visit the components on their route")
+{
+    routed_list list(3);
+    for (alia_element_id const& id : list.ids)
+        CHECK(id.route != 0);
+
+    list.send_timer(list.ids[1]);
+    CHECK(list.deliveries == 1);
+    CHECK(list.timer_runs == std::vector<int>{0, 1, 0});
+
+    list.send_timer(list.ids[2]);
+    CHECK(list.deliveries == 2);
+    CHECK(list.timer_runs == std::vector<int>{0, 1, 1});
+
+    // Without route information, the event visits everything.
+    alia_element_id unrouted = list.ids[0];
+    unrouted.route = 0;
+    list.send_timer(unrouted);
+    CHECK(list.timer_runs == std::vector<int>{1, 2, 2});
+}
+
+TEST_CASE("targeted events skip components across identical resolves")
+{
+    routed_list list(3);
+
+    // Resolving again reproduces the same placements, so the components can
+    // still step over theirs without another untargeted pass.
+    alia_layout_system_resolve(&list.ui->layout, {100.f, 10000.f});
+    list.send_timer(list.ids[1]);
+    CHECK(list.timer_runs == std::vector<int>{0, 1, 0});
+
+    // Changing the available space invalidates the recorded placements, so
+    // the next targeted event has to visit everything.
+    alia_layout_system_resolve(&list.ui->layout, {200.f, 10000.f});
+    list.send_timer(list.ids[1]);
+    CHECK(list.timer_runs == std::vector<int>{1, 2, 1});
+
+    // ... but that pass records them again.
+    alia_layout_system_resolve(&list.ui->layout, {200.f, 10000.f});
+    list.send_timer(list.ids[2]);
+    CHECK(list.timer_runs == std::vector<int>{1, 2, 2});
+}
+
+TEST_CASE("retained drawing replays unchanged components")
+{
+    retained_drawing_list list(3);
+
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{1, 1, 1});
+    CHECK(list.drawn == std::vector<int>{0, 1, 2});
+    alia_draw_stats stats = alia_ui_get_draw_stats(list.ui);
+    CHECK(stats.commands_recorded == 3);
+    CHECK(stats.commands_replayed == 0);
+
+    // Nothing has changed, so the second pass replays everything.
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{1, 1, 1});
+    CHECK(list.drawn == std::vector<int>{0, 1, 2});
+    stats = alia_ui_get_draw_stats(list.ui);
+    CHECK(stats.commands_recorded == 3);
+    CHECK(stats.commands_replayed == 3);
+
+    // Changing one component's value ID refreshes it, so only it redraws.
+    list.values[1] = 7;
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{1, 2, 1});
+    CHECK(list.drawn == std::vector<int>{0, 7, 2});
+    stats = alia_ui_get_draw_stats(list.ui);
+    CHECK(stats.commands_recorded == 4);
+    CHECK(stats.commands_replayed == 5);
+
+    // Changing the palette invalidates everything.
+    list.ui->palette.flat[0].r ^= 1;
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{2, 3, 2});
+    CHECK(list.drawn == std::vector<int>{0, 7, 2});
+
+    alia_ui_reset_draw_stats(list.ui);
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{2, 3, 2});
+    stats = alia_ui_get_draw_stats(list.ui);
+    CHECK(stats.commands_recorded == 0);
+    CHECK(stats.commands_replayed == 3);
+}
+
+TEST_CASE("draw damage covers only what changed")
+{
+    retained_drawing_list list(3);
+    list.track_damage();
+
+    // There's nothing to compare the first pass against.
+    list.draw_pass();
+    alia_draw_damage const* damage = alia_ui_get_draw_damage(list.ui);
+    CHECK(damage->full);
+    CHECK(list.drawn == std::vector<int>{0, 1, 2});
+
+    // If nothing changes, nothing is damaged (or drawn).
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(!damage->full);
+    CHECK(damage->count == 0);
+    CHECK(list.drawn.empty());
+
+    // Changing one component's drawing damages just its box.
+    list.values[1] = 7;
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(!damage->full);
+    REQUIRE(damage->count == 1);
+    CHECK(alia_box_equal(damage->rects[0], list.boxes[1]));
+    CHECK(list.drawn == std::vector<int>{0, 7, 2});
+
+    // Everything gets redrawn after a palette change, but the commands come
+    // out the same, so nothing is damaged.
+    list.ui->palette.flat[0].r ^= 1;
+    list.draw_pass();
+    CHECK(list.draw_runs == std::vector<int>{2, 3, 2});
+    CHECK(!damage->full);
+    CHECK(damage->count == 0);
+
+    // Resizing the surface damages everything.
+    alia_ui_surface_set_size(list.ui, {100, 5000});
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(damage->full);
+}
+
+TEST_CASE("draw damage covers effect parameters and volatile regions")
+{
+    retained_drawing_list list(3, true);
+    list.track_damage();
+    alia_draw_damage const* damage = alia_ui_get_draw_damage(list.ui);
+
+    list.draw_pass();
+    CHECK(damage->full);
+
+    // The viewport draws an external scene, so its region is damaged on
+    // every pass, even when its component replays it.
+    for (int i = 0; i != 2; ++i)
+    {
+        alia_ui_system_update(list.ui);
+        alia_ui_reset_draw_stats(list.ui);
+        list.draw_pass();
+        CHECK(alia_ui_get_draw_stats(list.ui).commands_replayed == 4);
+        CHECK(!damage->full);
+        REQUIRE(damage->count == 1);
+        CHECK(
+            damage->rects[0].min.y
+            >= list.boxes[2].min.y + list.boxes[2].size.y);
+    }
+
+    // The effect's parameters live outside of its command (at the same
+    // address on every pass), but changing them still damages the surface.
+    list.effect_param = 1.f;
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(damage->full);
+    alia_ui_system_update(list.ui);
+    list.draw_pass();
+    CHECK(!damage->full);
+    CHECK(damage->count == 1);
+}
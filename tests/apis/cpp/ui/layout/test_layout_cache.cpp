@@ -0,0 +1,461 @@
+#include <alia/test/layout/layout_test_helpers.hpp>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+
+namespace {
+
+// the parameters of a test UI that can change between refreshes
+struct cache_test_ui
+{
+    // the leaf to widen (in emission order) and by how much
+    int changed_leaf = -1;
+    float extra_width = 0.f;
+};
+
+// A column of rows with varied contents - Most of the rows are identical, so
+// their subtrees share cache entries.
+void
+emit_cache_test_ui(
+    alia_context& ctx, cache_test_ui const& ui, std::vector<alia_box>& boxes)
+{
+    int leaf_index = 0;
+    auto leaf = [&](alia_vec2f size, layout_flag_set flags = NO_FLAGS) {
+        if (leaf_index++ == ui.changed_leaf)
+            size.x += ui.extra_width;
+        alia_box box;
+        test_leaf(ctx, size, flags, &box, size.y * 0.75f, size.y * 0.25f);
+        if (!is_refresh_event(ctx))
+            boxes.push_back(box);
+    };
+    column(ctx, [&]() {
+        for (int i = 0; i != 12; ++i)
+        {
+            row(ctx, [&]() {
+                leaf(alia_vec2f_make(20.f, 10.f));
+                leaf(alia_vec2f_make(0.f, 0.f), FILL | GROW);
+                edge_offsets(ctx, {2.f, 3.f, 1.f, 4.f}, [&]() {
+                    leaf(alia_vec2f_make(30.f, 8.f), BASELINE_Y);
+                });
+            });
+        }
+        row(ctx, GROW, [&]() {
+            column(ctx, GROW, [&]() {
+                for (int i = 0; i != 4; ++i)
+                    leaf(alia_vec2f_make(15.f, 5.f), FILL);
+            });
+            flow(ctx, GROW, [&]() {
+                for (int i = 0; i != 6; ++i)
+                {
+                    row(ctx, [&]() {
+                        leaf(alia_vec2f_make(12.f, 6.f));
+                        leaf(alia_vec2f_make(7.f, 6.f));
+                    });
+                }
+            });
+        });
+    });
+}
+
+std::vector<alia_box>
+lay_out(
+    layout_test_fixture* fixture, cache_test_ui const& ui, alia_vec2f size)
+{
+    std::vector<alia_box> boxes;
+    layout_test_fixture_run_refresh(fixture, [&](alia_context* ctx) {
+        emit_cache_test_ui(*ctx, ui, boxes);
+    });
+    layout_test_fixture_resolve(fixture, size);
+    layout_test_fixture_run_spatial(fixture, [&](alia_context* ctx) {
+        emit_cache_test_ui(*ctx, ui, boxes);
+    });
+    return boxes;
+}
+
+// Lay out `ui` with a fresh fixture (and therefore an empty cache).
+std::vector<alia_box>
+lay_out_fresh(cache_test_ui const& ui, alia_vec2f size)
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    auto boxes = lay_out(fixture, ui, size);
+    layout_test_fixture_destroy(fixture);
+    return boxes;
+}
+
+bool
+boxes_match(std::vector<alia_box> const& a, std::vector<alia_box> const& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i != a.size(); ++i)
+    {
+        if (!alia_box_equal(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+// A column of flows, like paragraphs of text - These mix in the features that
+// affect line breaking (gaps, springs, nested runs, line gaps and minimum line
+// heights, justification and baselines).
+void
+emit_paragraph_ui(alia_context& ctx, std::vector<alia_box>& boxes)
+{
+    auto word = [&](int i) {
+        float const width = float(10 + (i * 37) % 45);
+        alia_box box;
+        test_leaf(ctx, alia_vec2f_make(width, 12.f), NO_FLAGS, &box, 9.f, 3.f);
+        if (!is_refresh_event(ctx))
+            boxes.push_back(box);
+    };
+    column(ctx, gap(5.f), [&]() {
+        flow(ctx, gap(4.f), line_gap(2.f), [&]() {
+            for (int i = 0; i != 40; ++i)
+                word(i);
+        });
+        flow(ctx, JUSTIFY_SPACE_BETWEEN, [&]() {
+            for (int i = 0; i != 30; ++i)
+            {
+                word(i + 7);
+                if (i % 3 == 0)
+                    test_flow_spring(ctx);
+            }
+        });
+        flow(ctx, gap(3.f), minimum_line_height(20.f), [&]() {
+            for (int i = 0; i != 12; ++i)
+            {
+                word(i + 3);
+                edge_offsets(ctx, {2.f, 5.f, 1.f, 1.f}, [&]() {
+                    word(i + 11);
+                    word(i + 17);
+                });
+            }
+        });
+    });
+}
+
+std::vector<alia_box>
+lay_out_paragraphs(layout_test_fixture* fixture, alia_vec2f size)
+{
+    std::vector<alia_box> boxes;
+    layout_test_fixture_run_refresh(fixture, [&](alia_context* ctx) {
+        emit_paragraph_ui(*ctx, boxes);
+    });
+    layout_test_fixture_resolve(fixture, size);
+    layout_test_fixture_run_spatial(fixture, [&](alia_context* ctx) {
+        emit_paragraph_ui(*ctx, boxes);
+    });
+    return boxes;
+}
+
+std::vector<alia_box>
+lay_out_paragraphs_fresh(alia_vec2f size)
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    auto boxes = lay_out_paragraphs(fixture, size);
+    layout_test_fixture_destroy(fixture);
+    return boxes;
+}
+
+// A grid between a growing leaf and a row - Changing the available height
+// moves the grid without changing its width. The grid's cells include
+// containers, which go through the cache themselves.
+void
+emit_grid_test_ui(
+    alia_context& ctx, cache_test_ui const& ui, std::vector<alia_box>& boxes)
+{
+    int leaf_index = 0;
+    auto leaf = [&](alia_vec2f size, layout_flag_set flags = NO_FLAGS) {
+        if (leaf_index++ == ui.changed_leaf)
+            size.x += ui.extra_width;
+        alia_box box;
+        test_leaf(ctx, size, flags, &box, size.y * 0.75f, size.y * 0.25f);
+        if (!is_refresh_event(ctx))
+            boxes.push_back(box);
+    };
+    column(ctx, [&]() {
+        leaf(alia_vec2f_make(20.f, 10.f), GROW);
+        grid(ctx, [&](alia_layout_grid_handle grid) {
+            for (int i = 0; i != 8; ++i)
+            {
+                grid_row(ctx, grid, [&]() {
+                    leaf(alia_vec2f_make(10.f + float(i % 3), 10.f));
+                    row(ctx, [&]() {
+                        leaf(alia_vec2f_make(8.f, 6.f));
+                        leaf(alia_vec2f_make(0.f, 0.f), FILL | GROW);
+                    });
+                    edge_offsets(ctx, {2.f, 3.f, 1.f, 4.f}, [&]() {
+                        leaf(alia_vec2f_make(12.f, 8.f), BASELINE_Y);
+                    });
+                });
+            }
+        });
+        row(ctx, [&]() {
+            leaf(alia_vec2f_make(30.f, 5.f));
+            leaf(alia_vec2f_make(15.f, 5.f));
+        });
+    });
+}
+
+std::vector<alia_box>
+lay_out_grid(
+    layout_test_fixture* fixture, cache_test_ui const& ui, alia_vec2f size)
+{
+    std::vector<alia_box> boxes;
+    layout_test_fixture_run_refresh(fixture, [&](alia_context* ctx) {
+        emit_grid_test_ui(*ctx, ui, boxes);
+    });
+    layout_test_fixture_resolve(fixture, size);
+    layout_test_fixture_run_spatial(fixture, [&](alia_context* ctx) {
+        emit_grid_test_ui(*ctx, ui, boxes);
+    });
+    return boxes;
+}
+
+std::vector<alia_box>
+lay_out_grid_fresh(cache_test_ui const& ui, alia_vec2f size)
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    auto boxes = lay_out_grid(fixture, ui, size);
+    layout_test_fixture_destroy(fixture);
+    return boxes;
+}
+
+alia::layout_cache_stats
+cache_stats(layout_test_fixture* fixture)
+{
+    return layout_fixture_layout_system(fixture)->cache.stats;
+}
+
+} // namespace
+
+TEST_CASE("layout cache reuses results for an unchanged tree")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    cache_test_ui const ui;
+    alia_vec2f const size = alia_vec2f_make(400.f, 300.f);
+
+    auto const first = lay_out(fixture, ui, size);
+    CHECK(cache_stats(fixture).misses > 0);
+
+    auto const second = lay_out(fixture, ui, size);
+    CHECK(boxes_match(first, second));
+    CHECK(cache_stats(fixture).misses == 0);
+    CHECK(cache_stats(fixture).hits > 0);
+    CHECK(cache_stats(fixture).placement_copies > 0);
+    CHECK(cache_stats(fixture).rebuilds == 0);
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache reuses the placements of identical siblings")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    alia_vec2f const size = alia_vec2f_make(400.f, 300.f);
+
+    // Change a leaf in the last row, which leaves the boxes of the 12
+    // identical rows above it alone. Each of those should find its own
+    // placement data, even though they all share a content hash.
+    cache_test_ui ui;
+    lay_out(fixture, ui, size);
+    for (int step = 1; step != 4; ++step)
+    {
+        CAPTURE(step);
+        ui.changed_leaf = 40;
+        ui.extra_width = float(step);
+        auto const incremental = lay_out(fixture, ui, size);
+        CHECK(boxes_match(incremental, lay_out_fresh(ui, size)));
+        CHECK(cache_stats(fixture).placement_copies >= 12);
+    }
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache matches full layout as leaves change")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    alia_vec2f const size = alia_vec2f_make(400.f, 300.f);
+
+    // Walk through a series of changes (including ones that shift later
+    // rows, change the column width, and touch leaves inside the flow), and
+    // check each incremental layout against a fresh one.
+    cache_test_ui ui;
+    for (int step = 0; step != 24; ++step)
+    {
+        ui.changed_leaf = (step * 7) % 52;
+        ui.extra_width = float(step % 4) * 40.f;
+        auto const incremental = lay_out(fixture, ui, size);
+        auto const fresh = lay_out_fresh(ui, size);
+        CAPTURE(step);
+        CHECK(boxes_match(incremental, fresh));
+    }
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache matches full layout as the available size changes")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    cache_test_ui const ui;
+
+    for (float width : {400.f, 300.f, 400.f, 220.f, 600.f, 600.f})
+    {
+        alia_vec2f const size = alia_vec2f_make(width, 300.f);
+        auto const incremental = lay_out(fixture, ui, size);
+        auto const fresh = lay_out_fresh(ui, size);
+        CAPTURE(width);
+        CHECK(boxes_match(incremental, fresh));
+    }
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache remeasures cached subtrees at new widths")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    cache_test_ui const ui;
+
+    lay_out(fixture, ui, alia_vec2f_make(400.f, 300.f));
+    alia_vec2f const size = alia_vec2f_make(500.f, 300.f);
+    auto const incremental = lay_out(fixture, ui, size);
+    CHECK(cache_stats(fixture).rebuilds > 0);
+    CHECK(boxes_match(incremental, lay_out_fresh(ui, size)));
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache reuses flow line breaks within their width range")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+
+    // Drag the width down a pixel at a time. Most steps stay within the slack
+    // of every line, so most flows should reuse their breaks.
+    int steps = 0, flows_rebroken = 0;
+    for (float width = 300.f; width != 240.f; width -= 1.f, ++steps)
+    {
+        alia_vec2f const size = alia_vec2f_make(width, 1000.f);
+        auto const incremental = lay_out_paragraphs(fixture, size);
+        CAPTURE(width);
+        CHECK(boxes_match(incremental, lay_out_paragraphs_fresh(size)));
+        // (Each flow is looked up twice per resolve, so one that misses in
+        // the vertical pass hits while its boxes are assigned.)
+        alia::layout_cache_stats const stats = cache_stats(fixture);
+        CHECK(stats.line_break_hits + stats.line_break_misses == 6);
+        flows_rebroken += int(stats.line_break_misses);
+    }
+    CHECK(flows_rebroken > 0);
+    CHECK(flows_rebroken < steps);
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache rebreaks flow lines outside their width range")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+
+    for (float width : {300.f, 120.f, 301.f, 60.f, 800.f, 300.f, 299.5f})
+    {
+        alia_vec2f const size = alia_vec2f_make(width, 1000.f);
+        auto const incremental = lay_out_paragraphs(fixture, size);
+        CAPTURE(width);
+        CHECK(boxes_match(incremental, lay_out_paragraphs_fresh(size)));
+    }
+
+    // Jumping between widths that break the lines differently has to
+    // rebreak them.
+    lay_out_paragraphs(fixture, alia_vec2f_make(120.f, 1000.f));
+    CHECK(cache_stats(fixture).line_break_misses > 0);
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache reuses unchanged grids")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    cache_test_ui ui;
+
+    lay_out_grid(fixture, ui, alia_vec2f_make(400.f, 300.f));
+
+    // Changing the leaf below the grid leaves the grid alone.
+    ui.changed_leaf = 33;
+    ui.extra_width = 10.f;
+    alia_vec2f const size = alia_vec2f_make(400.f, 300.f);
+    auto const changed = lay_out_grid(fixture, ui, size);
+    CHECK(boxes_match(changed, lay_out_grid_fresh(ui, size)));
+    alia::layout_cache_stats stats = cache_stats(fixture);
+    CHECK(stats.placement_copies == 1);
+    CHECK(stats.rebuilds == 0);
+
+    // Changing the available height just moves it.
+    alia_vec2f const taller = alia_vec2f_make(400.f, 350.f);
+    auto const moved = lay_out_grid(fixture, ui, taller);
+    CHECK(boxes_match(moved, lay_out_grid_fresh(ui, taller)));
+    stats = cache_stats(fixture);
+    CHECK(stats.misses == 0);
+    CHECK(stats.rebuilds == 0);
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("layout cache matches full layout for grids")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+
+    // Walk through changes inside and outside the grid, along with changes
+    // to the available size that move or resize it.
+    cache_test_ui ui;
+    for (int step = 0; step != 24; ++step)
+    {
+        ui.changed_leaf = (step * 11) % 35;
+        ui.extra_width = float(step % 3) * 15.f;
+        alia_vec2f const size = alia_vec2f_make(
+            step % 4 == 3 ? 200.f : 400.f, 300.f + float(step % 5) * 10.f);
+        auto const incremental = lay_out_grid(fixture, ui, size);
+        auto const fresh = lay_out_grid_fresh(ui, size);
+        CAPTURE(step);
+        CHECK(boxes_match(incremental, fresh));
+    }
+
+    layout_test_fixture_destroy(fixture);
+}
+
+TEST_CASE("cached grids survive parallel resolves")
+{
+    layout_test_fixture* fixture = layout_test_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    cache_test_ui const ui;
+    std::vector<alia_box> boxes;
+    auto resolve = [&](alia_vec2f size) {
+        boxes.clear();
+        layout_test_fixture_resolve(fixture, size);
+        layout_test_fixture_run_spatial(fixture, [&](alia_context* ctx) {
+            emit_grid_test_ui(*ctx, ui, boxes);
+        });
+        CHECK(boxes_match(boxes, lay_out_grid_fresh(ui, size)));
+    };
+
+    // The parallel resolve measures the grid's rows in chunks (bypassing the
+    // cache), which mustn't confuse the serial resolve that replays the
+    // grid's cached results afterwards.
+    layout_test_fixture_run_refresh(fixture, [&](alia_context* ctx) {
+        emit_grid_test_ui(*ctx, ui, boxes);
+    });
+    resolve(alia_vec2f_make(400.f, 300.f));
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 4, .min_fork_size = 1});
+    resolve(alia_vec2f_make(400.f, 300.f));
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 1, .min_fork_size = 0});
+    resolve(alia_vec2f_make(400.f, 350.f));
+    CHECK(cache_stats(fixture).rebuilds == 0);
+
+    layout_test_fixture_destroy(fixture);
+}
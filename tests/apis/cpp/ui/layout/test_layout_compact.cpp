@@ -0,0 +1,164 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/layout_test_helpers.hpp>
+#include <alia/test/layout/scenarios.h>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/system.h>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+
+namespace {
+
+typedef std::function<void(alia_context*)> test_ui;
+
+// Refresh and resolve `ui` with the given storage, returning the placement
+// data that the resolve produced.
+std::vector<uint8_t>
+lay_out(test_ui ui, alia_layout_storage storage, alia_vec2f size)
+{
+    return layout_fixture_lay_out_fresh(ui, size, [&](layout_fixture* f) {
+        alia_layout_system_set_storage(
+            layout_fixture_layout_system(f), storage);
+    });
+}
+
+std::vector<uint8_t>
+lay_out_linked(test_ui const& ui, alia_vec2f size)
+{
+    return lay_out(ui, ALIA_LAYOUT_STORAGE_LINKED, size);
+}
+
+// a mix of the containers that compact storage flattens and the ones that it
+// treats as opaque
+void
+emit_mixed_ui(alia_context& ctx)
+{
+    static alia_box provided_boxes[2];
+    auto leaf = [&](float width, float height, layout_flag_set flags) {
+        test_leaf(ctx, alia_vec2f_make(width, height), flags);
+    };
+    column(ctx, gap(3.f), &provided_boxes[0], [&]() {
+        for (int i = 0; i != 5; ++i)
+        {
+            row(ctx, BASELINE_Y, gap(float(i)), [&]() {
+                leaf(20.f, 10.f, NO_FLAGS);
+                leaf(0.f, 0.f, FILL | GROW);
+                leaf(float(i * 7), 12.f, BASELINE_Y);
+                edge_offsets(ctx, {2.f, 3.f, 1.f, 4.f}, [&]() {
+                    leaf(30.f, 8.f, CENTER);
+                });
+            });
+        }
+        row(ctx, GROW, [&]() {
+            column(ctx, GROW | ALIGN_RIGHT, &provided_boxes[1], [&]() {
+                for (int i = 0; i != 4; ++i)
+                    leaf(15.f + float(i), 5.f, i % 2 == 0 ? FILL : CENTER_X);
+            });
+            flow(ctx, GROW, [&]() {
+                for (int i = 0; i != 6; ++i)
+                {
+                    row(ctx, [&]() {
+                        leaf(12.f, 6.f, NO_FLAGS);
+                        leaf(7.f, 6.f, NO_FLAGS);
+                    });
+                }
+            });
+        });
+        grid(ctx, [&](alia_layout_grid_handle grid) {
+            for (int i = 0; i != 3; ++i)
+            {
+                grid_row(ctx, grid, [&]() {
+                    leaf(10.f * float(i + 1), 5.f, NO_FLAGS);
+                    column(ctx, [&]() {
+                        leaf(8.f, 4.f, NO_FLAGS);
+                        leaf(0.f, 0.f, FILL | GROW);
+                    });
+                });
+            }
+        });
+        column(ctx, ALIGN_END, [&]() {});
+    });
+}
+
+} // namespace
+
+TEST_CASE("compact layout matches linked layout on every scenario")
+{
+    alia_vec2f const sizes[] = {
+        alia_vec2f_make(10'000.f, 10'000.f), alia_vec2f_make(300.f, 200.f)};
+    for (alia_layout_scenario_info const& s :
+         alia_layout_small_scenario_table())
+    {
+        CAPTURE(s.name);
+        for (alia_vec2f const& size : sizes)
+        {
+            test_ui const ui
+                = [&](alia_context* ctx) { s.fn(ctx, nullptr); };
+            auto const linked = lay_out_linked(ui, size);
+            REQUIRE(!linked.empty());
+            CHECK(lay_out(ui, ALIA_LAYOUT_STORAGE_COMPACT, size) == linked);
+        }
+    }
+}
+
+TEST_CASE("compact layout matches linked layout on a mixed tree")
+{
+    test_ui const ui = [](alia_context* ctx) { emit_mixed_ui(*ctx); };
+    for (float width : {50.f, 200.f, 600.f})
+    {
+        CAPTURE(width);
+        alia_vec2f const size = alia_vec2f_make(width, 400.f);
+        auto const linked = lay_out_linked(ui, size);
+        REQUIRE(!linked.empty());
+        CHECK(lay_out(ui, ALIA_LAYOUT_STORAGE_COMPACT, size) == linked);
+    }
+}
+
+TEST_CASE("compact layout follows changes to the tree")
+{
+    test_ui small = [](alia_context* ctx) {
+        alia_layout_scenario_column_of_rows_100(ctx, nullptr);
+    };
+    test_ui mixed = [](alia_context* ctx) { emit_mixed_ui(*ctx); };
+    alia_vec2f const size = alia_vec2f_make(400.f, 300.f);
+
+    layout_fixture* fixture = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_COMPACT);
+
+    layout_test_fixture_run_refresh(fixture, small);
+    layout_fixture_resolve(fixture, size);
+    CHECK(
+        layout_fixture_placement_data(fixture)
+        == lay_out_linked(small, size));
+    // Resolving again (without a refresh) reuses the compact tree.
+    layout_fixture_resolve(fixture, alia_vec2f_make(100.f, 50.f));
+    CHECK(
+        layout_fixture_placement_data(fixture)
+        == lay_out_linked(small, alia_vec2f_make(100.f, 50.f)));
+
+    layout_test_fixture_run_refresh(fixture, mixed);
+    layout_fixture_resolve(fixture, size);
+    CHECK(
+        layout_fixture_placement_data(fixture)
+        == lay_out_linked(mixed, size));
+
+    // Switching back to linked storage drops the compact tree.
+    alia_layout_system_set_storage(system, ALIA_LAYOUT_STORAGE_LINKED);
+    CHECK(system->compact == nullptr);
+    layout_fixture_resolve(fixture, size);
+    CHECK(
+        layout_fixture_placement_data(fixture)
+        == lay_out_linked(mixed, size));
+
+    layout_fixture_destroy(fixture);
+}
@@ -0,0 +1,381 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/layout_test_helpers.hpp>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/protocol.h>
+#include <alia/abi/ui/layout/utilities/emission.h>
+#include <alia/abi/ui/layout/utilities/flow.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/events.hpp>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/layout/components/flow.h>
+#include <alia/ui/layout/fragment_batch.h>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+
+namespace {
+
+// KERNELS
+
+// a deterministic stream of pseudorandom numbers
+struct test_random
+{
+    uint32_t state = 12345;
+
+    uint32_t
+    next()
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // a value on the 1/64 grid in [0, range)
+    float
+    exact_value(int range)
+    {
+        return float(next() % uint32_t(range * 64)) / 64.f;
+    }
+};
+
+} // namespace
+
+TEST_CASE("flow batch prefix sums match scalar sums")
+{
+    test_random random;
+    for (size_t count : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 63, 100, 1000})
+    {
+        CAPTURE(count);
+        std::vector<float> values(count);
+        for (float& value : values)
+            value = random.exact_value(100);
+        std::vector<float> expected(count);
+        float sum = 0.f;
+        for (size_t i = 0; i != count; ++i)
+        {
+            sum += values[i];
+            expected[i] = sum;
+        }
+        flow_batch_prefix_sums(values.data(), count);
+        CHECK(values == expected);
+    }
+}
+
+TEST_CASE("flow batch search finds the first exceeding value")
+{
+    std::vector<float> values(50);
+    for (size_t i = 0; i != values.size(); ++i)
+        values[i] = float(i * 10);
+    for (size_t begin : {0, 1, 5, 13})
+    {
+        for (size_t end : {13, 14, 21, 50})
+        {
+            for (float limit : {-1.f, 0.f, 95.f, 100.f, 101.f, 1000.f})
+            {
+                CAPTURE(begin);
+                CAPTURE(end);
+                CAPTURE(limit);
+                size_t expected = begin;
+                while (expected != end && 5.f + values[expected] <= limit)
+                    ++expected;
+                CHECK(
+                    flow_batch_find_exceeding(
+                        values.data(), begin, end, 5.f, limit)
+                    == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("flow batch max matches a scalar max")
+{
+    test_random random;
+    std::vector<float> values(40);
+    for (float& value : values)
+        value = float(random.next() % 1000) * 0.37f;
+    for (size_t begin : {0, 1, 3, 8})
+    {
+        for (size_t end : {8, 9, 12, 17, 40})
+        {
+            for (float initial : {0.f, 200.f, 1e6f})
+            {
+                float expected = initial;
+                for (size_t i = begin; i != end; ++i)
+                    expected = alia_max(expected, values[i]);
+                CHECK(
+                    flow_batch_max(values.data(), begin, end, initial)
+                    == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("flow batch exactness")
+{
+    CHECK(flow_batch_value_is_exact(0.f));
+    CHECK(flow_batch_value_is_exact(12.f));
+    CHECK(flow_batch_value_is_exact(12.015625f));
+    CHECK(!flow_batch_value_is_exact(0.1f));
+    CHECK(!flow_batch_value_is_exact(flow_batch_exact_limit));
+}
+
+namespace {
+
+// FLOWS
+
+// A layout node that emits a fixed list of fragments into its flow (like a
+// text node does for its words and spaces) and records the placement of each
+// one.
+struct fragment_stream_node
+{
+    alia_layout_node base;
+    std::vector<alia_flow_fragment> const* fragments;
+};
+
+alia_horizontal_requirements
+fragment_stream_measure_horizontal(
+    alia_measurement_context*, alia_layout_node*)
+{
+    return alia_horizontal_requirements{};
+}
+
+alia_vertical_requirements
+fragment_stream_measure_vertical(
+    alia_measurement_context*, alia_main_axis_index, alia_layout_node*, float)
+{
+    return alia_vertical_requirements{};
+}
+
+void
+fragment_stream_assign_boxes(
+    alia_placement_context*,
+    alia_main_axis_index,
+    alia_layout_node*,
+    alia_box,
+    float)
+{
+}
+
+alia_flow_emission_counts
+fragment_stream_count_flow_emissions(
+    alia_measurement_context*, alia_layout_node* node)
+{
+    auto& stream = *reinterpret_cast<fragment_stream_node*>(node);
+    return alia_flow_emission_counts_with_run_scope(alia_flow_emission_counts{
+        .fragment_count = int(stream.fragments->size())});
+}
+
+void
+fragment_stream_emit_flow_fragments(
+    alia_measurement_context*,
+    alia_layout_node* node,
+    alia_flow_fragment_emitter* emitter)
+{
+    auto& stream = *reinterpret_cast<fragment_stream_node*>(node);
+    alia_flow_emit_run_push_control(emitter, alia_edge_offsets{});
+    for (alia_flow_fragment const& fragment : *stream.fragments)
+        alia_layout_emit_flow_fragment_raw(emitter, fragment);
+    alia_flow_emit_run_pop_control(emitter);
+}
+
+void
+fragment_stream_read_fragment_placements(
+    alia_placement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_reader* reader)
+{
+    auto& stream = *reinterpret_cast<fragment_stream_node*>(node);
+    alia_layout_skip_flow_run_push_fragment(reader);
+    for (size_t i = 0; i != stream.fragments->size(); ++i)
+    {
+        *arena_alloc<alia_flow_fragment_placement>(ctx->arena)
+            = *alia_layout_read_fragment_placement(reader);
+        alia_layout_advance_fragment(reader);
+    }
+    alia_layout_skip_flow_run_pop_fragment(reader);
+}
+
+alia_layout_node_vtable fragment_stream_vtable
+    = {fragment_stream_measure_horizontal,
+       fragment_stream_measure_vertical,
+       fragment_stream_assign_boxes,
+       fragment_stream_count_flow_emissions,
+       fragment_stream_emit_flow_fragments,
+       fragment_stream_read_fragment_placements};
+
+void
+fragment_stream(
+    alia_context& ctx, std::vector<alia_flow_fragment> const& fragments)
+{
+    if (!is_refresh_event(ctx))
+        return;
+    auto& emission = ctx.layout->emission;
+    auto* node = arena_alloc<fragment_stream_node>(emission.arena);
+    alia_layout_emit_node(&emission, &node->base);
+    *node = fragment_stream_node{
+        .base = {.vtable = &fragment_stream_vtable, .next_sibling = nullptr},
+        .fragments = &fragments};
+}
+
+enum class width_kind
+{
+    // integer widths
+    INTEGER,
+    // widths on the 1/64 grid (like 26.6 font metrics)
+    GRID,
+    // arbitrary fractional widths
+    FRACTIONAL
+};
+
+// Generate a stream of words, spaces, gaps and occasional forced breaks.
+std::vector<alia_flow_fragment>
+make_fragments(int count, width_kind widths, uint32_t seed)
+{
+    test_random random{.state = seed};
+    auto width = [&]() {
+        switch (widths)
+        {
+            case width_kind::INTEGER:
+                return float(3 + random.next() % 40);
+            case width_kind::GRID:
+                return 3.f + random.exact_value(40);
+            case width_kind::FRACTIONAL:
+            default:
+                return 3.f + float(random.next() % 4000) * 0.0107f;
+        }
+    };
+    auto content
+        = [&](alia_flow_fragment_flags flags, float height, float ascent) {
+              return alia_flow_fragment{
+                  .flags = flags,
+                  .kind = ALIA_FLOW_FRAGMENT_KIND_CONTENT,
+                  .content = alia_layout_content_metrics{
+                      .size = alia_vec2f_make(width(), height),
+                      .ascent = ascent,
+                      .descent = height - ascent}};
+          };
+    std::vector<alia_flow_fragment> fragments;
+    for (int i = 0; i != count; ++i)
+    {
+        uint32_t const roll = random.next() % 100;
+        if (roll < 50)
+        {
+            float const height = float(10 + random.next() % 8);
+            fragments.push_back(content(0, height, height - 3.f));
+        }
+        else if (roll < 80)
+        {
+            fragments.push_back(
+                content(ALIA_FLOW_FRAGMENT_SUPPRESS_AT_LINE_EDGES, 12.f, 9.f));
+        }
+        else if (roll < 92)
+        {
+            alia_flow_fragment gap;
+            gap.flags = ALIA_FLOW_FRAGMENT_CONTROL_BASE_FLAGS;
+            gap.kind = ALIA_FLOW_FRAGMENT_KIND_GAP;
+            gap.gap.gap = width() * 0.25f;
+            fragments.push_back(gap);
+        }
+        else if (roll < 98)
+        {
+            fragments.push_back(content(
+                ALIA_FLOW_FRAGMENT_EXPANDABLE
+                    | ALIA_FLOW_FRAGMENT_OMIT_FROM_BOUNDS,
+                4.f,
+                2.f));
+        }
+        else
+        {
+            fragments.push_back(content(
+                ALIA_FLOW_FRAGMENT_BREAK_AFTER
+                    | ALIA_FLOW_FRAGMENT_OMIT_FROM_BOUNDS,
+                12.f,
+                9.f));
+        }
+    }
+    return fragments;
+}
+
+struct flow_test_content
+{
+    std::vector<alia_flow_fragment> integer
+        = make_fragments(600, width_kind::INTEGER, 1);
+    std::vector<alia_flow_fragment> grid
+        = make_fragments(600, width_kind::GRID, 2);
+    std::vector<alia_flow_fragment> fractional
+        = make_fragments(600, width_kind::FRACTIONAL, 3);
+};
+
+void
+emit_flow_test_ui(alia_context& ctx, flow_test_content const& content)
+{
+    column(ctx, gap(6.f), [&]() {
+        flow(ctx, gap(3.f), line_gap(2.f), [&]() {
+            fragment_stream(ctx, content.integer);
+        });
+        flow(ctx, JUSTIFY_SPACE_BETWEEN, [&]() {
+            fragment_stream(ctx, content.grid);
+            test_flow_spring(ctx, 5.f);
+            fragment_stream(ctx, content.integer);
+        });
+        flow(ctx, JUSTIFY_CENTER, minimum_line_height(20.f), [&]() {
+            fragment_stream(ctx, content.fractional);
+            edge_offsets(ctx, {2.f, 5.f, 1.f, 1.f}, [&]() {
+                fragment_stream(ctx, content.grid);
+            });
+            for (int i = 0; i != 100; ++i)
+                test_leaf(ctx, alia_vec2f_make(float(i % 7) + 0.5f, 10.f));
+        });
+        flow(ctx, JUSTIFY_SPACE_EVENLY, gap(1.5f), [&]() {
+            for (int i = 0; i != 200; ++i)
+            {
+                test_leaf(
+                    ctx,
+                    alia_vec2f_make(float(5 + i % 11), 12.f),
+                    BASELINE_Y,
+                    nullptr,
+                    9.f,
+                    3.f);
+            }
+        });
+    });
+}
+
+// the placement data written by laying out `content` at `width` with
+// `min_fragments` as the batching threshold
+std::vector<uint8_t>
+lay_out(flow_test_content const& content, float width, int min_fragments)
+{
+    int const saved_min_fragments = flow_batch_min_fragments;
+    flow_batch_min_fragments = min_fragments;
+    auto placements = layout_fixture_lay_out_fresh(
+        [&](alia_context* ctx) { emit_flow_test_ui(*ctx, content); },
+        alia_vec2f_make(width, 10'000.f));
+    flow_batch_min_fragments = saved_min_fragments;
+    return placements;
+}
+
+} // namespace
+
+TEST_CASE("batched flows match unbatched flows")
+{
+    flow_test_content const content;
+    // (Batches are only used at widths where lines hold many fragments.)
+    for (float width :
+         {1.f, 47.5f, 173.25f, 400.f, 1000.f, 1234.5f, 2500.f, 100'000.f})
+    {
+        CAPTURE(width);
+        auto const unbatched = lay_out(content, width, INT_MAX);
+        REQUIRE(!unbatched.empty());
+        CHECK(lay_out(content, width, 0) == unbatched);
+        CHECK(lay_out(content, width, flow_batch_min_fragments) == unbatched);
+    }
+}
@@ -0,0 +1,183 @@
+#include <alia/abi/ui/layout/api.h>
+
+#include <alia/abi/kernel/events.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/kernel/flow/dispatch.h>
+#include <alia/impl/events.hpp>
+#include <alia/ui/system/object.h>
+
+#include <doctest/doctest.h>
+
+#include <new>
+#include <vector>
+
+using namespace alia;
+
+namespace {
+
+// a grid of fixed-size cells (given by their widths, row by row), driven by
+// a full UI system, so that the grid keeps its column cache across updates
+struct grid_log
+{
+    std::vector<std::vector<float>> widths;
+    // the boxes of the cells, row by row, as of the last non-refresh pass
+    std::vector<alia_box> boxes;
+
+    alia_ui_system* ui = nullptr;
+
+    explicit grid_log(std::vector<std::vector<float>> widths)
+        : widths(std::move(widths))
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {400, 400});
+        update();
+    }
+
+    ~grid_log()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    // Refresh and then do a full non-refresh pass so that the cells know
+    // their placements.
+    void
+    update()
+    {
+        alia_ui_system_update(ui);
+        alia_event hit_test = alia_make_mouse_hit_test_event(
+            {.x = -1.f, .y = -1.f, .result = {}});
+        dispatch_event(*ui, hit_test);
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& log = *static_cast<grid_log*>(user_data);
+        bool const refreshing = is_refresh_event(*ctx);
+        if (!refreshing)
+            log.boxes.clear();
+        alia_layout_grid_handle grid = alia_layout_grid_begin(ctx, 0);
+        for (auto const& row : log.widths)
+        {
+            alia_layout_grid_row_begin(ctx, grid, 0);
+            for (float width : row)
+            {
+                if (refreshing)
+                {
+                    alia_layout_leaf_emit(
+                        ctx,
+                        alia_layout_content_metrics_make(
+                            alia_vec2f_make(width, 10.f)),
+                        0);
+                }
+                else
+                {
+                    log.boxes.push_back(alia_layout_consume_box(ctx));
+                }
+            }
+            alia_layout_grid_row_end(ctx);
+        }
+        alia_layout_grid_end(ctx);
+    }
+};
+
+// Check that `log` matches a grid that's laid out from scratch with the same
+// cells.
+void
+check_against_fresh_grid(grid_log const& log)
+{
+    grid_log fresh(log.widths);
+    REQUIRE(log.boxes.size() == fresh.boxes.size());
+    for (size_t i = 0; i != log.boxes.size(); ++i)
+    {
+        CAPTURE(i);
+        CHECK(log.boxes[i].min.x == fresh.boxes[i].min.x);
+        CHECK(log.boxes[i].min.y == fresh.boxes[i].min.y);
+        CHECK(log.boxes[i].size.x == fresh.boxes[i].size.x);
+        CHECK(log.boxes[i].size.y == fresh.boxes[i].size.y);
+    }
+}
+
+} // namespace
+
+TEST_CASE("grid columns follow changes in their cells")
+{
+    grid_log log({{10, 20, 30}, {40, 10, 10}, {10, 50, 10}});
+    check_against_fresh_grid(log);
+    float const second_column = log.boxes.at(1).min.x;
+    float const third_column = log.boxes.at(2).min.x;
+
+    // Widening a cell widens its column.
+    log.widths[1][0] = 60;
+    log.update();
+    check_against_fresh_grid(log);
+    CHECK(log.boxes.at(1).min.x > second_column);
+
+    // Narrowing the widest cell in a column narrows the column.
+    log.widths[1][0] = 40;
+    log.update();
+    check_against_fresh_grid(log);
+    CHECK(log.boxes.at(1).min.x == second_column);
+
+    log.widths[2][1] = 5;
+    log.update();
+    check_against_fresh_grid(log);
+    CHECK(log.boxes.at(2).min.x < third_column);
+}
+
+TEST_CASE("grid columns follow changes in their rows")
+{
+    grid_log log({{10, 20}, {40, 10}, {10, 50, 70}});
+    check_against_fresh_grid(log);
+
+    // Removing the only row with a third cell removes the third column.
+    log.widths.pop_back();
+    log.update();
+    check_against_fresh_grid(log);
+
+    // Removing the row with the widest first cell narrows the first column.
+    log.widths.erase(log.widths.begin() + 1);
+    log.update();
+    check_against_fresh_grid(log);
+
+    // Rows (and columns) can also be added back.
+    log.widths.push_back({30, 30, 30, 30});
+    log.widths.push_back({});
+    log.update();
+    check_against_fresh_grid(log);
+
+    log.widths.clear();
+    log.update();
+    CHECK(log.boxes.empty());
+}
+
+TEST_CASE("grids keep their columns across updates")
+{
+    std::vector<std::vector<float>> widths;
+    for (int i = 0; i != 200; ++i)
+        widths.push_back({float(i % 17), float(i % 13 * 2), 5.f});
+    grid_log log(widths);
+
+    // Nothing changes, so the layout doesn't either.
+    std::vector<alia_box> const before = log.boxes;
+    log.update();
+    log.update();
+    REQUIRE(log.boxes.size() == before.size());
+    for (size_t i = 0; i != before.size(); ++i)
+    {
+        CAPTURE(i);
+        CHECK(log.boxes[i].min.x == before[i].min.x);
+        CHECK(log.boxes[i].size.x == before[i].size.x);
+    }
+
+    // Changes are picked up wherever they are.
+    log.widths[123][2] = 80.f;
+    log.widths[7][0] = 0.f;
+    log.update();
+    check_against_fresh_grid(log);
+}
@@ -0,0 +1,120 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/scenarios.h>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/system.h>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+typedef alia_layout_scenario_info test_scenario;
+
+// the parallel configurations to check against serial resolves - These go
+// from forking (nearly) every container to only forking the largest ones.
+alia_layout_parallelism const configurations[] = {
+    {.thread_count = 4, .min_fork_size = 1},
+    {.thread_count = 4, .min_fork_size = 16},
+    {.thread_count = 3, .min_fork_size = 200},
+    {.thread_count = 2, .min_fork_size = 0},
+};
+
+// Refresh and resolve `scenario` (with `change`) in `fixture`, returning the
+// placement data that the resolve produced.
+std::vector<uint8_t>
+lay_out(
+    layout_fixture* fixture,
+    test_scenario const& scenario,
+    alia_layout_scenario_change* change,
+    alia_vec2f size)
+{
+    return layout_fixture_lay_out(
+        fixture,
+        [&](alia_context* ctx) { scenario.fn(ctx, change); },
+        size);
+}
+
+// Lay out `scenario` with a fresh, serial fixture.
+std::vector<uint8_t>
+lay_out_serially(
+    test_scenario const& scenario,
+    alia_layout_scenario_change* change,
+    alia_vec2f size)
+{
+    return layout_fixture_lay_out_fresh(
+        [&](alia_context* ctx) { scenario.fn(ctx, change); }, size);
+}
+
+} // namespace
+
+TEST_CASE("parallel layout matches serial layout on every scenario")
+{
+    alia_vec2f const size = alia_vec2f_make(10'000.f, 10'000.f);
+    for (test_scenario const& scenario : alia_layout_small_scenario_table())
+    {
+        CAPTURE(scenario.name);
+        auto const serial = lay_out_serially(scenario, nullptr, size);
+        REQUIRE(!serial.empty());
+        for (alia_layout_parallelism const& parallelism : configurations)
+        {
+            CAPTURE(parallelism.thread_count);
+            CAPTURE(parallelism.min_fork_size);
+            layout_fixture* fixture = layout_fixture_create();
+            alia_layout_system_set_parallelism(
+                layout_fixture_layout_system(fixture), parallelism);
+            // The second resolve runs with a warm cache.
+            CHECK(lay_out(fixture, scenario, nullptr, size) == serial);
+            CHECK(lay_out(fixture, scenario, nullptr, size) == serial);
+            layout_fixture_destroy(fixture);
+        }
+    }
+}
+
+TEST_CASE("parallel layout matches serial layout as the tree changes")
+{
+    for (test_scenario const& scenario : alia_layout_small_scenario_table())
+    {
+        CAPTURE(scenario.name);
+        layout_fixture* fixture = layout_fixture_create();
+        alia_layout_system_set_parallelism(
+            layout_fixture_layout_system(fixture),
+            {.thread_count = 4, .min_fork_size = 16});
+        // Walk through a series of leaf changes and available sizes, so that
+        // the resolves mix cached and forked subtrees in different ways.
+        for (uint32_t step = 0; step != 12; ++step)
+        {
+            CAPTURE(step);
+            alia_layout_scenario_change change
+                = {.leaf_index = (step * 37) % scenario.leaf_count(),
+                   .extra_width = float(step % 3) * 25.f,
+                   .leaf_counter = 0};
+            alia_vec2f const size
+                = alia_vec2f_make(step % 2 == 0 ? 10'000.f : 900.f, 5'000.f);
+            auto const parallel = lay_out(fixture, scenario, &change, size);
+            CHECK(parallel == lay_out_serially(scenario, &change, size));
+        }
+        layout_fixture_destroy(fixture);
+    }
+}
+
+TEST_CASE("layout parallelism can be turned off")
+{
+    test_scenario const& scenario = alia_layout_small_scenarios[0];
+    alia_vec2f const size = alia_vec2f_make(10'000.f, 10'000.f);
+    auto const serial = lay_out_serially(scenario, nullptr, size);
+
+    layout_fixture* fixture = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 4, .min_fork_size = 1});
+    CHECK(lay_out(fixture, scenario, nullptr, size) == serial);
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 1, .min_fork_size = 0});
+    CHECK(system->worker_pool == nullptr);
+    CHECK(lay_out(fixture, scenario, nullptr, size) == serial);
+    layout_fixture_destroy(fixture);
+}
@@ -0,0 +1,330 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/layout_test_helpers.hpp>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/placements.h>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+
+namespace {
+
+// an element ID for each tagged element in the test UI
+alia_element_id
+test_id(int index)
+{
+    static char elements[1000];
+    return {.ptr = &elements[index], .generation = 0, .route = 0};
+}
+
+// the parameters of the test UI
+struct tagged_ui
+{
+    int row_count = 8;
+    // the leaf to widen (by index) and by how much
+    int changed_leaf = -1;
+    float extra_width = 0.f;
+};
+
+// A column of tagged rows of tagged leaves, followed by a flow of tagged words
+// - On spatial passes, this records the box that each tagged leaf consumes.
+void
+emit_tagged_ui(
+    alia_context& ctx, tagged_ui const& ui, std::map<int, alia_box>& boxes)
+{
+    int leaf_index = 0;
+    auto leaf = [&](alia_vec2f size, layout_flag_set flags) {
+        int const index = leaf_index++;
+        if (index == ui.changed_leaf)
+            size.x += ui.extra_width;
+        layout_tag(ctx, test_id(index), [&]() {
+            alia_box box;
+            test_leaf(ctx, size, flags, &box);
+            if (!is_refresh_event(ctx))
+                boxes[index] = box;
+        });
+    };
+    column(ctx, gap(2.f), [&]() {
+        for (int i = 0; i != ui.row_count; ++i)
+        {
+            layout_tag(ctx, test_id(500 + i), [&]() {
+                row(ctx, gap(3.f), [&]() {
+                    leaf(alia_vec2f_make(20.f, 10.f), FILL);
+                    leaf(alia_vec2f_make(float(5 + i), 8.f), FILL | GROW);
+                    edge_offsets(ctx, {2.f, 3.f, 1.f, 4.f}, [&]() {
+                        leaf(alia_vec2f_make(30.f, 8.f), FILL);
+                    });
+                });
+            });
+        }
+        flow(ctx, gap(4.f), [&]() {
+            for (int i = 0; i != 30; ++i)
+                leaf(alia_vec2f_make(float(10 + (i * 37) % 45), 12.f), FILL);
+        });
+    });
+}
+
+std::map<int, alia_box>
+lay_out(layout_fixture* fixture, tagged_ui const& ui, alia_vec2f size)
+{
+    std::map<int, alia_box> boxes;
+    layout_test_fixture_run_refresh(fixture, [&](alia_context* ctx) {
+        emit_tagged_ui(*ctx, ui, boxes);
+    });
+    layout_fixture_resolve(fixture, size);
+    layout_test_fixture_run_spatial(fixture, [&](alia_context* ctx) {
+        emit_tagged_ui(*ctx, ui, boxes);
+    });
+    return boxes;
+}
+
+alia_layout_placement_table const*
+placements(layout_fixture* fixture)
+{
+    return alia_layout_system_placements(
+        layout_fixture_layout_system(fixture));
+}
+
+std::vector<alia_layout_placement>
+table_entries(alia_layout_placement_table const* table)
+{
+    alia_layout_placement const* entries
+        = alia_layout_placement_table_entries(table);
+    return std::vector<alia_layout_placement>(
+        entries, entries + alia_layout_placement_table_size(table));
+}
+
+// Check that `fixture`'s table has an entry for each leaf in `boxes` (with
+// the box that the leaf consumed) and each row.
+void
+check_table(
+    layout_fixture* fixture,
+    tagged_ui const& ui,
+    std::map<int, alia_box> const& boxes)
+{
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    alia_layout_placement_table const* table = placements(fixture);
+    CHECK(
+        alia_layout_placement_table_size(table)
+        == boxes.size() + size_t(ui.row_count));
+    for (auto const& [index, box] : boxes)
+    {
+        CAPTURE(index);
+        alia_layout_placement const* entry
+            = alia_layout_placement_table_find(table, test_id(index));
+        REQUIRE(entry != nullptr);
+        CHECK(alia_box_equal(entry->box, box));
+        // A leaf's placement data is just its box.
+        alia_box placed;
+        std::memcpy(
+            &placed,
+            alia_layout_system_placement_data(system, entry->offset),
+            sizeof(placed));
+        CHECK(alia_box_equal(placed, box));
+    }
+    for (int i = 0; i != ui.row_count; ++i)
+    {
+        CAPTURE(i);
+        alia_layout_placement const* entry
+            = alia_layout_placement_table_find(table, test_id(500 + i));
+        REQUIRE(entry != nullptr);
+        // Each row contains its leaves.
+        alia_box const& first_leaf = boxes.at(i * 3);
+        CHECK(entry->box.min.x <= first_leaf.min.x);
+        CHECK(entry->box.min.y <= first_leaf.min.y);
+    }
+    CHECK(alia_layout_placement_table_find(table, test_id(999)) == nullptr);
+}
+
+bool
+entries_match(
+    std::vector<alia_layout_placement> const& a,
+    std::vector<alia_layout_placement> const& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i != a.size(); ++i)
+    {
+        if (!alia_element_id_equal(a[i].id, b[i].id)
+            || !alia_box_equal(a[i].box, b[i].box)
+            || a[i].offset != b[i].offset)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<alia_layout_placement_change>
+diff(
+    alia_layout_placement_table const* before,
+    alia_layout_placement_table const* after)
+{
+    std::vector<alia_layout_placement_change> changes;
+    uint32_t const count = alia_layout_placement_table_diff(
+        before,
+        after,
+        [](void* user_data, alia_layout_placement_change const* change) {
+            static_cast<std::vector<alia_layout_placement_change>*>(user_data)
+                ->push_back(*change);
+        },
+        &changes);
+    CHECK(count == changes.size());
+    return changes;
+}
+
+alia_layout_placement_change const*
+find_change(
+    std::vector<alia_layout_placement_change> const& changes, int index)
+{
+    for (auto const& change : changes)
+    {
+        if (alia_element_id_equal(change.id, test_id(index)))
+            return &change;
+    }
+    return nullptr;
+}
+
+alia_vec2f const test_size = alia_vec2f_make(300.f, 1'000.f);
+
+} // namespace
+
+TEST_CASE("placement tables index the boxes of tagged elements")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    tagged_ui const ui;
+    auto const boxes = lay_out(fixture, ui, test_size);
+    check_table(fixture, ui, boxes);
+    layout_fixture_destroy(fixture);
+}
+
+TEST_CASE("placement tables include cached subtrees")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    tagged_ui ui;
+    lay_out(fixture, ui, test_size);
+    auto const first = table_entries(placements(fixture));
+
+    // The second resolve copies most of its placement data from the cache.
+    auto boxes = lay_out(fixture, ui, test_size);
+    CHECK(system->cache.stats.placement_copies > 0);
+    check_table(fixture, ui, boxes);
+    CHECK(entries_match(table_entries(placements(fixture)), first));
+
+    // Changing one leaf still leaves the rest of the tree to the cache.
+    ui.changed_leaf = 4;
+    ui.extra_width = 7.f;
+    boxes = lay_out(fixture, ui, test_size);
+    check_table(fixture, ui, boxes);
+
+    layout_fixture* fresh = layout_fixture_create();
+    lay_out(fresh, ui, test_size);
+    CHECK(entries_match(
+        table_entries(placements(fixture)),
+        table_entries(placements(fresh))));
+    layout_fixture_destroy(fresh);
+
+    layout_fixture_destroy(fixture);
+}
+
+TEST_CASE("placement tables are the same for every kind of resolve")
+{
+    tagged_ui const ui;
+
+    layout_fixture* linked = layout_fixture_create();
+    lay_out(linked, ui, test_size);
+
+    layout_fixture* compact = layout_fixture_create();
+    alia_layout_system_set_storage(
+        layout_fixture_layout_system(compact), ALIA_LAYOUT_STORAGE_COMPACT);
+    auto const boxes = lay_out(compact, ui, test_size);
+    check_table(compact, ui, boxes);
+    CHECK(entries_match(
+        table_entries(placements(compact)),
+        table_entries(placements(linked))));
+
+    layout_fixture* parallel = layout_fixture_create();
+    alia_layout_system_set_parallelism(
+        layout_fixture_layout_system(parallel),
+        {.thread_count = 4, .min_fork_size = 1});
+    lay_out(parallel, ui, test_size);
+    CHECK(entries_match(
+        table_entries(placements(parallel)),
+        table_entries(placements(linked))));
+
+    layout_fixture_destroy(parallel);
+    layout_fixture_destroy(compact);
+    layout_fixture_destroy(linked);
+}
+
+TEST_CASE("placement table diffs list the elements that changed")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    tagged_ui ui;
+    lay_out(fixture, ui, test_size);
+
+    // Nothing changes.
+    lay_out(fixture, ui, test_size);
+    CHECK(diff(
+              alia_layout_system_previous_placements(system),
+              alia_layout_system_placements(system))
+              .empty());
+
+    // Widening the first leaf of the first row resizes it, and the growing
+    // leaf next to it gives up the space (so it moves and shrinks).
+    ui.changed_leaf = 0;
+    ui.extra_width = 10.f;
+    lay_out(fixture, ui, test_size);
+    auto changes = diff(
+        alia_layout_system_previous_placements(system),
+        alia_layout_system_placements(system));
+    CHECK(changes.size() == 2);
+    auto const* widened = find_change(changes, 0);
+    REQUIRE(widened != nullptr);
+    CHECK(widened->flags == ALIA_LAYOUT_PLACEMENT_RESIZED);
+    CHECK(widened->after.size.x == widened->before.size.x + 10.f);
+    auto const* shrunk = find_change(changes, 1);
+    REQUIRE(shrunk != nullptr);
+    CHECK(
+        shrunk->flags
+        == (ALIA_LAYOUT_PLACEMENT_MOVED | ALIA_LAYOUT_PLACEMENT_RESIZED));
+    CHECK(shrunk->after.size.x == shrunk->before.size.x - 10.f);
+
+    // Removing the last row removes its elements.
+    ui.row_count = 7;
+    lay_out(fixture, ui, test_size);
+    changes = diff(
+        alia_layout_system_previous_placements(system),
+        alia_layout_system_placements(system));
+    auto const* removed = find_change(changes, 507);
+    REQUIRE(removed != nullptr);
+    CHECK(removed->flags == ALIA_LAYOUT_PLACEMENT_REMOVED);
+
+    // ... and adding it back adds them.
+    changes = diff(
+        alia_layout_system_placements(system),
+        alia_layout_system_previous_placements(system));
+    auto const* added = find_change(changes, 507);
+    REQUIRE(added != nullptr);
+    CHECK(added->flags == ALIA_LAYOUT_PLACEMENT_ADDED);
+
+    CHECK(
+        alia_layout_placement_table_diff(
+            alia_layout_system_previous_placements(system),
+            alia_layout_system_placements(system),
+            nullptr,
+            nullptr)
+        == changes.size());
+
+    layout_fixture_destroy(fixture);
+}
@@ -0,0 +1,160 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/scenarios.h>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/profile.h>
+#include <alia/abi/ui/layout/system.h>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef ALIA_LAYOUT_PROFILING
+
+namespace {
+
+// Find the profile entry for the node type called `name`.
+alia_layout_profile_node_type const*
+find_node_type(alia_layout_profile const& profile, char const* name)
+{
+    for (uint32_t i = 0; i != profile.node_type_count; ++i)
+    {
+        char const* type_name = profile.node_types[i].vtable->name;
+        if (type_name && std::strcmp(type_name, name) == 0)
+            return &profile.node_types[i];
+    }
+    return nullptr;
+}
+
+uint64_t
+count_calls(alia_layout_profile const& profile, int call)
+{
+    uint64_t count = 0;
+    for (uint32_t i = 0; i != profile.node_type_count; ++i)
+        count += profile.node_types[i].calls[call].count;
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("layout profiles record each resolve")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(fixture);
+    layout_fixture_run_refresh_impl(
+        fixture, alia_layout_scenario_column_of_rows_100, nullptr);
+    layout_fixture_resolve(fixture, alia_vec2f_make(10'000.f, 10'000.f));
+
+    alia_layout_profile const* profile = alia_layout_system_profile(system);
+    REQUIRE(profile != nullptr);
+
+    // Every leaf has its box assigned once. (Leaves with the same content
+    // are only measured once, since the rest come out of the cache.)
+    alia_layout_profile_node_type const* leaf
+        = find_node_type(*profile, "leaf");
+    REQUIRE(leaf != nullptr);
+    CHECK(
+        leaf->calls[ALIA_LAYOUT_PROFILE_ASSIGN_BOXES].count
+        == alia_layout_scenario_column_of_rows_100_leaf_count());
+    CHECK(leaf->calls[ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL].count != 0);
+    CHECK(
+        leaf->calls[ALIA_LAYOUT_PROFILE_MEASURE_VERTICAL].count
+        == leaf->calls[ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL].count);
+    CHECK(find_node_type(*profile, "row") != nullptr);
+    CHECK(find_node_type(*profile, "column") != nullptr);
+
+    CHECK(
+        profile->nodes_visited
+        == count_calls(*profile, ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL)
+               + count_calls(*profile, ALIA_LAYOUT_PROFILE_MEASURE_VERTICAL)
+               + count_calls(*profile, ALIA_LAYOUT_PROFILE_ASSIGN_BOXES));
+    CHECK(profile->untracked_calls == 0);
+
+    // A call never takes less time than the calls nested within it.
+    for (uint32_t i = 0; i != profile->node_type_count; ++i)
+    {
+        for (auto const& calls : profile->node_types[i].calls)
+            CHECK(calls.self_nanoseconds <= calls.nanoseconds);
+    }
+
+    uint64_t phase_total = 0;
+    for (uint64_t ns : profile->phase_nanoseconds)
+        phase_total += ns;
+    CHECK(phase_total <= profile->total_nanoseconds);
+
+    CHECK(profile->placement_bytes == system->placement_size);
+    CHECK(profile->placement_bytes > 0);
+    CHECK(profile->scratch_peak_bytes > 0);
+
+    // With nothing changed, the next resolve comes out of the cache, so it
+    // visits fewer nodes (and the profile only covers that resolve).
+    uint64_t const full_visits = profile->nodes_visited;
+    layout_fixture_resolve(fixture, alia_vec2f_make(10'000.f, 10'000.f));
+    CHECK(profile->nodes_visited < full_visits);
+
+    layout_fixture_destroy(fixture);
+}
+
+TEST_CASE("parallel layout profiles include the workers' calls")
+{
+    alia_vec2f const size = alia_vec2f_make(10'000.f, 10'000.f);
+
+    layout_fixture* serial = layout_fixture_create();
+    layout_fixture_run_refresh_impl(
+        serial, alia_layout_scenario_nested_grid_10, nullptr);
+    layout_fixture_resolve(serial, size);
+    alia_layout_profile const& serial_profile
+        = *alia_layout_system_profile(layout_fixture_layout_system(serial));
+
+    layout_fixture* parallel = layout_fixture_create();
+    alia_layout_system* system = layout_fixture_layout_system(parallel);
+    alia_layout_system_set_parallelism(
+        system, {.thread_count = 4, .min_fork_size = 1});
+    layout_fixture_run_refresh_impl(
+        parallel, alia_layout_scenario_nested_grid_10, nullptr);
+    layout_fixture_resolve(parallel, size);
+    alia_layout_profile const& parallel_profile
+        = *alia_layout_system_profile(system);
+
+    // Forked subtrees aren't cached, so every leaf is measured (mostly on the
+    // worker threads).
+    auto const* leaf = find_node_type(parallel_profile, "leaf");
+    REQUIRE(leaf != nullptr);
+    CHECK(
+        leaf->calls[ALIA_LAYOUT_PROFILE_MEASURE_HORIZONTAL].count
+        == alia_layout_scenario_nested_grid_10_leaf_count());
+    CHECK(
+        leaf->calls[ALIA_LAYOUT_PROFILE_MEASURE_VERTICAL].count
+        == alia_layout_scenario_nested_grid_10_leaf_count());
+
+    // Boxes are assigned serially either way.
+    for (char const* name : {"leaf", "row", "column"})
+    {
+        CAPTURE(name);
+        auto const* serial_type = find_node_type(serial_profile, name);
+        auto const* parallel_type = find_node_type(parallel_profile, name);
+        REQUIRE(serial_type != nullptr);
+        REQUIRE(parallel_type != nullptr);
+        CHECK(
+            parallel_type->calls[ALIA_LAYOUT_PROFILE_ASSIGN_BOXES].count
+            == serial_type->calls[ALIA_LAYOUT_PROFILE_ASSIGN_BOXES].count);
+    }
+
+    layout_fixture_destroy(parallel);
+    layout_fixture_destroy(serial);
+}
+
+#else
+
+TEST_CASE("layout profiles aren't available unless profiling is compiled in")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    CHECK(
+        alia_layout_system_profile(layout_fixture_layout_system(fixture))
+        == nullptr);
+    layout_fixture_destroy(fixture);
+}
+
+#endif
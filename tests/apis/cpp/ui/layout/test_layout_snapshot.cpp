@@ -0,0 +1,341 @@
+#include <alia/test/layout/layout_fixture.hpp>
+#include <alia/test/layout/layout_test_helpers.hpp>
+#include <alia/test/layout/scenarios.h>
+
+#include <alia/abi/base/geometry/vec2.h>
+#include <alia/abi/ui/layout/snapshot.h>
+#include <alia/abi/ui/layout/utilities/defaults.h>
+#include <alia/abi/ui/layout/utilities/flow.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/impl/ui/layout.hpp>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/layout/system.h>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace alia;
+using namespace alia::layout_test;
+
+namespace {
+
+// a node type that the snapshot format doesn't know about, with fixed
+// requirements - If `split` is set, it breaks into two halves in flows.
+struct custom_node
+{
+    alia_layout_node base;
+    alia_vec2f size;
+    bool split;
+};
+
+alia_horizontal_requirements
+custom_measure_horizontal(alia_measurement_context*, alia_layout_node* node)
+{
+    auto& custom = *reinterpret_cast<custom_node*>(node);
+    return {.min_size = custom.size.x, .growth_factor = 0};
+}
+
+alia_vertical_requirements
+custom_measure_vertical(
+    alia_measurement_context*,
+    alia_main_axis_index,
+    alia_layout_node* node,
+    float)
+{
+    auto& custom = *reinterpret_cast<custom_node*>(node);
+    return {
+        .min_size = custom.size.y,
+        .growth_factor = 0,
+        .ascent = custom.size.y,
+        .descent = 0};
+}
+
+void
+custom_assign_boxes(
+    alia_placement_context* ctx,
+    alia_main_axis_index,
+    alia_layout_node*,
+    alia_box box,
+    float)
+{
+    *arena_alloc<alia_box>(ctx->arena) = box;
+}
+
+alia_flow_emission_counts
+custom_count_flow_emissions(
+    alia_measurement_context* ctx, alia_layout_node* node)
+{
+    auto& custom = *reinterpret_cast<custom_node*>(node);
+    if (!custom.split)
+        return alia_default_count_flow_emissions(ctx, node);
+    return {.fragment_count = 2};
+}
+
+void
+custom_emit_flow_fragments(
+    alia_measurement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_emitter* emitter)
+{
+    auto& custom = *reinterpret_cast<custom_node*>(node);
+    if (!custom.split)
+    {
+        alia_default_emit_flow_fragments(ctx, node, emitter);
+        return;
+    }
+    for (int i = 0; i != 2; ++i)
+    {
+        alia_layout_emit_flow_fragment(
+            emitter,
+            alia_flow_fragment{
+                .flags = 0,
+                .kind = ALIA_FLOW_FRAGMENT_KIND_CONTENT,
+                .content = {
+                    .size = alia_vec2f_make(custom.size.x / 2, custom.size.y),
+                    .ascent = custom.size.y,
+                    .descent = 0}});
+    }
+}
+
+void
+custom_read_fragment_placements(
+    alia_placement_context* ctx,
+    alia_layout_node* node,
+    alia_flow_fragment_reader* reader)
+{
+    auto& custom = *reinterpret_cast<custom_node*>(node);
+    if (!custom.split)
+    {
+        alia_default_read_fragment_placements(ctx, node, reader);
+        return;
+    }
+    for (int i = 0; i != 2; ++i)
+    {
+        alia_flow_fragment const* fragment
+            = alia_layout_read_fragment_spec(reader);
+        *arena_alloc<alia_box>(ctx->arena) = alia_box{
+            alia_layout_read_fragment_placement(reader)->position,
+            alia_flow_fragment_content(fragment)->size};
+        alia_layout_advance_fragment(reader);
+    }
+}
+
+alia_layout_node_vtable custom_vtable
+    = {custom_measure_horizontal,
+       custom_measure_vertical,
+       custom_assign_boxes,
+       custom_count_flow_emissions,
+       custom_emit_flow_fragments,
+       custom_read_fragment_placements,
+       false,
+       "custom"};
+
+void
+custom(alia_context& ctx, alia_vec2f size, bool split = false)
+{
+    if (!is_refresh_event(ctx))
+        return;
+    auto& emission = ctx.layout->emission;
+    auto* node = arena_alloc<custom_node>(emission.arena);
+    alia_layout_emit_node(&emission, &node->base);
+    *node = custom_node{
+        .base = {.vtable = &custom_vtable, .next_sibling = nullptr},
+        .size = size,
+        .split = split};
+}
+
+// a tree with every kind of node that snapshots record
+void
+emit_everything(alia_context& ctx)
+{
+    auto leaf = [&](float width, float height, layout_flag_set flags) {
+        test_leaf(ctx, alia_vec2f_make(width, height), flags);
+    };
+    column(ctx, gap(2.f), [&]() {
+        row(ctx, BASELINE_Y, gap(3.f), [&]() {
+            leaf(20.f, 10.f, NO_FLAGS);
+            leaf(0.f, 0.f, FILL | GROW);
+            custom(ctx, alia_vec2f_make(14.f, 9.f));
+        });
+        flow(ctx, GROW, line_gap(1.f), [&]() {
+            for (int i = 0; i != 12; ++i)
+            {
+                leaf(float(10 + i * 3), 8.f, NO_FLAGS);
+                custom(ctx, alia_vec2f_make(30.f, 6.f), true);
+                if (i % 4 == 0)
+                    test_flow_spring(ctx, 2.f);
+            }
+        });
+        block_flow(ctx, minimum_line_height(12.f), [&]() {
+            for (int i = 0; i != 6; ++i)
+            {
+                edge_offsets(ctx, {1.f, 2.f, 3.f, 4.f}, [&]() {
+                    leaf(25.f, 7.f, NO_FLAGS);
+                });
+            }
+        });
+        grid(ctx, [&](alia_layout_grid_handle grid) {
+            for (int i = 0; i != 3; ++i)
+            {
+                grid_row(ctx, grid, [&]() {
+                    leaf(10.f * float(i + 1), 5.f, NO_FLAGS);
+                    alignment_override(ctx, CENTER, [&]() {
+                        leaf(8.f, 4.f, NO_FLAGS);
+                    });
+                    growth_override(ctx, 2.f, [&]() {
+                        min_size_constraint(
+                            ctx, alia_vec2f_make(12.f, 6.f), [&]() {
+                                leaf(4.f, 3.f, NO_FLAGS);
+                            });
+                    });
+                });
+            }
+        });
+    });
+}
+
+void
+append_bytes(void* user_data, void const* data, size_t size)
+{
+    auto& bytes = *static_cast<std::vector<uint8_t>*>(user_data);
+    auto const* p = static_cast<uint8_t const*>(data);
+    bytes.insert(bytes.end(), p, p + size);
+}
+
+struct round_trip
+{
+    std::vector<uint8_t> snapshot;
+    std::vector<uint8_t> original;
+    std::vector<uint8_t> replayed;
+};
+
+// Lay out `ui` within `size`, capturing a snapshot as it's resolved, then
+// replay the snapshot in another fixture.
+round_trip
+lay_out_and_replay(std::function<void(alia_context*)> ui, alia_vec2f size)
+{
+    round_trip result;
+
+    layout_fixture* original = layout_fixture_create();
+    layout_test_fixture_run_refresh(original, ui);
+    alia_layout_system_capture_next_resolve(
+        layout_fixture_layout_system(original),
+        {.write = append_bytes, .user_data = &result.snapshot});
+    layout_fixture_resolve(original, size);
+    result.original = layout_fixture_placement_data(original);
+    layout_fixture_destroy(original);
+
+    layout_fixture* replay = layout_fixture_create();
+    alia_vec2f available;
+    REQUIRE(layout_fixture_load_snapshot(
+        replay, result.snapshot.data(), result.snapshot.size(), &available));
+    CHECK(available.x == size.x);
+    CHECK(available.y == size.y);
+    layout_fixture_resolve(replay, available);
+    result.replayed = layout_fixture_placement_data(replay);
+    layout_fixture_destroy(replay);
+
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("layout snapshots replay the scenarios exactly")
+{
+    for (alia_layout_scenario_info const& s :
+         alia_layout_small_scenario_table())
+    {
+        CAPTURE(s.name);
+        auto const result = lay_out_and_replay(
+            [&](alia_context* ctx) { s.fn(ctx, nullptr); },
+            alia_vec2f_make(800.f, 10'000.f));
+        REQUIRE(!result.original.empty());
+        CHECK(result.replayed == result.original);
+    }
+}
+
+TEST_CASE("layout snapshots record unknown nodes as opaque nodes")
+{
+    for (float width : {1'000.f, 150.f})
+    {
+        CAPTURE(width);
+        auto const result = lay_out_and_replay(
+            [&](alia_context* ctx) { emit_everything(*ctx); },
+            alia_vec2f_make(width, 1'000.f));
+        REQUIRE(!result.original.empty());
+        CHECK(result.replayed == result.original);
+    }
+}
+
+TEST_CASE("capturing a layout snapshot only applies to the next resolve")
+{
+    layout_fixture* fixture = layout_fixture_create();
+    layout_fixture_run_refresh_impl(
+        fixture, alia_layout_scenario_grid_100, nullptr);
+    std::vector<uint8_t> snapshot;
+    alia_layout_system_capture_next_resolve(
+        layout_fixture_layout_system(fixture),
+        {.write = append_bytes, .user_data = &snapshot});
+    layout_fixture_resolve(fixture, alia_vec2f_make(500.f, 500.f));
+    size_t const size = snapshot.size();
+    CHECK(size > 0);
+    layout_fixture_resolve(fixture, alia_vec2f_make(500.f, 500.f));
+    CHECK(snapshot.size() == size);
+    layout_fixture_destroy(fixture);
+}
+
+TEST_CASE("malformed layout snapshots are rejected")
+{
+    std::vector<uint8_t> snapshot;
+    {
+        layout_fixture* fixture = layout_fixture_create();
+        layout_test_fixture_run_refresh(
+            fixture, [](alia_context* ctx) { emit_everything(*ctx); });
+        alia_layout_system_write_snapshot(
+            layout_fixture_layout_system(fixture),
+            alia_vec2f_make(300.f, 300.f),
+            {.write = append_bytes, .user_data = &snapshot});
+        layout_fixture_destroy(fixture);
+    }
+    alia_vec2f available;
+    REQUIRE(alia_layout_snapshot_read(
+        snapshot.data(), snapshot.size(), &available));
+
+    CHECK(!alia_layout_snapshot_read(nullptr, 0, &available));
+
+    // every truncation
+    for (size_t size = 0; size != snapshot.size(); ++size)
+    {
+        CAPTURE(size);
+        CHECK(!alia_layout_snapshot_read(snapshot.data(), size, &available));
+    }
+
+    // trailing bytes
+    auto extended = snapshot;
+    extended.push_back(0);
+    CHECK(!alia_layout_snapshot_read(
+        extended.data(), extended.size(), &available));
+
+    // a bad magic number, version or node kind
+    for (size_t offset : {size_t(0), size_t(4), size_t(16)})
+    {
+        CAPTURE(offset);
+        auto corrupted = snapshot;
+        corrupted[offset] = 0xff;
+        CHECK(!alia_layout_snapshot_read(
+            corrupted.data(), corrupted.size(), &available));
+    }
+
+    // A failed load leaves the fixture's tree alone.
+    layout_fixture* fixture = layout_fixture_create();
+    layout_fixture_run_refresh_impl(
+        fixture, alia_layout_scenario_grid_100, nullptr);
+    alia_layout_node* root = layout_fixture_root_child(fixture);
+    CHECK(!layout_fixture_load_snapshot(
+        fixture, snapshot.data(), snapshot.size() - 1, &available));
+    CHECK(layout_fixture_root_child(fixture) == root);
+    layout_fixture_destroy(fixture);
+}
@@ -0,0 +1,193 @@
+#include <alia/abi/ui/library.h>
+
+#include <alia/abi/kernel/events.h>
+#include <alia/abi/ui/layout/api.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/kernel/flow/dispatch.h>
+#include <alia/impl/events.hpp>
+#include <alia/ui/system/object.h>
+
+#include <doctest/doctest.h>
+
+#include <new>
+#include <vector>
+
+using namespace alia;
+
+namespace {
+
+// a scroll view containing a long virtual column of items whose heights
+// differ from the estimate, driven by a full UI system
+struct virtual_log
+{
+    uint32_t item_count;
+    uint32_t reveal = ALIA_VIRTUAL_COLUMN_NO_ITEM;
+    // the items emitted by the last refresh
+    alia_virtual_column_range range = {0, 0};
+    // the boxes of the items in `range`, as of the last non-refresh pass
+    std::vector<alia_box> boxes;
+    // the vertical scroll position of the view, as of the last non-refresh
+    // pass
+    float scroll = 0.f;
+
+    alia_ui_system* ui = nullptr;
+
+    explicit virtual_log(uint32_t count) : item_count(count)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {100, 200});
+        update();
+    }
+
+    ~virtual_log()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    // Refresh and then do a full non-refresh pass so that the items know
+    // their placements.
+    void
+    update()
+    {
+        alia_ui_system_update(ui);
+        alia_event hit_test = alia_make_mouse_hit_test_event(
+            {.x = -1.f, .y = -1.f, .result = {}});
+        dispatch_event(*ui, hit_test);
+    }
+
+    static float
+    item_height(uint32_t item)
+    {
+        return item % 3 == 0 ? 30.f : 10.f;
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& log = *static_cast<virtual_log*>(user_data);
+        bool const refreshing = is_refresh_event(*ctx);
+        if (!refreshing)
+            log.boxes.clear();
+        alia_ui_scroll_view_begin(ctx, ALIA_GROW, 0x2, 0);
+        alia_virtual_column_range const range = alia_ui_virtual_column_begin(
+            ctx, 0, log.item_count, 20.f, 15.f, &log.reveal);
+        if (!refreshing)
+            log.scroll = ctx->layout->viewport->scroll.y;
+        for (uint32_t i = range.begin; i != range.end; ++i)
+        {
+            if (refreshing)
+            {
+                alia_layout_leaf_emit(
+                    ctx,
+                    alia_layout_content_metrics_make(
+                        alia_vec2f_make(50.f, item_height(i))),
+                    0);
+            }
+            else
+            {
+                log.boxes.push_back(alia_layout_consume_box(ctx));
+            }
+        }
+        alia_ui_virtual_column_end(ctx);
+        alia_ui_scroll_view_end(ctx);
+        if (refreshing)
+            log.range = range;
+    }
+};
+
+// Check that the items in `log.range` are stacked at their own heights (plus
+// the same spacing between each pair) and that at least one of them is
+// visible within the 200px tall view.
+void
+check_item_boxes(virtual_log const& log)
+{
+    REQUIRE(log.boxes.size() == log.range.end - log.range.begin);
+    REQUIRE(log.boxes.size() > 1);
+    float const spacing
+        = log.boxes[1].min.y - (log.boxes[0].min.y + log.boxes[0].size.y);
+    bool any_visible = false;
+    for (size_t i = 0; i != log.boxes.size(); ++i)
+    {
+        CAPTURE(i);
+        alia_box const& box = log.boxes[i];
+        CHECK(box.size.y
+              == virtual_log::item_height(log.range.begin + uint32_t(i)));
+        if (i != 0)
+        {
+            alia_box const& above = log.boxes[i - 1];
+            CHECK(
+                box.min.y
+                == doctest::Approx(above.min.y + above.size.y + spacing));
+        }
+        float const top = box.min.y - log.scroll;
+        if (top < 200.f && top + box.size.y > 0.f)
+            any_visible = true;
+    }
+    CHECK(any_visible);
+}
+
+} // namespace
+
+TEST_CASE("virtual column emits only the visible items")
+{
+    virtual_log log(500000);
+    // The visible 200px (plus overscan) can't hold more than a couple dozen
+    // items.
+    CHECK(log.range.begin == 0);
+    CHECK(log.range.end > 0);
+    CHECK(log.range.end < 40);
+    check_item_boxes(log);
+}
+
+TEST_CASE("virtual column reveals distant items")
+{
+    virtual_log log(500000);
+    float const top = log.boxes.at(0).min.y;
+
+    uint32_t const target = 400000;
+    log.reveal = target;
+    log.update();
+    // The reveal is consumed by the refresh that handles it.
+    CHECK(log.reveal == ALIA_VIRTUAL_COLUMN_NO_ITEM);
+    // The heights of the newly emitted items replace their estimates, so it
+    // can take another update for the view to settle.
+    log.update();
+    log.update();
+
+    CHECK(log.range.begin <= target);
+    CHECK(log.range.end > target);
+    CHECK(log.range.end - log.range.begin < 40);
+    check_item_boxes(log);
+    alia_box const& box = log.boxes.at(target - log.range.begin);
+    CHECK(box.min.y - log.scroll >= 0.f);
+    CHECK(box.min.y + box.size.y - log.scroll <= 200.f);
+
+    // Revealing the start of the list scrolls back to the top.
+    log.reveal = 0;
+    log.update();
+    log.update();
+    CHECK(log.range.begin == 0);
+    check_item_boxes(log);
+    CHECK(log.boxes[0].min.y == top);
+}
+
+TEST_CASE("virtual column follows changes in its item count")
+{
+    virtual_log log(500000);
+    log.item_count = 5;
+    log.update();
+    CHECK(log.range.begin == 0);
+    CHECK(log.range.end == 5);
+    check_item_boxes(log);
+
+    log.item_count = 0;
+    log.update();
+    CHECK(log.range.begin == 0);
+    CHECK(log.range.end == 0);
+    CHECK(log.boxes.empty());
+}
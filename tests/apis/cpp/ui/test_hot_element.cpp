@@ -0,0 +1,147 @@
+#include <alia/abi/ui/input/regions.h>
+
+#include <alia/abi/kernel/components.h>
+#include <alia/abi/ui/input/elements.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/abi/ui/system/input_processing.h>
+#include <alia/abi/ui/system/work.h>
+#include <alia/impl/events.hpp>
+#include <alia/kernel/id.hpp>
+#include <alia/ui/layout/api.hpp>
+#include <alia/ui/system/object.h>
+
+#include <doctest/doctest.h>
+
+#include <new>
+#include <vector>
+
+using namespace alia;
+
+namespace {
+
+// a column of rows, each declaring a mouse region, driven by a full UI system
+struct hover_list
+{
+    std::vector<alia_element_id> ids;
+    // the box that each row was last assigned
+    std::vector<alia_box> boxes;
+    // the number of mouse hit test passes that the controller has seen
+    int hit_test_passes = 0;
+
+    alia_ui_system* ui = nullptr;
+
+    explicit hover_list(size_t count) : ids(count), boxes(count)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {100, 100});
+        alia_ui_system_update(ui);
+    }
+
+    ~hover_list()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    // Move the mouse to `position` and return the number of mouse hit test
+    // passes that the update needed.
+    int
+    move_mouse(alia_vec2f position)
+    {
+        int const before = hit_test_passes;
+        alia_ui_enqueue_mouse_motion(ui, position);
+        alia_ui_system_update(ui);
+        return hit_test_passes - before;
+    }
+
+    // Move the mouse to the center of row `i`.
+    int
+    move_to_row(size_t i)
+    {
+        return move_mouse(alia_vec2f_add(
+            boxes[i].min, alia_vec2f_scale(boxes[i].size, 0.5f)));
+    }
+
+    alia_element_id
+    hot() const
+    {
+        return ui->input.hot_element;
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& list = *static_cast<hover_list*>(user_data);
+        if (get_event_type(*ctx) == ALIA_EVENT_MOUSE_HIT_TEST)
+            ++list.hit_test_passes;
+        alia_layout_column_begin(ctx, 0, 0.f);
+        for (size_t i = 0; i != list.ids.size(); ++i)
+        {
+            if (alia_component_begin(ctx, unit_id()))
+            {
+                alia_element_id const id = alia_element_get_identity(ctx);
+                list.ids[i] = id;
+                if (is_refresh_event(*ctx))
+                {
+                    alia_layout_leaf_emit(
+                        ctx,
+                        alia_layout_content_metrics_make(
+                            alia_vec2f_make(100.f, 10.f)),
+                        0);
+                }
+                else
+                {
+                    alia_box const box = alia_layout_consume_box(ctx);
+                    list.boxes[i] = box;
+                    alia_element_box_region(
+                        ctx,
+                        id,
+                        &box,
+                        ALIA_CURSOR_DEFAULT,
+                        ALIA_HIT_TEST_MOUSE);
+                }
+            }
+            alia_component_end(ctx);
+        }
+        alia_layout_column_end(ctx);
+    }
+};
+
+} // namespace
+
+TEST_CASE("pointer motion resolves the hot element from the hit index")
+{
+    hover_list list(3);
+    alia_ui_refresh_policy const never{
+        .before_input = ALIA_UI_REFRESH_NEVER,
+        .before_draw = ALIA_UI_REFRESH_NEVER};
+    alia_ui_set_refresh_policy(list.ui, &never);
+
+    // The first motion has to do a full pass (which records the index and
+    // tells us where the rows are).
+    CHECK(list.move_mouse({1.f, 1.f}) == 1);
+    CHECK(!alia_element_id_is_valid(list.hot()));
+
+    // Since nothing is refreshing, the layout keeps resolving to the same
+    // placements and further motion is handled by the index alone.
+    CHECK(list.move_to_row(0) == 0);
+    CHECK(alia_element_id_equal(list.hot(), list.ids[0]));
+    CHECK(list.move_to_row(1) == 0);
+    CHECK(alia_element_id_equal(list.hot(), list.ids[1]));
+    CHECK(list.move_to_row(2) == 0);
+    CHECK(alia_element_id_equal(list.hot(), list.ids[2]));
+    CHECK(list.move_mouse({50.f, 90.f}) == 0);
+    CHECK(!alia_element_id_is_valid(list.hot()));
+
+    // Resizing the surface changes the placements, so the next motion has to
+    // record the index again (but only once).
+    alia_ui_surface_set_size(list.ui, {200, 100});
+    CHECK(list.move_to_row(0) == 1);
+    CHECK(alia_element_id_equal(list.hot(), list.ids[0]));
+    CHECK(list.move_to_row(1) == 0);
+    CHECK(alia_element_id_equal(list.hot(), list.ids[1]));
+}
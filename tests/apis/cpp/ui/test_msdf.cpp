@@ -0,0 +1,691 @@
+#include <alia/abi/ui/msdf.h>
+
+#include <alia/abi/ui/drawing/primitives.h>
+#include <alia/abi/ui/drawing/system.h>
+#include <alia/abi/ui/geometry.h>
+#include <alia/abi/ui/system/api.h>
+#include <alia/abi/ui/system/renderer.h>
+#include <alia/abi/ui/text.h>
+#include <alia/impl/events.hpp>
+#include <alia/ui/system/object.h>
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+alia_msdf_glyph
+test_glyph(uint32_t unicode, float advance)
+{
+    return {
+        .unicode = unicode,
+        .advance = advance,
+        .visible = true,
+        .plane_left = 0.f,
+        .plane_bottom = 0.f,
+        .plane_right = advance,
+        .plane_top = 1.f,
+        .atlas_left = 0.f,
+        .atlas_bottom = 0.f,
+        .atlas_right = 10.f,
+        .atlas_top = 10.f};
+}
+
+// a glyph with no quad, like a space
+alia_msdf_glyph
+blank_glyph(uint32_t unicode, float advance)
+{
+    return {.unicode = unicode, .advance = advance, .visible = false};
+}
+
+struct test_font
+{
+    std::vector<alia_msdf_glyph> glyphs
+        = {test_glyph('A', 0.5f),
+           test_glyph('V', 0.25f),
+           blank_glyph(' ', 0.125f),
+           test_glyph('o', 1.f),
+           // a glyph outside the dense range
+           test_glyph(0x263a, 2.f),
+           // a duplicate, which replaces the first 'o'
+           test_glyph('o', 0.75f)};
+    std::vector<alia_msdf_kerning_pair> kerning
+        = {{.left = 'V', .right = 'o', .adjustment = -0.125f},
+           {.left = 'A', .right = 'V', .adjustment = -0.5f},
+           {.left = 'V', .right = 'A', .adjustment = -0.25f},
+           // a duplicate, which replaces the first AV pair
+           {.left = 'A', .right = 'V', .adjustment = -0.0625f},
+           // a pair for a glyph that the font doesn't have
+           {.left = 'x', .right = 'A', .adjustment = -1.f}};
+    alia_msdf_text_engine* engine;
+
+    test_font()
+    {
+        alia_msdf_font_description const description
+            = {.metrics = {.em_size = 1.f, .line_height = 1.f},
+               .atlas = {.font_size = 32.f, .width = 100.f, .height = 100.f},
+               .glyphs = glyphs.data(),
+               .glyph_count = glyphs.size(),
+               .kerning_pairs = kerning.data(),
+               .kerning_pair_count = kerning.size()};
+        engine = alia_msdf_create_text_engine(&description, 1);
+    }
+
+    ~test_font()
+    {
+        alia_msdf_destroy_text_engine(engine);
+    }
+
+    float
+    width(char const* text, size_t length)
+    {
+        return alia_msdf_measure_text_width(engine, 0, text, length, 2.f);
+    }
+};
+
+// a UI that draws a single string and captures the primitive commands and
+// atlas updates that it produces
+struct text_drawing
+{
+    test_font& font;
+    char const* text = "";
+    size_t length = 0;
+    std::vector<alia_draw_command const*> commands;
+    std::vector<alia_msdf_atlas_region> atlas_updates;
+    alia_ui_system* ui = nullptr;
+
+    explicit text_drawing(test_font& font) : font(font)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {100, 100});
+        alia_material_register(
+            ui,
+            ALIA_PRIMITIVE_MATERIAL_ID,
+            {.draw_bucket = draw_bucket},
+            this);
+        alia_renderer_ops ops{};
+        ops.update_msdf_atlas = update_atlas;
+        ops.user = this;
+        alia_ui_system_set_renderer_ops(ui, &ops);
+        alia_ui_bind_msdf_text_engine(ui, font.engine);
+        alia_ui_system_update(ui);
+    }
+
+    // Do a draw pass that draws `text`.
+    void
+    draw(char const* new_text, size_t new_length)
+    {
+        text = new_text;
+        length = new_length;
+        commands.clear();
+        alia_ui_execute_draw_pass(ui);
+    }
+
+    static void
+    update_atlas(void* user, alia_msdf_atlas_region const* region)
+    {
+        static_cast<text_drawing*>(user)->atlas_updates.push_back(*region);
+    }
+
+    ~text_drawing()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    static void
+    draw_bucket(void* user, alia_draw_bucket const* bucket)
+    {
+        auto& self = *static_cast<text_drawing*>(user);
+        for (auto const* cmd = bucket->head; cmd; cmd = cmd->next)
+            self.commands.push_back(cmd);
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& self = *static_cast<text_drawing*>(user_data);
+        if (alia::get_event_type(*ctx) != ALIA_EVENT_DRAW)
+            return;
+        alia_geometry_push_clip_box(ctx, {{0.f, 0.f}, {100.f, 100.f}});
+        alia_msdf_draw_text(
+            self.font.engine,
+            ctx,
+            0,
+            self.text,
+            self.length,
+            2.f,
+            {10.f, 20.f},
+            {0xff, 0xff, 0xff, 0xff},
+            0);
+        alia_geometry_pop_clip_box(ctx);
+    }
+};
+
+} // namespace
+
+TEST_CASE("MSDF text measurement")
+{
+    test_font font;
+
+    CHECK(font.width("", 0) == 0.f);
+    CHECK(font.width("A", 1) == 1.f);
+    CHECK(font.width("o", 1) == 1.5f);
+    // (0.5 - 0.0625 + 0.25 - 0.125 + 0.75) * 2
+    CHECK(font.width("AVo", 3) == 2.625f);
+    // (0.25 - 0.25 + 0.5 + 0.125 + 0.5) * 2
+    CHECK(font.width("VA A", 4) == 2.25f);
+
+    CHECK(alia_msdf_measure_codepoint_width(font.engine, 0, 0x263a, 2.f)
+          == 4.f);
+    CHECK(alia_msdf_measure_codepoint_width(font.engine, 0, 'V', 2.f) == .5f);
+}
+
+TEST_CASE("MSDF line breaking")
+{
+    test_font font;
+
+    char const text[] = "AVo AVo\nA";
+    size_t const length = sizeof(text) - 1;
+
+    // The first line breaks after the space.
+    alia_msdf_break_result result = alia_msdf_break_text(
+        font.engine, 0, text, 0, length, length, 2.f, 4.f, false);
+    CHECK(result.next == 4);
+
+    // The second ends at the newline.
+    result = alia_msdf_break_text(
+        font.engine, 0, text, 4, length, length, 2.f, 100.f, false);
+    CHECK(result.next == 8);
+    CHECK(result.width == 2.625f);
+
+    result = alia_msdf_break_text(
+        font.engine, 0, text, 8, length, length, 2.f, 100.f, false);
+    CHECK(result.next == length);
+    CHECK(result.width == 1.f);
+}
+
+TEST_CASE("MSDF glyph runs")
+{
+    test_font font;
+
+    char const text[] = "AV o";
+    text_drawing drawing(font);
+    drawing.draw(text, sizeof(text) - 1);
+
+    // The whole string is a single command, and the space has no quad.
+    REQUIRE(drawing.commands.size() == 1);
+    auto const* run
+        = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+            drawing.commands[0]);
+    REQUIRE(run->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN);
+    REQUIRE(run->count == 3);
+    CHECK(run->scale == 2.f);
+
+    // The pen positions match the measured widths of the preceding text
+    // (including any kerning with the glyph itself).
+    alia_msdf_glyph_run_entry const* entries
+        = alia_msdf_glyph_run_entries(run);
+    CHECK(entries[0].x == 0.f);
+    CHECK(entries[1].x == font.width(text, 2) - font.width(text + 1, 1));
+    CHECK(entries[2].x == font.width(text, 3));
+
+    alia_box const box = alia_msdf_glyph_run_entry_box(run, entries[2]);
+    CHECK(box.min.x == run->origin.x + font.width(text, 3));
+    CHECK(box.size.x == 1.5f);
+    CHECK(box.size.y == 2.f);
+    CHECK(run->glyphs[entries[2].glyph].uv_rect[2] == 0.1f);
+
+    // Each glyph costs an entry rather than a whole primitive command.
+    CHECK(
+        alia_msdf_glyph_run_size(3) - alia_msdf_glyph_run_size(0)
+        <= 3 * sizeof(alia_msdf_glyph_run_entry) + ALIA_MIN_ALIGN);
+}
+
+TEST_CASE("MSDF UTF-8 decoding")
+{
+    test_font font;
+
+    // "A\u263a" - The smiley is a sparse glyph.
+    CHECK(font.width("A\xe2\x98\xba", 4) == 5.f);
+    // Malformed sequences (a stray continuation byte and a truncated
+    // sequence) decode to U+FFFD, which the font doesn't have.
+    CHECK(font.width("\x80" "A\xe2\x98", 4) == 1.f);
+    // So do overlong encodings.
+    CHECK(font.width("\xc1\x81", 2) == 0.f);
+
+    // Forced breaks land between characters, not in the middle of one.
+    char const text[] = "\xe2\x98\xba\xe2\x98\xba";
+    alia_msdf_break_result result
+        = alia_msdf_break_text(font.engine, 0, text, 0, 6, 6, 2.f, 1.f, true);
+    CHECK(result.next == 3);
+    result
+        = alia_msdf_break_text(font.engine, 0, text, 0, 6, 6, 2.f, 6.f, true);
+    CHECK(result.next == 3);
+}
+
+namespace {
+
+// a glyph generator that produces a square glyph for every codepoint at or
+// above U+4E00 (and nothing else)
+struct test_generator
+{
+    int calls = 0;
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(4 * 4 * 3, 0x80);
+
+    static bool
+    generate(
+        void* user,
+        size_t font_index,
+        uint32_t codepoint,
+        alia_msdf_generated_glyph* out)
+    {
+        auto& self = *static_cast<test_generator*>(user);
+        ++self.calls;
+        CHECK(font_index == 0);
+        if (codepoint < 0x4e00)
+            return false;
+        *out = {
+            .advance = 1.f,
+            .plane_left = 0.f,
+            .plane_bottom = 0.f,
+            .plane_right = 1.f,
+            .plane_top = 1.f,
+            .rgb = self.pixels.data(),
+            .width = 4,
+            .height = 4};
+        return true;
+    }
+};
+
+// Encode a codepoint from the U+0800 to U+FFFF range as UTF-8.
+void
+append_utf8(std::string& text, uint32_t codepoint)
+{
+    text += char(0xe0 | (codepoint >> 12));
+    text += char(0x80 | ((codepoint >> 6) & 0x3f));
+    text += char(0x80 | (codepoint & 0x3f));
+}
+
+std::string
+cjk_text(uint32_t first, uint32_t count)
+{
+    std::string text;
+    for (uint32_t i = 0; i != count; ++i)
+        append_utf8(text, first + i);
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("MSDF dynamic glyphs")
+{
+    test_font font;
+    test_generator generator;
+    // Each glyph takes up 5x5 pixels (with padding), so each 100x8 page holds
+    // a single row of 20 glyphs.
+    alia_msdf_dynamic_glyph_config const config
+        = {.generate = test_generator::generate,
+           .user = &generator,
+           .page_height = 8,
+           .page_count = 2,
+           .glyph_capacity = 100};
+    alia_msdf_enable_dynamic_glyphs(font.engine, &config);
+    alia_vec2i const texture_size
+        = alia_msdf_get_atlas_texture_size(font.engine);
+    CHECK(texture_size.x == 100);
+    CHECK(texture_size.y == 116);
+
+    // Generated glyphs are measured like baked ones, and each is only
+    // generated once.
+    std::string const one = cjk_text(0x4e00, 1);
+    CHECK(font.width(one.data(), one.size()) == 2.f);
+    CHECK(font.width(one.data(), one.size()) == 2.f);
+    CHECK(generator.calls == 1);
+    // Codepoints that the generator doesn't have are remembered too.
+    CHECK(font.width("\xc3\xa9", 2) == 0.f);
+    CHECK(font.width("\xc3\xa9", 2) == 0.f);
+    CHECK(generator.calls == 2);
+
+    text_drawing drawing(font);
+
+    // Fill both pages.
+    std::string const forty = cjk_text(0x4e00, 40);
+    float const forty_width = font.width(forty.data(), forty.size());
+    drawing.draw(forty.data(), forty.size());
+    REQUIRE(drawing.commands.size() == 1);
+    auto const* run
+        = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+            drawing.commands[0]);
+    CHECK(run->count == 40);
+    CHECK(drawing.atlas_updates.size() == 40);
+    // The pages are below the baked atlas.
+    for (alia_msdf_atlas_region const& region : drawing.atlas_updates)
+    {
+        CHECK(region.y >= 100);
+        CHECK(region.y + region.height <= 116);
+        CHECK(region.width == 4);
+    }
+    alia_msdf_glyph_metrics const& first
+        = run->glyphs[alia_msdf_glyph_run_entries(run)[0].glyph];
+    CHECK(first.uv_rect[1] * 116.f == doctest::Approx(100.f));
+    CHECK(first.uv_rect[3] * 116.f == doctest::Approx(4.f));
+    // The baked glyphs' UVs are scaled to the taller texture.
+    drawing.draw("A", 1);
+    REQUIRE(drawing.commands.size() == 1);
+    run = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+        drawing.commands[0]);
+    CHECK(
+        run->glyphs[alia_msdf_glyph_run_entries(run)[0].glyph].uv_rect[2]
+        == 0.1f);
+    CHECK(
+        run->glyphs[alia_msdf_glyph_run_entries(run)[0].glyph].uv_rect[3]
+        == doctest::Approx(10.f / 116.f));
+
+    // Use the second page's glyphs plus a new one. There's no room for the
+    // new one yet, so it's left out of this pass.
+    std::string const recent = cjk_text(0x4e14, 21);
+    drawing.draw(recent.data(), recent.size());
+    REQUIRE(drawing.commands.size() == 1);
+    run = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+        drawing.commands[0]);
+    CHECK(run->count == 20);
+    CHECK(drawing.atlas_updates.size() == 40);
+
+    // The next pass evicts the least recently used page (the first one) to
+    // make room.
+    drawing.draw(recent.data(), recent.size());
+    REQUIRE(drawing.commands.size() == 1);
+    run = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+        drawing.commands[0]);
+    CHECK(run->count == 21);
+    REQUIRE(drawing.atlas_updates.size() == 41);
+    CHECK(drawing.atlas_updates[40].x == drawing.atlas_updates[0].x);
+    CHECK(drawing.atlas_updates[40].y == drawing.atlas_updates[0].y);
+
+    // Eviction doesn't affect measurement.
+    CHECK(font.width(forty.data(), forty.size()) == forty_width);
+}
+
+namespace {
+
+// a UI with copies of a text element (in the test font) that counts the
+// glyphs it draws
+struct text_element
+{
+    test_font& font;
+    alia_typeface_id typeface;
+    std::string text;
+    uint64_t revision = 0;
+    int copies = 1;
+    size_t glyphs_drawn = 0;
+    alia_ui_system* ui = nullptr;
+
+    explicit text_element(test_font& font) : font(font)
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        void* storage
+            = ::operator new(spec.size, std::align_val_t(spec.align));
+        ui = alia_ui_system_init(
+            storage, {.fn = controller, .user_data = this}, {1000, 100});
+        alia_material_register(
+            ui,
+            ALIA_PRIMITIVE_MATERIAL_ID,
+            {.draw_bucket = draw_bucket},
+            this);
+        typeface = alia_msdf_register_typeface(ui, font.engine, 0);
+    }
+
+    ~text_element()
+    {
+        alia_struct_spec const spec = alia_ui_system_object_spec();
+        ui->~alia_ui_system();
+        ::operator delete(ui, std::align_val_t(spec.align));
+    }
+
+    void
+    set_text(std::string new_text)
+    {
+        text = std::move(new_text);
+        ++revision;
+    }
+
+    // Update the UI and do a draw pass.
+    void
+    update()
+    {
+        alia_ui_system_update(ui);
+        glyphs_drawn = 0;
+        alia_ui_execute_draw_pass(ui);
+    }
+
+    // Update the UI whenever a background preparation finishes, until the
+    // text is drawn (or a reasonable amount of time has passed). There may
+    // be completions from abandoned preparations along the way.
+    bool
+    update_until_drawn()
+    {
+        for (int i = 0; i != 5000; ++i)
+        {
+            if (ui->text_completions.pending.load())
+            {
+                update();
+                if (glyphs_drawn != 0)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    static void
+    draw_bucket(void* user, alia_draw_bucket const* bucket)
+    {
+        auto& self = *static_cast<text_element*>(user);
+        for (auto const* cmd = bucket->head; cmd; cmd = cmd->next)
+        {
+            auto const* run
+                = reinterpret_cast<alia_draw_msdf_glyph_run_command const*>(
+                    cmd);
+            if (run->primitive_type == ALIA_PRIMITIVE_MSDF_GLYPH_RUN)
+                self.glyphs_drawn += run->count;
+        }
+    }
+
+    static void
+    controller(void* user_data, alia_context* ctx)
+    {
+        auto& self = *static_cast<text_element*>(user_data);
+        alia_font_push(ctx, alia_resolve_font(ctx, {self.typeface, 10.f}));
+        for (int i = 0; i != self.copies; ++i)
+        {
+            alia_text(
+                ctx,
+                0,
+                alia_text_revision(
+                    self.text.data(), self.text.size(), self.revision),
+                nullptr);
+        }
+        alia_font_pop(ctx);
+    }
+};
+
+std::string
+repeated_text(char const* piece, int count)
+{
+    std::string text;
+    for (int i = 0; i != count; ++i)
+        text += piece;
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("MSDF background preparation")
+{
+    test_font font;
+    alia_msdf_background_config const config
+        = {.thread_count = 2, .min_length = 100};
+    alia_msdf_enable_background_preparation(font.engine, &config);
+
+    text_element element(font);
+    alia_resolved_typeface const typeface
+        = alia_typeface_resolve(element.ui, element.typeface);
+    alia_text_engine* engine = typeface.engine;
+    alia_text_engine_vtable const& vtable = *engine->vtable;
+
+    auto const on_ready = [](void* user) {
+        static_cast<std::atomic<bool>*>(user)->store(true);
+    };
+    auto const begin
+        = [&](std::string const& text, std::atomic<bool>& ready) {
+              return vtable.begin_prepare_block(
+                  engine,
+                  typeface.engine_handle,
+                  2.f,
+                  ALIA_TEXT_DIRECTION_LTR,
+                  text.data(),
+                  text.size(),
+                  on_ready,
+                  &ready);
+          };
+
+    // Small blocks are left to `prepare_block`.
+    std::atomic<bool> ready = false;
+    CHECK(begin("AVo", ready) == nullptr);
+
+    // Large ones are prepared in the background, with the same results.
+    std::string const text = repeated_text("AVo A\n", 100);
+    alia_text_preparation* preparation = begin(text, ready);
+    REQUIRE(preparation != nullptr);
+    for (int i = 0; i != 5000 && !ready.load(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(ready.load());
+    alia_text_block* block = vtable.finish_prepare_block(engine, preparation);
+    alia_text_block* expected = vtable.prepare_block(
+        engine,
+        typeface.engine_handle,
+        2.f,
+        ALIA_TEXT_DIRECTION_LTR,
+        text.data(),
+        text.size());
+    int const count = vtable.segment_count(engine, block);
+    REQUIRE(count == vtable.segment_count(engine, expected));
+    CHECK(count == 400);
+    for (int i = 0; i != count; ++i)
+    {
+        alia_text_segment a, b;
+        vtable.segment_info(engine, block, i, &a);
+        vtable.segment_info(engine, expected, i, &b);
+        CHECK(a.byte_start == b.byte_start);
+        CHECK(a.byte_end == b.byte_end);
+        CHECK(a.advance_width == b.advance_width);
+        CHECK(a.kind == b.kind);
+    }
+    vtable.release_block(engine, block);
+    vtable.release_block(engine, expected);
+
+    // Preparations can be abandoned at any point.
+    std::atomic<bool> abandoned[8] = {};
+    for (auto& flag : abandoned)
+        vtable.cancel_prepare_block(engine, begin(text, flag));
+
+    // A text element draws nothing until its block is ready.
+    element.set_text(repeated_text("AVo ", 50));
+    element.update();
+    CHECK(element.glyphs_drawn == 0);
+    REQUIRE(element.update_until_drawn());
+    CHECK(element.glyphs_drawn == 150);
+
+    // Changing the text starts over (and abandons the previous block).
+    element.set_text(repeated_text("oo ", 50));
+    element.update();
+    CHECK(element.glyphs_drawn == 0);
+    REQUIRE(element.update_until_drawn());
+    CHECK(element.glyphs_drawn == 100);
+}
+
+TEST_CASE("shared text blocks")
+{
+    test_font font;
+    text_element element(font);
+
+    // Identical text is only prepared once.
+    element.copies = 10;
+    element.set_text("AV");
+    element.update();
+    alia_text_block_cache_stats stats
+        = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits >= 9);
+    CHECK(stats.resident_blocks == 1);
+    size_t const av_bytes = stats.resident_bytes;
+    CHECK(av_bytes > 0);
+
+    // Blocks that go out of use stay in the cache...
+    element.set_text("AVo");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 2);
+    CHECK(stats.resident_blocks == 2);
+
+    // ... so they can be picked up again.
+    alia_ui_reset_text_block_cache_stats(element.ui);
+    element.set_text("AV");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 0);
+    CHECK(stats.hits >= 10);
+
+    // Unused blocks are evicted to stay within the budget, but blocks that
+    // are in use aren't.
+    alia_ui_set_text_block_cache_budget(element.ui, 0);
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.evictions == 1);
+    CHECK(stats.resident_blocks == 1);
+    CHECK(stats.resident_bytes == av_bytes);
+
+    element.set_text("A");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 1);
+    CHECK(stats.evictions == 2);
+    CHECK(stats.resident_blocks == 1);
+
+    // The least recently used blocks go first.
+    alia_ui_set_text_block_cache_budget(element.ui, 1 << 20);
+    element.set_text("V");
+    element.update();
+    element.set_text("o");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 3);
+    CHECK(stats.resident_blocks == 3);
+    alia_ui_set_text_block_cache_budget(element.ui, stats.resident_bytes - 1);
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.evictions == 3);
+    CHECK(stats.resident_blocks == 2);
+    // "V" is still there, but "A" has to be prepared again.
+    element.set_text("V");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 3);
+    element.set_text("A");
+    element.update();
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.misses == 4);
+
+    alia_ui_clear_text_block_cache(element.ui);
+    stats = alia_ui_get_text_block_cache_stats(element.ui);
+    CHECK(stats.resident_blocks == 1);
+}
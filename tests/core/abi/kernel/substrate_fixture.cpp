@@ -8,6 +8,7 @@
 #include <alia/kernel/substrate.h>
 
 #include <cstdlib>
+#include <new>
 
 #if defined(_MSC_VER)
 #include <malloc.h>
@@ -82,8 +83,9 @@ extern "C" {
 alia_test_substrate_fixture*
 alia_test_substrate_fixture_create(alia_general_allocator allocator)
 {
-    auto* fixture = static_cast<alia_test_substrate_fixture*>(
-        std::malloc(sizeof(alia_test_substrate_fixture)));
+    // (Value-initializing the fixture gives the event traversal a null
+    // active component, which state tracking relies on.)
+    auto* fixture = new (std::nothrow) alia_test_substrate_fixture{};
     if (!fixture)
         return nullptr;
 
@@ -93,7 +95,7 @@ alia_test_substrate_fixture_create(alia_general_allocator allocator)
         = aligned_alloc_portable(arena_spec.align, arena_spec.size);
     if (!fixture->arena_storage)
     {
-        std::free(fixture);
+        delete fixture;
         return nullptr;
     }
 
@@ -103,7 +105,7 @@ alia_test_substrate_fixture_create(alia_general_allocator allocator)
     {
         aligned_free_portable(fixture->arena_storage);
         fixture->arena_storage = NULL;
-        std::free(fixture);
+        delete fixture;
         return nullptr;
     }
 
@@ -151,7 +153,7 @@ alia_test_substrate_fixture_destroy(alia_test_substrate_fixture* fixture)
         fixture->arena_storage = NULL;
     }
 
-    std::free(fixture);
+    delete fixture;
 }
 
 alia_substrate_traversal*
@@ -182,6 +184,7 @@ alia_test_substrate_fixture_prepare_refresh_event(
     fixture->refresh_event = alia_make_refresh_event(alia_refresh{false});
     fixture->event_traversal.event = &fixture->refresh_event;
     fixture->event_traversal.aborted = false;
+    fixture->event_traversal.active_component = nullptr;
     ctx->events = &fixture->event_traversal;
 }
 
@@ -920,6 +920,270 @@ test_keyed_block_sweep_stale(void)
     substrate_fixture_destroy(&t);
 }
 
+typedef struct counted_object
+{
+    int* destroy_count;
+} counted_object;
+
+static void
+counted_object_cleanup(
+    alia_substrate_system* system, void* p, alia_substrate_cleanup_mode mode)
+{
+    (void) system;
+    if (mode == ALIA_SUBSTRATE_DESTROY)
+        ++*((counted_object*) p)->destroy_count;
+}
+
+static void
+visit_counted_keys(
+    substrate_fixture* t,
+    alia_substrate_key_table* table,
+    int* destroy_count,
+    uint64_t key_count,
+    uint64_t stride,
+    void** ptrs,
+    int* init_count)
+{
+    alia_substrate_key_scope* scope
+        = alia_substrate_begin_key_scope(&t->ctx, table);
+    for (uint64_t key = 0; key < key_count; key += stride)
+    {
+        alia_substrate_begin_keyed_block(
+            &t->ctx, scope, alia_id_view_make_u64(key), &keyed_block_spec);
+        alia_substrate_usage_result use = alia_substrate_use_object(
+            &t->ctx,
+            sizeof(counted_object),
+            _Alignof(counted_object),
+            counted_object_cleanup);
+        if (use.mode == ALIA_SUBSTRATE_BLOCK_TRAVERSAL_INIT)
+        {
+            ((counted_object*) use.ptr)->destroy_count = destroy_count;
+            ++*init_count;
+        }
+        ptrs[key] = use.ptr;
+        alia_substrate_end_keyed_block(&t->ctx);
+    }
+    alia_substrate_end_key_scope(&t->ctx, scope);
+}
+
+static void
+test_keyed_block_sweep_many(void)
+{
+    // This exercises key map growth and sweeping runs of entries out of the
+    // middle of probe sequences.
+    enum
+    {
+        key_count = 200
+    };
+
+    substrate_fixture t;
+    substrate_fixture_init(&t);
+
+    alia_substrate_anchor* root
+        = alia_test_substrate_fixture_root_anchor(t.fixture);
+    int destroy_count = 0;
+    int init_count = 0;
+    void* first_ptrs[key_count] = {0};
+    void* later_ptrs[key_count] = {0};
+
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    alia_substrate_key_table* table = alia_substrate_use_key_table(
+        &t.ctx, ALIA_SUBSTRATE_KEY_TABLE_NORMAL);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 1, first_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+    TEST_CHECK(init_count == key_count);
+
+    // Only every third key survives this pass.
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 3, later_ptrs, &init_count);
+    alia_substrate_sweep_table_keys(&t.ctx, table);
+    (void) alia_substrate_end_block(&t.ctx);
+    TEST_CHECK(init_count == key_count);
+    TEST_CHECK(destroy_count == key_count - (key_count + 2) / 3);
+
+    // The survivors should all still be found (with their original data)...
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 3, later_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+    TEST_CHECK(init_count == key_count);
+    for (int key = 0; key < key_count; key += 3)
+        TEST_CHECK(later_ptrs[key] == first_ptrs[key]);
+
+    // ... while the swept keys should get fresh blocks.
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 1, later_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+    TEST_CHECK(init_count == key_count + key_count - (key_count + 2) / 3);
+
+    alia_test_substrate_fixture_cleanup_root_block(t.fixture);
+    TEST_CHECK(destroy_count == init_count);
+    substrate_fixture_destroy(&t);
+}
+
+static void
+test_keyed_block_incremental_sweep(void)
+{
+    enum
+    {
+        key_count = 200,
+        survivor_count = (key_count + 2) / 3
+    };
+
+    substrate_fixture t;
+    substrate_fixture_init(&t);
+
+    alia_substrate_system* system
+        = alia_test_substrate_fixture_system(t.fixture);
+    alia_substrate_anchor* root
+        = alia_test_substrate_fixture_root_anchor(t.fixture);
+    int destroy_count = 0;
+    int init_count = 0;
+    void* first_ptrs[key_count] = {0};
+    void* later_ptrs[key_count] = {0};
+
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    alia_substrate_key_table* table = alia_substrate_use_key_table(
+        &t.ctx, ALIA_SUBSTRATE_KEY_TABLE_NORMAL);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 1, first_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 3, later_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+
+    // A deadline that has already passed shouldn't allow any work.
+    alia_substrate_sweep_budget expired = {.max_work = 0, .deadline = 1};
+    alia_substrate_sweep_progress progress
+        = alia_substrate_sweep_system_keys_incrementally(system, expired);
+    TEST_CHECK(progress.work_done == 0);
+    TEST_CHECK(alia_substrate_sweep_is_pending(progress));
+    TEST_CHECK(destroy_count == 0);
+
+    // With a small work budget, the sweep should take several calls, and
+    // each call should stay within its budget.
+    alia_substrate_sweep_budget small = {.max_work = 16, .deadline = 0};
+    int calls = 0;
+    do
+    {
+        int const destroyed_before = destroy_count;
+        progress
+            = alia_substrate_sweep_system_keys_incrementally(system, small);
+        TEST_CHECK(progress.work_done <= 16);
+        TEST_CHECK(destroy_count - destroyed_before <= 16);
+        ++calls;
+    } while (alia_substrate_sweep_is_pending(progress) && calls < 1000);
+    TEST_CHECK(calls > 1);
+    TEST_CHECK(progress.pending_slots == 0);
+    TEST_CHECK(progress.pending_frees == 0);
+    TEST_CHECK(destroy_count == key_count - survivor_count);
+
+    // The survivors should be unaffected.
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 3, later_ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+    TEST_CHECK(init_count == key_count);
+    for (int key = 0; key < key_count; key += 3)
+        TEST_CHECK(later_ptrs[key] == first_ptrs[key]);
+
+    // An unlimited budget should finish a fresh cycle in one call.
+    alia_substrate_sweep_budget unlimited = {.max_work = 0, .deadline = 0};
+    progress
+        = alia_substrate_sweep_system_keys_incrementally(system, unlimited);
+    TEST_CHECK(!alia_substrate_sweep_is_pending(progress));
+    TEST_CHECK(destroy_count == key_count - survivor_count);
+
+    alia_test_substrate_fixture_cleanup_root_block(t.fixture);
+    TEST_CHECK(destroy_count == init_count);
+    substrate_fixture_destroy(&t);
+}
+
+static void
+test_keyed_block_incremental_sweep_pending_on_reset(void)
+{
+    // Blocks that are still waiting to be freed when the substrate is reset
+    // should be cleaned up along with everything else.
+    enum
+    {
+        key_count = 40
+    };
+
+    substrate_fixture t;
+    substrate_fixture_init(&t);
+
+    alia_substrate_system* system
+        = alia_test_substrate_fixture_system(t.fixture);
+    alia_substrate_anchor* root
+        = alia_test_substrate_fixture_root_anchor(t.fixture);
+    int destroy_count = 0;
+    int init_count = 0;
+    void* ptrs[key_count] = {0};
+
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    alia_substrate_key_table* table = alia_substrate_use_key_table(
+        &t.ctx, ALIA_SUBSTRATE_KEY_TABLE_NORMAL);
+    visit_counted_keys(
+        &t, table, &destroy_count, key_count, 1, ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+
+    alia_test_substrate_fixture_advance_frame(t.fixture);
+    alia_test_substrate_fixture_reset_traversal(t.fixture, true);
+    alia_stack_reset(t.stack);
+
+    alia_substrate_begin_block(&t.ctx, root, &root_block_spec);
+    visit_counted_keys(&t, table, &destroy_count, 1, 1, ptrs, &init_count);
+    (void) alia_substrate_end_block(&t.ctx);
+
+    // Leave enough budget to scan the whole table (64 slots, plus a
+    // re-examination for each of the 39 erasures) but not to free much.
+    alia_substrate_sweep_budget budget = {.max_work = 110, .deadline = 0};
+    alia_substrate_sweep_progress progress
+        = alia_substrate_sweep_system_keys_incrementally(system, budget);
+    TEST_CHECK(progress.pending_slots == 0);
+    TEST_CHECK(progress.pending_frees != 0);
+
+    alia_test_substrate_fixture_cleanup_root_block(t.fixture);
+    TEST_CHECK(destroy_count == init_count);
+    substrate_fixture_destroy(&t);
+}
+
 static void
 test_keyed_scope_requires_explicit_delete(void)
 {
@@ -1365,6 +1629,9 @@ substrate_tests(void)
     test_keyed_block_basic();
     test_keyed_block_reorder();
     test_keyed_block_sweep_stale();
+    test_keyed_block_sweep_many();
+    test_keyed_block_incremental_sweep();
+    test_keyed_block_incremental_sweep_pending_on_reset();
     test_keyed_scope_requires_explicit_delete();
     test_keyed_block_soft_delete_while_active();
     test_keyed_block_nested_scopes();
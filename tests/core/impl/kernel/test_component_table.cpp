@@ -0,0 +1,99 @@
+#include <doctest/doctest.h>
+
+#include <alia/kernel/flow/component_table.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+using namespace alia;
+
+namespace {
+
+alia_general_allocator
+test_allocator()
+{
+    return alia_general_allocator{
+        [](void*, size_t size, size_t) -> void* { return malloc(size); },
+        [](void*, void* ptr, size_t, size_t) { free(ptr); },
+        nullptr};
+}
+
+alia_component*
+fake_component(std::uintptr_t raw)
+{
+    return reinterpret_cast<alia_component*>(raw * 16);
+}
+
+struct table_fixture
+{
+    alia_general_allocator allocator = test_allocator();
+    alia_component_table table;
+
+    table_fixture()
+    {
+        component_table_init(table);
+    }
+
+    ~table_fixture()
+    {
+        component_table_destroy(table, allocator);
+    }
+};
+
+} // namespace
+
+TEST_CASE("component table lookups")
+{
+    table_fixture t;
+
+    CHECK(component_table_lookup(t.table, 0) == nullptr);
+
+    alia_route_node_id a
+        = component_table_acquire(t.table, t.allocator, fake_component(1));
+    alia_route_node_id b
+        = component_table_acquire(t.table, t.allocator, fake_component(2));
+    CHECK(a != 0);
+    CHECK(b != 0);
+    CHECK(a != b);
+    CHECK(component_table_lookup(t.table, a) == fake_component(1));
+    CHECK(component_table_lookup(t.table, b) == fake_component(2));
+
+    // IDs that were never issued don't resolve.
+    CHECK(component_table_lookup(t.table, b + 1) == nullptr);
+}
+
+TEST_CASE("component table IDs go stale when released")
+{
+    table_fixture t;
+
+    alia_route_node_id a
+        = component_table_acquire(t.table, t.allocator, fake_component(1));
+    component_table_release(t.table, a);
+    CHECK(component_table_lookup(t.table, a) == nullptr);
+
+    // The slot is reused, but with a new generation, so the old ID stays
+    // stale.
+    alia_route_node_id c
+        = component_table_acquire(t.table, t.allocator, fake_component(3));
+    CHECK(c != a);
+    CHECK(component_table_lookup(t.table, a) == nullptr);
+    CHECK(component_table_lookup(t.table, c) == fake_component(3));
+}
+
+TEST_CASE("component table grows")
+{
+    table_fixture t;
+
+    std::vector<alia_route_node_id> ids;
+    for (std::uintptr_t i = 1; i <= 1000; ++i)
+    {
+        ids.push_back(
+            component_table_acquire(t.table, t.allocator, fake_component(i)));
+    }
+    for (std::uintptr_t i = 1; i <= 1000; ++i)
+    {
+        CHECK(
+            component_table_lookup(t.table, ids[i - 1]) == fake_component(i));
+    }
+}
@@ -0,0 +1,84 @@
+#include <doctest/doctest.h>
+
+#include <alia/base/arena.h>
+#include <alia/impl/base/arena.hpp>
+#include <alia/ui/drawing/bucket_key.h>
+#include <alia/ui/drawing/bucket_table.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace alia;
+
+namespace {
+
+struct table_fixture
+{
+    alia_arena arena;
+    alia_bump_allocator allocator;
+    alia_draw_bucket_table table;
+
+    table_fixture()
+    {
+        initialize_lazy_commit_arena(&arena, 16 * 1024 * 1024);
+        alia_bump_allocator_init(&allocator, &arena);
+        draw_bucket_table_init(table, &allocator);
+    }
+
+    ~table_fixture()
+    {
+        alia_arena_destroy(&arena);
+    }
+};
+
+} // namespace
+
+TEST_CASE("draw bucket table lookups")
+{
+    table_fixture t;
+
+    uint64_t const a = make_bucket_key(0, 1, 2, 3);
+    uint64_t const b = make_bucket_key(0, 1, 2, 4);
+    uint32_t const bucket_a
+        = draw_bucket_table_find_or_create(t.table, a, nullptr);
+    uint32_t const bucket_b
+        = draw_bucket_table_find_or_create(t.table, b, nullptr);
+    CHECK(bucket_a != bucket_b);
+    CHECK(draw_bucket_table_find_or_create(t.table, a, nullptr) == bucket_a);
+    CHECK(draw_bucket_table_find_or_create(t.table, b, nullptr) == bucket_b);
+    CHECK(t.table.count == 2);
+}
+
+TEST_CASE("draw bucket table sorting")
+{
+    table_fixture t;
+
+    // Insert a few thousand random keys (which forces the table to grow
+    // several times), some of them more than once.
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> keys;
+    for (int i = 0; i != 3000; ++i)
+    {
+        uint64_t const key = make_bucket_key(
+            alia_draw_target_id(rng() % 3),
+            alia_z_index(rng() % 20),
+            alia_clip_id(rng() % 500),
+            alia_draw_material_id(rng() % 5));
+        uint32_t const bucket
+            = draw_bucket_table_find_or_create(t.table, key, nullptr);
+        ++t.table.buckets[bucket].count;
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    REQUIRE(t.table.count == keys.size());
+
+    sorted_draw_bucket const* sorted = sort_draw_buckets(t.table);
+    for (uint32_t i = 0; i != t.table.count; ++i)
+    {
+        CHECK(sorted[i].key == keys[i]);
+        CHECK(t.table.keys[sorted[i].bucket] == keys[i]);
+    }
+}
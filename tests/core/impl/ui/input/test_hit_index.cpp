@@ -0,0 +1,122 @@
+#include <doctest/doctest.h>
+
+#include <alia/ui/input/hit_index.h>
+
+using namespace alia;
+
+namespace {
+
+alia_element_id
+make_id(uintptr_t n)
+{
+    return alia_element_id{reinterpret_cast<void*>(n * 16), 0};
+}
+
+hit_region
+make_region(
+    uintptr_t n,
+    float x,
+    float y,
+    float w,
+    float h,
+    alia_cursor_t cursor = ALIA_CURSOR_DEFAULT,
+    bool custom = false)
+{
+    hit_region region;
+    region.min = {x, y};
+    region.max = {x + w, y + h};
+    region.region = {{x, y}, {w, h}};
+    region.id = make_id(n);
+    region.cursor = cursor;
+    region.custom = custom;
+    return region;
+}
+
+alia_element_id
+lookup(hit_index const& index, float x, float y)
+{
+    alia_mouse_hit_test_result result;
+    REQUIRE(hit_index_lookup(index, {x, y}, result));
+    return result.id;
+}
+
+} // namespace
+
+TEST_CASE("hit index lookups")
+{
+    hit_index index;
+    hit_index_begin_recording(index);
+    // a background covering most of the surface...
+    hit_index_record(index, make_region(1, 0, 0, 500, 500));
+    // ... with a button on top of it that spans several grid cells...
+    hit_index_record(
+        index, make_region(2, 100, 100, 200, 50, ALIA_CURSOR_POINTER));
+    // ... and an empty (e.g., fully clipped) region that should be dropped
+    hit_index_record(index, make_region(3, 120, 120, 0, 10));
+    hit_index_end_recording(index, {640, 480}, 7);
+
+    CHECK(index.valid);
+    CHECK(index.placement_epoch == 7);
+    CHECK(index.regions.size() == 2);
+
+    // The later (topmost) region wins where they overlap.
+    CHECK(alia_element_id_equal(lookup(index, 150, 120), make_id(2)));
+    CHECK(alia_element_id_equal(lookup(index, 299, 149), make_id(2)));
+    CHECK(alia_element_id_equal(lookup(index, 300, 120), make_id(1)));
+    CHECK(alia_element_id_equal(lookup(index, 10, 10), make_id(1)));
+
+    alia_mouse_hit_test_result result;
+    REQUIRE(hit_index_lookup(index, {150, 120}, result));
+    CHECK(result.cursor == ALIA_CURSOR_POINTER);
+    CHECK(result.region.min.x == 100);
+    CHECK(result.region.size.x == 200);
+
+    // Misses (including points outside the surface) resolve to nothing.
+    CHECK(!alia_element_id_is_valid(lookup(index, 600, 10)));
+    CHECK(!alia_element_id_is_valid(lookup(index, -5, -5)));
+    CHECK(!alia_element_id_is_valid(lookup(index, 2000, 2000)));
+}
+
+TEST_CASE("hit index custom regions")
+{
+    hit_index index;
+    hit_index_begin_recording(index);
+    hit_index_record(index, make_region(1, 0, 0, 200, 200));
+    hit_index_record(
+        index, make_region(2, 50, 50, 50, 50, ALIA_CURSOR_DEFAULT, true));
+    hit_index_end_recording(index, {200, 200}, 1);
+    REQUIRE(index.valid);
+
+    // Lookups that land on a custom region can't be resolved...
+    alia_mouse_hit_test_result result;
+    CHECK(!hit_index_lookup(index, {60, 60}, result));
+    // ... but ones that miss it still can.
+    CHECK(alia_element_id_equal(lookup(index, 10, 10), make_id(1)));
+}
+
+TEST_CASE("hit index invalidation")
+{
+    hit_index index;
+    alia_input_state input{};
+
+    hit_index_begin_recording(index);
+    hit_index_record(index, make_region(1, 0, 0, 10, 10));
+    hit_index_end_recording(index, {100, 100}, 1);
+    REQUIRE(index.valid);
+
+    // Plain pointer motion leaves the index alone...
+    alia_event motion = alia_make_mouse_motion_event({});
+    hit_index_note_event(index, motion, input);
+    CHECK(index.valid);
+
+    // ... but dragging doesn't.
+    input.mouse_button_state = 1;
+    hit_index_note_event(index, motion, input);
+    CHECK(!index.valid);
+
+    // An undeclared hit during recording leaves the index invalid.
+    hit_index_begin_recording(index);
+    index.saw_undeclared_hit = true;
+    hit_index_end_recording(index, {100, 100}, 1);
+    CHECK(!index.valid);
+}
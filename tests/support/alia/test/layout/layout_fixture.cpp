@@ -4,6 +4,7 @@
 #include <alia/abi/base/stack.h>
 #include <alia/abi/ui/events.h>
 #include <alia/abi/ui/geometry.h>
+#include <alia/abi/ui/layout/snapshot.h>
 #include <alia/abi/ui/styling.h>
 #include <alia/base/stack.h>
 #include <alia/impl/events.hpp>
@@ -84,8 +85,10 @@ wire_context(layout_fixture& fixture, bool refresh)
     }
     fixture.event_traversal.aborted = false;
 
+    fixture.layout_context.system = &fixture.layout;
     fixture.layout_context.emission.next_ptr
         = &fixture.layout.root.first_child;
+    fixture.layout_context.emission.node_count = 0;
     alia_bump_allocator_init(
         &fixture.layout_context.emission.arena, &fixture.layout.node_arena);
     alia_bump_allocator_init(
@@ -141,9 +144,7 @@ layout_fixture_destroy(layout_fixture* fixture)
     if (!fixture)
         return;
 
-    alia_arena_destroy(&fixture->layout.node_arena);
-    alia_arena_destroy(&fixture->layout.scratch_arena);
-    alia_arena_destroy(&fixture->layout.placement_arena);
+    alia_layout_system_destroy(&fixture->layout);
 
     if (fixture->stack_buffer)
     {
@@ -214,6 +215,46 @@ layout_fixture_run_refresh_impl(
     wire_context(*fixture, true);
     fn(&fixture->context, user);
     *fixture->layout_context.emission.next_ptr = nullptr;
+    alia::layout_system_end_refresh(fixture->layout);
+    alia_bump_allocator_commit_peak(&fixture->layout_context.emission.arena);
+}
+
+namespace {
+
+struct snapshot_data
+{
+    void const* data;
+    size_t size;
+};
+
+void
+emit_snapshot(alia_context* ctx, void* user)
+{
+    auto const& snapshot = *static_cast<snapshot_data const*>(user);
+    alia_layout_snapshot_emit(ctx, snapshot.data, snapshot.size);
+}
+
+} // namespace
+
+bool
+layout_fixture_load_snapshot(
+    layout_fixture* fixture,
+    void const* data,
+    size_t size,
+    alia_vec2f* available)
+{
+    if (!fixture || !alia_layout_snapshot_read(data, size, available))
+        return false;
+    snapshot_data snapshot{.data = data, .size = size};
+    layout_fixture_run_refresh_impl(fixture, emit_snapshot, &snapshot);
+    return true;
+}
+
+void
+layout_fixture_clear_layout_cache(layout_fixture* fixture)
+{
+    if (fixture)
+        alia::layout_cache_clear(fixture->layout.cache);
 }
 
 void
@@ -235,6 +276,14 @@ layout_fixture_run_spatial_impl(
     fn(&fixture->context, user);
 }
 
+std::vector<uint8_t>
+layout_fixture_placement_data(layout_fixture* fixture)
+{
+    alia_layout_system const& system = fixture->layout;
+    uint8_t const* data = system.placement_arena.base;
+    return std::vector<uint8_t>(data, data + system.placement_size);
+}
+
 bool
 alia_layout_context_is_refresh(alia_context* ctx)
 {
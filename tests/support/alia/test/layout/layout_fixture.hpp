@@ -7,8 +7,10 @@
 #include <alia/abi/ui/layout/system.h>
 
 #ifdef __cplusplus
+#include <cstdint>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #endif
 
 struct layout_fixture;
@@ -52,6 +54,22 @@ layout_fixture_run_refresh_impl(
 void
 layout_fixture_resolve(layout_fixture* fixture, alia_vec2f available);
 
+// Replace the fixture's layout tree with the one recorded in a snapshot (see
+// alia/abi/ui/layout/snapshot.h) and set `*available` to the space that it
+// was resolved within. This returns false (and leaves the tree alone) if the
+// snapshot isn't well-formed.
+bool
+layout_fixture_load_snapshot(
+    layout_fixture* fixture,
+    void const* data,
+    size_t size,
+    alia_vec2f* available);
+
+// Forget everything that the layout cache remembers from previous resolves
+// (so that the next one lays out the whole tree).
+void
+layout_fixture_clear_layout_cache(layout_fixture* fixture);
+
 void
 layout_fixture_run_spatial_impl(
     layout_fixture* fixture, void (*fn)(alia_context*, void*), void* user);
@@ -86,6 +104,43 @@ layout_fixture_run_spatial(layout_fixture* fixture, Fn&& fn)
         &fn);
 }
 
+// the placement data written by the last resolve of `fixture`
+std::vector<uint8_t>
+layout_fixture_placement_data(layout_fixture* fixture);
+
+// Refresh `fixture` with `fn`, resolve it within `available`, and return the
+// placement data that the resolve produced.
+template<class Fn>
+std::vector<uint8_t>
+layout_fixture_lay_out(layout_fixture* fixture, Fn&& fn, alia_vec2f available)
+{
+    layout_fixture_run_refresh(fixture, std::forward<Fn>(fn));
+    layout_fixture_resolve(fixture, available);
+    return layout_fixture_placement_data(fixture);
+}
+
+// Do the same with a fresh fixture, which is passed to `setup` first (so that
+// it can be configured).
+template<class Fn, class Setup>
+std::vector<uint8_t>
+layout_fixture_lay_out_fresh(Fn&& fn, alia_vec2f available, Setup&& setup)
+{
+    layout_fixture* fixture = layout_fixture_create();
+    setup(fixture);
+    auto placements
+        = layout_fixture_lay_out(fixture, std::forward<Fn>(fn), available);
+    layout_fixture_destroy(fixture);
+    return placements;
+}
+
+template<class Fn>
+std::vector<uint8_t>
+layout_fixture_lay_out_fresh(Fn&& fn, alia_vec2f available)
+{
+    return layout_fixture_lay_out_fresh(
+        std::forward<Fn>(fn), available, [](layout_fixture*) {});
+}
+
 // Backward-compatible aliases for layout tests.
 using layout_test_fixture = layout_fixture;
 
@@ -4,10 +4,28 @@
 #include <alia/abi/ui/layout/api.h>
 #include <alia/abi/ui/layout/flags.h>
 
+static void
+begin_scenario(void* user_data)
+{
+    if (user_data)
+        ((alia_layout_scenario_change*) user_data)->leaf_counter = 0;
+}
+
 static void
 scenario_leaf(
-    alia_context* ctx, float width, float height, alia_layout_flags_t flags)
+    alia_context* ctx,
+    void* user_data,
+    float width,
+    float height,
+    alia_layout_flags_t flags)
 {
+    if (user_data)
+    {
+        alia_layout_scenario_change* change
+            = (alia_layout_scenario_change*) user_data;
+        if (change->leaf_counter++ == change->leaf_index)
+            width += change->extra_width;
+    }
     if (alia_layout_context_is_refresh(ctx))
     {
         alia_layout_leaf_emit(
@@ -19,20 +37,21 @@ scenario_leaf(
         (void) alia_layout_consume_box(ctx);
 }
 
-void
-alia_layout_scenario_nested_grid_10(alia_context* ctx, void* user_data)
+// a row of `n` columns, each holding `n` rows of `n` leaves
+static void
+nested_grid(alia_context* ctx, void* user_data, uint32_t n)
 {
-    (void) user_data;
+    begin_scenario(user_data);
 
     alia_layout_row_begin(ctx, 0, 0);
-    for (uint32_t i = 0; i < 10; ++i)
+    for (uint32_t i = 0; i < n; ++i)
     {
         alia_layout_column_begin(ctx, 0, 0);
-        for (uint32_t j = 0; j < 10; ++j)
+        for (uint32_t j = 0; j < n; ++j)
         {
             alia_layout_row_begin(ctx, 0, 0);
-            for (uint32_t k = 0; k < 10; ++k)
-                scenario_leaf(ctx, 100.f, 100.f, 0);
+            for (uint32_t k = 0; k < n; ++k)
+                scenario_leaf(ctx, user_data, 100.f, 100.f, 0);
             alia_layout_row_end(ctx);
         }
         alia_layout_column_end(ctx);
@@ -40,39 +59,108 @@ alia_layout_scenario_nested_grid_10(alia_context* ctx, void* user_data)
     alia_layout_row_end(ctx);
 }
 
-void
-alia_layout_scenario_column_of_rows_100(alia_context* ctx, void* user_data)
+// a column of `row_count` rows, each holding two leaves
+static void
+column_of_rows(alia_context* ctx, void* user_data, uint32_t row_count)
 {
-    (void) user_data;
+    begin_scenario(user_data);
 
     alia_layout_column_begin(ctx, 0, 0);
-    for (uint32_t j = 0; j < 100; ++j)
+    for (uint32_t j = 0; j < row_count; ++j)
     {
         alia_layout_row_begin(ctx, 0, 0);
-        scenario_leaf(ctx, 20.f, 20.f, 0);
-        scenario_leaf(ctx, 20.f, (float) ((j & 7u) * 5u), 0);
+        scenario_leaf(ctx, user_data, 20.f, 20.f, 0);
+        scenario_leaf(ctx, user_data, 20.f, (float) ((j & 7u) * 5u), 0);
         alia_layout_row_end(ctx);
     }
     alia_layout_column_end(ctx);
 }
 
+// the number of rows in the 1M node version of `column_of_rows`
+#define COLUMN_OF_ROWS_1M_ROW_COUNT 333333u
+
+// the shape of the `paragraphs` scenario
+#define PARAGRAPH_COUNT 20u
+#define PARAGRAPH_WORD_COUNT 200u
+
+void
+alia_layout_scenario_nested_grid_10(alia_context* ctx, void* user_data)
+{
+    nested_grid(ctx, user_data, 10);
+}
+
+void
+alia_layout_scenario_column_of_rows_100(alia_context* ctx, void* user_data)
+{
+    column_of_rows(ctx, user_data, 100);
+}
+
+void
+alia_layout_scenario_nested_grid_1m(alia_context* ctx, void* user_data)
+{
+    nested_grid(ctx, user_data, 100);
+}
+
+void
+alia_layout_scenario_column_of_rows_1m(alia_context* ctx, void* user_data)
+{
+    column_of_rows(ctx, user_data, COLUMN_OF_ROWS_1M_ROW_COUNT);
+}
+
 void
 alia_layout_scenario_growth_rows_100(alia_context* ctx, void* user_data)
 {
-    (void) user_data;
+    begin_scenario(user_data);
 
     alia_layout_column_begin(ctx, 0, 0);
     for (uint32_t j = 0; j < 100; ++j)
     {
         alia_layout_row_begin(ctx, ALIA_GROW, 0);
-        scenario_leaf(ctx, 20.f, 20.f, 0);
-        scenario_leaf(ctx, 0.f, 0.f, ALIA_FILL | ALIA_GROW);
-        scenario_leaf(ctx, (float) ((j & 7u) * 5u), 0.f, 0);
+        scenario_leaf(ctx, user_data, 20.f, 20.f, 0);
+        scenario_leaf(ctx, user_data, 0.f, 0.f, ALIA_FILL | ALIA_GROW);
+        scenario_leaf(ctx, user_data, (float) ((j & 7u) * 5u), 0.f, 0);
         alia_layout_row_end(ctx);
     }
     alia_layout_column_end(ctx);
 }
 
+void
+alia_layout_scenario_grid_100(alia_context* ctx, void* user_data)
+{
+    begin_scenario(user_data);
+
+    alia_layout_grid_handle grid = alia_layout_grid_begin(ctx, 0);
+    for (uint32_t j = 0; j < 100; ++j)
+    {
+        alia_layout_grid_row_begin(ctx, grid, 0);
+        scenario_leaf(ctx, user_data, 20.f, 20.f, 0);
+        scenario_leaf(ctx, user_data, (float) ((j & 7u) * 5u), 10.f, 0);
+        scenario_leaf(ctx, user_data, 0.f, 0.f, ALIA_FILL | ALIA_GROW);
+        scenario_leaf(ctx, user_data, 15.f, (float) ((j & 3u) * 5u), 0);
+        alia_layout_grid_row_end(ctx);
+    }
+    alia_layout_grid_end(ctx);
+}
+
+void
+alia_layout_scenario_paragraphs(alia_context* ctx, void* user_data)
+{
+    begin_scenario(user_data);
+
+    alia_layout_column_begin(ctx, 0, 4);
+    for (uint32_t j = 0; j < PARAGRAPH_COUNT; ++j)
+    {
+        alia_layout_flow_begin(ctx, 0, 4, 2, 0);
+        for (uint32_t k = 0; k < PARAGRAPH_WORD_COUNT; ++k)
+        {
+            float const width = (float) (20u + (j * 13u + k * 37u) % 60u);
+            scenario_leaf(ctx, user_data, width, 16.f, 0);
+        }
+        alia_layout_flow_end(ctx);
+    }
+    alia_layout_column_end(ctx);
+}
+
 uint32_t
 alia_layout_scenario_nested_grid_10_leaf_count(void)
 {
@@ -90,3 +178,49 @@ alia_layout_scenario_growth_rows_100_leaf_count(void)
 {
     return 100u * 3u;
 }
+
+uint32_t
+alia_layout_scenario_grid_100_leaf_count(void)
+{
+    return 100u * 4u;
+}
+
+uint32_t
+alia_layout_scenario_nested_grid_1m_leaf_count(void)
+{
+    return 100u * 100u * 100u;
+}
+
+uint32_t
+alia_layout_scenario_column_of_rows_1m_leaf_count(void)
+{
+    return COLUMN_OF_ROWS_1M_ROW_COUNT * 2u;
+}
+
+uint32_t
+alia_layout_scenario_paragraphs_leaf_count(void)
+{
+    return PARAGRAPH_COUNT * PARAGRAPH_WORD_COUNT;
+}
+
+alia_layout_scenario_info const alia_layout_small_scenarios[] = {
+    {"nested_grid_10",
+     alia_layout_scenario_nested_grid_10,
+     alia_layout_scenario_nested_grid_10_leaf_count},
+    {"column_of_rows_100",
+     alia_layout_scenario_column_of_rows_100,
+     alia_layout_scenario_column_of_rows_100_leaf_count},
+    {"growth_rows_100",
+     alia_layout_scenario_growth_rows_100,
+     alia_layout_scenario_growth_rows_100_leaf_count},
+    {"grid_100",
+     alia_layout_scenario_grid_100,
+     alia_layout_scenario_grid_100_leaf_count},
+    {"paragraphs",
+     alia_layout_scenario_paragraphs,
+     alia_layout_scenario_paragraphs_leaf_count},
+};
+
+uint32_t const alia_layout_small_scenario_count
+    = sizeof(alia_layout_small_scenarios)
+    / sizeof(alia_layout_small_scenarios[0]);
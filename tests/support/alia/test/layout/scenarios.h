@@ -7,6 +7,17 @@ ALIA_EXTERN_C_BEGIN
 
 typedef void (*alia_layout_scenario_fn)(alia_context* ctx, void* user_data);
 
+// If a scenario is passed one of these as its user data, it widens one of its
+// leaves (counting in emission order) by `extra_width`. This is used to
+// measure incremental layout.
+typedef struct alia_layout_scenario_change
+{
+    uint32_t leaf_index;
+    float extra_width;
+    // (used internally to count leaves during emission)
+    uint32_t leaf_counter;
+} alia_layout_scenario_change;
+
 bool
 alia_layout_context_is_refresh(alia_context* ctx);
 
@@ -19,6 +30,22 @@ alia_layout_scenario_column_of_rows_100(alia_context* ctx, void* user_data);
 void
 alia_layout_scenario_growth_rows_100(alia_context* ctx, void* user_data);
 
+void
+alia_layout_scenario_grid_100(alia_context* ctx, void* user_data);
+
+// a column of 20 flows, each holding 200 leaves of varying widths (like words
+// in paragraphs of text)
+void
+alia_layout_scenario_paragraphs(alia_context* ctx, void* user_data);
+
+// larger versions of the scenarios above, with about a million nodes each
+
+void
+alia_layout_scenario_nested_grid_1m(alia_context* ctx, void* user_data);
+
+void
+alia_layout_scenario_column_of_rows_1m(alia_context* ctx, void* user_data);
+
 uint32_t
 alia_layout_scenario_nested_grid_10_leaf_count(void);
 
@@ -28,4 +55,42 @@ alia_layout_scenario_column_of_rows_100_leaf_count(void);
 uint32_t
 alia_layout_scenario_growth_rows_100_leaf_count(void);
 
+uint32_t
+alia_layout_scenario_grid_100_leaf_count(void);
+
+uint32_t
+alia_layout_scenario_paragraphs_leaf_count(void);
+
+uint32_t
+alia_layout_scenario_nested_grid_1m_leaf_count(void);
+
+uint32_t
+alia_layout_scenario_column_of_rows_1m_leaf_count(void);
+
+typedef struct alia_layout_scenario_info
+{
+    char const* name;
+    alia_layout_scenario_fn fn;
+    uint32_t (*leaf_count)(void);
+} alia_layout_scenario_info;
+
+// all of the small scenarios above (i.e., everything but the `_1m` ones) -
+// Tests that check one layout path against another should cover all of
+// these, so they should iterate over this table rather than listing their
+// own.
+extern alia_layout_scenario_info const alia_layout_small_scenarios[];
+extern uint32_t const alia_layout_small_scenario_count;
+
 ALIA_EXTERN_C_END
+
+#ifdef __cplusplus
+
+#include <span>
+
+inline std::span<alia_layout_scenario_info const>
+alia_layout_small_scenario_table()
+{
+    return {alia_layout_small_scenarios, alia_layout_small_scenario_count};
+}
+
+#endif